@@ -137,7 +137,7 @@ decomp_fullaca_rkmatrix(pamatrix A, const real accur, uint ** ridx,
       d[i + j * ldd] = 0.0;
     }
     for (i = j; i < cols; i++) {
-      d[i + j * ldd] = a[j + i * ld];
+      d[i + j * ldd] = CONJ(a[j + i * ld]);
     }
   }
 
@@ -184,7 +184,7 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data,
   pamatrix  A, B;
   amatrix   A_k, B_k;
   uint     *rperm, *cperm, *rpiv, *cpiv;
-  uint      i, j, mu, k, i_k, j_k;
+  uint      i, j, mu, k, kmax, kcap, i_k, j_k;
   real      error, error2, starterror, M;
   field     Aij;
   pfield    aa, bb;
@@ -207,12 +207,23 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data,
   A = &R->A;
   B = &R->B;
 
+  /* The factors are stored in buffers with room for kcap columns.
+     Their capacity is doubled when needed, so building a rank k
+     approximation takes only O(log k) allocations and copies. */
+  kmax = UINT_MIN(rows, cols);
+  kcap = UINT_MIN(kmax, ACA_INITIAL_RANK);
+  resize_amatrix(A, rows, kcap);
+  resize_amatrix(B, cols, kcap);
+
   error = 1.0;
   starterror = 1.0;
 
-  while (error > accur && k < rows && k < cols) {
-    resizecopy_amatrix(A, rows, k + 1);
-    resizecopy_amatrix(B, cols, k + 1);
+  while (error > accur && k < kmax) {
+    if (k == kcap) {
+      kcap = UINT_MIN(kmax, 2 * kcap);
+      resizecopy_amatrix(A, rows, kcap);
+      resizecopy_amatrix(B, cols, kcap);
+    }
     aa = A->a;
     bb = B->a;
 
@@ -242,7 +253,7 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data,
       bb[j + k * cols] = 0.0;
     }
     for (mu = 0; mu < k; ++mu) {
-      Aij = aa[i_k + mu * rows];
+      Aij = CONJ(aa[i_k + mu * rows]);
       for (j = k; j < cols; ++j) {
 	bb[j + k * cols] = bb[j + k * cols] - bb[j + mu * cols] * Aij;
       }
@@ -266,13 +277,13 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data,
       aa[i + k * rows] = 0.0;
     }
     for (mu = 0; mu < k; ++mu) {
-      Aij = bb[j_k + mu * cols];
+      Aij = CONJ(bb[j_k + mu * cols]);
       for (i = k; i < rows; ++i) {
 	aa[i + k * rows] = aa[i + k * rows] - aa[i + mu * rows] * Aij;
       }
     }
 
-    Aij = 1.0 / bb[j_k + k * cols];
+    Aij = 1.0 / CONJ(bb[j_k + k * cols]);
     for (i = 0; i < rows; ++i) {
       aa[i + k * rows] = aa[i + k * rows] * Aij;
     }
@@ -331,6 +342,11 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data,
     uninit_amatrix(&B_k);
   }
 
+  /* Release unused columns */
+  if (k < kcap) {
+    resizecopy_amatrix(A, rows, k);
+    resizecopy_amatrix(B, cols, k);
+  }
   R->k = k;
 
   /* Reverse pivot permutations */
@@ -419,13 +435,13 @@ copy_upper_aca_amatrix(bool unit, pcamatrix A, uint * xi, pamatrix B)
     assert(xi[j] < A->rows);
     jj = xi[j];
     for (i = 0; i < j; ++i) {
-      b[i + j * ldb] = a[jj + i * lda];
+      b[i + j * ldb] = CONJ(a[jj + i * lda]);
     }
     if (unit) {
       b[i + j * ldb] = 1.0;
     }
     else {
-      b[i + j * ldb] = a[jj + i * lda];
+      b[i + j * ldb] = CONJ(a[jj + i * lda]);
     }
   }
 }
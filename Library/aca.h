@@ -43,12 +43,18 @@
  *    <tt>ntrans</tt> is not set and <tt>N->rows</tt> if it is set.
  *  @param data Arbitrary data the callback function might require
  *    to complete its task, e.g., geometry data.
- *  @param ntrans Set if the transposed matrix is to be filled.
+ *  @param ntrans Set if the adjoint matrix is to be filled.
  *  @param N Target matrix. */
 typedef void (*matrixentry_t)(const uint *ridx, const uint *cidx,
 			      void *data,
 			      const bool ntrans, pamatrix N);
 
+/** @brief Number of columns initially reserved for the factors in
+ *  @ref decomp_partialaca_rkmatrix.
+ *
+ *  The capacity is doubled whenever it is exhausted. */
+#define ACA_INITIAL_RANK 16
+
 /**
  * @brief This routine computes the adaptive cross approximation using full
  * pivoting of a given matrix @f$ A @f$.
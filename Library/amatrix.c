@@ -7,12 +7,20 @@
 
 #include "settings.h"
 #include "basic.h"
+#include "blas.h"
 
 #include <math.h>
 #include <stdio.h>
 
+#ifdef USE_SIMD
+#include <immintrin.h>
+#endif
+
 static uint active_amatrix = 0;
 
+/* Marks coefficients taken from the scratch arena */
+static char scratch_owner;
+
 /* ------------------------------------------------------------
  Constructors and destructors
  ------------------------------------------------------------ */
@@ -80,6 +88,45 @@ init_vec_amatrix(pamatrix a, pavector src, uint rows, uint cols)
   return a;
 }
 
+pamatrix
+init_pointer_amatrix(pamatrix a, pfield src, uint rows, uint cols)
+{
+  assert(a != NULL);
+  assert(src != NULL || rows == 0 || cols == 0);
+
+  a->a = src;
+  a->ld = rows;
+  a->rows = rows;
+  a->cols = cols;
+  a->owner = src;
+
+#ifdef USE_OPENMP
+#pragma omp atomic
+#endif
+  active_amatrix++;
+
+  return a;
+}
+
+pamatrix
+init_scratch_amatrix(pamatrix a, uint rows, uint cols)
+{
+  assert(a != NULL);
+
+  a->a = allocscratch((size_t) rows * cols);
+  a->ld = rows;
+  a->rows = rows;
+  a->cols = cols;
+  a->owner = &scratch_owner;
+
+#ifdef USE_OPENMP
+#pragma omp atomic
+#endif
+  active_amatrix++;
+
+  return a;
+}
+
 pamatrix
 init_zero_amatrix(pamatrix a, uint rows, uint cols)
 {
@@ -153,6 +200,18 @@ new_sub_amatrix(pamatrix src, uint rows, uint roff, uint cols, uint coff)
   return a;
 }
 
+pamatrix
+new_pointer_amatrix(pfield src, uint rows, uint cols)
+{
+  pamatrix  a;
+
+  a = (pamatrix) allocmem(sizeof(amatrix));
+
+  init_pointer_amatrix(a, src, rows, cols);
+
+  return a;
+}
+
 pamatrix
 new_zero_amatrix(uint rows, uint cols)
 {
@@ -231,6 +290,29 @@ resizecopy_amatrix(pamatrix a, uint rows, uint cols)
   }
 }
 
+void
+move_amatrix(pamatrix a, pfield data, void *owner)
+{
+  longindex lda, ldn;
+  uint      i, j;
+
+  assert(a->owner == NULL);
+  assert(owner != NULL);
+
+  lda = a->ld;
+  ldn = a->rows;
+
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++)
+      data[i + j * ldn] = a->a[i + j * lda];
+
+  freemem(a->a);
+
+  a->a = data;
+  a->ld = a->rows;
+  a->owner = owner;
+}
+
 /* ------------------------------------------------------------
  Statistics
  ------------------------------------------------------------ */
@@ -305,7 +387,7 @@ random_amatrix(pamatrix a)
 
   for (j = 0; j < a->cols; j++)
     for (i = 0; i < rows; i++)
-      a->a[i + j * lda] = 2.0 * rand() / RAND_MAX - 1.0;
+      a->a[i + j * lda] = FIELD_RAND();
 }
 
 void
@@ -321,7 +403,7 @@ random_invertible_amatrix(pamatrix a, real alpha)
 
   for (j = 0; j < rows; j++) {
     for (i = 0; i < rows; i++)
-      aa[i + j * lda] = 2.0 * rand() / RAND_MAX - 1.0;
+      aa[i + j * lda] = FIELD_RAND();
     aa[j + j * lda] = 0.0;
   }
 
@@ -344,7 +426,7 @@ random_selfadjoint_amatrix(pamatrix a)
 
   for (j = 0; j < rows; j++) {
     for (i = 0; i < j; i++) {
-      a->a[i + j * lda] = 2.0 * rand() / RAND_MAX - 1.0;
+      a->a[i + j * lda] = FIELD_RAND();
       a->a[j + i * lda] = CONJ(a->a[i + j * lda]);
     }
     a->a[j + j * lda] = 2.0 * rand() / RAND_MAX - 1.0;
@@ -364,7 +446,7 @@ random_spd_amatrix(pamatrix a, real alpha)
 
   for (j = 0; j < rows; j++) {
     for (i = 0; i < j; i++) {
-      aa[i + j * lda] = 2.0 * rand() / RAND_MAX - 1.0;
+      aa[i + j * lda] = FIELD_RAND();
       aa[j + i * lda] = CONJ(aa[i + j * lda]);
     }
     aa[j + j * lda] = 0.0;
@@ -408,7 +490,7 @@ copy_sub_amatrix(bool atrans, pcamatrix a, pamatrix b)
 
     for (i = 0; i < rows; i++)
       for (j = 0; j < cols; j++)
-	b->a[i + j * ldb] = a->a[j + i * lda];
+	b->a[i + j * ldb] = CONJ(a->a[j + i * lda]);
   }
   else {
     rows = UINT_MIN(a->rows, b->rows);
@@ -433,9 +515,9 @@ print_amatrix(pcamatrix a)
     return;
 
   for (i = 0; i < rows; i++) {
-    (void) printf("  (% .5e", a->a[i]);
+    (void) printf("  (" FIELD_FMT, FIELD_PRINT(a->a[i]));
     for (j = 1; j < cols; j++)
-      (void) printf(" % .5e", a->a[i + j * a->ld]);
+      (void) printf(" " FIELD_FMT, FIELD_PRINT(a->a[i + j * a->ld]));
     (void) printf(")\n");
   }
 }
@@ -454,9 +536,9 @@ print_matlab_amatrix(pcamatrix a)
     if (cols == 0)
       (void) printf("  [ ]\n");
     else {
-      (void) printf("  [% .5e", a->a[0]);
+      (void) printf("  [" FIELD_FMT, FIELD_PRINT(a->a[0]));
       for (j = 1; j < cols; j++)
-	(void) printf(" % .5e", a->a[j * lda]);
+	(void) printf(" " FIELD_FMT, FIELD_PRINT(a->a[j * lda]));
       (void) printf("]\n");
     }
   }
@@ -468,19 +550,19 @@ print_matlab_amatrix(pcamatrix a)
       (void) printf(" ]\n");
     }
     else {
-      (void) printf("  [% .5e", a->a[0]);
+      (void) printf("  [" FIELD_FMT, FIELD_PRINT(a->a[0]));
       for (j = 1; j < cols; j++)
-	(void) printf(" % .5e", a->a[j * lda]);
+	(void) printf(" " FIELD_FMT, FIELD_PRINT(a->a[j * lda]));
       (void) printf(" ;\n");
       for (i = 1; i < rows - 1; i++) {
-	(void) printf("  % .5e", a->a[i]);
+	(void) printf("  " FIELD_FMT, FIELD_PRINT(a->a[i]));
 	for (j = 1; j < cols; j++)
-	  (void) printf(" % .5e", a->a[i + j * lda]);
+	  (void) printf(" " FIELD_FMT, FIELD_PRINT(a->a[i + j * lda]));
 	(void) printf(" ;\n");
       }
-      (void) printf("  % .5e", a->a[i]);
+      (void) printf("  " FIELD_FMT, FIELD_PRINT(a->a[i]));
       for (j = 1; j < cols; j++)
-	(void) printf(" % .5e", a->a[i + j * lda]);
+	(void) printf(" " FIELD_FMT, FIELD_PRINT(a->a[i + j * lda]));
       (void) printf("]\n");
     }
   }
@@ -516,6 +598,424 @@ check_ortho_amatrix(bool atrans, pcamatrix a)
   return error;
 }
 
+/* ------------------------------------------------------------
+ Kernels for builds without BLAS
+ ------------------------------------------------------------ */
+
+#ifndef USE_BLAS
+
+/*
+ * Without BLAS, matrix-vector and matrix-matrix products are handled
+ * by the blocked kernels below.
+ * Matrix-vector products work on four columns at a time, so that the
+ * innermost loops run along contiguous columns.
+ * Matrix-matrix products follow the usual GEMM scheme: blocks of
+ * op(B) and op(A) are packed into contiguous panels in the scratch
+ * arena, where they stay in the caches, and a register-tiled
+ * micro-kernel computes GEMM_MR x GEMM_NR blocks of the result.
+ * Packing also takes care of transposition and conjugation, so the
+ * micro-kernel is the same for all four cases.
+ *
+ * If USE_SIMD is defined and the field is real, the kernels use
+ * AVX-512 or AVX vectors, depending on the instruction sets enabled
+ * by the compiler, e.g., by -march=native.
+ */
+
+#if defined(USE_SIMD) && !defined(USE_COMPLEX) && defined(__AVX512F__)
+#define SIMD_WIDTH 8
+typedef __m512d vreal;
+#define vzero_real() _mm512_setzero_pd()
+#define vset1_real(x) _mm512_set1_pd(x)
+#define vload_real(p) _mm512_loadu_pd(p)
+#define vstore_real(p, x) _mm512_storeu_pd(p, x)
+#define vadd_real(x, y) _mm512_add_pd(x, y)
+#define vfmadd_real(x, y, z) _mm512_fmadd_pd(x, y, z)
+#define vsum_real(x) _mm512_reduce_add_pd(x)
+#elif defined(USE_SIMD) && !defined(USE_COMPLEX) && defined(__AVX__)
+#define SIMD_WIDTH 4
+typedef __m256d vreal;
+#define vzero_real() _mm256_setzero_pd()
+#define vset1_real(x) _mm256_set1_pd(x)
+#define vload_real(p) _mm256_loadu_pd(p)
+#define vstore_real(p, x) _mm256_storeu_pd(p, x)
+#define vadd_real(x, y) _mm256_add_pd(x, y)
+#ifdef __FMA__
+#define vfmadd_real(x, y, z) _mm256_fmadd_pd(x, y, z)
+#else
+#define vfmadd_real(x, y, z) _mm256_add_pd(_mm256_mul_pd(x, y), z)
+#endif
+
+INLINE_PREFIX real
+vsum_real(vreal x)
+{
+  __m128d   lo, hi;
+
+  lo = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+  hi = _mm_unpackhi_pd(lo, lo);
+
+  return _mm_cvtsd_f64(_mm_add_sd(lo, hi));
+}
+#endif
+
+/* Rows and columns of the register tile of the micro-kernel */
+#ifdef SIMD_WIDTH
+#define GEMM_MR (2 * SIMD_WIDTH)
+#else
+#define GEMM_MR 4
+#endif
+#define GEMM_NR 4
+
+/* Rows of op(A), columns of op(B) and summation indices handled by
+ * one packed block, chosen so that a panel of op(B) fits into the
+ * L1 cache and a block of op(A) fits into the L2 cache */
+#define GEMM_MC 128
+#define GEMM_NC 1024
+#define GEMM_KC 256
+
+/* Products with fewer operations are not worth packing */
+#define GEMM_SMALL 8192
+
+/* Rows handled at a time by addeval_amatrix_avector, so that the
+ * partial sums stay in the L1 cache */
+#define GEMV_MB 2048
+
+/* y += x0 a0 + x1 a1 + x2 a2 + x3 a3 for n entries, adding the
+ * columns one after another */
+static void
+axpy4_kernel(uint n, pcfield a0, pcfield a1, pcfield a2, pcfield a3,
+	     field x0, field x1, field x2, field x3, pfield y)
+{
+  field     yi;
+  uint      i;
+
+  i = 0;
+
+#ifdef SIMD_WIDTH
+  {
+    vreal     vx0, vx1, vx2, vx3, vy;
+
+    vx0 = vset1_real(x0);
+    vx1 = vset1_real(x1);
+    vx2 = vset1_real(x2);
+    vx3 = vset1_real(x3);
+
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+      vy = vload_real(y + i);
+      vy = vfmadd_real(vload_real(a0 + i), vx0, vy);
+      vy = vfmadd_real(vload_real(a1 + i), vx1, vy);
+      vy = vfmadd_real(vload_real(a2 + i), vx2, vy);
+      vy = vfmadd_real(vload_real(a3 + i), vx3, vy);
+      vstore_real(y + i, vy);
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    yi = y[i];
+    yi += a0[i] * x0;
+    yi += a1[i] * x1;
+    yi += a2[i] * x2;
+    yi += a3[i] * x3;
+    y[i] = yi;
+  }
+}
+
+/* s_l = sum_i conj(a_l[i]) x[i] for l = 0, ..., 3 */
+static void
+dot4_kernel(uint n, pcfield a0, pcfield a1, pcfield a2, pcfield a3,
+	    pcfield x, pfield s)
+{
+  field     s0, s1, s2, s3, xi;
+  uint      i;
+
+  s0 = s1 = s2 = s3 = 0.0;
+  i = 0;
+
+#ifdef SIMD_WIDTH
+  {
+    vreal     vs0, vs1, vs2, vs3, vx;
+
+    vs0 = vs1 = vs2 = vs3 = vzero_real();
+
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+      vx = vload_real(x + i);
+      vs0 = vfmadd_real(vload_real(a0 + i), vx, vs0);
+      vs1 = vfmadd_real(vload_real(a1 + i), vx, vs1);
+      vs2 = vfmadd_real(vload_real(a2 + i), vx, vs2);
+      vs3 = vfmadd_real(vload_real(a3 + i), vx, vs3);
+    }
+
+    s0 = vsum_real(vs0);
+    s1 = vsum_real(vs1);
+    s2 = vsum_real(vs2);
+    s3 = vsum_real(vs3);
+  }
+#endif
+
+  for (; i < n; i++) {
+    xi = x[i];
+    s0 += CONJ(a0[i]) * xi;
+    s1 += CONJ(a1[i]) * xi;
+    s2 += CONJ(a2[i]) * xi;
+    s3 += CONJ(a3[i]) * xi;
+  }
+
+  s[0] = s0;
+  s[1] = s1;
+  s[2] = s2;
+  s[3] = s3;
+}
+
+/* Pack an mc x kc block of op(A) into panels of GEMM_MR rows,
+ * padded with zeros */
+static void
+pack_a_gemm(bool atrans, pcfield aa, longindex lda, uint mc, uint kc,
+	    pfield buf)
+{
+  uint      i, k, l, m;
+
+  for (i = 0; i < mc; i += GEMM_MR) {
+    m = UINT_MIN(GEMM_MR, mc - i);
+
+    if (atrans)
+      for (k = 0; k < kc; k++) {
+	for (l = 0; l < m; l++)
+	  buf[l + k * GEMM_MR] = CONJ(aa[k + (i + l) * lda]);
+	for (; l < GEMM_MR; l++)
+	  buf[l + k * GEMM_MR] = 0.0;
+      }
+    else
+      for (k = 0; k < kc; k++) {
+	for (l = 0; l < m; l++)
+	  buf[l + k * GEMM_MR] = aa[(i + l) + k * lda];
+	for (; l < GEMM_MR; l++)
+	  buf[l + k * GEMM_MR] = 0.0;
+      }
+
+    buf += (size_t) GEMM_MR * kc;
+  }
+}
+
+/* Pack a kc x nc block of op(B) into panels of GEMM_NR columns,
+ * padded with zeros */
+static void
+pack_b_gemm(bool btrans, pcfield ba, longindex ldb,
+	    uint kc, uint nc, pfield buf)
+{
+  uint      j, k, l, n;
+
+  for (j = 0; j < nc; j += GEMM_NR) {
+    n = UINT_MIN(GEMM_NR, nc - j);
+
+    if (btrans)
+      for (k = 0; k < kc; k++) {
+	for (l = 0; l < n; l++)
+	  buf[l + k * GEMM_NR] = CONJ(ba[(j + l) + k * ldb]);
+	for (; l < GEMM_NR; l++)
+	  buf[l + k * GEMM_NR] = 0.0;
+      }
+    else
+      for (k = 0; k < kc; k++) {
+	for (l = 0; l < n; l++)
+	  buf[l + k * GEMM_NR] = ba[k + (j + l) * ldb];
+	for (; l < GEMM_NR; l++)
+	  buf[l + k * GEMM_NR] = 0.0;
+      }
+
+    buf += (size_t) GEMM_NR * kc;
+  }
+}
+
+/* C += alpha A B for a packed GEMM_MR x kc panel A and a packed
+ * kc x GEMM_NR panel B, only the leading m x n block of C is
+ * written */
+static void
+micro_kernel_gemm(field alpha, uint kc, pcfield ap, pcfield bp,
+		  uint m, uint n, pfield c, longindex ldc)
+{
+  field     ab[GEMM_MR * GEMM_NR];
+  uint      i, j, k;
+
+#ifdef SIMD_WIDTH
+  vreal     c00, c10, c01, c11, c02, c12, c03, c13;
+  vreal     a0, a1, b, valpha;
+
+  c00 = c10 = c01 = c11 = c02 = c12 = c03 = c13 = vzero_real();
+
+  for (k = 0; k < kc; k++) {
+    a0 = vload_real(ap);
+    a1 = vload_real(ap + SIMD_WIDTH);
+
+    b = vset1_real(bp[0]);
+    c00 = vfmadd_real(a0, b, c00);
+    c10 = vfmadd_real(a1, b, c10);
+    b = vset1_real(bp[1]);
+    c01 = vfmadd_real(a0, b, c01);
+    c11 = vfmadd_real(a1, b, c11);
+    b = vset1_real(bp[2]);
+    c02 = vfmadd_real(a0, b, c02);
+    c12 = vfmadd_real(a1, b, c12);
+    b = vset1_real(bp[3]);
+    c03 = vfmadd_real(a0, b, c03);
+    c13 = vfmadd_real(a1, b, c13);
+
+    ap += GEMM_MR;
+    bp += GEMM_NR;
+  }
+
+  if (m == GEMM_MR && n == GEMM_NR) {
+    valpha = vset1_real(alpha);
+    vstore_real(c, vfmadd_real(valpha, c00, vload_real(c)));
+    vstore_real(c + SIMD_WIDTH,
+		vfmadd_real(valpha, c10, vload_real(c + SIMD_WIDTH)));
+    c += ldc;
+    vstore_real(c, vfmadd_real(valpha, c01, vload_real(c)));
+    vstore_real(c + SIMD_WIDTH,
+		vfmadd_real(valpha, c11, vload_real(c + SIMD_WIDTH)));
+    c += ldc;
+    vstore_real(c, vfmadd_real(valpha, c02, vload_real(c)));
+    vstore_real(c + SIMD_WIDTH,
+		vfmadd_real(valpha, c12, vload_real(c + SIMD_WIDTH)));
+    c += ldc;
+    vstore_real(c, vfmadd_real(valpha, c03, vload_real(c)));
+    vstore_real(c + SIMD_WIDTH,
+		vfmadd_real(valpha, c13, vload_real(c + SIMD_WIDTH)));
+    return;
+  }
+
+  vstore_real(ab, c00);
+  vstore_real(ab + SIMD_WIDTH, c10);
+  vstore_real(ab + GEMM_MR, c01);
+  vstore_real(ab + GEMM_MR + SIMD_WIDTH, c11);
+  vstore_real(ab + 2 * GEMM_MR, c02);
+  vstore_real(ab + 2 * GEMM_MR + SIMD_WIDTH, c12);
+  vstore_real(ab + 3 * GEMM_MR, c03);
+  vstore_real(ab + 3 * GEMM_MR + SIMD_WIDTH, c13);
+#else
+  for (i = 0; i < GEMM_MR * GEMM_NR; i++)
+    ab[i] = 0.0;
+
+  for (k = 0; k < kc; k++) {
+    for (j = 0; j < GEMM_NR; j++)
+      for (i = 0; i < GEMM_MR; i++)
+	ab[i + j * GEMM_MR] += ap[i] * bp[j];
+
+    ap += GEMM_MR;
+    bp += GEMM_NR;
+  }
+#endif
+
+  for (j = 0; j < n; j++)
+    for (i = 0; i < m; i++)
+      c[i + j * ldc] += alpha * ab[i + j * GEMM_MR];
+}
+
+/* C += alpha op(A) op(B) with packed blocks */
+static void
+gemm_blocked(field alpha, bool atrans, pcfield aa, longindex lda,
+	     bool btrans, pcfield ba, longindex ldb,
+	     uint rows, uint cols, uint mid, pfield ca, longindex ldc)
+{
+  pfield    abuf, bbuf;
+  size_t    mark;
+  uint      ic, jc, pc, ir, jr;
+  uint      mc, nc, kc;
+
+  mark = mark_scratch();
+
+  nc = UINT_MIN(GEMM_NC, cols);
+  abuf = allocscratch((size_t) GEMM_MC * GEMM_KC);
+  bbuf = allocscratch((size_t) ((nc + GEMM_NR - 1) / GEMM_NR) * GEMM_NR
+		      * GEMM_KC);
+
+  for (jc = 0; jc < cols; jc += GEMM_NC) {
+    nc = UINT_MIN(GEMM_NC, cols - jc);
+
+    for (pc = 0; pc < mid; pc += GEMM_KC) {
+      kc = UINT_MIN(GEMM_KC, mid - pc);
+
+      pack_b_gemm(btrans,
+		  (btrans ? ba + jc + pc * ldb : ba + pc + jc * ldb), ldb,
+		  kc, nc, bbuf);
+
+      for (ic = 0; ic < rows; ic += GEMM_MC) {
+	mc = UINT_MIN(GEMM_MC, rows - ic);
+
+	pack_a_gemm(atrans,
+		    (atrans ? aa + pc + ic * lda : aa + ic + pc * lda), lda,
+		    mc, kc, abuf);
+
+	for (jr = 0; jr < nc; jr += GEMM_NR)
+	  for (ir = 0; ir < mc; ir += GEMM_MR)
+	    micro_kernel_gemm(alpha, kc, abuf + (size_t) ir * kc,
+			      bbuf + (size_t) jr * kc,
+			      UINT_MIN(GEMM_MR, mc - ir),
+			      UINT_MIN(GEMM_NR, nc - jr),
+			      ca + (ic + ir) + (jc + jr) * ldc, ldc);
+      }
+    }
+  }
+
+  release_scratch(mark);
+}
+
+/* C += alpha op(A) op(B) for small products, without packing */
+static void
+gemm_small(field alpha, bool atrans, pcfield aa, longindex lda,
+	   bool btrans, pcfield ba, longindex ldb,
+	   uint rows, uint cols, uint mid, pfield ca, longindex ldc)
+{
+  pfield    sum;
+  field     beta;
+  size_t    mark;
+  uint      i, j, k;
+
+  mark = mark_scratch();
+  sum = allocscratch(rows);
+
+  for (k = 0; k < cols; k++) {
+    for (i = 0; i < rows; i++)
+      sum[i] = 0.0;
+
+    if (atrans)
+      for (i = 0; i < rows; i++)
+	if (btrans)
+	  for (j = 0; j < mid; j++)
+	    sum[i] += CONJ(aa[j + i * lda]) * CONJ(ba[k + j * ldb]);
+	else
+	  for (j = 0; j < mid; j++)
+	    sum[i] += CONJ(aa[j + i * lda]) * ba[j + k * ldb];
+    else
+      for (j = 0; j < mid; j++) {
+	beta = (btrans ? CONJ(ba[k + j * ldb]) : ba[j + k * ldb]);
+	for (i = 0; i < rows; i++)
+	  sum[i] += aa[i + j * lda] * beta;
+      }
+
+    for (i = 0; i < rows; i++)
+      ca[i + k * ldc] += alpha * sum[i];
+  }
+
+  release_scratch(mark);
+}
+
+/* C += alpha op(A) op(B), choosing the kernel by size */
+static void
+gemm_kernel(field alpha, bool atrans, pcfield aa, longindex lda,
+	    bool btrans, pcfield ba, longindex ldb,
+	    uint rows, uint cols, uint mid, pfield ca, longindex ldc)
+{
+  if (rows < GEMM_MR || cols < GEMM_NR
+      || (size_t) rows * cols * mid < GEMM_SMALL)
+    gemm_small(alpha, atrans, aa, lda, btrans, ba, ldb, rows, cols, mid,
+	       ca, ldc);
+  else
+    gemm_blocked(alpha, atrans, aa, lda, btrans, ba, ldb, rows, cols, mid,
+		 ca, ldc);
+}
+
+#endif
+
 /* ------------------------------------------------------------
  Basic linear algebra
  ------------------------------------------------------------ */
@@ -604,20 +1104,6 @@ norm2diff_amatrix(pcamatrix a, pcamatrix b)
 }
 
 #ifdef USE_BLAS
-IMPORT_PREFIX double
-
-
-
-
-
-
-
-
-
-
-ddot_(const unsigned *n,
-      const double *x, const int *incx, const double *y, const int *incy);
-
 field
 dotprod_amatrix(pcamatrix a, pcamatrix b)
 {
@@ -633,7 +1119,7 @@ dotprod_amatrix(pcamatrix a, pcamatrix b)
 
   sum = 0.0;
   for (j = 0; j < cols; j++)
-    sum += ddot_(&rows, a->a + j * a->ld, &i_one, b->a + j * b->ld, &i_one);
+    sum += h2_dot(&rows, a->a + j * a->ld, &u_one, b->a + j * b->ld, &u_one);
 
   return sum;
 }
@@ -661,9 +1147,6 @@ dotprod_amatrix(pcamatrix a, pcamatrix b)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX double
-          dnrm2_(const unsigned *n, const double *x, const int *incx);
-
 real
 normfrob_amatrix(pcamatrix a)
 {
@@ -672,7 +1155,7 @@ normfrob_amatrix(pcamatrix a)
 
   sum = 0.0;
   for (j = 0; j < a->cols; j++)
-    sum += REAL_SQR(dnrm2_(&a->rows, a->a + j * a->ld, &i_one));
+    sum += REAL_SQR(h2_nrm2(&a->rows, a->a + j * a->ld, &u_one));
 
   return REAL_SQRT(sum);
 }
@@ -693,26 +1176,6 @@ normfrob_amatrix(pcamatrix a)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-
-
-
-
-
-
-
-
-
-
-dgemv_(const char *trans,
-       const unsigned *m,
-       const unsigned *n,
-       const double *alpha,
-       const double *a,
-       const unsigned *lda,
-       const double *x,
-       const int *incx, const double *beta, double *y, const int *incy);
-
 void
 addeval_amatrix_avector(field alpha, pcamatrix a, pcavector src, pavector trg)
 {
@@ -720,8 +1183,8 @@ addeval_amatrix_avector(field alpha, pcamatrix a, pcavector src, pavector trg)
   assert(trg->dim >= a->rows);
 
   if (a->rows > 0 && a->cols > 0)
-    dgemv_("Not Transposed", &a->rows, &a->cols, &alpha, a->a, &a->ld,
-	   src->v, &i_one, &f_one, trg->v, &i_one);
+    h2_gemv(_h2_ntrans, &a->rows, &a->cols, &alpha, a->a, &a->ld,
+	    src->v, &u_one, &f_one, trg->v, &u_one);
 }
 
 void
@@ -732,44 +1195,77 @@ addevaltrans_amatrix_avector(field alpha, pcamatrix a, pcavector src,
   assert(trg->dim >= a->cols);
 
   if (a->rows > 0 && a->cols > 0)
-    dgemv_("Transposed", &a->rows, &a->cols, &alpha, a->a, &a->ld,
-	   src->v, &i_one, &f_one, trg->v, &i_one);
+    h2_gemv(_h2_adj, &a->rows, &a->cols, &alpha, a->a, &a->ld,
+	    src->v, &u_one, &f_one, trg->v, &u_one);
 }
 #else
 void
 addeval_amatrix_avector(field alpha, pcamatrix a, pcavector src, pavector trg)
 {
-  field     sum;
+  pcfield   aa = a->a;
+  pcfield   x = src->v;
   longindex lda = a->ld;
-  uint      i, j;
+  uint      rows = a->rows;
+  uint      cols = a->cols;
+  pfield    sum;
+  size_t    mark;
+  uint      i, j, l, m;
 
   assert(src->dim >= a->cols);
   assert(trg->dim >= a->rows);
 
-  for (i = 0; i < a->rows; i++) {
-    sum = f_zero;
-    for (j = 0; j < a->cols; j++)
-      sum += a->a[i + j * lda] * src->v[j];
-    trg->v[i] += alpha * sum;
+  mark = mark_scratch();
+  sum = allocscratch(UINT_MIN(rows, GEMV_MB));
+
+  for (i = 0; i < rows; i += GEMV_MB) {
+    m = UINT_MIN(GEMV_MB, rows - i);
+
+    for (l = 0; l < m; l++)
+      sum[l] = 0.0;
+
+    for (j = 0; j + 4 <= cols; j += 4)
+      axpy4_kernel(m, aa + i + j * lda, aa + i + (j + 1) * lda,
+		   aa + i + (j + 2) * lda, aa + i + (j + 3) * lda,
+		   x[j], x[j + 1], x[j + 2], x[j + 3], sum);
+    for (; j < cols; j++)
+      for (l = 0; l < m; l++)
+	sum[l] += aa[i + l + j * lda] * x[j];
+
+    for (l = 0; l < m; l++)
+      trg->v[i + l] += alpha * sum[l];
   }
+
+  release_scratch(mark);
 }
 
 void
 addevaltrans_amatrix_avector(field alpha, pcamatrix a, pcavector src,
 			     pavector trg)
 {
-  field     sum;
+  pcfield   aa = a->a;
   longindex lda = a->ld;
+  uint      rows = a->rows;
+  uint      cols = a->cols;
+  field     sum[4];
   uint      i, j;
 
   assert(src->dim >= a->rows);
   assert(trg->dim >= a->cols);
 
-  for (j = 0; j < a->cols; j++) {
-    sum = f_zero;
-    for (i = 0; i < a->rows; i++)
-      sum += CONJ(a->a[i + j * lda]) * src->v[i];
-    trg->v[j] += alpha * sum;
+  for (j = 0; j + 4 <= cols; j += 4) {
+    dot4_kernel(rows, aa + j * lda, aa + (j + 1) * lda,
+		aa + (j + 2) * lda, aa + (j + 3) * lda, src->v, sum);
+
+    trg->v[j] += alpha * sum[0];
+    trg->v[j + 1] += alpha * sum[1];
+    trg->v[j + 2] += alpha * sum[2];
+    trg->v[j + 3] += alpha * sum[3];
+  }
+  for (; j < cols; j++) {
+    sum[0] = 0.0;
+    for (i = 0; i < rows; i++)
+      sum[0] += CONJ(aa[i + j * lda]) * src->v[i];
+    trg->v[j] += alpha * sum[0];
   }
 }
 #endif
@@ -784,23 +1280,78 @@ mvm_amatrix_avector(field alpha, bool atrans, pcamatrix a, pcavector src,
     addeval_amatrix_avector(alpha, a, src, trg);
 }
 
-#ifdef USE_BLAS
-IMPORT_PREFIX void
+/* ------------------------------------------------------------
+ Single precision storage
+ ------------------------------------------------------------ */
 
+void
+tosingle_amatrix(pcamatrix a, psfield s)
+{
+  longindex lda = a->ld;
+  longindex lds = a->rows;
+  uint      i, j;
 
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++)
+      s[i + j * lds] = (sfield) a->a[i + j * lda];
+}
 
+void
+fromsingle_amatrix(pcsfield s, pamatrix a)
+{
+  longindex lda = a->ld;
+  longindex lds = a->rows;
+  uint      i, j;
 
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++)
+      a->a[i + j * lda] = (field) s[i + j * lds];
+}
 
+void
+addeval_single_avector(field alpha, uint rows, uint cols, pcsfield s,
+		       pcavector src, pavector trg)
+{
+  field     beta;
+  pfield    y = trg->v;
+  pcsfield  sj;
+  uint      i, j;
 
+  assert(src->dim >= cols);
+  assert(trg->dim >= rows);
 
+  for (j = 0; j < cols; j++) {
+    beta = alpha * src->v[j];
+    sj = s + (size_t) rows * j;
+    for (i = 0; i < rows; i++)
+      y[i] += (field) sj[i] * beta;
+  }
+}
 
+void
+addevaltrans_single_avector(field alpha, uint rows, uint cols, pcsfield s,
+			    pcavector src, pavector trg)
+{
+  field     sum;
+  pcfield   x = src->v;
+  pcsfield  sj;
+  uint      i, j;
 
+  assert(src->dim >= rows);
+  assert(trg->dim >= cols);
 
-daxpy_(const unsigned *n,
-       const double *alpha,
-       const double *x,
-       const unsigned *incx, double *y, const unsigned *incy);
+  for (j = 0; j < cols; j++) {
+    sum = f_zero;
+    sj = s + (size_t) rows * j;
+    for (i = 0; i < rows; i++)
+      sum += CONJ((field) sj[i]) * x[i];
+    trg->v[j] += alpha * sum;
+  }
+}
 
+/* BLAS cannot add the adjoint of a complex matrix, so the
+   straightforward implementation is used in this case */
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
 void
 add_amatrix(field alpha, bool atrans, pcamatrix a, pamatrix b)
 {
@@ -811,15 +1362,15 @@ add_amatrix(field alpha, bool atrans, pcamatrix a, pamatrix b)
     assert(a->cols <= b->rows);
 
     for (i = 0; i < a->cols; i++)
-      daxpy_(&a->rows, &alpha, a->a + i * a->ld, &u_one, b->a + i, &b->ld);
+      h2_axpy(&a->rows, &alpha, a->a + i * a->ld, &u_one, b->a + i, &b->ld);
   }
   else {
     assert(a->rows <= b->rows);
     assert(a->cols <= b->cols);
 
     for (i = 0; i < a->cols; i++)
-      daxpy_(&a->rows, &alpha, a->a + i * a->ld, &u_one, b->a + i * b->ld,
-	     &u_one);
+      h2_axpy(&a->rows, &alpha, a->a + i * a->ld, &u_one, b->a + i * b->ld,
+	      &u_one);
   }
 }
 #else
@@ -850,29 +1401,6 @@ add_amatrix(field alpha, bool atrans, pcamatrix a, pamatrix b)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-
-
-
-
-
-
-
-
-
-
-dgemm_(const char *transa,
-       const char *transb,
-       const unsigned *m,
-       const unsigned *n,
-       const unsigned *k,
-       const double *alpha,
-       const double *a,
-       const unsigned *lda,
-       const double *b,
-       const unsigned *ldb,
-       const double *beta, double *c, const unsigned *ldc);
-
 void
 addmul_amatrix(field alpha,
 	       bool atrans, pcamatrix a, bool btrans, pcamatrix b, pamatrix c)
@@ -884,9 +1412,9 @@ addmul_amatrix(field alpha,
       assert(a->rows == b->cols);
 
       if (a->cols > 0 && b->rows > 0 && a->rows > 0)
-	dgemm_("Transposed", "Transposed",
-	       &a->cols, &b->rows, &a->rows,
-	       &alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
+	h2_gemm(_h2_adj, _h2_adj,
+		&a->cols, &b->rows, &a->rows,
+		&alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
     }
     else {
       assert(a->cols <= c->rows);
@@ -894,9 +1422,9 @@ addmul_amatrix(field alpha,
       assert(a->rows == b->rows);
 
       if (a->cols > 0 && b->cols > 0 && a->rows > 0)
-	dgemm_("Transposed", "Not Transposed",
-	       &a->cols, &b->cols, &a->rows,
-	       &alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
+	h2_gemm(_h2_adj, _h2_ntrans,
+		&a->cols, &b->cols, &a->rows,
+		&alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
     }
   }
   else {
@@ -906,9 +1434,9 @@ addmul_amatrix(field alpha,
       assert(a->cols == b->cols);
 
       if (a->rows > 0 && b->rows > 0 && a->cols > 0)
-	dgemm_("Not Transposed", "Transposed",
-	       &a->rows, &b->rows, &a->cols,
-	       &alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
+	h2_gemm(_h2_ntrans, _h2_adj,
+		&a->rows, &b->rows, &a->cols,
+		&alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
     }
     else {
       assert(a->rows <= c->rows);
@@ -916,9 +1444,9 @@ addmul_amatrix(field alpha,
       assert(a->cols == b->rows);
 
       if (a->rows > 0 && b->cols > 0 && a->cols > 0)
-	dgemm_("Not Transposed", "Not Transposed",
-	       &a->rows, &b->cols, &a->cols,
-	       &alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
+	h2_gemm(_h2_ntrans, _h2_ntrans,
+		&a->rows, &b->cols, &a->cols,
+		&alpha, a->a, &a->ld, b->a, &b->ld, &f_one, c->a, &c->ld);
     }
   }
 }
@@ -928,108 +1456,40 @@ addmul_amatrix(field alpha, bool atrans, pcamatrix a, bool btrans,
 	       pcamatrix b, pamatrix c)
 {
   uint      rows, cols, mid;
-  pcfield   aa = a->a;
-  pcfield   ba = b->a;
-  pfield    ca = c->a;
-  longindex lda = a->ld;
-  longindex ldb = b->ld;
-  longindex ldc = c->ld;
-  register field sum;
-  register uint i, j, k;
 
   if (atrans) {
-    if (btrans) {
-      assert(a->cols <= c->rows);
-      assert(b->rows <= c->cols);
-      assert(a->rows == b->cols);
-
-      rows = a->cols;
-      mid = a->rows;
-      cols = b->rows;
-
-      for (i = 0; i < rows; i++)
-	for (k = 0; k < cols; k++) {
-	  sum = 0.0;
-	  for (j = 0; j < mid; j++)
-	    sum += CONJ(aa[j + i * lda]) * CONJ(ba[k + j * ldb]);
-	  ca[i + k * ldc] += alpha * sum;
-	}
-    }
-    else {
-      assert(a->cols <= c->rows);
-      assert(b->cols <= c->cols);
-      assert(a->rows == b->rows);
-
-      rows = a->cols;
-      mid = a->rows;
-      cols = b->cols;
-
-      for (i = 0; i < rows; i++)
-	for (k = 0; k < cols; k++) {
-	  sum = 0.0;
-	  for (j = 0; j < mid; j++)
-	    sum += CONJ(aa[j + i * lda]) * ba[j + k * ldb];
-	  ca[i + k * ldc] += alpha * sum;
-	}
-    }
+    assert(a->cols <= c->rows);
+    rows = a->cols;
+    mid = a->rows;
   }
   else {
-    if (btrans) {
-      assert(a->rows <= c->rows);
-      assert(b->rows <= c->cols);
-      assert(a->cols == b->cols);
-
-      rows = a->rows;
-      mid = a->cols;
-      cols = b->rows;
-
-      for (i = 0; i < rows; i++)
-	for (k = 0; k < cols; k++) {
-	  sum = 0.0;
-	  for (j = 0; j < mid; j++)
-	    sum += aa[i + j * lda] * CONJ(ba[k + j * ldb]);
-	  ca[i + k * ldc] += alpha * sum;
-	}
-    }
-    else {
-      assert(a->rows <= c->rows);
-      assert(b->cols <= c->cols);
-      assert(a->cols == b->rows);
-
-      rows = a->rows;
-      mid = a->cols;
-      cols = b->cols;
+    assert(a->rows <= c->rows);
+    rows = a->rows;
+    mid = a->cols;
+  }
 
-      for (i = 0; i < rows; i++)
-	for (k = 0; k < cols; k++) {
-	  sum = 0.0;
-	  for (j = 0; j < mid; j++)
-	    sum += aa[i + j * lda] * ba[j + k * ldb];
-	  ca[i + k * ldc] += alpha * sum;
-	}
-    }
+  if (btrans) {
+    assert(b->rows <= c->cols);
+    assert(b->cols == mid);
+    cols = b->rows;
+  }
+  else {
+    assert(b->cols <= c->cols);
+    assert(b->rows == mid);
+    cols = b->cols;
   }
+
+  if (rows > 0 && cols > 0 && mid > 0)
+    gemm_kernel(alpha, atrans, a->a, a->ld, btrans, b->a, b->ld,
+		rows, cols, mid, c->a, c->ld);
 }
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-
-
-
-
-
-
-
-
-
-
-dscal_(const unsigned *n, double *da, const double *dx, const unsigned *incx);
-
 void
 diagmul_amatrix(field alpha, bool atrans, pamatrix a, pcavector d)
 {
-  double    beta;
+  field     beta;
   unsigned  j;
 
   if (atrans) {
@@ -1040,7 +1500,7 @@ diagmul_amatrix(field alpha, bool atrans, pamatrix a, pcavector d)
 
     for (j = 0; j < a->rows; j++) {
       beta = CONJ(alpha * d->v[j]);
-      dscal_(&a->cols, &beta, a->a + j, &a->ld);
+      h2_scal(&a->cols, &beta, a->a + j, &a->ld);
     }
   }
   else {
@@ -1051,7 +1511,7 @@ diagmul_amatrix(field alpha, bool atrans, pamatrix a, pcavector d)
 
     for (j = 0; j < a->cols; j++) {
       beta = alpha * d->v[j];
-      dscal_(&a->rows, &beta, a->a + j * a->ld, &u_one);
+      h2_scal(&a->rows, &beta, a->a + j * a->ld, &u_one);
     }
   }
 }
@@ -1085,24 +1545,11 @@ diagmul_amatrix(field alpha, bool atrans, pamatrix a, pcavector d)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-
-
-
-
-
-
-
-
-
-
-dscal_(const unsigned *n, double *da, const double *dx, const unsigned *incx);
-
 void
 bidiagmul_amatrix(field alpha,
 		  bool atrans, pamatrix a, pcavector d, pcavector l)
 {
-  double    beta, gamma;
+  field     beta, gamma;
   unsigned  j;
 
   if (atrans) {
@@ -1114,12 +1561,12 @@ bidiagmul_amatrix(field alpha,
 
     for (j = 0; j + 1 < a->rows; j++) {
       gamma = CONJ(alpha * d->v[j]);
-      dscal_(&a->cols, &gamma, a->a + j, &a->ld);
+      h2_scal(&a->cols, &gamma, a->a + j, &a->ld);
       beta = CONJ(alpha * l->v[j]);
-      daxpy_(&a->cols, &beta, a->a + (j + 1), &a->ld, a->a + j, &a->ld);
+      h2_axpy(&a->cols, &beta, a->a + (j + 1), &a->ld, a->a + j, &a->ld);
     }
     gamma = CONJ(alpha * d->v[j]);
-    dscal_(&a->cols, &gamma, a->a + j, &a->ld);
+    h2_scal(&a->cols, &gamma, a->a + j, &a->ld);
   }
   else {
     assert(a->cols == d->dim);
@@ -1130,13 +1577,13 @@ bidiagmul_amatrix(field alpha,
 
     for (j = 0; j + 1 < a->cols; j++) {
       gamma = alpha * d->v[j];
-      dscal_(&a->rows, &gamma, a->a + j * a->ld, &u_one);
+      h2_scal(&a->rows, &gamma, a->a + j * a->ld, &u_one);
       beta = alpha * l->v[j];
-      daxpy_(&a->rows, &beta, a->a + (j + 1) * a->ld, &u_one,
-	     a->a + j * a->ld, &u_one);
+      h2_axpy(&a->rows, &beta, a->a + (j + 1) * a->ld, &u_one,
+	      a->a + j * a->ld, &u_one);
     }
     gamma = alpha * d->v[j];
-    dscal_(&a->rows, &gamma, a->a + j * a->ld, &u_one);
+    h2_scal(&a->rows, &gamma, a->a + j * a->ld, &u_one);
   }
 }
 #else
@@ -110,6 +110,40 @@ init_sub_amatrix(pamatrix a, pamatrix src,
 HEADER_PREFIX pamatrix
 init_vec_amatrix(pamatrix a, pavector src, uint rows, uint cols);
 
+/** @brief Initialize an @ref amatrix object using an existing array.
+ *
+ *  Sets up the components of the object and uses the given array
+ *  with leading dimension <tt>rows</tt> for the coefficients.
+ *
+ *  @remark Should always be matched by a call to @ref uninit_amatrix that
+ *  will <em>not</em> release the coefficient storage.
+ *
+ *  @param a Object to be initialized.
+ *  @param src Array holding at least <tt>rows*cols</tt> coefficients.
+ *  @param rows Number of rows.
+ *  @param cols Number of columns.
+ *  @returns Initialized @ref amatrix object. */
+HEADER_PREFIX pamatrix
+init_pointer_amatrix(pamatrix a, pfield src, uint rows, uint cols);
+
+/** @brief Initialize an @ref amatrix object using temporary storage
+ *  from the scratch arena of the current thread.
+ *
+ *  Sets up the components of the object and takes the coefficients
+ *  from the scratch arena, see @ref allocscratch.
+ *  The coefficients are not initialized.
+ *
+ *  @remark Should always be matched by a call to @ref uninit_amatrix that
+ *  will <em>not</em> release the coefficient storage.
+ *  The storage is returned to the arena by @ref release_scratch.
+ *
+ *  @param a Object to be initialized.
+ *  @param rows Number of rows.
+ *  @param cols Number of columns.
+ *  @returns Initialized @ref amatrix object. */
+HEADER_PREFIX pamatrix
+init_scratch_amatrix(pamatrix a, uint rows, uint cols);
+
 /** @brief Initialize an @ref amatrix object and set it to zero.
  *
  *  Sets up the components of the object, allocates storage for the
@@ -183,6 +217,21 @@ new_sub_amatrix(pamatrix src,
 		uint rows, uint roff,
 		uint cols, uint coff);
 
+/** @brief Create a new @ref amatrix object using an existing array.
+ *
+ *  Allocates storage for the object, but uses the given array with
+ *  leading dimension <tt>rows</tt> to keep the coefficients.
+ *
+ *  @remark Should always be matched by a call to @ref del_amatrix that
+ *  will <em>not</em> release the coefficient storage.
+ *
+ *  @param src Array holding at least <tt>rows*cols</tt> coefficients.
+ *  @param rows Number of rows.
+ *  @param cols Number of columns.
+ *  @returns New @ref amatrix object. */
+HEADER_PREFIX pamatrix
+new_pointer_amatrix(pfield src, uint rows, uint cols);
+
 /** @brief Create a new @ref amatrix object representing a zero matrix.
  *
  *  Allocates storage for the object and sets all coefficients to
@@ -256,6 +305,27 @@ resize_amatrix(pamatrix a, uint rows, uint cols);
 HEADER_PREFIX void
 resizecopy_amatrix(pamatrix a, uint rows, uint cols);
 
+/** @brief Move the coefficients of an @ref amatrix object into
+ *  storage provided by the caller.
+ *
+ *  The coefficients are copied to <tt>data</tt> with leading dimension
+ *  <tt>a->rows</tt>, the original storage is released and
+ *  <tt>owner</tt> is recorded as the owner of the new storage,
+ *  so it will not be released by @ref uninit_amatrix.
+ *  This allows many matrices to share one contiguous array.
+ *
+ *  @attention Make sure that there are no submatrix objects referring
+ *  to this object, since they might otherwise keep using pointers
+ *  to invalid storage.
+ *
+ *  @param a Matrix owning its storage, i.e., <tt>a->owner==NULL</tt>.
+ *  @param data Target storage for at least <tt>a->rows*a->cols</tt>
+ *         coefficients.
+ *  @param owner Object responsible for releasing <tt>data</tt>,
+ *         must not be null. */
+HEADER_PREFIX void
+move_amatrix(pamatrix a, pfield data, void *owner);
+
 /* ------------------------------------------------------------
    Access methods
    ------------------------------------------------------------ */
@@ -574,6 +644,56 @@ HEADER_PREFIX void
 mvm_amatrix_avector(field alpha, bool atrans, pcamatrix a, pcavector src,
 	    pavector trg);
 
+/* ------------------------------------------------------------
+ Single precision storage
+ ------------------------------------------------------------ */
+
+/** @brief Store the coefficients of a matrix in single precision.
+ *
+ *  @param a Source matrix @f$A@f$.
+ *  @param s Target array with room for <tt>a->rows*a->cols</tt>
+ *    coefficients, the matrix is stored with leading dimension
+ *    <tt>a->rows</tt>. */
+HEADER_PREFIX void
+tosingle_amatrix(pcamatrix a, psfield s);
+
+/** @brief Restore the coefficients of a matrix from single precision.
+ *
+ *  @param s Source array, contains the matrix with leading dimension
+ *    <tt>a->rows</tt>, e.g., filled by @ref tosingle_amatrix.
+ *  @param a Target matrix @f$A@f$. */
+HEADER_PREFIX void
+fromsingle_amatrix(pcsfield s, pamatrix a);
+
+/** @brief Multiply a matrix @f$S@f$ stored in single precision by
+ *  a vector @f$x@f$, @f$y \gets y + \alpha S x@f$.
+ *
+ *  The coefficients are promoted to @ref field on the fly, so
+ *  only the storage of @f$S@f$ is in single precision.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param rows Number of rows of @f$S@f$.
+ *  @param cols Number of columns of @f$S@f$.
+ *  @param s Coefficients of @f$S@f$ with leading dimension <tt>rows</tt>.
+ *  @param src Source vector @f$x@f$.
+ *  @param trg Target vector @f$y@f$. */
+HEADER_PREFIX void
+addeval_single_avector(field alpha, uint rows, uint cols, pcsfield s,
+		       pcavector src, pavector trg);
+
+/** @brief Multiply the adjoint of a matrix @f$S@f$ stored in single
+ *  precision by a vector @f$x@f$, @f$y \gets y + \alpha S^* x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param rows Number of rows of @f$S@f$.
+ *  @param cols Number of columns of @f$S@f$.
+ *  @param s Coefficients of @f$S@f$ with leading dimension <tt>rows</tt>.
+ *  @param src Source vector @f$x@f$.
+ *  @param trg Target vector @f$y@f$. */
+HEADER_PREFIX void
+addevaltrans_single_avector(field alpha, uint rows, uint cols, pcsfield s,
+			    pcavector src, pavector trg);
+
 /** @brief Add two matrices,
  *  @f$B \gets B + \alpha A@f$ or @f$B \gets B + \alpha A^*@f$.
  *
@@ -8,12 +8,16 @@
 
 #include "settings.h"
 #include "basic.h"
+#include "blas.h"
 
 #include <math.h>
 #include <stdio.h>
 
 static uint active_avector = 0;
 
+/* Marks coefficients taken from the scratch arena */
+static char scratch_owner;
+
 /* ------------------------------------------------------------
    Constructors and destructors
    ------------------------------------------------------------ */
@@ -95,6 +99,23 @@ init_pointer_avector(pavector v, pfield src, uint dim)
   return v;
 }
 
+pavector
+init_scratch_avector(pavector v, uint dim)
+{
+  assert(v != NULL);
+
+  v->v = allocscratch(dim);
+  v->dim = dim;
+  v->owner = &scratch_owner;
+
+#ifdef USE_OPENMP
+#pragma omp atomic
+#endif
+  active_avector++;
+
+  return v;
+}
+
 void
 uninit_avector(pavector v)
 {
@@ -226,7 +247,7 @@ random_avector(pavector v)
   uint      i;
 
   for (i = 0; i < v->dim; i++)
-    v->v[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    v->v[i] = FIELD_RAND();
 }
 
 void
@@ -261,9 +282,9 @@ print_avector(pcavector v)
   if (dim == 0)
     return;
 
-  (void) printf("  (% .5e", v->v[0]);
+  (void) printf("  (" FIELD_FMT, FIELD_PRINT(v->v[0]));
   for (i = 1; i < dim; i++)
-    (void) printf(" % .5e", v->v[i]);
+    (void) printf(" " FIELD_FMT, FIELD_PRINT(v->v[i]));
   (void) printf(")\n");
 }
 
@@ -272,19 +293,10 @@ print_avector(pcavector v)
    ------------------------------------------------------------ */
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-
-
-
-
-
-
-
-   dscal_(const unsigned *n, const double *alpha, double *x, const int *incx);
 void
 scale_avector(field alpha, pavector v)
 {
-  dscal_(&v->dim, &alpha, v->v, &i_one);
+  h2_scal(&v->dim, &alpha, v->v, &u_one);
 }
 #else
 void
@@ -298,13 +310,10 @@ scale_avector(field alpha, pavector v)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX double
-          dnrm2_(const unsigned *n, const double *x, const int *incx);
-
 real
 norm2_avector(pcavector v)
 {
-  return dnrm2_(&v->dim, v->v, &i_one);
+  return h2_nrm2(&v->dim, v->v, &u_one);
 }
 #else
 real
@@ -322,26 +331,12 @@ norm2_avector(pcavector v)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX double
-
-
-
-
-
-
-
-
-
-
-ddot_(const unsigned *n,
-      const double *x, const int *incx, const double *y, const int *incy);
-
 field
 dotprod_avector(pcavector x, pcavector y)
 {
   assert(x->dim == y->dim);
 
-  return ddot_(&x->dim, x->v, &i_one, y->v, &i_one);
+  return h2_dot(&x->dim, x->v, &u_one, y->v, &u_one);
 }
 #else
 field
@@ -361,28 +356,12 @@ dotprod_avector(pcavector x, pcavector y)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-
-
-
-
-
-
-
-
-
-
-daxpy_(const unsigned *n,
-       const double *alpha,
-       const double *x,
-       const unsigned *incx, double *y, const unsigned *incy);
-
 void
 add_avector(field alpha, pcavector x, pavector y)
 {
   assert(x->dim == y->dim);
 
-  daxpy_(&x->dim, &alpha, x->v, &u_one, y->v, &u_one);
+  h2_axpy(&x->dim, &alpha, x->v, &u_one, y->v, &u_one);
 }
 #else
 void
@@ -118,6 +118,23 @@ init_column_avector(pavector v, pamatrix src, uint col);
 HEADER_PREFIX pavector
 init_pointer_avector(pavector v, pfield src, uint dim);
 
+/** @brief Initialize an @ref avector object using temporary storage
+ *  from the scratch arena of the current thread.
+ *
+ *  Sets up the components of the object and takes the coefficients
+ *  from the scratch arena, see @ref allocscratch.
+ *  The coefficients are not initialized.
+ *
+ *  @remark Should always be matched by a call to @ref uninit_avector that
+ *  will <em>not</em> release the coefficient storage.
+ *  The storage is returned to the arena by @ref release_scratch.
+ *
+ *  @param v Object to be initialized.
+ *  @param dim Dimension of the new vector.
+ *  @returns Initialized @ref avector object. */
+HEADER_PREFIX pavector
+init_scratch_avector(pavector v, uint dim);
+
 /** @brief Uninitialize an @ref avector object.
  *
  *  Invalidates pointers, freeing corresponding storage if appropriate,
@@ -83,7 +83,17 @@ init_h2lib(int *argc, char ***argv)
 void
 uninit_h2lib()
 {
+  clear_all_scratch();
+}
 
+uint
+getmaxthreads()
+{
+#ifdef USE_OPENMP
+  return (uint) omp_get_max_threads();
+#else
+  return 1;
+#endif
 }
 
 /* ------------------------------------------------------------
@@ -208,6 +218,249 @@ freemem(void *ptr)
   free(ptr);
 }
 
+/* ------------------------------------------------------------
+   Scratch memory
+   ------------------------------------------------------------ */
+
+/* Initial size of a scratch arena, in coefficients */
+#define SCRATCH_MINSIZE 4096
+
+/* Largest block an empty arena keeps for later use, in coefficients.
+   Arenas that have needed more storage return it to the heap. */
+#define SCRATCH_MAXKEEP 1048576
+
+typedef struct _scratchblock scratchblock;
+typedef scratchblock *pscratchblock;
+
+typedef struct _scratcharena scratcharena;
+typedef scratcharena *pscratcharena;
+
+/* Block of a scratch arena. If a block is full, a larger one is
+   started and the older one is kept until its storage is released. */
+struct _scratchblock {
+  /* Storage of this block */
+  field    *data;
+  /* Number of coefficients in this block */
+  size_t    size;
+  /* Number of coefficients in use */
+  size_t    used;
+  /* Number of coefficients in use in older blocks */
+  size_t    base;
+  /* Next older block */
+  pscratchblock prev;
+};
+
+/* Scratch arena of one thread */
+struct _scratcharena {
+  /* Newest block */
+  pscratchblock top;
+  /* Peak usage */
+  size_t    peak;
+  /* Next arena in the list of all arenas */
+  pscratcharena next;
+};
+
+/* Arena of the current thread */
+static pscratcharena scratch = NULL;
+
+#ifdef USE_OPENMP
+#pragma omp threadprivate(scratch)
+#endif
+
+/* List of the arenas of all threads, so that uninit_h2lib can release
+   the storage of worker threads. The arenas themselves are kept, since
+   the threads still refer to them. */
+static pscratcharena scratch_all = NULL;
+
+/* Peak usage of all arenas */
+static size_t scratch_maxpeak = 0;
+
+static    pscratchblock
+new_scratchblock(size_t size, pscratchblock prev, const char *filename,
+		 int line)
+{
+  pscratchblock b;
+
+  b = (pscratchblock) _h2_allocmem(sizeof(scratchblock), filename, line);
+  b->data = _h2_allocfield(size, filename, line);
+  b->size = size;
+  b->used = 0;
+  b->base = (prev ? prev->base + prev->used : 0);
+  b->prev = prev;
+
+  return b;
+}
+
+static void
+del_scratchblock(pscratchblock b)
+{
+  freemem(b->data);
+  freemem(b);
+}
+
+static void
+del_scratchblocks(pscratcharena sa)
+{
+  pscratchblock b;
+
+  while (sa->top) {
+    b = sa->top;
+    sa->top = b->prev;
+    del_scratchblock(b);
+  }
+}
+
+field    *
+_h2_allocscratch(size_t sz, const char *filename, int line)
+{
+  pscratcharena sa;
+  pscratchblock b;
+  field    *ptr;
+  size_t    size, total;
+
+  if (sz == 0)
+    return NULL;
+
+  sa = scratch;
+
+  /* Set up the arena of this thread on first use */
+  if (sa == NULL) {
+    sa = scratch = (pscratcharena) _h2_allocmem(sizeof(scratcharena),
+						filename, line);
+    sa->top = NULL;
+    sa->peak = 0;
+
+#ifdef USE_OPENMP
+#pragma omp critical(scratch)
+#endif
+    {
+      sa->next = scratch_all;
+      scratch_all = sa;
+    }
+  }
+
+  b = sa->top;
+
+  /* Start a new block if the current one is too small */
+  if (b == NULL || b->used + sz > b->size) {
+    size = (b ? 2 * b->size : SCRATCH_MINSIZE);
+    while (size < sz)
+      size *= 2;
+
+    b = sa->top = new_scratchblock(size, b, filename, line);
+  }
+
+  ptr = b->data + b->used;
+  b->used += sz;
+
+  /* Update statistics */
+  total = b->base + b->used;
+  if (total > sa->peak) {
+    sa->peak = total;
+
+#ifdef USE_OPENMP
+#pragma omp critical(scratch)
+#endif
+    if (total > scratch_maxpeak)
+      scratch_maxpeak = total;
+  }
+
+  return ptr;
+}
+
+size_t
+mark_scratch()
+{
+  return (scratch && scratch->top ? scratch->top->base + scratch->top->used
+	  : 0);
+}
+
+void
+release_scratch(size_t mark)
+{
+  pscratcharena sa;
+  pscratchblock b;
+
+  sa = scratch;
+  if (sa == NULL || sa->top == NULL)
+    return;
+
+  b = sa->top;
+
+  assert(mark <= b->base + b->used);
+
+  /* Remove blocks that have been started after the mark */
+  while (b->prev && b->base > mark) {
+    sa->top = b->prev;
+    del_scratchblock(b);
+    b = sa->top;
+  }
+
+  b->used = mark - b->base;
+
+  /* If the arena is empty, replace it by one block that is large
+     enough for the peak usage, so no blocks have to be added in the
+     future. Arenas with a very large peak return their storage to the
+     heap instead of keeping it. */
+  if (mark == 0 && (b->prev || b->size < sa->peak
+		    || b->size > SCRATCH_MAXKEEP)) {
+    del_scratchblocks(sa);
+
+    if (sa->peak <= SCRATCH_MAXKEEP)
+      sa->top = new_scratchblock(sa->peak, NULL, __FILE__, __LINE__);
+  }
+}
+
+void
+clear_scratch()
+{
+  assert(mark_scratch() == 0);
+
+  if (scratch)
+    del_scratchblocks(scratch);
+}
+
+void
+clear_all_scratch()
+{
+  pscratcharena sa;
+
+#ifdef USE_OPENMP
+  assert(!omp_in_parallel());
+#endif
+
+  for (sa = scratch_all; sa; sa = sa->next) {
+    assert(sa->top == NULL || sa->top->base + sa->top->used == 0);
+
+    del_scratchblocks(sa);
+  }
+}
+
+size_t
+getsize_scratch()
+{
+  pscratcharena sa;
+  pscratchblock b;
+  size_t    sz;
+
+  sz = 0;
+
+#ifdef USE_OPENMP
+#pragma omp critical(scratch)
+#endif
+  for (sa = scratch_all; sa; sa = sa->next)
+    for (b = sa->top; b; b = b->prev)
+      sz += b->size;
+
+  return sz * sizeof(field);
+}
+
+size_t
+getpeak_scratch()
+{
+  return scratch_maxpeak * sizeof(field);
+}
+
 /* ------------------------------------------------------------
    Sorting
    ------------------------------------------------------------ */
@@ -72,6 +72,12 @@ init_h2lib(int *argc, char ***argv);
 HEADER_PREFIX void
 uninit_h2lib();
 
+/** @brief Get the maximal number of threads used in parallel regions.
+ *
+ *  @returns Maximal number of threads, 1 if OpenMP is not used. */
+HEADER_PREFIX uint
+getmaxthreads();
+
 /* ------------------------------------------------------------
    General utility macros and functions
    ------------------------------------------------------------ */
@@ -86,6 +92,16 @@ uninit_h2lib();
 
 /* Macros for the type "field" */
 
+#ifdef USE_COMPLEX
+/** @brief Compute the complex conjugate @f$\bar x@f$ of a field element @f$x@f$. */
+#define CONJ(x) conj(x)
+
+/** @brief Get the real part @f$a@f$ of a field element @f$x=a+ib@f$. */
+#define REAL(x) creal(x)
+
+/** @brief Get the imaginary part @f$b@f$ of a field element @f$x=a+ib@f$. */
+#define IMAG(x) cimag(x)
+#else
 /** @brief Compute the complex conjugate @f$\bar x@f$ of a field element @f$x@f$. */
 #define CONJ(x) (x)
 
@@ -94,16 +110,40 @@ uninit_h2lib();
 
 /** @brief Get the imaginary part @f$b@f$ of a field element @f$x=a+ib@f$. */
 #define IMAG(x) 0
+#endif
 
 /** @brief Compute the square of the absolute value @f$|x|^2@f$ of a field element @f$x@f$. */
 #define ABSSQR(x) _h2_abssqr(x)
 
 /** @brief Compute the absolute value @f$|x|@f$ of a field element @f$x@f$. */
+#ifdef USE_COMPLEX
+#define ABS(x) cabs(x)
+#else
 #define ABS(x) fabs(x)
+#endif
 
 /** @brief Compute the sign @f$\mathop{\rm sgn}(x)@f$ of a field element @f$x@f$. */
 #define SIGN(x) _h2_sgn(x)
 
+/** @brief Draw a random field element with real and imaginary parts
+ *  uniformly distributed in @f$[-1,1]@f$. */
+#ifdef USE_COMPLEX
+#define FIELD_RAND() (2.0 * rand() / RAND_MAX - 1.0 \
+		      + (2.0 * rand() / RAND_MAX - 1.0) * _Complex_I)
+#else
+#define FIELD_RAND() (2.0 * rand() / RAND_MAX - 1.0)
+#endif
+
+/** @brief <tt>printf</tt> format for a field element, the arguments
+ *  are provided by @ref FIELD_PRINT. */
+#ifdef USE_COMPLEX
+#define FIELD_FMT "% .5e%+.5ei"
+#define FIELD_PRINT(x) REAL(x), IMAG(x)
+#else
+#define FIELD_FMT "% .5e"
+#define FIELD_PRINT(x) (x)
+#endif
+
 /* Macros for the type "real" */
 
 /** @brief Compute the absolute value @f$|x|@f$ of a real number @f$x@f$. */
@@ -171,7 +211,11 @@ INLINE_PREFIX uint _h2_uintmin3(uint a, uint b, uint c) __attribute__((unused,co
 INLINE_PREFIX real
 _h2_abssqr(field x)
 {
+#ifdef USE_COMPLEX
+  return creal(x) * creal(x) + cimag(x) * cimag(x);
+#else
   return x*x;
+#endif
 }
 
 /** @brief Compute the sign @f$\mathop{\rm sgn}(x)@f$ of a field element @f$x@f$.
@@ -181,7 +225,13 @@ _h2_abssqr(field x)
 INLINE_PREFIX field
 _h2_sgn(field x)
 {
+#ifdef USE_COMPLEX
+  real      norm = cabs(x);
+
+  return (norm > 0.0 ? x / norm : 1.0);
+#else
   return (x < 0.0 ? -1.0 : 1.0);
+#endif
 }
 
 /** @brief Compute the square @f$x^2@f$ of a real number @f$x@f$.
@@ -381,6 +431,83 @@ _h2_allocmatrix(size_t rows, size_t cols, const char *filename, int line);
 void
 freemem(void *ptr);
 
+/* ------------------------------------------------------------
+   Scratch memory
+   ------------------------------------------------------------ */
+
+/** @brief Allocate temporary storage of type @ref field from the
+ *  scratch arena of the current thread.
+ *
+ *  The scratch arena works like a stack: the current position is
+ *  obtained by @ref mark_scratch, and all storage allocated after
+ *  this point is released at once by @ref release_scratch.
+ *  Once the arena has grown large enough, no further heap allocations
+ *  are required, and since every thread uses its own arena, there is
+ *  no contention in parallel algorithms.
+ *
+ *  @param sz Number of @ref field variables.
+ *  @returns Pointer to <tt>sz</tt> variables of type @ref field. */
+#define allocscratch(sz) _h2_allocscratch(sz,__FILE__,__LINE__)
+/** @brief Allocate temporary storage of type @ref field from the
+ *  scratch arena of the current thread.
+ *
+ *  @param sz Number of @ref field variables.
+ *  @param filename Name of source file (used for error messages).
+ *  @param line Line number in source file.
+ *  @returns Pointer to <tt>sz</tt> variables of type @ref field. */
+field *
+_h2_allocscratch(size_t sz, const char *filename, int line);
+
+/** @brief Get the current position of the scratch arena of the
+ *  current thread.
+ *
+ *  @returns Mark that can be passed to @ref release_scratch. */
+HEADER_PREFIX size_t
+mark_scratch();
+
+/** @brief Release all scratch storage of the current thread that
+ *  has been allocated after a given mark.
+ *
+ *  Marks have to be released in reverse order.
+ *  Once the arena is empty, it keeps a single block for its peak usage
+ *  if this usage is below a fixed limit of a few megabytes, otherwise
+ *  all of its storage is returned to the heap.
+ *
+ *  @param mark Mark obtained by @ref mark_scratch. */
+HEADER_PREFIX void
+release_scratch(size_t mark);
+
+/** @brief Return the storage of the scratch arena of the current
+ *  thread to the heap.
+ *
+ *  All scratch storage of the current thread has to be released
+ *  before calling this function. */
+HEADER_PREFIX void
+clear_scratch();
+
+/** @brief Return the storage of the scratch arenas of all threads to
+ *  the heap.
+ *
+ *  Called by @ref uninit_h2lib, must not be called in a parallel
+ *  region. All scratch storage has to be released before calling this
+ *  function. */
+HEADER_PREFIX void
+clear_all_scratch();
+
+/** @brief Get the storage currently held by the scratch arenas.
+ *
+ *  @returns Number of bytes held by the scratch arenas of all
+ *     threads. */
+HEADER_PREFIX size_t
+getsize_scratch();
+
+/** @brief Get the peak size of the scratch arenas.
+ *
+ *  @returns Largest number of bytes used by the scratch arena of
+ *     any thread. */
+HEADER_PREFIX size_t
+getpeak_scratch();
+
 /* ------------------------------------------------------------
    Sorting
    ------------------------------------------------------------ */
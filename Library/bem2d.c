@@ -255,6 +255,8 @@ struct _parbem2d {
   uint      grbnn;
   pgreenclusterbasis2d *gcbn;
   uint      gcbnn;
+  real     *ttime;		/* time spent by each thread in the last assembly */
+  uint      ttimen;		/* number of entries of ttime */
 };
 
 struct _greencluster2d {
@@ -509,6 +511,8 @@ new_parbem2d()
   par->grbnn = 0;
   par->gcbn = NULL;
   par->gcbnn = 0;
+  par->ttime = NULL;
+  par->ttimen = 0;
 
   return par;
 }
@@ -586,6 +590,10 @@ del_parbem2d(pparbem2d par)
     freemem(par->gcbn);
   }
 
+  if (par->ttime != NULL) {
+    freemem(par->ttime);
+  }
+
   freemem(par);
 }
 
@@ -769,7 +777,7 @@ build_bem2d_cluster(pcbem2d bem, uint clf, basisfunctionbem2d basis)
     n = bem->gr->vertices;
   }
 
-  c = build_adaptive_cluster(cg, n, idx, clf);
+  c = build_parallel_cluster(cg, n, idx, clf, H2_ADAPTIVE, max_pardepth);
 
   del_clustergeometry(cg);
 
@@ -1404,14 +1412,15 @@ assemble_bem2d_greenhybrid_row_rkmatrix(pccluster rc, uint rname,
 
   (void) cname;
 
-  grc = par->grcn[rname];
-
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (grc == NULL) {
-    grc = par->grcn[rname] = new_greencluster2d(rc);
-    assemble_row_greencluster2d(bem, grc);
+  {
+    grc = par->grcn[rname];
+    if (grc == NULL) {
+      grc = par->grcn[rname] = new_greencluster2d(rc);
+      assemble_row_greencluster2d(bem, grc);
+    }
   }
 
   V = grc->V;
@@ -1509,14 +1518,15 @@ assemble_bem2d_greenhybrid_col_rkmatrix(pccluster rc, uint rname,
 
   (void) rname;
 
-  gcc = par->gccn[cname];
-
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (gcc == NULL) {
-    gcc = par->gccn[cname] = new_greencluster2d(cc);
-    assemble_col_greencluster2d(bem, gcc);
+  {
+    gcc = par->gccn[cname];
+    if (gcc == NULL) {
+      gcc = par->gccn[cname] = new_greencluster2d(cc);
+      assemble_col_greencluster2d(bem, gcc);
+    }
   }
 
   V = gcc->V;
@@ -1545,23 +1555,26 @@ assemble_bem2d_greenhybrid_mixed_rkmatrix(pccluster rc, uint rname,
   uint     *xihatV, *xihatW;
   uint      rankV, rankW;
 
-  grc = par->grcn[rname];
-  gcc = par->gccn[cname];
-
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (grc == NULL) {
-    grc = par->grcn[rname] = new_greencluster2d(rc);
-    assemble_row_greencluster2d(bem, grc);
+  {
+    grc = par->grcn[rname];
+    if (grc == NULL) {
+      grc = par->grcn[rname] = new_greencluster2d(rc);
+      assemble_row_greencluster2d(bem, grc);
+    }
   }
 
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (gcc == NULL) {
-    gcc = par->gccn[cname] = new_greencluster2d(cc);
-    assemble_col_greencluster2d(bem, gcc);
+  {
+    gcc = par->gccn[cname];
+    if (gcc == NULL) {
+      gcc = par->gccn[cname] = new_greencluster2d(cc);
+      assemble_col_greencluster2d(bem, gcc);
+    }
   }
 
   rankV = grc->V->cols;
@@ -1647,7 +1660,8 @@ assemble_bem2d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
   const uint cols = cc->size;
 
   prkmatrix R2;
-  pamatrix  S, C, D;
+  amatrix   tmp;
+  pamatrix  S, Sk, C, D;
   real(*IT)[2], (*IS)[2], (*ITk)[2], (*ISk)[2];
   uint     *I_k, *J_k;
   uint      i, j, rank;
@@ -1680,10 +1694,11 @@ assemble_bem2d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
     }
   }
 
-  resize_amatrix(S, rank, rank);
+  /* Use the leading part of S instead of allocating a new matrix */
+  Sk = init_sub_amatrix(&tmp, S, rank, 0, rank, 0);
 
-  copy_lower_aca_amatrix(true, C, I_k, S);
-  copy_upper_aca_amatrix(false, D, J_k, S);
+  copy_lower_aca_amatrix(true, C, I_k, Sk);
+  copy_upper_aca_amatrix(false, D, J_k, Sk);
 
   resize_rkmatrix(R, rows, cols, rank);
 
@@ -1691,14 +1706,15 @@ assemble_bem2d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
   kernels->kernel_col(cidx, (const real(*)[2]) ITk, bem, &R->B);
 
   if (rows < cols) {
-    triangularsolve_amatrix(false, false, true, S, true, &R->A);
-    triangularsolve_amatrix(true, true, true, S, true, &R->A);
+    triangularsolve_amatrix(false, false, true, Sk, true, &R->A);
+    triangularsolve_amatrix(true, true, true, Sk, true, &R->A);
   }
   else {
-    triangularsolve_amatrix(true, true, false, S, true, &R->B);
-    triangularsolve_amatrix(false, false, false, S, true, &R->B);
+    triangularsolve_amatrix(true, true, false, Sk, true, &R->B);
+    triangularsolve_amatrix(false, false, false, Sk, true, &R->B);
   }
 
+  uninit_amatrix(Sk);
   del_rkmatrix(R2);
   del_amatrix(S);
   freemem(IT);
@@ -3612,6 +3628,37 @@ setup_h2matrix_aprx_greenhybrid_ortho_bem2d(pbem2d bem, pcclusterbasis rb,
   par->gcbnn = n;
 }
 
+/* ------------------------------------------------------------
+ Per-thread timing of the assembly
+ ------------------------------------------------------------ */
+
+static real *
+threadtimes_bem2d(pparbem2d par)
+{
+  uint      threads;
+
+  threads = getmaxthreads();
+  if (par->ttimen != threads) {
+    if (par->ttime != NULL) {
+      freemem(par->ttime);
+    }
+    par->ttime = (real *) allocmem((size_t) sizeof(real) * threads);
+    par->ttimen = threads;
+  }
+
+  return par->ttime;
+}
+
+const real *
+getthreadtimes_bem2d(pcbem2d bem, uint * threads)
+{
+  pcparbem2d par = bem->par;
+
+  *threads = par->ttimen;
+
+  return par->ttime;
+}
+
 /* ------------------------------------------------------------
  Methods to fill hmatrices
  ------------------------------------------------------------ */
@@ -3678,8 +3725,8 @@ assemble_bem2d_hmatrix(pbem2d bem, pblock b, phmatrix G)
 
   par->hn = enumerate_hmatrix(b, G);
 
-  iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
-		      assemble_bem2d_block_hmatrix, bem);
+  iterate_leaves_block(b, 0, 0, 0, max_pardepth, NULL,
+		       assemble_bem2d_block_hmatrix, bem, threadtimes_bem2d(par));
 
   freemem(par->hn);
   par->hn = NULL;
@@ -3821,8 +3868,8 @@ assemble_bem2d_h2matrix(pbem2d bem, pblock b, ph2matrix G)
   pparbem2d par = bem->par;
   par->h2n = enumerate_h2matrix(b, G);
 
-  iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
-		      assemble_bem2d_block_h2matrix, bem);
+  iterate_leaves_block(b, 0, 0, 0, max_pardepth, NULL,
+		       assemble_bem2d_block_h2matrix, bem, threadtimes_bem2d(par));
 
   freemem(par->h2n);
   par->h2n = NULL;
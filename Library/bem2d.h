@@ -1803,6 +1803,25 @@ HEADER_PREFIX void setup_h2matrix_aprx_greenhybrid_ortho_bem2d(pbem2d bem,
     pcclusterbasis rb, pcclusterbasis cb, pcblock tree, uint m, uint l,
     real delta, real accur, quadpoints2d quadpoints);
 
+/* ------------------------------------------------------------
+ Per-thread timing of the assembly
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Get the time each thread spent in the last call of
+ * @ref assemble_bem2d_hmatrix or @ref assemble_bem2d_h2matrix.
+ *
+ * Both functions distribute the leaves of the block tree by a dynamic
+ * work queue, so large differences between the threads indicate that
+ * a few blocks dominate the assembly.
+ *
+ * @param bem @ref _bem2d "bem2d" object used for the assembly.
+ * @param threads Number of entries of the returned array.
+ * @returns Time in seconds spent by each thread, <tt>NULL</tt> if
+ * no matrix has been assembled yet.
+ */
+HEADER_PREFIX const real *getthreadtimes_bem2d(pcbem2d bem, uint *threads);
+
 /* ------------------------------------------------------------
  Fill hmatrix
  ------------------------------------------------------------ */
@@ -252,6 +252,8 @@ struct _parbem3d {
   uint      grbnn;
   pgreenclusterbasis3d *gcbn;
   uint      gcbnn;
+  real     *ttime;		/* time spent by each thread in the last assembly */
+  uint      ttimen;		/* number of entries of ttime */
 };
 
 struct _greencluster3d {
@@ -537,6 +539,8 @@ new_parbem3d()
   par->grbnn = 0;
   par->gcbn = NULL;
   par->gcbnn = 0;
+  par->ttime = NULL;
+  par->ttimen = 0;
 
   return par;
 }
@@ -614,6 +618,10 @@ del_parbem3d(pparbem3d par)
     freemem(par->gcbn);
   }
 
+  if (par->ttime != NULL) {
+    freemem(par->ttime);
+  }
+
   freemem(par);
 }
 
@@ -626,6 +634,7 @@ new_bem3d(pcsurface3d gr)
 
   bem->gr = gr;
 
+  bem->sqc = NULL;
   bem->mass = NULL;
   bem->v2t = NULL;
   bem->alpha = 0.0;
@@ -663,6 +672,10 @@ del_bem3d(pbem3d bem)
     del_singquad2d(bem->sq);
   }
 
+  if (bem->sqc != NULL) {
+    unref_singquadcache2d(bem->sqc);
+  }
+
   del_aprxbem3d(bem->aprx);
   del_kernelbem3d(bem->kernels);
   del_parbem3d(bem->par);
@@ -680,6 +693,22 @@ del_bem3d(pbem3d bem)
   freemem(bem);
 }
 
+psingquadcache2d
+setup_singquadcache_bem3d(pbem3d bem, psingquadcache2d sc)
+{
+  pcsurface3d gr = bem->gr;
+
+  if (sc == NULL)
+    sc = build_singquadcache2d(gr->triangles, gr->vertices,
+			       (const uint(*)[3]) gr->t);
+
+  assert(sc->triangles == gr->triangles);
+
+  ref_singquadcache2d(&bem->sqc, sc);
+
+  return sc;
+}
+
 pvert_list
 new_vert_list(pvert_list next)
 {
@@ -906,7 +935,7 @@ build_bem3d_cluster(pcbem3d bem, uint clf, basisfunctionbem3d basis)
     n = bem->gr->vertices;
   }
 
-  c = build_adaptive_cluster(cg, n, idx, clf);
+  c = build_parallel_cluster(cg, n, idx, clf, H2_ADAPTIVE, max_pardepth);
 
   del_clustergeometry(cg);
 
@@ -1540,14 +1569,15 @@ assemble_bem3d_greenhybrid_row_rkmatrix(pccluster rc, uint rname,
 
   (void) cname;
 
-  grc = par->grcn[rname];
-
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (grc == NULL) {
-    grc = par->grcn[rname] = new_greencluster3d(rc);
-    assemble_row_greencluster3d(bem, grc);
+  {
+    grc = par->grcn[rname];
+    if (grc == NULL) {
+      grc = par->grcn[rname] = new_greencluster3d(rc);
+      assemble_row_greencluster3d(bem, grc);
+    }
   }
 
   V = grc->V;
@@ -1643,14 +1673,15 @@ assemble_bem3d_greenhybrid_col_rkmatrix(pccluster rc, uint rname,
 
   (void) rname;
 
-  gcc = par->gccn[cname];
-
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (gcc == NULL) {
-    gcc = par->gccn[cname] = new_greencluster3d(cc);
-    assemble_col_greencluster3d(bem, gcc);
+  {
+    gcc = par->gccn[cname];
+    if (gcc == NULL) {
+      gcc = par->gccn[cname] = new_greencluster3d(cc);
+      assemble_col_greencluster3d(bem, gcc);
+    }
   }
 
   V = gcc->V;
@@ -1681,23 +1712,26 @@ assemble_bem3d_greenhybrid_mixed_rkmatrix(pccluster rc, uint rname,
   uint     *xihatV, *xihatW;
   uint      rankV, rankW;
 
-  grc = par->grcn[rname];
-  gcc = par->gccn[cname];
-
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (grc == NULL) {
-    grc = par->grcn[rname] = new_greencluster3d(rc);
-    assemble_row_greencluster3d(bem, grc);
+  {
+    grc = par->grcn[rname];
+    if (grc == NULL) {
+      grc = par->grcn[rname] = new_greencluster3d(rc);
+      assemble_row_greencluster3d(bem, grc);
+    }
   }
 
 #ifdef USE_OPENMP
 #pragma omp critical
 #endif
-  if (gcc == NULL) {
-    gcc = par->gccn[cname] = new_greencluster3d(cc);
-    assemble_col_greencluster3d(bem, gcc);
+  {
+    gcc = par->gccn[cname];
+    if (gcc == NULL) {
+      gcc = par->gccn[cname] = new_greencluster3d(cc);
+      assemble_col_greencluster3d(bem, gcc);
+    }
   }
 
   rankV = grc->V->cols;
@@ -1787,7 +1821,8 @@ assemble_bem3d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
   const uint cols = cc->size;
 
   prkmatrix R2;
-  pamatrix  S, C, D;
+  amatrix   tmp;
+  pamatrix  S, Sk, C, D;
   real(*IT)[3], (*IS)[3], (*ITk)[3], (*ISk)[3];
   uint     *I_k, *J_k;
   uint      i, j, rank;
@@ -1820,10 +1855,11 @@ assemble_bem3d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
     }
   }
 
-  resize_amatrix(S, rank, rank);
+  /* Use the leading part of S instead of allocating a new matrix */
+  Sk = init_sub_amatrix(&tmp, S, rank, 0, rank, 0);
 
-  copy_lower_aca_amatrix(true, C, I_k, S);
-  copy_upper_aca_amatrix(false, D, J_k, S);
+  copy_lower_aca_amatrix(true, C, I_k, Sk);
+  copy_upper_aca_amatrix(false, D, J_k, Sk);
 
   resize_rkmatrix(R, rows, cols, rank);
 
@@ -1831,14 +1867,15 @@ assemble_bem3d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
   kernels->kernel_col(cidx, (const real(*)[3]) ITk, bem, &R->B);
 
   if (rows < cols) {
-    triangularsolve_amatrix(false, false, true, S, true, &R->A);
-    triangularsolve_amatrix(true, true, true, S, true, &R->A);
+    triangularsolve_amatrix(false, false, true, Sk, true, &R->A);
+    triangularsolve_amatrix(true, true, true, Sk, true, &R->A);
   }
   else {
-    triangularsolve_amatrix(true, true, false, S, true, &R->B);
-    triangularsolve_amatrix(false, false, false, S, true, &R->B);
+    triangularsolve_amatrix(true, true, false, Sk, true, &R->B);
+    triangularsolve_amatrix(false, false, false, Sk, true, &R->B);
   }
 
+  uninit_amatrix(Sk);
   del_rkmatrix(R2);
   del_amatrix(S);
   freemem(IT);
@@ -3344,7 +3381,7 @@ assemble_bem3d_dn_lagrange_linear_amatrix(const uint * idx, pcavector px,
   real      gs, sum, lagrx, lagry, lagrz, x, y, z, tx, sx, Ax, Bx, Cx;
   longindex ii, vv;
 
-  quad = allocfield(bem->sq->n_single);
+  quad = allocreal(bem->sq->n_single);
 
   clear_amatrix(V);
 
@@ -4322,6 +4359,382 @@ setup_h2matrix_aprx_greenhybrid_ortho_bem3d(pbem3d bem, pcclusterbasis rb,
   par->gcbnn = n;
 }
 
+/* ------------------------------------------------------------
+ Automatic parameter tuning
+ ------------------------------------------------------------ */
+
+/* Measurements shorter than this are repeated to reduce the influence
+ * of the resolution of the stopwatch */
+#define AUTOTUNE_MIN_TIME 0.02
+
+/* Upper bound for the number of repetitions of a measurement */
+#define AUTOTUNE_MAX_REPS 256
+
+struct _tuneleaf {
+  pcblock   b;
+  uint      rname;
+  uint      cname;
+};
+
+struct _tunedata {
+  pbem3d    bem;
+  struct _tuneleaf *near;
+  uint      nearn;
+  struct _tuneleaf *far;
+  uint      farn;
+  uint      samples;
+  pamatrix *N;
+  prkmatrix *R;
+};
+
+static void
+collect_tuneleaf(pcblock b, uint bname, uint rname, uint cname,
+		 uint pardepth, void *data)
+{
+  struct _tunedata *td = (struct _tunedata *) data;
+  struct _tuneleaf *tl;
+
+  (void) bname;
+  (void) pardepth;
+
+  if (b->son)
+    return;
+
+  tl = (b->a ? td->far + td->farn++ : td->near + td->nearn++);
+  tl->b = b;
+  tl->rname = rname;
+  tl->cname = cname;
+}
+
+/* Pick the i-th of n samples evenly distributed among m leaves */
+static    uint
+sample_index(uint i, uint n, uint m)
+{
+  return (uint) (((size_t) i * m) / n);
+}
+
+static void
+run_nearfield_autotune(struct _tunedata *td)
+{
+  pbem3d    bem = td->bem;
+  struct _tuneleaf *tl;
+  uint      i;
+
+  for (i = 0; i < td->samples; i++) {
+    tl = td->near + sample_index(i, td->samples, td->nearn);
+    bem->nearfield(tl->b->rc->idx, tl->b->cc->idx, bem, false, td->N[i]);
+  }
+}
+
+static void
+run_farfield_autotune(struct _tunedata *td)
+{
+  pbem3d    bem = td->bem;
+  struct _tuneleaf *tl;
+  uint      i;
+
+  for (i = 0; i < td->samples; i++) {
+    tl = td->far + sample_index(i, td->samples, td->farn);
+    bem->farfield_rk(tl->b->rc, tl->rname, tl->b->cc, tl->cname, bem,
+		     td->R[i]);
+  }
+}
+
+/* Average time of one call of run(td), repeated until the stopwatch
+ * has a chance to measure it */
+static    real
+measure_autotune(void (*run) (struct _tunedata * td), struct _tunedata *td,
+		 pstopwatch sw)
+{
+  uint      reps, i;
+  real      t;
+
+  reps = 1;
+  while (1) {
+    start_stopwatch(sw);
+    for (i = 0; i < reps; i++)
+      run(td);
+    t = stop_stopwatch(sw);
+
+    if (t >= AUTOTUNE_MIN_TIME || reps >= AUTOTUNE_MAX_REPS)
+      break;
+
+    reps *= 2;
+  }
+
+  return t / reps;
+}
+
+static void
+setup_aprx_autotune(pbem3d bem, aprxfamilybem3d family, pccluster rc,
+		    pccluster cc, pcblock b, uint m, real eps_aca)
+{
+  switch (family) {
+  case APRX_INTER_ROW_BEM3D:
+    setup_hmatrix_aprx_inter_row_bem3d(bem, rc, cc, b, m);
+    break;
+  case APRX_INTER_COL_BEM3D:
+    setup_hmatrix_aprx_inter_col_bem3d(bem, rc, cc, b, m);
+    break;
+  case APRX_INTER_MIXED_BEM3D:
+    setup_hmatrix_aprx_inter_mixed_bem3d(bem, rc, cc, b, m);
+    break;
+  case APRX_ACA_BEM3D:
+    setup_hmatrix_aprx_aca_bem3d(bem, rc, cc, b, eps_aca);
+    break;
+  case APRX_PACA_BEM3D:
+    setup_hmatrix_aprx_paca_bem3d(bem, rc, cc, b, eps_aca);
+    break;
+  case APRX_HCA_BEM3D:
+    setup_hmatrix_aprx_hca_bem3d(bem, rc, cc, b, m, eps_aca);
+    break;
+  default:
+    fprintf(stderr, "Unknown approximation family %d\n", (int) family);
+    abort();
+  }
+}
+
+/* Compute the sampled nearfield blocks and return the time required
+ * for all nearfield blocks */
+static    real
+estimate_nearfield_autotune(struct _tunedata *td, size_t nearentries,
+			    pstopwatch sw)
+{
+  struct _tuneleaf *tl;
+  size_t    sampled;
+  real      t;
+  uint      i;
+
+  if (td->nearn == 0)
+    return 0.0;
+
+  td->samples = UINT_MIN(td->samples, td->nearn);
+
+  sampled = 0;
+  for (i = 0; i < td->samples; i++) {
+    tl = td->near + sample_index(i, td->samples, td->nearn);
+    td->N[i] = new_amatrix(tl->b->rc->size, tl->b->cc->size);
+    sampled += (size_t) tl->b->rc->size * tl->b->cc->size;
+  }
+
+  t = measure_autotune(run_nearfield_autotune, td, sw);
+
+  for (i = 0; i < td->samples; i++)
+    del_amatrix(td->N[i]);
+
+  return t * nearentries / sampled;
+}
+
+/* Compute the sampled farfield blocks, determine their maximal relative
+ * error and average rank and return the time required for all farfield
+ * blocks */
+static    real
+estimate_farfield_autotune(struct _tunedata *td, size_t farsize,
+			   pstopwatch sw, real * error, real * rank)
+{
+  pbem3d    bem = td->bem;
+  struct _tuneleaf *tl;
+  pamatrix  G;
+  size_t    sampled;
+  real      t, norm, ranksum;
+  uint      i;
+
+  *error = 0.0;
+  *rank = 0.0;
+
+  if (td->farn == 0)
+    return 0.0;
+
+  td->samples = UINT_MIN(td->samples, td->farn);
+
+  sampled = 0;
+  for (i = 0; i < td->samples; i++) {
+    tl = td->far + sample_index(i, td->samples, td->farn);
+    td->R[i] = new_rkmatrix(tl->b->rc->size, tl->b->cc->size, 0);
+    sampled += (size_t) tl->b->rc->size + tl->b->cc->size;
+  }
+
+  t = measure_autotune(run_farfield_autotune, td, sw);
+
+  ranksum = 0.0;
+  for (i = 0; i < td->samples; i++) {
+    tl = td->far + sample_index(i, td->samples, td->farn);
+
+    G = new_amatrix(tl->b->rc->size, tl->b->cc->size);
+    bem->nearfield(tl->b->rc->idx, tl->b->cc->idx, bem, false, G);
+    norm = normfrob_amatrix(G);
+
+    addmul_amatrix(-1.0, false, &td->R[i]->A, true, &td->R[i]->B, G);
+    if (norm > 0.0)
+      *error = REAL_MAX(*error, normfrob_amatrix(G) / norm);
+
+    ranksum += td->R[i]->k;
+
+    del_amatrix(G);
+    del_rkmatrix(td->R[i]);
+  }
+  *rank = ranksum / td->samples;
+
+  return t * farsize / sampled;
+}
+
+/* Compare two candidates: accurate ones win, among them the fastest */
+static    bool
+better_autotune(pcautotunebem3d a, pcautotunebem3d b, real accur)
+{
+  bool      aokay = (a->error <= accur);
+  bool      bokay = (b->error <= accur);
+
+  if (aokay != bokay)
+    return aokay;
+
+  if (aokay)
+    return (a->time < b->time);
+
+  return (a->error < b->error);
+}
+
+bool
+autotune_hmatrix_bem3d(pbem3d bem, aprxfamilybem3d family,
+		       basisfunctionbem3d row_basis,
+		       basisfunctionbem3d col_basis, uint nclf,
+		       const uint * clf, uint neta, const real * eta,
+		       uint nm, const uint * m, uint neps,
+		       const real * eps_aca, real accur, uint samples,
+		       pautotunebem3d at)
+{
+  struct _tunedata td;
+  autotunebem3d cand;
+  pcluster  rc, cc;
+  pblock    b;
+  pstopwatch sw;
+  blockcost bc;
+  real      tnear, tfar, rank;
+  bool      usem, useeps;
+  uint      candidates, ic, ie, im, ip;
+
+  assert(nclf > 0 && neta > 0);
+  assert(samples > 0);
+
+  usem = (family != APRX_ACA_BEM3D && family != APRX_PACA_BEM3D);
+  useeps = (family == APRX_ACA_BEM3D || family == APRX_PACA_BEM3D
+	    || family == APRX_HCA_BEM3D);
+  assert(!usem || nm > 0);
+  assert(!useeps || neps > 0);
+
+  sw = new_stopwatch();
+
+  td.bem = bem;
+  td.N = (pamatrix *) allocmem(sizeof(pamatrix) * samples);
+  td.R = (prkmatrix *) allocmem(sizeof(prkmatrix) * samples);
+
+  candidates = 0;
+
+  for (ic = 0; ic < nclf; ic++) {
+    rc = build_bem3d_cluster(bem, clf[ic], row_basis);
+    cc = (col_basis == row_basis ? rc :
+	  build_bem3d_cluster(bem, clf[ic], col_basis));
+
+    for (ie = 0; ie < neta; ie++) {
+      b = build_strict_block(rc, cc, (void *) (eta + ie),
+			     admissible_max_cluster);
+
+      /* With k=1, farentries is the sum of the row and column sizes
+       * of the admissible leaves */
+      estimate_cost_block(b, 1, &bc);
+
+      td.near = (struct _tuneleaf *) allocmem(sizeof(struct _tuneleaf)
+					      * (bc.nearleaves + 1));
+      td.far = (struct _tuneleaf *) allocmem(sizeof(struct _tuneleaf)
+					     * (bc.farleaves + 1));
+      td.nearn = 0;
+      td.farn = 0;
+      iterate_block(b, 0, 0, 0, collect_tuneleaf, NULL, &td);
+      assert(td.nearn == bc.nearleaves);
+      assert(td.farn == bc.farleaves);
+
+      td.samples = samples;
+      tnear = estimate_nearfield_autotune(&td, bc.nearentries, sw);
+
+      for (im = 0; im < (usem ? nm : 1); im++) {
+	for (ip = 0; ip < (useeps ? neps : 1); ip++) {
+	  cand.clf = clf[ic];
+	  cand.eta = eta[ie];
+	  cand.m = (usem ? m[im] : 0);
+	  cand.eps_aca = (useeps ? eps_aca[ip] : 0.0);
+
+	  setup_aprx_autotune(bem, family, rc, cc, b, cand.m, cand.eps_aca);
+
+	  td.samples = samples;
+	  tfar = estimate_farfield_autotune(&td, bc.farentries, sw,
+					    &cand.error, &rank);
+
+	  cand.time = tnear + tfar;
+	  cand.storage = (size_t) sizeof(field) *
+	    (bc.nearentries + (size_t) (rank * bc.farentries + 0.5));
+
+	  if (candidates == 0 || better_autotune(&cand, at, accur))
+	    *at = cand;
+	  candidates++;
+	}
+      }
+
+      freemem(td.far);
+      freemem(td.near);
+      del_block(b);
+    }
+
+    if (cc != rc) {
+      freemem(cc->idx);
+      del_cluster(cc);
+    }
+    freemem(rc->idx);
+    del_cluster(rc);
+  }
+
+  freemem(td.R);
+  freemem(td.N);
+  del_stopwatch(sw);
+
+  at->candidates = candidates;
+
+  /* The chosen approximation scheme does not depend on the trees */
+  setup_aprx_autotune(bem, family, NULL, NULL, NULL, at->m, at->eps_aca);
+
+  return (at->error <= accur);
+}
+
+/* ------------------------------------------------------------
+ Per-thread timing of the assembly
+ ------------------------------------------------------------ */
+
+static real *
+threadtimes_bem3d(pparbem3d par)
+{
+  uint      threads;
+
+  threads = getmaxthreads();
+  if (par->ttimen != threads) {
+    if (par->ttime != NULL) {
+      freemem(par->ttime);
+    }
+    par->ttime = (real *) allocmem((size_t) sizeof(real) * threads);
+    par->ttimen = threads;
+  }
+
+  return par->ttime;
+}
+
+const real *
+getthreadtimes_bem3d(pcbem3d bem, uint * threads)
+{
+  pcparbem3d par = bem->par;
+
+  *threads = par->ttimen;
+
+  return par->ttime;
+}
+
 /* ------------------------------------------------------------
  Fill hmatrix
  ------------------------------------------------------------ */
@@ -4385,8 +4798,8 @@ assemble_bem3d_hmatrix(pbem3d bem, pblock b, phmatrix G)
   pparbem3d par = bem->par;
   par->hn = enumerate_hmatrix(b, G);
 
-  iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
-		      assemble_bem3d_block_hmatrix, bem);
+  iterate_leaves_block(b, 0, 0, 0, max_pardepth, NULL,
+		       assemble_bem3d_block_hmatrix, bem, threadtimes_bem3d(par));
 
   freemem(par->hn);
   par->hn = NULL;
@@ -4526,8 +4939,8 @@ assemble_bem3d_h2matrix(pbem3d bem, pblock b, ph2matrix G)
   pparbem3d par = bem->par;
   par->h2n = enumerate_h2matrix(b, G);
 
-  iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
-		      assemble_bem3d_block_h2matrix, bem);
+  iterate_leaves_block(b, 0, 0, 0, max_pardepth, NULL,
+		       assemble_bem3d_block_h2matrix, bem, threadtimes_bem3d(par));
 
   freemem(par->h2n);
   par->h2n = NULL;
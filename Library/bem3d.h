@@ -168,6 +168,62 @@ enum _basisfunctionbem3d {
  */
 typedef enum _basisfunctionbem3d basisfunctionbem3d;
 
+/**
+ * @brief Families of @ref _hmatrix "hmatrix" approximation schemes that
+ * can be chosen by @ref autotune_hmatrix_bem3d.
+ */
+enum _aprxfamilybem3d {
+  /**
+   * @brief Interpolation, see @ref setup_hmatrix_aprx_inter_row_bem3d.
+   */
+  APRX_INTER_ROW_BEM3D,
+  /**
+   * @brief Interpolation, see @ref setup_hmatrix_aprx_inter_col_bem3d.
+   */
+  APRX_INTER_COL_BEM3D,
+  /**
+   * @brief Interpolation, see @ref setup_hmatrix_aprx_inter_mixed_bem3d.
+   */
+  APRX_INTER_MIXED_BEM3D,
+  /**
+   * @brief Adaptive cross approximation, see
+   * @ref setup_hmatrix_aprx_aca_bem3d.
+   */
+  APRX_ACA_BEM3D,
+  /**
+   * @brief Partially pivoted adaptive cross approximation, see
+   * @ref setup_hmatrix_aprx_paca_bem3d.
+   */
+  APRX_PACA_BEM3D,
+  /**
+   * @brief Hybrid cross approximation, see
+   * @ref setup_hmatrix_aprx_hca_bem3d.
+   */
+  APRX_HCA_BEM3D
+};
+
+/**
+ * This is just an abbreviation for the enum @ref _aprxfamilybem3d .
+ */
+typedef enum _aprxfamilybem3d aprxfamilybem3d;
+
+/**
+ * @ref autotunebem3d is just an abbreviation for the struct
+ * @ref _autotunebem3d containing the result of
+ * @ref autotune_hmatrix_bem3d.
+ */
+typedef struct _autotunebem3d autotunebem3d;
+
+/**
+ * Pointer to a @ref _autotunebem3d "autotunebem3d" object.
+ */
+typedef autotunebem3d *pautotunebem3d;
+
+/**
+ * Pointer to a constant @ref _autotunebem3d "autotunebem3d" object.
+ */
+typedef const autotunebem3d *pcautotunebem3d;
+
 /**
  * Defining a type for function that map from the boundary @f$ \Gamma @f$ of
  * the domain to a field @f$ \mathbb K @f$.
@@ -250,6 +306,18 @@ struct _bem3d {
    */
   psingquad2d sq;
 
+  /**
+   * @brief Optional classification of neighbouring triangles.
+   *
+   * If set, the nearfield callbacks look up the quadrature case and
+   * permutations of pairs of triangles instead of computing them again for
+   * every assembly. Initialized to <tt>NULL</tt>, see
+   * @ref setup_singquadcache_bem3d.
+   *
+   * \see _singquadcache2d.
+   */
+  psingquadcache2d sqc;
+
   /**
    * @brief Number of degrees of freedom for neumann data.
    */
@@ -1015,6 +1083,22 @@ HEADER_PREFIX pbem3d new_bem3d(pcsurface3d gr);
  */
 HEADER_PREFIX void del_bem3d(pbem3d bem);
 
+/**
+ * @brief Classify all pairs of neighbouring triangles of <tt>bem->gr</tt>
+ * once, so that repeated nearfield assemblies can skip this step.
+ *
+ * The cache only depends on the mesh, so one cache can be shared by several
+ * @ref _bem3d "bem3d" objects on the same surface, e.g., for the single and
+ * double layer operator or for a sweep over parameters.
+ *
+ * @param bem @ref _bem3d "bem3d" object that will use the cache.
+ * @param sc Cache for <tt>bem->gr</tt> obtained from a previous call, or
+ * <tt>NULL</tt> to build a new one.
+ * @return The cache now referenced by <tt>bem->sqc</tt>.
+ */
+HEADER_PREFIX psingquadcache2d
+setup_singquadcache_bem3d(pbem3d bem, psingquadcache2d sc);
+
 /* ------------------------------------------------------------
  Methods to build clustertrees
  ------------------------------------------------------------ */
@@ -1925,6 +2009,119 @@ HEADER_PREFIX void setup_h2matrix_aprx_greenhybrid_ortho_bem3d(pbem3d bem,
     pcclusterbasis rb, pcclusterbasis cb, pcblock tree, uint m, uint l,
     real delta, real accur, quadpoints3d quadpoints);
 
+/* ------------------------------------------------------------
+ Automatic parameter tuning
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Parameters chosen by @ref autotune_hmatrix_bem3d together with
+ * the predicted cost of the resulting @ref _hmatrix "hmatrix".
+ */
+struct _autotunebem3d {
+  /**
+   * @brief Leaf size for @ref build_bem3d_cluster.
+   */
+  uint clf;
+  /**
+   * @brief Parameter for @ref admissible_max_cluster.
+   */
+  real eta;
+  /**
+   * @brief Interpolation order, 0 if the family does not use it.
+   */
+  uint m;
+  /**
+   * @brief Accuracy of the cross approximation, 0 if the family does not
+   * use it.
+   */
+  real eps_aca;
+  /**
+   * @brief Maximal relative error of the sampled admissible blocks.
+   */
+  real error;
+  /**
+   * @brief Predicted sequential assembly time in seconds.
+   */
+  real time;
+  /**
+   * @brief Predicted storage of the @ref _hmatrix "hmatrix" in bytes.
+   */
+  size_t storage;
+  /**
+   * @brief Number of configurations that have been compared.
+   */
+  uint candidates;
+};
+
+/**
+ * @brief Choose leaf size, admissibility parameter and approximation
+ * parameters for the assembly of an @ref _hmatrix "hmatrix".
+ *
+ * For every combination of the given candidates, the cluster trees are
+ * constructed by @ref build_bem3d_cluster and the block tree by
+ * @ref build_strict_block with @ref admissible_max_cluster.
+ * Only <tt>samples</tt> inadmissible and <tt>samples</tt> admissible
+ * leaves, evenly distributed over the block tree, are actually computed.
+ * The accuracy is measured by comparing the sampled low-rank blocks
+ * with the corresponding dense blocks, the time for the entire matrix
+ * is extrapolated from the sampled blocks using
+ * @ref estimate_cost_block.
+ *
+ * Among all configurations whose sampled blocks meet the relative
+ * accuracy <tt>accur</tt>, the one with the smallest predicted
+ * assembly time is chosen. If no configuration is accurate enough, the
+ * most accurate one is chosen.
+ *
+ * @attention The approximation scheme of <tt>bem</tt> is set up with
+ * the chosen parameters. The trees have to be constructed again by the
+ * caller using <tt>at->clf</tt> and <tt>at->eta</tt>.
+ *
+ * @param bem @ref _bem3d "bem3d" object describing the matrix.
+ * @param family Approximation scheme for the admissible blocks.
+ * @param row_basis Basis functions for the row cluster tree.
+ * @param col_basis Basis functions for the column cluster tree.
+ * @param nclf Number of candidates for the leaf size.
+ * @param clf Candidates for the leaf size.
+ * @param neta Number of candidates for the admissibility parameter.
+ * @param eta Candidates for the admissibility parameter.
+ * @param nm Number of candidates for the interpolation order, ignored
+ *        for @ref APRX_ACA_BEM3D and @ref APRX_PACA_BEM3D.
+ * @param m Candidates for the interpolation order.
+ * @param neps Number of candidates for the cross approximation accuracy,
+ *        ignored for interpolation.
+ * @param eps_aca Candidates for the cross approximation accuracy.
+ * @param accur Required relative accuracy of the admissible blocks.
+ * @param samples Number of sampled leaves of each kind.
+ * @param at Receives the chosen configuration.
+ *
+ * @returns <tt>true</tt> if the chosen configuration meets the
+ * required accuracy.
+ */
+HEADER_PREFIX bool autotune_hmatrix_bem3d(pbem3d bem, aprxfamilybem3d family,
+    basisfunctionbem3d row_basis, basisfunctionbem3d col_basis, uint nclf,
+    const uint *clf, uint neta, const real *eta, uint nm, const uint *m,
+    uint neps, const real *eps_aca, real accur, uint samples,
+    pautotunebem3d at);
+
+/* ------------------------------------------------------------
+ Per-thread timing of the assembly
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Get the time each thread spent in the last call of
+ * @ref assemble_bem3d_hmatrix or @ref assemble_bem3d_h2matrix.
+ *
+ * Both functions distribute the leaves of the block tree by a dynamic
+ * work queue, so large differences between the threads indicate that
+ * a few blocks dominate the assembly.
+ *
+ * @param bem @ref _bem3d "bem3d" object used for the assembly.
+ * @param threads Number of entries of the returned array.
+ * @returns Time in seconds spent by each thread, <tt>NULL</tt> if
+ * no matrix has been assembled yet.
+ */
+HEADER_PREFIX const real *getthreadtimes_bem3d(pcbem3d bem, uint *threads);
+
 /* ------------------------------------------------------------
  Fill hmatrix
  ------------------------------------------------------------ */
@@ -0,0 +1,547 @@
+/* ------------------------------------------------------------
+   This is the file "binaryio.c" of the H2Lib package.
+   All rights reserved, H2Lib developers 2015
+   ------------------------------------------------------------ */
+
+/* Request 64-bit file offsets on 32-bit POSIX systems, this has to
+   happen before any system header is included */
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "binaryio.h"
+
+#include "basic.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <sys/types.h>
+#include <unistd.h>
+#ifdef _POSIX_MAPPED_FILES
+#include <sys/mman.h>
+#define BINARY_MMAP
+#endif
+#define BINARY_OFF_T
+#endif
+
+/* File offsets, ftell and fseek only use long, which has 32 bits
+   on LLP64 systems like Windows, so files beyond 2 GB need the
+   wider variants of the platform */
+#if defined(BINARY_OFF_T)
+typedef off_t fileoff;
+#define tell_file(f) ftello(f)
+#define seek_file(f, o) fseeko(f, o, SEEK_SET)
+#define seekend_file(f) fseeko(f, 0, SEEK_END)
+#elif defined(_WIN32)
+typedef __int64 fileoff;
+#define tell_file(f) _ftelli64(f)
+#define seek_file(f, o) _fseeki64(f, o, SEEK_SET)
+#define seekend_file(f) _fseeki64(f, 0, SEEK_END)
+#else
+typedef long fileoff;
+#define tell_file(f) ftell(f)
+#define seek_file(f, o) fseek(f, o, SEEK_SET)
+#define seekend_file(f) fseek(f, 0, SEEK_END)
+#endif
+
+/* Largest value of the signed type fileoff */
+#define FILEOFF_MAX \
+  ((((fileoff) 1 << (8 * sizeof(fileoff) - 2)) - 1) * 2 + 1)
+
+/* Convert a file offset to size_t, fails for negative offsets and
+   for offsets that do not fit */
+static    bool
+size_from_fileoff(fileoff o, size_t *s)
+{
+  *s = 0;
+  if (o < 0 || (uintmax_t) o > (uintmax_t) SIZE_MAX)
+    return false;
+
+  *s = (size_t) o;
+  return true;
+}
+
+/* Convert a size_t to a file offset, fails for sizes that do not fit */
+static    bool
+fileoff_from_size(size_t s, fileoff *o)
+{
+  *o = 0;
+  if ((uintmax_t) s > (uintmax_t) FILEOFF_MAX)
+    return false;
+
+  *o = (fileoff) s;
+  return true;
+}
+
+/* Identification of binary files */
+static const char binary_magic[8] = { 'H', '2', 'L', 'i', 'b', 'B', 'i', 'n' };
+
+/* Used to detect files written with a different byte order */
+static const uint binary_check = 0x01020304;
+
+/* ------------------------------------------------------------
+   Header
+   ------------------------------------------------------------ */
+
+/* Size of the header in bytes */
+#define BINARY_HEADER (8 * sizeof(char) + 7 * sizeof(uint) + 2 * sizeof(size_t))
+
+static void
+write_header(pbinaryfile bf)
+{
+  uint      h[7];
+  size_t    s[2];
+  size_t    n;
+
+  h[0] = BINARY_VERSION;
+  h[1] = bf->kind;
+  h[2] = sizeof(uint);
+  h[3] = sizeof(real);
+  h[4] = sizeof(field);
+  h[5] = sizeof(size_t);
+  h[6] = binary_check;
+
+  s[0] = bf->dataoff;
+  s[1] = bf->datasize;
+
+  n = fwrite(binary_magic, sizeof(char), 8, bf->file);
+  n += fwrite(h, sizeof(uint), 7, bf->file);
+  n += fwrite(s, sizeof(size_t), 2, bf->file);
+  check_binaryfile(bf, n == 17);
+}
+
+static    bool
+read_header(pbinaryfile bf, const char *filename)
+{
+  char      magic[8];
+  uint      h[7];
+  size_t    s[2];
+  size_t    n;
+
+  n = fread(magic, sizeof(char), 8, bf->file);
+  if (n != 8 || memcmp(magic, binary_magic, 8) != 0) {
+    (void) fprintf(stderr, "File \"%s\" is not an H2Lib binary file\n",
+		   filename);
+    return false;
+  }
+
+  n = fread(h, sizeof(uint), 7, bf->file);
+  n += fread(s, sizeof(size_t), 2, bf->file);
+  if (n != 9 || h[5] != sizeof(size_t) || h[6] != binary_check) {
+    (void) fprintf(stderr,
+		   "File \"%s\" has been written on an incompatible system\n",
+		   filename);
+    return false;
+  }
+
+  if (h[0] != BINARY_VERSION) {
+    (void) fprintf(stderr,
+		   "File \"%s\" has version %u, only version %u is supported\n",
+		   filename, h[0], BINARY_VERSION);
+    return false;
+  }
+
+  if (h[2] != sizeof(uint) || h[3] != sizeof(real) || h[4] != sizeof(field)) {
+    (void) fprintf(stderr,
+		   "File \"%s\" uses different types for uint, real or field\n",
+		   filename);
+    return false;
+  }
+
+  if (h[1] != bf->kind) {
+    (void) fprintf(stderr,
+		   "File \"%s\" contains an object of kind %u instead of %u\n",
+		   filename, h[1], bf->kind);
+    return false;
+  }
+
+  bf->dataoff = s[0];
+  bf->datasize = s[1];
+
+  return true;
+}
+
+/* ------------------------------------------------------------
+   Constructors and destructors
+   ------------------------------------------------------------ */
+
+static    pbinaryfile
+new_binaryfile(const char *filename, FILE * file, binarykind kind,
+	       bool write)
+{
+  pbinaryfile bf;
+
+  bf = (pbinaryfile) allocmem(sizeof(binaryfile));
+  bf->file = file;
+  bf->kind = kind;
+  bf->write = write;
+  bf->dataoff = 0;
+  bf->datasize = 0;
+  bf->pos = 0;
+  bf->store = NULL;
+  bf->name = (char *) allocmem(strlen(filename) + 1);
+  strcpy(bf->name, filename);
+  bf->off = BINARY_HEADER;
+  bf->error = false;
+
+  return bf;
+}
+
+static void
+free_binaryfile(pbinaryfile bf)
+{
+  freemem(bf->name);
+  freemem(bf);
+}
+
+pbinaryfile
+new_write_binaryfile(const char *filename, binarykind kind)
+{
+  pbinaryfile bf;
+  FILE     *out;
+
+  out = fopen(filename, "wb");
+  if (out == NULL) {
+    (void) fprintf(stderr, "Could not open file \"%s\" for writing\n",
+		   filename);
+    return NULL;
+  }
+
+  bf = new_binaryfile(filename, out, kind, true);
+
+  /* Preliminary header, completed by del_binaryfile */
+  write_header(bf);
+
+  return bf;
+}
+
+static    pbinarystore
+new_binarystore()
+{
+  pbinarystore bs;
+
+  bs = (pbinarystore) allocmem(sizeof(binarystore));
+  bs->data = NULL;
+  bs->size = 0;
+  bs->map = NULL;
+  bs->mapsize = 0;
+  bs->refs = 0;
+
+  return bs;
+}
+
+static void
+del_binarystore(pbinarystore bs)
+{
+  assert(bs->refs == 0);
+
+#ifdef BINARY_MMAP
+  if (bs->map)
+    (void) munmap(bs->map, bs->mapsize);
+  else
+#endif
+  if (bs->data)
+    freemem(bs->data);
+
+  freemem(bs);
+}
+
+pbinaryfile
+new_read_binaryfile(const char *filename, binarykind kind, bool map)
+{
+  pbinaryfile bf;
+  pbinarystore bs;
+  FILE     *in;
+  fileoff   start, end, data;
+  size_t    n, endsize;
+
+  in = fopen(filename, "rb");
+  if (in == NULL) {
+    (void) fprintf(stderr, "Could not open file \"%s\" for reading\n",
+		   filename);
+    return NULL;
+  }
+
+  bf = new_binaryfile(filename, in, kind, false);
+
+  if (!read_header(bf, filename)) {
+    fclose(in);
+    free_binaryfile(bf);
+    return NULL;
+  }
+
+  /* Make sure that the data section is complete */
+  start = tell_file(in);
+  end = (start >= 0 && seekend_file(in) == 0 ? tell_file(in) : -1);
+  if (start != (fileoff) BINARY_HEADER || !size_from_fileoff(end, &endsize)
+      || bf->dataoff % BINARY_ALIGN != 0 || bf->dataoff < BINARY_HEADER
+      || !fileoff_from_size(bf->dataoff, &data)
+      || bf->datasize > (SIZE_MAX - bf->dataoff) / sizeof(field)
+      || endsize < bf->dataoff + sizeof(field) * bf->datasize) {
+    (void) fprintf(stderr, "File \"%s\" is truncated or damaged\n",
+		   filename);
+    fclose(in);
+    free_binaryfile(bf);
+    return NULL;
+  }
+
+  bs = new_binarystore();
+  bs->size = bf->datasize;
+
+#ifdef BINARY_MMAP
+  if (map && bf->datasize > 0) {
+    /* Private mapping, so changes to coefficients stay in memory */
+    bs->mapsize = bf->dataoff + sizeof(field) * bf->datasize;
+    bs->map = mmap(NULL, bs->mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		   fileno(in), 0);
+    if (bs->map == MAP_FAILED)
+      bs->map = NULL;
+    else
+      bs->data = (pfield) ((char *) bs->map + bf->dataoff);
+  }
+#else
+  (void) map;
+#endif
+
+  if (bs->data == NULL && bf->datasize > 0) {
+    bs->data = allocfield(bf->datasize);
+    n = 0;
+    if (seek_file(in, data) == 0)
+      n = fread(bs->data, sizeof(field), bf->datasize, in);
+    check_binaryfile(bf, n == bf->datasize);
+  }
+
+  ref_binarystore(&bf->store, bs);
+
+  if (!check_binaryfile(bf, seek_file(in, start) == 0)) {
+    (void) fprintf(stderr, "Could not read file \"%s\"\n", filename);
+    unref_binarystore(bf->store);
+    fclose(in);
+    free_binaryfile(bf);
+    return NULL;
+  }
+
+  return bf;
+}
+
+bool
+del_binaryfile(pbinaryfile bf)
+{
+  bool      okay;
+
+  if (bf->write) {
+    assert(bf->pos == bf->datasize);
+
+    if (bf->dataoff == 0)
+      start_data_binaryfile(bf);
+
+    if (!bf->error && check_binaryfile(bf, seek_file(bf->file, 0) == 0))
+      write_header(bf);
+
+    check_binaryfile(bf, fclose(bf->file) == 0);
+
+    if (bf->error)
+      (void) fprintf(stderr, "Could not write file \"%s\"\n", bf->name);
+  }
+  else {
+    /* All coefficients should have been claimed by now */
+    check_binaryfile(bf, bf->pos == bf->datasize);
+
+    unref_binarystore(bf->store);
+
+    fclose(bf->file);
+
+    if (bf->error)
+      (void) fprintf(stderr, "File \"%s\" is truncated or damaged\n",
+		     bf->name);
+  }
+
+  okay = !bf->error;
+
+  free_binaryfile(bf);
+
+  return okay;
+}
+
+/* ------------------------------------------------------------
+   Error handling
+   ------------------------------------------------------------ */
+
+bool
+check_binaryfile(pbinaryfile bf, bool okay)
+{
+  if (!okay)
+    bf->error = true;
+
+  return !bf->error;
+}
+
+/* ------------------------------------------------------------
+   Reference counting
+   ------------------------------------------------------------ */
+
+void
+ref_binarystore(pbinarystore *ptr, pbinarystore bs)
+{
+  if (*ptr)
+    unref_binarystore(*ptr);
+
+  *ptr = bs;
+
+  if (bs)
+    bs->refs++;
+}
+
+void
+unref_binarystore(pbinarystore bs)
+{
+  assert(bs->refs > 0);
+
+  bs->refs--;
+
+  if (bs->refs == 0)
+    del_binarystore(bs);
+}
+
+/* ------------------------------------------------------------
+   Structure section
+   ------------------------------------------------------------ */
+
+void
+put_uint_binaryfile(pbinaryfile bf, uint x)
+{
+  size_t    n;
+
+  assert(bf->write);
+  assert(bf->dataoff == 0);
+
+  n = fwrite(&x, sizeof(uint), 1, bf->file);
+  check_binaryfile(bf, n == 1);
+  bf->off += sizeof(uint);
+}
+
+void
+put_real_binaryfile(pbinaryfile bf, real x)
+{
+  size_t    n;
+
+  assert(bf->write);
+  assert(bf->dataoff == 0);
+
+  n = fwrite(&x, sizeof(real), 1, bf->file);
+  check_binaryfile(bf, n == 1);
+  bf->off += sizeof(real);
+}
+
+uint
+get_uint_binaryfile(pbinaryfile bf)
+{
+  uint      x;
+  size_t    n;
+
+  assert(!bf->write);
+
+  /* Reading stops at the first error, and the structure section must
+     not extend into the data section */
+  n = 0;
+  if (!bf->error && bf->off + sizeof(uint) <= bf->dataoff)
+    n = fread(&x, sizeof(uint), 1, bf->file);
+  if (!check_binaryfile(bf, n == 1))
+    return 0;
+
+  bf->off += sizeof(uint);
+
+  return x;
+}
+
+real
+get_real_binaryfile(pbinaryfile bf)
+{
+  real      x;
+  size_t    n;
+
+  assert(!bf->write);
+
+  n = 0;
+  if (!bf->error && bf->off + sizeof(real) <= bf->dataoff)
+    n = fread(&x, sizeof(real), 1, bf->file);
+  if (!check_binaryfile(bf, n == 1))
+    return 0.0;
+
+  bf->off += sizeof(real);
+
+  return x;
+}
+
+uint
+get_count_binaryfile(pbinaryfile bf, size_t size)
+{
+  uint      n;
+
+  n = get_uint_binaryfile(bf);
+
+  if (size > 0
+      && !check_binaryfile(bf, n <= (bf->dataoff - bf->off) / size))
+    return 0;
+
+  return n;
+}
+
+/* ------------------------------------------------------------
+   Data section
+   ------------------------------------------------------------ */
+
+void
+start_data_binaryfile(pbinaryfile bf)
+{
+  size_t    pos;
+
+  assert(bf->write);
+  assert(bf->dataoff == 0);
+
+  if (!check_binaryfile(bf, size_from_fileoff(tell_file(bf->file), &pos)))
+    pos = bf->off;
+
+  while (pos % BINARY_ALIGN != 0) {
+    check_binaryfile(bf, fputc(0, bf->file) != EOF);
+    pos++;
+  }
+
+  bf->dataoff = (size_t) pos;
+}
+
+void
+put_amatrix_binaryfile(pbinaryfile bf, pcamatrix a)
+{
+  size_t    n;
+  uint      j;
+
+  assert(bf->write);
+  assert(bf->dataoff > 0);
+
+  for (j = 0; j < a->cols; j++) {
+    n = fwrite(a->a + (size_t) a->ld * j, sizeof(field), a->rows, bf->file);
+    check_binaryfile(bf, n == a->rows);
+  }
+
+  bf->datasize += (size_t) a->rows * a->cols;
+  bf->pos = bf->datasize;
+}
+
+pfield
+get_data_binaryfile(pbinaryfile bf, size_t size)
+{
+  pfield    data;
+
+  assert(!bf->write);
+
+  if (!check_binaryfile(bf, size <= bf->datasize - bf->pos))
+    return NULL;
+
+  data = (size > 0 ? bf->store->data + bf->pos : NULL);
+  bf->pos += size;
+
+  return data;
+}
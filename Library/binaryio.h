@@ -0,0 +1,280 @@
+/* ------------------------------------------------------------
+   This is the file "binaryio.h" of the H2Lib package.
+   All rights reserved, H2Lib developers 2015
+   ------------------------------------------------------------ */
+
+/** @file binaryio.h */
+
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+/** @defgroup binaryio binaryio
+ *  @brief Binary files for cluster trees, block trees and matrices.
+ *
+ *  A binary file starts with a header describing the kind of the
+ *  stored object and the sizes of the basic types.
+ *  It is followed by the <em>structure section</em> containing
+ *  the trees and dimensions and the <em>data section</em> containing
+ *  the coefficients of all matrices.
+ *  The data section is aligned, so it can be mapped into memory
+ *  and used directly without copying.
+ *  @{ */
+
+/** @brief Binary file opened for reading or writing. */
+typedef struct _binaryfile binaryfile;
+
+/** @brief Pointer to a @ref binaryfile object. */
+typedef binaryfile *pbinaryfile;
+
+/** @brief Coefficients read from a binary file. */
+typedef struct _binarystore binarystore;
+
+/** @brief Pointer to a @ref binarystore object. */
+typedef binarystore *pbinarystore;
+
+#include <stdio.h>
+
+#include "amatrix.h"
+#include "settings.h"
+
+/** @brief Version of the binary file format. */
+#define BINARY_VERSION 1
+
+/** @brief Alignment of the data section in bytes. */
+#define BINARY_ALIGN 64
+
+/** @brief Kinds of objects stored in binary files. */
+enum _binarykind {
+  /** @brief Cluster tree, see @ref write_binary_cluster. */
+  BINARY_CLUSTER = 1,
+  /** @brief Block tree, see @ref write_binary_block. */
+  BINARY_BLOCK = 2,
+  /** @brief @f$\mathcal{H}@f$-matrix, see @ref write_binary_hmatrix. */
+  BINARY_HMATRIX = 3,
+  /** @brief Cluster basis, see @ref write_binary_clusterbasis. */
+  BINARY_CLUSTERBASIS = 4,
+  /** @brief @f$\mathcal{H}^2@f$-matrix, see @ref write_binary_h2matrix. */
+  BINARY_H2MATRIX = 5
+};
+
+/** @brief This is just an abbreviation for the enum @ref _binarykind. */
+typedef enum _binarykind binarykind;
+
+/** @brief Coefficients read from a binary file.
+ *
+ *  The data section is either mapped into memory or read into
+ *  an array.
+ *  All objects using the coefficients hold a reference, and
+ *  the storage is released once the last reference is gone. */
+struct _binarystore {
+  /** @brief Coefficients of the data section. */
+  pfield data;
+  /** @brief Number of coefficients in <tt>data</tt>. */
+  size_t size;
+
+  /** @brief Start of the memory mapping, or <tt>NULL</tt> if
+   *  <tt>data</tt> has been allocated. */
+  void *map;
+  /** @brief Length of the memory mapping in bytes. */
+  size_t mapsize;
+
+  /** @brief Number of references. */
+  uint refs;
+};
+
+/** @brief Binary file opened for reading or writing. */
+struct _binaryfile {
+  /** @brief File handle. */
+  FILE *file;
+  /** @brief Kind of the stored object. */
+  binarykind kind;
+  /** @brief Set if the file has been opened for writing. */
+  bool write;
+
+  /** @brief Position of the data section in bytes. */
+  size_t dataoff;
+  /** @brief Number of coefficients in the data section. */
+  size_t datasize;
+  /** @brief Number of coefficients already written or read. */
+  size_t pos;
+
+  /** @brief Coefficients of a file opened for reading. */
+  pbinarystore store;
+
+  /** @brief Name of the file, used for error messages. */
+  char *name;
+  /** @brief Position in the structure section in bytes. */
+  size_t off;
+  /** @brief Set if an operation has failed or the file is inconsistent.
+   *  All further reads return zero. */
+  bool error;
+};
+
+/* ------------------------------------------------------------
+   Constructors and destructors
+   ------------------------------------------------------------ */
+
+/** @brief Create a binary file and write a preliminary header.
+ *
+ *  The structure section has to be written first by
+ *  @ref put_uint_binaryfile and @ref put_real_binaryfile, then
+ *  the data section is started by @ref start_data_binaryfile and
+ *  written by @ref put_amatrix_binaryfile.
+ *  The header is completed by @ref del_binaryfile, which also reports
+ *  whether all data have been written successfully.
+ *
+ *  @param filename Name of the file.
+ *  @param kind Kind of the stored object.
+ *  @returns New @ref binaryfile object or <tt>NULL</tt> if the file
+ *     could not be created. */
+HEADER_PREFIX pbinaryfile
+new_write_binaryfile(const char *filename, binarykind kind);
+
+/** @brief Open a binary file for reading.
+ *
+ *  The header is checked and the data section is provided by a new
+ *  @ref binarystore object.
+ *  If <tt>map</tt> is set and memory mapping is supported, the data
+ *  section is mapped copy-on-write, i.e., it is only read from disk
+ *  when the coefficients are accessed.
+ *  Otherwise it is read into memory.
+ *
+ *  @param filename Name of the file.
+ *  @param kind Expected kind of the stored object.
+ *  @param map Set to map the data section into memory.
+ *  @returns New @ref binaryfile object or <tt>NULL</tt> if the file
+ *     could not be opened or is not compatible. */
+HEADER_PREFIX pbinaryfile
+new_read_binaryfile(const char *filename, binarykind kind, bool map);
+
+/** @brief Close a binary file.
+ *
+ *  If the file has been opened for writing, the header is completed.
+ *  If it has been opened for reading, the reference to the
+ *  @ref binarystore is released, so the coefficients remain available
+ *  to all objects that have been read from the file.
+ *
+ *  @param bf File that will be closed.
+ *  @returns <tt>true</tt> if all operations have been successful,
+ *     <tt>false</tt> if an error has occurred. In the latter case,
+ *     objects read from the file are not usable. */
+HEADER_PREFIX bool
+del_binaryfile(pbinaryfile bf);
+
+/* ------------------------------------------------------------
+   Error handling
+   ------------------------------------------------------------ */
+
+/** @brief Check a condition on the contents of a binary file.
+ *
+ *  Readers use this function to check the consistency of the data
+ *  they have read. If <tt>okay</tt> is not set, the error flag of the
+ *  file is set.
+ *
+ *  @param bf Binary file.
+ *  @param okay Result of the check.
+ *  @returns <tt>true</tt> if no error has occurred so far. */
+HEADER_PREFIX bool
+check_binaryfile(pbinaryfile bf, bool okay);
+
+/* ------------------------------------------------------------
+   Reference counting
+   ------------------------------------------------------------ */
+
+/** @brief Set a pointer to a @ref binarystore object, increase its
+ *  reference counter, and decrease reference counter of original
+ *  pointer target.
+ *
+ *  @param ptr Pointer to the @ref pbinarystore variable that will be
+ *     changed.
+ *  @param bs @ref binarystore that will be referenced. */
+HEADER_PREFIX void
+ref_binarystore(pbinarystore *ptr, pbinarystore bs);
+
+/** @brief Reduce the reference counter of a @ref binarystore object.
+ *
+ *  If the reference counter reaches zero, the mapping is removed or
+ *  the coefficients are released.
+ *
+ *  @param bs @ref binarystore that will be unreferenced. */
+HEADER_PREFIX void
+unref_binarystore(pbinarystore bs);
+
+/* ------------------------------------------------------------
+   Structure section
+   ------------------------------------------------------------ */
+
+/** @brief Write an unsigned integer to the structure section.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param x Value. */
+HEADER_PREFIX void
+put_uint_binaryfile(pbinaryfile bf, uint x);
+
+/** @brief Write a real number to the structure section.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param x Value. */
+HEADER_PREFIX void
+put_real_binaryfile(pbinaryfile bf, real x);
+
+/** @brief Read an unsigned integer from the structure section.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @returns Value. */
+HEADER_PREFIX uint
+get_uint_binaryfile(pbinaryfile bf);
+
+/** @brief Read a real number from the structure section.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @returns Value. */
+HEADER_PREFIX real
+get_real_binaryfile(pbinaryfile bf);
+
+/** @brief Read a number of items from the structure section.
+ *
+ *  Every item is assumed to take at least <tt>size</tt> bytes of the
+ *  remaining structure section. If there is not enough room, the file
+ *  is damaged, the error flag is set and zero is returned, so
+ *  damaged files cannot lead to huge allocations.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @param size Minimal size of an item in bytes.
+ *  @returns Number of items. */
+HEADER_PREFIX uint
+get_count_binaryfile(pbinaryfile bf, size_t size);
+
+/* ------------------------------------------------------------
+   Data section
+   ------------------------------------------------------------ */
+
+/** @brief Finish the structure section and start the data section.
+ *
+ *  @param bf Binary file opened for writing. */
+HEADER_PREFIX void
+start_data_binaryfile(pbinaryfile bf);
+
+/** @brief Write the coefficients of a matrix to the data section.
+ *
+ *  The coefficients are written column by column, i.e., with leading
+ *  dimension <tt>a->rows</tt>.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param a Matrix. */
+HEADER_PREFIX void
+put_amatrix_binaryfile(pbinaryfile bf, pcamatrix a);
+
+/** @brief Get the next coefficients from the data section.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @param size Number of coefficients.
+ *  @returns Pointer to <tt>size</tt> coefficients in
+ *     <tt>bf->store</tt>, or <tt>NULL</tt> if the data section is
+ *     too short. */
+HEADER_PREFIX pfield
+get_data_binaryfile(pbinaryfile bf, size_t size);
+
+/** @} */
+
+#endif
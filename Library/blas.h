@@ -0,0 +1,398 @@
+/* ------------------------------------------------------------
+   This is the file "blas.h" of the H2Lib package.
+   All rights reserved, H2Lib developers 2015
+   ------------------------------------------------------------ */
+
+/** @file blas.h */
+
+#ifndef BLAS_H
+#define BLAS_H
+
+/** @defgroup blas blas
+ *  @brief Interface to BLAS and LAPACK.
+ *
+ *  The routines are called by macros with the prefix <tt>h2_</tt>
+ *  that select the real or complex version depending on
+ *  <tt>USE_COMPLEX</tt>, e.g., @ref h2_gemm calls <tt>dgemm_</tt>
+ *  or <tt>zgemm_</tt>.
+ *  In the complex case, the adjoint takes the place of the transposed
+ *  matrix, so @ref _h2_adj should be used instead of "Transposed".
+ *  @{ */
+
+#include "settings.h"
+
+#ifdef USE_BLAS
+
+/** @brief Operation flag for BLAS and LAPACK: use the matrix itself. */
+#define _h2_ntrans "Not Transposed"
+
+/** @brief Operation flag for BLAS and LAPACK: use the adjoint matrix. */
+#ifdef USE_COMPLEX
+#define _h2_adj "Conjugate Transposed"
+#else
+#define _h2_adj "Transposed"
+#endif
+
+/* ------------------------------------------------------------
+ BLAS level 1
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+IMPORT_PREFIX void
+zaxpy_(const unsigned *n, const field *alpha, const field *x,
+       const unsigned *incx, field *y, const unsigned *incy);
+
+IMPORT_PREFIX field
+zdotc_(const unsigned *n, const field *x, const unsigned *incx,
+       const field *y, const unsigned *incy);
+
+IMPORT_PREFIX double
+dznrm2_(const unsigned *n, const field *x, const unsigned *incx);
+
+IMPORT_PREFIX void
+zscal_(const unsigned *n, const field *alpha, field *x,
+       const unsigned *incx);
+
+/** @brief Compute @f$y \gets y + \alpha x@f$. */
+#define h2_axpy(n, alpha, x, incx, y, incy) \
+  zaxpy_(n, alpha, x, incx, y, incy)
+
+/** @brief Compute @f$x^* y@f$. */
+#define h2_dot(n, x, incx, y, incy) \
+  zdotc_(n, x, incx, y, incy)
+
+/** @brief Compute @f$\|x\|_2@f$. */
+#define h2_nrm2(n, x, incx) \
+  dznrm2_(n, x, incx)
+
+/** @brief Compute @f$x \gets \alpha x@f$. */
+#define h2_scal(n, alpha, x, incx) \
+  zscal_(n, alpha, x, incx)
+#else
+IMPORT_PREFIX void
+daxpy_(const unsigned *n, const field *alpha, const field *x,
+       const unsigned *incx, field *y, const unsigned *incy);
+
+IMPORT_PREFIX field
+ddot_(const unsigned *n, const field *x, const unsigned *incx,
+      const field *y, const unsigned *incy);
+
+IMPORT_PREFIX double
+dnrm2_(const unsigned *n, const field *x, const unsigned *incx);
+
+IMPORT_PREFIX void
+dscal_(const unsigned *n, const field *alpha, field *x,
+       const unsigned *incx);
+
+#define h2_axpy(n, alpha, x, incx, y, incy) \
+  daxpy_(n, alpha, x, incx, y, incy)
+
+#define h2_dot(n, x, incx, y, incy) \
+  ddot_(n, x, incx, y, incy)
+
+#define h2_nrm2(n, x, incx) \
+  dnrm2_(n, x, incx)
+
+#define h2_scal(n, alpha, x, incx) \
+  dscal_(n, alpha, x, incx)
+#endif
+
+/* ------------------------------------------------------------
+ BLAS level 2
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+IMPORT_PREFIX void
+zgemv_(const char *trans, const unsigned *m, const unsigned *n,
+       const field *alpha, const field *a, const unsigned *lda,
+       const field *x, const unsigned *incx,
+       const field *beta, field *y, const unsigned *incy);
+
+IMPORT_PREFIX void
+ztrmv_(const char *uplo, const char *trans, const char *diag,
+       const unsigned *n, const field *a, const unsigned *lda,
+       field *x, const unsigned *incx);
+
+IMPORT_PREFIX void
+zgeru_(const unsigned *m, const unsigned *n, const field *alpha,
+       const field *x, const unsigned *incx,
+       const field *y, const unsigned *incy, field *a, const unsigned *lda);
+
+IMPORT_PREFIX void
+zgerc_(const unsigned *m, const unsigned *n, const field *alpha,
+       const field *x, const unsigned *incx,
+       const field *y, const unsigned *incy, field *a, const unsigned *lda);
+
+IMPORT_PREFIX void
+zher_(const char *uplo, const unsigned *n, const real *alpha,
+      const field *x, const unsigned *incx, field *a, const unsigned *lda);
+
+/** @brief Compute @f$y \gets \beta y + \alpha A x@f$ or
+ *  @f$y \gets \beta y + \alpha A^* x@f$. */
+#define h2_gemv(trans, m, n, alpha, a, lda, x, incx, beta, y, incy) \
+  zgemv_(trans, m, n, alpha, a, lda, x, incx, beta, y, incy)
+
+/** @brief Compute @f$x \gets A x@f$ or @f$x \gets A^* x@f$ for a
+ *  triangular matrix @f$A@f$. */
+#define h2_trmv(uplo, trans, diag, n, a, lda, x, incx) \
+  ztrmv_(uplo, trans, diag, n, a, lda, x, incx)
+
+/** @brief Compute @f$A \gets A + \alpha x y^T@f$. */
+#define h2_geru(m, n, alpha, x, incx, y, incy, a, lda) \
+  zgeru_(m, n, alpha, x, incx, y, incy, a, lda)
+
+/** @brief Compute @f$A \gets A + \alpha x y^*@f$. */
+#define h2_gerc(m, n, alpha, x, incx, y, incy, a, lda) \
+  zgerc_(m, n, alpha, x, incx, y, incy, a, lda)
+
+/** @brief Compute @f$A \gets A + \alpha x x^*@f$ for a self-adjoint
+ *  matrix @f$A@f$ and a real @f$\alpha@f$. */
+#define h2_syr(uplo, n, alpha, x, incx, a, lda) \
+  zher_(uplo, n, alpha, x, incx, a, lda)
+#else
+IMPORT_PREFIX void
+dgemv_(const char *trans, const unsigned *m, const unsigned *n,
+       const field *alpha, const field *a, const unsigned *lda,
+       const field *x, const unsigned *incx,
+       const field *beta, field *y, const unsigned *incy);
+
+IMPORT_PREFIX void
+dtrmv_(const char *uplo, const char *trans, const char *diag,
+       const unsigned *n, const field *a, const unsigned *lda,
+       field *x, const unsigned *incx);
+
+IMPORT_PREFIX void
+dger_(const unsigned *m, const unsigned *n, const field *alpha,
+      const field *x, const unsigned *incx,
+      const field *y, const unsigned *incy, field *a, const unsigned *lda);
+
+IMPORT_PREFIX void
+dsyr_(const char *uplo, const unsigned *n, const real *alpha,
+      const field *x, const unsigned *incx, field *a, const unsigned *lda);
+
+#define h2_gemv(trans, m, n, alpha, a, lda, x, incx, beta, y, incy) \
+  dgemv_(trans, m, n, alpha, a, lda, x, incx, beta, y, incy)
+
+#define h2_trmv(uplo, trans, diag, n, a, lda, x, incx) \
+  dtrmv_(uplo, trans, diag, n, a, lda, x, incx)
+
+#define h2_geru(m, n, alpha, x, incx, y, incy, a, lda) \
+  dger_(m, n, alpha, x, incx, y, incy, a, lda)
+
+#define h2_gerc(m, n, alpha, x, incx, y, incy, a, lda) \
+  dger_(m, n, alpha, x, incx, y, incy, a, lda)
+
+#define h2_syr(uplo, n, alpha, x, incx, a, lda) \
+  dsyr_(uplo, n, alpha, x, incx, a, lda)
+#endif
+
+/* ------------------------------------------------------------
+ BLAS level 3
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+IMPORT_PREFIX void
+zgemm_(const char *transa, const char *transb,
+       const unsigned *m, const unsigned *n, const unsigned *k,
+       const field *alpha, const field *a, const unsigned *lda,
+       const field *b, const unsigned *ldb,
+       const field *beta, field *c, const unsigned *ldc);
+
+IMPORT_PREFIX void
+ztrmm_(const char *side, const char *uplo, const char *transa,
+       const char *diag, const unsigned *m, const unsigned *n,
+       const field *alpha, const field *a, const unsigned *lda,
+       field *b, const unsigned *ldb);
+
+IMPORT_PREFIX void
+ztrsm_(const char *side, const char *uplo, const char *transa,
+       const char *diag, const unsigned *m, const unsigned *n,
+       const field *alpha, const field *a, const unsigned *lda,
+       field *b, const unsigned *ldb);
+
+/** @brief Compute @f$C \gets \beta C + \alpha \mathop{op}(A)
+ *  \mathop{op}(B)@f$. */
+#define h2_gemm(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc) \
+  zgemm_(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc)
+
+/** @brief Multiply by a triangular matrix. */
+#define h2_trmm(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb) \
+  ztrmm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb)
+
+/** @brief Solve with a triangular matrix. */
+#define h2_trsm(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb) \
+  ztrsm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb)
+#else
+IMPORT_PREFIX void
+dgemm_(const char *transa, const char *transb,
+       const unsigned *m, const unsigned *n, const unsigned *k,
+       const field *alpha, const field *a, const unsigned *lda,
+       const field *b, const unsigned *ldb,
+       const field *beta, field *c, const unsigned *ldc);
+
+IMPORT_PREFIX void
+dtrmm_(const char *side, const char *uplo, const char *transa,
+       const char *diag, const unsigned *m, const unsigned *n,
+       const field *alpha, const field *a, const unsigned *lda,
+       field *b, const unsigned *ldb);
+
+IMPORT_PREFIX void
+dtrsm_(const char *side, const char *uplo, const char *transa,
+       const char *diag, const unsigned *m, const unsigned *n,
+       const field *alpha, const field *a, const unsigned *lda,
+       field *b, const unsigned *ldb);
+
+#define h2_gemm(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc) \
+  dgemm_(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc)
+
+#define h2_trmm(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb) \
+  dtrmm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb)
+
+#define h2_trsm(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb) \
+  dtrsm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb)
+#endif
+
+/* ------------------------------------------------------------
+ LAPACK
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+IMPORT_PREFIX void
+ztrtrs_(const char *uplo, const char *trans, const char *diag,
+	const unsigned *n, const unsigned *nrhs,
+	const field *a, const unsigned *lda,
+	field *b, const unsigned *ldb, int *info);
+
+IMPORT_PREFIX void
+zpotrf_(const char *uplo, const unsigned *n, field *a, const unsigned *lda,
+	int *info);
+
+IMPORT_PREFIX void
+zgeqrf_(const unsigned *m, const unsigned *n, field *a, const unsigned *lda,
+	field *tau, field *work, const unsigned *lwork, int *info);
+
+IMPORT_PREFIX void
+zungqr_(const unsigned *m, const unsigned *n, const unsigned *k,
+	field *a, const unsigned *lda, const field *tau,
+	field *work, const unsigned *lwork, int *info);
+
+IMPORT_PREFIX void
+zunmqr_(const char *side, const char *trans,
+	const unsigned *m, const unsigned *n, const unsigned *k,
+	const field *a, const unsigned *lda, const field *tau,
+	field *c, const unsigned *ldc,
+	field *work, const unsigned *lwork, int *info);
+
+/** @brief Solve a triangular system. */
+#define h2_trtrs(uplo, trans, diag, n, nrhs, a, lda, b, ldb, info) \
+  ztrtrs_(uplo, trans, diag, n, nrhs, a, lda, b, ldb, info)
+
+/** @brief Cholesky factorization. */
+#define h2_potrf(uplo, n, a, lda, info) \
+  zpotrf_(uplo, n, a, lda, info)
+
+/** @brief Householder QR factorization. */
+#define h2_geqrf(m, n, a, lda, tau, work, lwork, info) \
+  zgeqrf_(m, n, a, lda, tau, work, lwork, info)
+
+/** @brief Set up the unitary factor of a QR factorization. */
+#define h2_orgqr(m, n, k, a, lda, tau, work, lwork, info) \
+  zungqr_(m, n, k, a, lda, tau, work, lwork, info)
+
+/** @brief Multiply by the unitary factor of a QR factorization. */
+#define h2_ormqr(side, trans, m, n, k, a, lda, tau, c, ldc, work, lwork, info) \
+  zunmqr_(side, trans, m, n, k, a, lda, tau, c, ldc, work, lwork, info)
+#else
+IMPORT_PREFIX void
+dtrtrs_(const char *uplo, const char *trans, const char *diag,
+	const unsigned *n, const unsigned *nrhs,
+	const field *a, const unsigned *lda,
+	field *b, const unsigned *ldb, int *info);
+
+IMPORT_PREFIX void
+dpotrf_(const char *uplo, const unsigned *n, field *a, const unsigned *lda,
+	int *info);
+
+IMPORT_PREFIX void
+dgeqrf_(const unsigned *m, const unsigned *n, field *a, const unsigned *lda,
+	field *tau, field *work, const unsigned *lwork, int *info);
+
+IMPORT_PREFIX void
+dorgqr_(const unsigned *m, const unsigned *n, const unsigned *k,
+	field *a, const unsigned *lda, const field *tau,
+	field *work, const unsigned *lwork, int *info);
+
+IMPORT_PREFIX void
+dormqr_(const char *side, const char *trans,
+	const unsigned *m, const unsigned *n, const unsigned *k,
+	const field *a, const unsigned *lda, const field *tau,
+	field *c, const unsigned *ldc,
+	field *work, const unsigned *lwork, int *info);
+
+#define h2_trtrs(uplo, trans, diag, n, nrhs, a, lda, b, ldb, info) \
+  dtrtrs_(uplo, trans, diag, n, nrhs, a, lda, b, ldb, info)
+
+#define h2_potrf(uplo, n, a, lda, info) \
+  dpotrf_(uplo, n, a, lda, info)
+
+#define h2_geqrf(m, n, a, lda, tau, work, lwork, info) \
+  dgeqrf_(m, n, a, lda, tau, work, lwork, info)
+
+#define h2_orgqr(m, n, k, a, lda, tau, work, lwork, info) \
+  dorgqr_(m, n, k, a, lda, tau, work, lwork, info)
+
+#define h2_ormqr(side, trans, m, n, k, a, lda, tau, c, ldc, work, lwork, info) \
+  dormqr_(side, trans, m, n, k, a, lda, tau, c, ldc, work, lwork, info)
+#endif
+
+/* ------------------------------------------------------------
+ LAPACK eigenvalues and singular values
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+IMPORT_PREFIX void
+zheev_(const char *jobz, const char *uplo, const unsigned *n,
+       field *a, const unsigned *lda, real *w,
+       field *work, const unsigned *lwork, real *rwork, int *info);
+
+IMPORT_PREFIX void
+zgesvd_(const char *jobu, const char *jobvt,
+	const unsigned *m, const unsigned *n,
+	field *a, const unsigned *lda, real *s,
+	field *u, const unsigned *ldu, field *vt, const unsigned *ldvt,
+	field *work, const unsigned *lwork, real *rwork, int *info);
+
+/** @brief Eigenvalues and eigenvectors of a self-adjoint matrix,
+ *  <tt>rwork</tt> needs @f$\max\{1,3n-2\}@f$ real numbers. */
+#define h2_heev(jobz, uplo, n, a, lda, w, work, lwork, rwork, info) \
+  zheev_(jobz, uplo, n, a, lda, w, work, lwork, rwork, info)
+
+/** @brief Singular value decomposition,
+ *  <tt>rwork</tt> needs @f$5\min\{m,n\}@f$ real numbers. */
+#define h2_gesvd(jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork, rwork, info) \
+  zgesvd_(jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork, rwork, info)
+#else
+IMPORT_PREFIX void
+dsyev_(const char *jobz, const char *uplo, const unsigned *n,
+       field *a, const unsigned *lda, real *w,
+       field *work, const unsigned *lwork, int *info);
+
+IMPORT_PREFIX void
+dgesvd_(const char *jobu, const char *jobvt,
+	const unsigned *m, const unsigned *n,
+	field *a, const unsigned *lda, real *s,
+	field *u, const unsigned *ldu, field *vt, const unsigned *ldvt,
+	field *work, const unsigned *lwork, int *info);
+
+#define h2_heev(jobz, uplo, n, a, lda, w, work, lwork, rwork, info) \
+  dsyev_(jobz, uplo, n, a, lda, w, work, lwork, info)
+
+#define h2_gesvd(jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork, rwork, info) \
+  dgesvd_(jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork, info)
+#endif
+
+#endif
+
+/** @} */
+
+#endif
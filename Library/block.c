@@ -17,6 +17,10 @@
 #include <GL/gl.h>
 #endif
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 #include "basic.h"
 #include "cluster.h"
 #include "block.h"
@@ -1126,6 +1130,152 @@ iterate_bycol_block(pcblock b, uint bname, uint rname, uint cname,
   del_blockentry(pb);
 }
 
+/* Leaf of a block tree with its numbers and estimated cost, used as
+ * an entry of the work queue of iterate_leaves_block */
+struct _leafentry {
+  pcblock   b;
+  uint      bname;
+  uint      rname;
+  uint      cname;
+  real      cost;
+};
+
+struct _leafqueue {
+  struct _leafentry *le;
+  uint      n;
+  real      (*cost) (pcblock b, void *data);
+  void     *data;
+};
+
+static    real
+default_cost_leaf(pcblock b, void *data)
+{
+  real      k;
+
+  (void) data;
+
+  /* The rank of low-rank blocks is usually bounded by a small multiple
+   * of the logarithm of the size. */
+  k = REAL_LOG(b->rc->size + b->cc->size + 1.0);
+
+  return estimate_leafcost_block(b, (uint) (k * k + 0.5));
+}
+
+static void
+collect_leaves(pcblock b, uint bname, uint rname, uint cname,
+	       uint pardepth, void *data)
+{
+  struct _leafqueue *lq = (struct _leafqueue *) data;
+  struct _leafentry *le;
+
+  (void) pardepth;
+
+  if (b->son == NULL) {
+    le = lq->le + lq->n;
+    le->b = b;
+    le->bname = bname;
+    le->rname = rname;
+    le->cname = cname;
+    le->cost = lq->cost(b, lq->data);
+    lq->n++;
+  }
+}
+
+static    uint
+leq_leafentry(uint i, uint j, void *data)
+{
+  struct _leafentry *le = (struct _leafentry *) data;
+
+  /* Sort by decreasing cost */
+  return (le[i].cost >= le[j].cost);
+}
+
+static void
+swap_leafentry(uint i, uint j, void *data)
+{
+  struct _leafentry *le = (struct _leafentry *) data;
+  struct _leafentry h;
+
+  h = le[i];
+  le[i] = le[j];
+  le[j] = h;
+}
+
+/* Collect the leaves of a block tree, sorted by decreasing cost.
+ * The largest blocks come first, so that the small ones can fill the
+ * gaps at the end. */
+static void
+collect_sorted_leaves(pcblock b, uint bname, uint rname, uint cname,
+		      real (*cost) (pcblock b, void *data), void *data,
+		      struct _leafqueue *lq)
+{
+  lq->le =
+    (struct _leafentry *) allocmem(sizeof(struct _leafentry) * b->desc);
+  lq->n = 0;
+  lq->cost = cost;
+  lq->data = data;
+
+  iterate_block(b, bname, rname, cname, collect_leaves, NULL, lq);
+
+  heapsort(lq->n, leq_leafentry, swap_leafentry, lq->le);
+}
+
+void
+iterate_leaves_block(pcblock b, uint bname, uint rname, uint cname,
+		     uint pardepth,
+		     real (*cost) (pcblock b, void *data),
+		     void (*leaf) (pcblock b, uint bname, uint rname,
+				   uint cname, uint pardepth, void *data),
+		     void *data, real *ttime)
+{
+  struct _leafqueue lq;
+  uint      threads;
+  uint      i;
+
+  collect_sorted_leaves(b, bname, rname, cname,
+			(cost ? cost : default_cost_leaf), data, &lq);
+
+  threads = getmaxthreads();
+  if (ttime)
+    for (i = 0; i < threads; i++)
+      ttime[i] = 0.0;
+
+#ifdef USE_OPENMP
+#pragma omp parallel if(pardepth > 0 && lq.n > 1)
+#endif
+  {
+    pstopwatch sw = NULL;
+    struct _leafentry *le;
+    uint      tid = 0;
+    int       j;
+
+#ifdef USE_OPENMP
+    tid = omp_get_thread_num();
+#endif
+
+    if (ttime) {
+      sw = new_stopwatch();
+      start_stopwatch(sw);
+    }
+
+    /* Every idle thread takes the next block from the queue */
+#ifdef USE_OPENMP
+#pragma omp for schedule(dynamic,1) nowait
+#endif
+    for (j = 0; j < (int) lq.n; j++) {
+      le = lq.le + j;
+      leaf(le->b, le->bname, le->rname, le->cname, 0, data);
+    }
+
+    if (sw) {
+      ttime[tid] = stop_stopwatch(sw);
+      del_stopwatch(sw);
+    }
+  }
+
+  freemem(lq.le);
+}
+
 /* ------------------------------------------------------------
  Enumeration
  ------------------------------------------------------------ */
@@ -1263,3 +1413,287 @@ compute_csp_block(pcblock b)
   freemem(cspdata);
   return csp;
 }
+
+/* ------------------------------------------------------------
+ Cost estimates
+ ------------------------------------------------------------ */
+
+real
+estimate_leafcost_block(pcblock b, uint k)
+{
+  real      rows = b->rc->size;
+  real      cols = b->cc->size;
+
+  if (b->a)
+    return (rows + cols) * k;
+
+  return rows * cols;
+}
+
+static void
+pre_estimate_cost_block(pcblock b, uint bname, uint rname, uint cname,
+			uint pardepth, void *data)
+{
+  pblockcost bc = (pblockcost) data;
+  size_t    rows = b->rc->size;
+  size_t    cols = b->cc->size;
+  size_t    k = bc->k;
+
+  (void) bname;
+  (void) rname;
+  (void) cname;
+  (void) pardepth;
+
+  if (b->son)
+    return;
+
+  if (b->a) {
+    bc->farleaves++;
+    bc->farentries += k * (rows + cols);
+    bc->couplingentries += k * k;
+    bc->hmvm += 2.0 * k * (rows + cols);
+    bc->h2mvm += 2.0 * k * k;
+  }
+  else {
+    bc->nearleaves++;
+    bc->nearentries += rows * cols;
+    bc->hmvm += 2.0 * rows * cols;
+    bc->h2mvm += 2.0 * rows * cols;
+  }
+  bc->assembly += estimate_leafcost_block(b, k);
+}
+
+void
+estimate_cost_block(pcblock b, uint k, pblockcost bc)
+{
+  bc->k = k;
+  bc->nearleaves = 0;
+  bc->farleaves = 0;
+  bc->nearentries = 0;
+  bc->farentries = 0;
+  bc->couplingentries = 0;
+  bc->assembly = 0.0;
+  bc->hmvm = 0.0;
+  bc->h2mvm = 0.0;
+
+  iterate_block(b, 0, 0, 0, pre_estimate_cost_block, NULL, bc);
+}
+
+static    real
+assembly_cost_leaf(pcblock b, void *data)
+{
+  uint      k = *(uint *) data;
+
+  return estimate_leafcost_block(b, k);
+}
+
+/* Distribute the multiplication with the leaves of b among the parts
+ * first, ..., first+parts-1 like fastaddeval_parallel_hmatrix_avector:
+ * up to the parallelization depth, every block row is handled by its
+ * own share of the parts, and below it, all work stays in one part */
+static void
+partition_rows_block(pcblock b, uint k, uint pardepth, uint first,
+		     uint parts, real * load)
+{
+  uint      rsons, csons;
+  uint      i, j, first1, parts1;
+
+  if (b->son == NULL) {
+    load[first] += 2.0 * estimate_leafcost_block(b, k);
+    return;
+  }
+
+  rsons = b->rsons;
+  csons = b->csons;
+
+  for (i = 0; i < rsons; i++) {
+    if (pardepth > 0) {
+      first1 = first + i * parts / rsons;
+      parts1 = first + (i + 1) * parts / rsons - first1;
+      if (parts1 == 0)
+	parts1 = 1;
+    }
+    else {
+      first1 = first;
+      parts1 = 1;
+    }
+
+    for (j = 0; j < csons; j++)
+      partition_rows_block(b->son[i + j * rsons], k,
+			   (pardepth > 0 ? pardepth - 1 : 0), first1, parts1,
+			   load);
+  }
+}
+
+real
+estimate_partition_block(pcblock b, uint k, bool mvm, uint parts,
+			 real * load)
+{
+  struct _leafqueue lq;
+  real      maxload, sum;
+  uint      i, j, jmin;
+
+  assert(parts > 0);
+
+  for (j = 0; j < parts; j++)
+    load[j] = 0.0;
+
+  if (mvm)
+    partition_rows_block(b, k, (uint) max_pardepth, 0, parts, load);
+  else {
+    collect_sorted_leaves(b, 0, 0, 0, assembly_cost_leaf, &k, &lq);
+
+    /* Every leaf goes to the part that becomes idle first, just like
+     * the dynamic queue of iterate_leaves_block */
+    for (i = 0; i < lq.n; i++) {
+      jmin = 0;
+      for (j = 1; j < parts; j++)
+	if (load[j] < load[jmin])
+	  jmin = j;
+      load[jmin] += lq.le[i].cost;
+    }
+
+    freemem(lq.le);
+  }
+
+  maxload = 0.0;
+  sum = 0.0;
+  for (j = 0; j < parts; j++) {
+    maxload = REAL_MAX(maxload, load[j]);
+    sum += load[j];
+  }
+
+  return (sum > 0.0 ? maxload * parts / sum : 1.0);
+}
+
+/* ------------------------------------------------------------
+ File I/O
+ ------------------------------------------------------------ */
+
+/* Sons of a block use either the father's cluster or one of its sons */
+static    uint
+son_index(pccluster t, pccluster s)
+{
+  uint      i;
+
+  if (s == t)
+    return 0;
+
+  for (i = 0; i < t->sons && t->son[i] != s; i++);
+  assert(i < t->sons);
+
+  return i + 1;
+}
+
+static    pcluster
+son_cluster(pbinaryfile bf, pcluster t, uint k)
+{
+  if (!check_binaryfile(bf, k <= t->sons))
+    return t;
+
+  return (k == 0 ? t : t->son[k - 1]);
+}
+
+void
+put_binary_block(pbinaryfile bf, pcblock b)
+{
+  pcblock   b1;
+  uint      rsons = b->rsons;
+  uint      csons = b->csons;
+  uint      i, j;
+
+  put_uint_binaryfile(bf, b->a);
+  put_uint_binaryfile(bf, (b->son ? rsons : 0));
+  put_uint_binaryfile(bf, (b->son ? csons : 0));
+
+  if (b->son)
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	b1 = b->son[i + j * rsons];
+
+	put_uint_binaryfile(bf, son_index(b->rc, b1->rc));
+	put_uint_binaryfile(bf, son_index(b->cc, b1->cc));
+	put_binary_block(bf, b1);
+      }
+}
+
+pblock
+get_binary_block(pbinaryfile bf, pcluster rc, pcluster cc)
+{
+  pblock    b;
+  pcluster  rc1, cc1;
+  bool      a;
+  uint      rsons, csons;
+  uint      i, j;
+
+  a = get_uint_binaryfile(bf);
+
+  /* Every son needs at least two indices and its own header */
+  rsons = get_count_binaryfile(bf, 5 * sizeof(uint));
+  csons = get_count_binaryfile(bf, (size_t) (rsons > 0 ? rsons : 1)
+			       * 5 * sizeof(uint));
+  if (!check_binaryfile(bf, (rsons == 0) == (csons == 0)))
+    rsons = csons = 0;
+
+  b = new_block(rc, cc, a, rsons, csons);
+
+  for (i = 0; i < rsons; i++)
+    for (j = 0; j < csons; j++) {
+      rc1 = son_cluster(bf, rc, get_uint_binaryfile(bf));
+      cc1 = son_cluster(bf, cc, get_uint_binaryfile(bf));
+      b->son[i + j * rsons] = get_binary_block(bf, rc1, cc1);
+    }
+
+  update_block(b);
+
+  return b;
+}
+
+bool
+write_binary_block(pcblock b, const char *filename)
+{
+  pbinaryfile bf;
+
+  bf = new_write_binaryfile(filename, BINARY_BLOCK);
+  if (bf == NULL)
+    return false;
+
+  put_binary_cluster(bf, b->rc);
+  put_uint_binaryfile(bf, (b->rc == b->cc));
+  if (b->rc != b->cc)
+    put_binary_cluster(bf, b->cc);
+
+  put_binary_block(bf, b);
+
+  return del_binaryfile(bf);
+}
+
+pblock
+read_binary_block(const char *filename)
+{
+  pbinaryfile bf;
+  pblock    b;
+  pcluster  rc, cc;
+
+  bf = new_read_binaryfile(filename, BINARY_BLOCK, false);
+  if (bf == NULL)
+    return NULL;
+
+  rc = get_binary_cluster(bf);
+  cc = (get_uint_binaryfile(bf) ? rc : get_binary_cluster(bf));
+
+  b = get_binary_block(bf, rc, cc);
+
+  if (!del_binaryfile(bf)) {
+    del_block(b);
+    if (cc != rc) {
+      freemem(cc->idx);
+      del_cluster(cc);
+    }
+    freemem(rc->idx);
+    del_cluster(rc);
+    return NULL;
+  }
+
+  return b;
+}
@@ -25,6 +25,15 @@ typedef block *pblock;
 /** @brief Pointer to constant @ref block object.*/
 typedef const block *pcblock;
 
+/** @brief Predicted storage and work for a block cluster tree.*/
+typedef struct _blockcost blockcost;
+
+/** @brief Pointer to @ref blockcost object.*/
+typedef blockcost *pblockcost;
+
+/** @brief Pointer to constant @ref blockcost object.*/
+typedef const blockcost *pcblockcost;
+
 #ifdef USE_CAIRO
 #include <cairo/cairo.h>
 #endif
@@ -377,6 +386,37 @@ iterate_bycol_block(pcblock b, uint bname, uint rname, uint cname,
         void (*post)(pcblock b, uint bname, uint rname, uint cname, uint pardepth,
             void *data), void *data);
 
+/** @brief Iterate through the leaves of a @ref block cluster tree
+ *  using a dynamic work queue.
+ *
+ *  All leaves are collected in a queue sorted by decreasing estimated
+ *  cost. If the iterator works with multiple threads, every thread
+ *  takes the next leaf from the queue as soon as it has finished its
+ *  current one, so a few expensive blocks in one row no longer keep
+ *  the other threads idle. There is no guarantee regarding the row or
+ *  column clusters handled in parallel, so <tt>leaf</tt> has to be
+ *  safe for arbitrary pairs of blocks.
+ *
+ *  @param b Block cluster tree.
+ *  @param bname Number of the block cluster tree.
+ *  @param rname Number of the row cluster tree in <tt>b</tt>.
+ *  @param cname Number of the column cluster tree in <tt>b</tt>.
+ *  @param pardepth Parallelization depth, the queue is processed in
+ *         parallel if <tt>pardepth > 0</tt>.
+ *  @param cost Estimated cost of a leaf, called with <tt>data</tt>.
+ *         If <tt>NULL</tt>, the cost is estimated by the size and
+ *         admissibility of the block.
+ *  @param leaf Function to be called for every leaf.
+ *  @param data Auxiliary data for Callback Functions.
+ *  @param ttime If not <tt>NULL</tt>, an array of length
+ *         @ref getmaxthreads that receives the time in seconds that
+ *         each thread spent processing the queue. */
+HEADER_PREFIX void
+iterate_leaves_block(pcblock b, uint bname, uint rname, uint cname,
+    uint pardepth, real (*cost)(pcblock b, void *data),
+    void (*leaf)(pcblock b, uint bname, uint rname, uint cname, uint pardepth,
+        void *data), void *data, real *ttime);
+
 /* ------------------------------------------------------------
  Enumeration
  ------------------------------------------------------------ */
@@ -436,6 +476,144 @@ getdepth_block(pcblock b);
 HEADER_PREFIX uint
 compute_csp_block(pcblock b);
 
+/* ------------------------------------------------------------
+ Cost estimates
+ ------------------------------------------------------------ */
+
+/** @brief Predicted storage and work for a block cluster tree.
+ *
+ *  All numbers are computed from the block cluster tree alone,
+ *  assuming that every admissible leaf is approximated with the same
+ *  rank <tt>k</tt>. Multiplying the numbers of coefficients by
+ *  <tt>sizeof(field)</tt> gives the storage in bytes. */
+struct _blockcost {
+  /** @brief Rank assumed for admissible leaves.*/
+  uint k;
+  /** @brief Number of inadmissible leaves.*/
+  uint nearleaves;
+  /** @brief Number of admissible leaves.*/
+  uint farleaves;
+  /** @brief Number of coefficients of the inadmissible leaves.*/
+  size_t nearentries;
+  /** @brief Number of coefficients of the low-rank factors of the
+   *  admissible leaves of an @ref hmatrix.*/
+  size_t farentries;
+  /** @brief Number of coefficients of the coupling matrices of the
+   *  admissible leaves of an @ref h2matrix.*/
+  size_t couplingentries;
+  /** @brief Number of kernel evaluations required for the assembly,
+   *  see @ref estimate_leafcost_block.*/
+  real assembly;
+  /** @brief Floating point operations for a matrix-vector
+   *  multiplication with an @ref hmatrix.*/
+  real hmvm;
+  /** @brief Floating point operations for the nearfield and coupling
+   *  part of a matrix-vector multiplication with an @ref h2matrix,
+   *  i.e., without the forward and backward transformations.*/
+  real h2mvm;
+};
+
+/** @brief Estimate the cost of assembling a leaf of a block cluster tree.
+ *
+ *  For an inadmissible leaf, all @f$ |\hat t| |\hat s| @f$ entries
+ *  have to be computed, for an admissible leaf interpolation and
+ *  adaptive cross approximation require about
+ *  @f$ k (|\hat t| + |\hat s|) @f$ kernel evaluations.
+ *
+ *  @param b Leaf of a block cluster tree.
+ *  @param k Rank of admissible leaves.
+ *  @returns Estimated number of kernel evaluations. */
+HEADER_PREFIX real
+estimate_leafcost_block(pcblock b, uint k);
+
+/** @brief Predict storage and work for a block cluster tree.
+ *
+ *  This function can be used to compare different admissibility
+ *  parameters or leaf sizes before any matrix is assembled.
+ *
+ *  @param b Block cluster tree.
+ *  @param k Rank of admissible leaves, e.g., @f$ m^3 @f$ for
+ *         interpolation of order @f$ m @f$ in three dimensions.
+ *  @param bc Receives the estimates. */
+HEADER_PREFIX void
+estimate_cost_block(pcblock b, uint k, pblockcost bc);
+
+/** @brief Predict the distribution of the work among several threads.
+ *
+ *  For the assembly, the dynamic work queue of
+ *  @ref iterate_leaves_block is simulated: the leaves are sorted by
+ *  decreasing cost and every leaf is assigned to the part with the
+ *  smallest load so far.
+ *
+ *  For the matrix-vector multiplication, the row partition of
+ *  @ref fastaddeval_parallel_hmatrix_avector is simulated: up to the
+ *  depth @ref max_pardepth, the parts are split evenly among the block
+ *  rows, and every leaf below this depth is assigned to the part of
+ *  its block row.
+ *
+ *  @param b Block cluster tree.
+ *  @param k Rank of admissible leaves.
+ *  @param mvm Set to <tt>true</tt> to distribute the work of an
+ *         @ref hmatrix matrix-vector multiplication, <tt>false</tt> to
+ *         distribute the kernel evaluations of the assembly.
+ *  @param parts Number of parts, usually @ref getmaxthreads.
+ *  @param load Array of length <tt>parts</tt>, receives the predicted
+ *         load of each part.
+ *  @returns Ratio of the maximal and the average load, 1 for a
+ *         perfectly balanced distribution. */
+HEADER_PREFIX real
+estimate_partition_block(pcblock b, uint k, bool mvm, uint parts, real *load);
+
+/* ------------------------------------------------------------
+ File I/O
+ ------------------------------------------------------------ */
+
+/** @brief Write a block tree to the structure section of a
+ *  @ref binaryfile.
+ *
+ *  Only the admissibility flags and the structure of the tree are
+ *  written, the cluster trees have to be written separately by
+ *  @ref put_binary_cluster.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param b Block tree. */
+HEADER_PREFIX void
+put_binary_block(pbinaryfile bf, pcblock b);
+
+/** @brief Read a block tree from the structure section of a
+ *  @ref binaryfile.
+ *
+ *  If the file is damaged, the error flag of <tt>bf</tt> is set and
+ *  the returned tree should be discarded.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @param rc Row cluster tree.
+ *  @param cc Column cluster tree.
+ *  @returns Block tree for <tt>rc</tt> and <tt>cc</tt>. */
+HEADER_PREFIX pblock
+get_binary_block(pbinaryfile bf, pcluster rc, pcluster cc);
+
+/** @brief Write a block tree and its cluster trees into a binary file.
+ *
+ *  @param b Block tree, <tt>b->rc</tt> and <tt>b->cc</tt> have to be
+ *     the roots of their cluster trees.
+ *  @param filename Name of the target file.
+ *  @returns <tt>true</tt> if the file has been written successfully. */
+HEADER_PREFIX bool
+write_binary_block(pcblock b, const char *filename);
+
+/** @brief Read a block tree and its cluster trees from a binary file.
+ *
+ *  @remark The cluster trees <tt>b->rc</tt> and <tt>b->cc</tt>
+ *  and their index arrays have to be released by the caller.
+ *  If both trees were identical when the file was written,
+ *  <tt>b->rc</tt> and <tt>b->cc</tt> point to the same tree.
+ *
+ *  @param filename Name of the source file.
+ *  @returns Block tree, or <tt>NULL</tt> if the file could not be read. */
+HEADER_PREFIX pblock
+read_binary_block(const char *filename);
+
 #endif
 
 /** @}*/
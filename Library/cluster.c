@@ -9,6 +9,7 @@
 
 #include "basic.h"
 #include "cluster.h"
+#include "binaryio.h"
 
 /* ------------------------------------------------------------
    Constructors and destructors
@@ -27,6 +28,7 @@ new_cluster(uint size, uint * idx, uint sons, uint dim)
   t->idx = idx;
   t->bmin = allocreal(dim);
   t->bmax = allocreal(dim);
+  t->type = 0;
   t->sons = sons;
   if (sons > 0) {
     t->son = (pcluster *) allocmem((size_t) sons * sizeof(pcluster));
@@ -398,3 +400,131 @@ enumerate_cluster(pcluster t)
 
   return tn;
 }
+
+/* ------------------------------------------------------------
+   File I/O
+   ------------------------------------------------------------ */
+
+static void
+put_node(pbinaryfile bf, pccluster t, const uint * idx)
+{
+  uint      i;
+
+  put_uint_binaryfile(bf, t->size);
+  put_uint_binaryfile(bf, (t->size > 0 ? (uint) (t->idx - idx) : 0));
+  put_uint_binaryfile(bf, t->sons);
+  put_uint_binaryfile(bf, t->type);
+
+  for (i = 0; i < t->dim; i++)
+    put_real_binaryfile(bf, t->bmin[i]);
+  for (i = 0; i < t->dim; i++)
+    put_real_binaryfile(bf, t->bmax[i]);
+
+  for (i = 0; i < t->sons; i++)
+    put_node(bf, t->son[i], idx);
+}
+
+void
+put_binary_cluster(pbinaryfile bf, pccluster t)
+{
+  uint      i;
+
+  put_uint_binaryfile(bf, t->size);
+  put_uint_binaryfile(bf, t->dim);
+
+  for (i = 0; i < t->size; i++)
+    put_uint_binaryfile(bf, t->idx[i]);
+
+  put_node(bf, t, t->idx);
+}
+
+static    pcluster
+get_node(pbinaryfile bf, uint * idx, uint total, uint dim)
+{
+  pcluster  t;
+  uint      size, off, sons;
+  uint      i;
+
+  size = get_uint_binaryfile(bf);
+  off = get_uint_binaryfile(bf);
+  sons = get_count_binaryfile(bf, 4 * sizeof(uint) + 2 * dim * sizeof(real));
+
+  /* Index range has to be contained in the root's index array */
+  if (!check_binaryfile(bf, off <= total && size <= total - off)) {
+    size = off = sons = 0;
+  }
+
+  t = new_cluster(size, idx + off, sons, dim);
+  t->type = get_uint_binaryfile(bf);
+
+  for (i = 0; i < dim; i++)
+    t->bmin[i] = get_real_binaryfile(bf);
+  for (i = 0; i < dim; i++)
+    t->bmax[i] = get_real_binaryfile(bf);
+
+  for (i = 0; i < sons; i++)
+    t->son[i] = get_node(bf, idx, total, dim);
+
+  update_cluster(t);
+
+  return t;
+}
+
+pcluster
+get_binary_cluster(pbinaryfile bf)
+{
+  pcluster  t;
+  uint     *idx;
+  uint      size, dim;
+  uint      i;
+
+  size = get_count_binaryfile(bf, sizeof(uint));
+  dim = get_count_binaryfile(bf, 2 * sizeof(real));
+
+  idx = allocuint(size);
+  for (i = 0; i < size; i++)
+    idx[i] = get_uint_binaryfile(bf);
+
+  t = get_node(bf, idx, size, dim);
+  /* Keep the index array with the root so that the caller can
+     release it even if the file is damaged */
+  if (!check_binaryfile(bf, t->size == size && t->idx == idx))
+    t->idx = idx;
+
+  return t;
+}
+
+bool
+write_binary_cluster(pccluster t, const char *filename)
+{
+  pbinaryfile bf;
+
+  bf = new_write_binaryfile(filename, BINARY_CLUSTER);
+  if (bf == NULL)
+    return false;
+
+  put_binary_cluster(bf, t);
+
+  return del_binaryfile(bf);
+}
+
+pcluster
+read_binary_cluster(const char *filename)
+{
+  pbinaryfile bf;
+  pcluster  t;
+
+  bf = new_read_binaryfile(filename, BINARY_CLUSTER, false);
+  if (bf == NULL)
+    return NULL;
+
+  t = get_binary_cluster(bf);
+
+  if (!del_binaryfile(bf)) {
+    freemem(t->idx);
+    del_cluster(t);
+    return NULL;
+  }
+
+  return t;
+}
@@ -26,6 +26,7 @@ typedef cluster* pcluster;
 /** @brief Pointer to constant @ref cluster object.*/
 typedef const cluster *pccluster;
 
+#include "binaryio.h"
 #include "settings.h"
 
 /** @brief Representation of cluster trees.
@@ -319,6 +320,57 @@ iterate_parallel_cluster(pccluster t, uint tname, uint pardepth,
 HEADER_PREFIX pcluster *
 enumerate_cluster(pcluster t);
 
+/* ------------------------------------------------------------
+ File I/O
+ ------------------------------------------------------------ */
+
+/** @brief Write a cluster tree to the structure section of a
+ *  @ref binaryfile.
+ *
+ *  The index array of the root and the sizes, index offsets and
+ *  bounding boxes of all clusters are written in depth-first order.
+ *
+ *  @remark All clusters have to use parts of the index array of the
+ *  root, as it is the case for all clustering strategies.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param t Root of the cluster tree. */
+HEADER_PREFIX void
+put_binary_cluster(pbinaryfile bf, pccluster t);
+
+/** @brief Read a cluster tree from the structure section of a
+ *  @ref binaryfile.
+ *
+ *  If the file is damaged, the error flag of <tt>bf</tt> is set and
+ *  the returned tree should be discarded.
+ *
+ *  @remark As for all clustering strategies, the index array
+ *  <tt>t->idx</tt> of the root has to be released by the caller.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @returns Root of the cluster tree. */
+HEADER_PREFIX pcluster
+get_binary_cluster(pbinaryfile bf);
+
+/** @brief Write a cluster tree into a binary file.
+ *
+ *  @param t Root of the cluster tree.
+ *  @param filename Name of the target file.
+ *  @returns <tt>true</tt> if the file has been written successfully. */
+HEADER_PREFIX bool
+write_binary_cluster(pccluster t, const char *filename);
+
+/** @brief Read a cluster tree from a binary file.
+ *
+ *  @remark The index array <tt>t->idx</tt> of the root has to be
+ *  released by the caller.
+ *
+ *  @param filename Name of the source file.
+ *  @returns Root of the cluster tree, or <tt>NULL</tt> if the file
+ *     could not be read. */
+HEADER_PREFIX pcluster
+read_binary_cluster(const char *filename);
+
 /** @}*/
 
 #endif
@@ -34,6 +34,12 @@ init_raw_clusterbasis(pclusterbasis cb, pccluster t)
 
   cb->Z = NULL;
 
+  cb->store = NULL;
+  cb->storesize = 0;
+  cb->bin = NULL;
+
+  cb->batch = NULL;
+
 #ifdef USE_OPENMP
 #pragma omp atomic
 #endif
@@ -106,6 +112,13 @@ uninit_clusterbasis(pclusterbasis cb)
   uninit_amatrix(&cb->V);
   uninit_amatrix(&cb->E);
 
+  if (cb->bin)
+    unref_binarystore(cb->bin);
+  else if (cb->store)
+    freemem(cb->store);
+
+  release_batch_clusterbasis(cb);
+
   assert(active_clusterbasis > 0);
 
 #ifdef USE_OPENMP
@@ -217,6 +230,8 @@ resize_clusterbasis(pclusterbasis cb, int k)
 {
   uint      i;
 
+  assert(cb->batch == NULL);
+
   if (cb->sons > 0) {
     for (i = 0; i < cb->sons; i++)
       resize_amatrix(&cb->son[i]->E, cb->son[i]->k, k);
@@ -318,6 +333,474 @@ clonestructure_clusterbasis(pcclusterbasis cb)
   return cbnew;
 }
 
+/* ------------------------------------------------------------
+   Contiguous storage
+   ------------------------------------------------------------ */
+
+static    size_t
+count_store(pcclusterbasis cb)
+{
+  size_t    size;
+  uint      i;
+
+  size = 0;
+  if (cb->E.owner == NULL)
+    size += (size_t) cb->E.rows * cb->E.cols;
+  if (cb->V.owner == NULL)
+    size += (size_t) cb->V.rows * cb->V.cols;
+
+  for (i = 0; i < cb->sons; i++)
+    size += count_store(cb->son[i]);
+
+  return size;
+}
+
+static void
+move_to_store(pamatrix a, pfield store, void *owner, size_t *off)
+{
+  if (a->owner == NULL && a->rows > 0 && a->cols > 0) {
+    move_amatrix(a, store + *off, owner);
+    *off += (size_t) a->rows * a->cols;
+  }
+}
+
+static void
+freeze_store(pclusterbasis cb, pfield store, void *owner, size_t *off)
+{
+  uint      i;
+
+  move_to_store(&cb->E, store, owner, off);
+  move_to_store(&cb->V, store, owner, off);
+
+  for (i = 0; i < cb->sons; i++)
+    freeze_store(cb->son[i], store, owner, off);
+}
+
+void
+freeze_clusterbasis(pclusterbasis cb)
+{
+  size_t    size, off;
+
+  assert(cb->store == NULL);
+
+  size = count_store(cb);
+  if (size == 0)
+    return;
+
+  cb->store = allocfield(size);
+  cb->storesize = size;
+
+  off = 0;
+  freeze_store(cb, cb->store, cb, &off);
+  assert(off == size);
+}
+
+/* ------------------------------------------------------------
+   Batched transformations
+   ------------------------------------------------------------ */
+
+static    uint
+count_nodes(pcclusterbasis cb, uint level, uint *levels)
+{
+  uint      nodes;
+  uint      i;
+
+  if (level + 1 > *levels)
+    *levels = level + 1;
+
+  nodes = 1;
+  for (i = 0; i < cb->sons; i++)
+    nodes += count_nodes(cb->son[i], level + 1, levels);
+
+  return nodes;
+}
+
+void
+prepare_batch_clusterbasis(pclusterbasis cb)
+{
+  pclusterbasisbatch b;
+  pcclusterbasis c;
+  uint     *level;
+  uint      i, j, n, off, poff;
+
+  assert(cb->batch == NULL);
+
+  b = (pclusterbasisbatch) allocmem(sizeof(clusterbasisbatch));
+
+  b->levels = 0;
+  b->nodes = count_nodes(cb, 0, &b->levels);
+  b->levelstart = allocuint(b->levels + 1);
+  b->cb = (pcclusterbasis *) allocmem(sizeof(pcclusterbasis) * b->nodes);
+  b->off = allocuint(b->nodes);
+  b->poff = allocuint(b->nodes);
+  b->son = allocuint(b->nodes);
+  b->ktree = cb->ktree;
+
+  /* Breadth-first traversal, so the clusters are sorted by level and
+   * the sons of each cluster are consecutive */
+  level = allocuint(b->nodes);
+  b->cb[0] = cb;
+  b->off[0] = 0;
+  b->poff[0] = 0;
+  level[0] = 0;
+  n = 1;
+  for (i = 0; i < b->nodes; i++) {
+    c = b->cb[i];
+
+    b->son[i] = n;
+    off = b->off[i] + c->k;
+    poff = b->poff[i];
+    for (j = 0; j < c->sons; j++) {
+      b->cb[n] = c->son[j];
+      b->off[n] = off;
+      b->poff[n] = poff;
+      level[n] = level[i] + 1;
+      n++;
+
+      off += c->son[j]->ktree;
+      poff += c->son[j]->t->size;
+    }
+    assert(c->sons == 0 || off == b->off[i] + c->ktree);
+  }
+  assert(n == b->nodes);
+
+  j = 0;
+  for (i = 0; i < b->levels; i++) {
+    b->levelstart[i] = j;
+    while (j < b->nodes && level[j] == i)
+      j++;
+  }
+  b->levelstart[b->levels] = j;
+  assert(j == b->nodes);
+
+  freemem(level);
+
+  cb->batch = b;
+}
+
+void
+release_batch_clusterbasis(pclusterbasis cb)
+{
+  pclusterbasisbatch b = cb->batch;
+
+  if (b == NULL)
+    return;
+
+  freemem(b->son);
+  freemem(b->poff);
+  freemem(b->off);
+  freemem(b->cb);
+  freemem(b->levelstart);
+  freemem(b);
+
+  cb->batch = NULL;
+}
+
+/* y += A^* x for a small matrix A */
+static void
+addevaltrans_batch(pcamatrix a, pcfield x, pfield y)
+{
+  pcfield   aa = a->a;
+  longindex lda = a->ld;
+  field     sum;
+  uint      i, j;
+
+  for (j = 0; j < a->cols; j++) {
+    sum = 0.0;
+    for (i = 0; i < a->rows; i++)
+      sum += CONJ(aa[i + j * lda]) * x[i];
+    y[j] += sum;
+  }
+}
+
+/* y += A x for a small matrix A */
+static void
+addeval_batch(pcamatrix a, pcfield x, pfield y)
+{
+  pcfield   aa = a->a;
+  longindex lda = a->ld;
+  field     sum;
+  uint      i, j;
+
+  for (i = 0; i < a->rows; i++) {
+    sum = 0.0;
+    for (j = 0; j < a->cols; j++)
+      sum += aa[i + j * lda] * x[j];
+    y[i] += sum;
+  }
+}
+
+/* Forward transformation for all clusters of one level, X has
+ * <tt>cols</tt> columns, the source is either the vector x in the
+ * original numbering or the matrix Xp in the cluster numbering */
+static void
+forward_batch_level(pcclusterbasisbatch b, uint l, pcfield x,
+		    pcfield Xp, longindex ldp, pfield Xt, longindex ldt,
+		    uint cols)
+{
+  pcclusterbasis c, c1;
+  pcfield   xp;
+  pfield    xc, xl;
+  uint      i, j, n, n0, n1, s;
+
+  n0 = b->levelstart[l];
+  n1 = b->levelstart[l + 1];
+
+#ifdef USE_OPENMP
+#pragma omp parallel for if(max_pardepth > 0 && n1 > n0 + 1), private(c,c1,xp,xc,xl,i,j,s)
+#endif
+  for (n = n0; n < n1; n++) {
+    c = b->cb[n];
+
+    for (j = 0; j < cols; j++) {
+      xc = Xt + b->off[n] + j * ldt;
+
+      for (i = 0; i < c->k; i++)
+	xc[i] = 0.0;
+
+      if (c->sons > 0) {
+	/* Collect coefficients of the sons */
+	for (s = 0; s < c->sons; s++) {
+	  c1 = b->cb[b->son[n] + s];
+	  addevaltrans_batch(&c1->E, Xt + b->off[b->son[n] + s] + j * ldt,
+			     xc);
+	}
+      }
+      else {
+	/* Copy permuted entries and multiply by leaf matrix */
+	xl = xc + c->k;
+	if (x) {
+	  for (i = 0; i < c->t->size; i++)
+	    xl[i] = x[c->t->idx[i]];
+	}
+	else {
+	  xp = Xp + b->poff[n] + j * ldp;
+	  for (i = 0; i < c->t->size; i++)
+	    xl[i] = xp[i];
+	}
+	addevaltrans_batch(&c->V, xl, xc);
+      }
+    }
+  }
+}
+
+/* Backward transformation for all clusters of one level, the target
+ * is either the vector y in the original numbering or the matrix Yp
+ * in the cluster numbering */
+static void
+backward_batch_level(pcclusterbasisbatch b, uint l, pfield y,
+		     pfield Yp, longindex ldp, pfield Yt, longindex ldt,
+		     uint cols)
+{
+  pcclusterbasis c, c1;
+  pfield    yp, yc, yl;
+  uint      i, j, n, n0, n1, s;
+
+  n0 = b->levelstart[l];
+  n1 = b->levelstart[l + 1];
+
+#ifdef USE_OPENMP
+#pragma omp parallel for if(max_pardepth > 0 && n1 > n0 + 1), private(c,c1,yp,yc,yl,i,j,s)
+#endif
+  for (n = n0; n < n1; n++) {
+    c = b->cb[n];
+
+    for (j = 0; j < cols; j++) {
+      yc = Yt + b->off[n] + j * ldt;
+
+      if (c->sons > 0) {
+	/* Distribute coefficients to the sons */
+	for (s = 0; s < c->sons; s++) {
+	  c1 = b->cb[b->son[n] + s];
+	  addeval_batch(&c1->E, yc, Yt + b->off[b->son[n] + s] + j * ldt);
+	}
+      }
+      else {
+	/* Multiply by leaf matrix and add permuted entries */
+	yl = yc + c->k;
+	addeval_batch(&c->V, yc, yl);
+	if (y) {
+	  for (i = 0; i < c->t->size; i++)
+	    y[c->t->idx[i]] += yl[i];
+	}
+	else {
+	  yp = Yp + b->poff[n] + j * ldp;
+	  for (i = 0; i < c->t->size; i++)
+	    yp[i] += yl[i];
+	}
+      }
+    }
+  }
+}
+
+static void
+forward_batch(pcclusterbasis cb, pcfield x, pcfield Xp, longindex ldp,
+	      pfield Xt, longindex ldt, uint cols)
+{
+  pcclusterbasisbatch b = cb->batch;
+  uint      l;
+
+  assert(b->ktree == cb->ktree);
+
+  for (l = b->levels; l-- > 0;)
+    forward_batch_level(b, l, x, Xp, ldp, Xt, ldt, cols);
+}
+
+static void
+backward_batch(pcclusterbasis cb, pfield y, pfield Yp, longindex ldp,
+	       pfield Yt, longindex ldt, uint cols)
+{
+  pcclusterbasisbatch b = cb->batch;
+  uint      l;
+
+  assert(b->ktree == cb->ktree);
+
+  for (l = 0; l < b->levels; l++)
+    backward_batch_level(b, l, y, Yp, ldp, Yt, ldt, cols);
+}
+
+/* ------------------------------------------------------------
+   File I/O
+   ------------------------------------------------------------ */
+
+void
+put_binary_clusterbasis(pbinaryfile bf, pcclusterbasis cb)
+{
+  uint      i;
+
+  put_uint_binaryfile(bf, cb->k);
+  put_uint_binaryfile(bf, cb->sons);
+  put_uint_binaryfile(bf, cb->V.rows);
+  put_uint_binaryfile(bf, cb->V.cols);
+  put_uint_binaryfile(bf, cb->E.rows);
+  put_uint_binaryfile(bf, cb->E.cols);
+
+  for (i = 0; i < cb->sons; i++) {
+    assert(cb->son[i]->t == cb->t->son[i]);
+
+    put_binary_clusterbasis(bf, cb->son[i]);
+  }
+}
+
+void
+putdata_binary_clusterbasis(pbinaryfile bf, pcclusterbasis cb)
+{
+  uint      i;
+
+  put_amatrix_binaryfile(bf, &cb->E);
+  put_amatrix_binaryfile(bf, &cb->V);
+
+  for (i = 0; i < cb->sons; i++)
+    putdata_binary_clusterbasis(bf, cb->son[i]);
+}
+
+static    pclusterbasis
+get_binary_node(pbinaryfile bf, pccluster t)
+{
+  pclusterbasis cb, cb1;
+  uint      k, sons, vrows, vcols, erows, ecols;
+  uint      i;
+
+  k = get_uint_binaryfile(bf);
+  sons = get_uint_binaryfile(bf);
+  vrows = get_uint_binaryfile(bf);
+  vcols = get_uint_binaryfile(bf);
+  erows = get_uint_binaryfile(bf);
+  ecols = get_uint_binaryfile(bf);
+
+  /* Sons have to match the cluster tree, and leaf matrices have to
+     match the cluster */
+  if (!check_binaryfile(bf, (sons == 0 || sons == t->sons)
+			&& (sons > 0 || k == 0
+			    || (vrows == t->size && vcols == k))))
+    sons = 0;
+
+  cb = (sons > 0 ? new_clusterbasis(t) : new_leaf_clusterbasis(t));
+  cb->k = k;
+
+  /* Same order as in putdata_binary_clusterbasis */
+  uninit_amatrix(&cb->E);
+  init_pointer_amatrix(&cb->E,
+		       get_data_binaryfile(bf, (size_t) erows * ecols),
+		       erows, ecols);
+  uninit_amatrix(&cb->V);
+  init_pointer_amatrix(&cb->V,
+		       get_data_binaryfile(bf, (size_t) vrows * vcols),
+		       vrows, vcols);
+
+  for (i = 0; i < sons; i++) {
+    cb1 = get_binary_node(bf, t->son[i]);
+    ref_clusterbasis(cb->son + i, cb1);
+  }
+
+  update_clusterbasis(cb);
+
+  return cb;
+}
+
+pclusterbasis
+get_binary_clusterbasis(pbinaryfile bf, pccluster t)
+{
+  pclusterbasis cb;
+  size_t    base;
+
+  base = bf->pos;
+
+  cb = get_binary_node(bf, t);
+
+  /* The coefficients remain in the storage provided by the file */
+  cb->storesize = bf->pos - base;
+  if (cb->storesize > 0) {
+    cb->store = bf->store->data + base;
+    ref_binarystore(&cb->bin, bf->store);
+  }
+
+  return cb;
+}
+
+bool
+write_binary_clusterbasis(pcclusterbasis cb, const char *filename)
+{
+  pbinaryfile bf;
+
+  bf = new_write_binaryfile(filename, BINARY_CLUSTERBASIS);
+  if (bf == NULL)
+    return false;
+
+  put_binary_cluster(bf, cb->t);
+  put_binary_clusterbasis(bf, cb);
+
+  start_data_binaryfile(bf);
+
+  putdata_binary_clusterbasis(bf, cb);
+
+  return del_binaryfile(bf);
+}
+
+pclusterbasis
+read_binary_clusterbasis(const char *filename, bool map)
+{
+  pbinaryfile bf;
+  pclusterbasis cb;
+  pcluster  t;
+
+  bf = new_read_binaryfile(filename, BINARY_CLUSTERBASIS, map);
+  if (bf == NULL)
+    return NULL;
+
+  t = get_binary_cluster(bf);
+  cb = get_binary_clusterbasis(bf, t);
+
+  if (!del_binaryfile(bf)) {
+    del_clusterbasis(cb);
+    freemem(t->idx);
+    del_cluster(t);
+    return NULL;
+  }
+
+  return cb;
+}
+
 /* ------------------------------------------------------------
    Statistics
    ------------------------------------------------------------ */
@@ -337,6 +820,14 @@ getsize_clusterbasis(pcclusterbasis cb)
   sz = (size_t) sizeof(clusterbasis);
   sz += getsize_heap_amatrix(&cb->V);
   sz += getsize_heap_amatrix(&cb->E);
+  sz += (size_t) sizeof(field) * cb->storesize;
+
+  if (cb->batch) {
+    sz += (size_t) sizeof(clusterbasisbatch);
+    sz += (size_t) sizeof(uint) * (cb->batch->levels + 1);
+    sz += (size_t) (sizeof(pcclusterbasis) + 3 * sizeof(uint))
+      * cb->batch->nodes;
+  }
 
   if (cb->sons > 0) {
     sz += (size_t) sizeof(pclusterbasis) * cb->sons;
@@ -509,6 +1000,12 @@ new_coeffs_clusterbasis_avector(pcclusterbasis cb)
 void
 forward_clusterbasis_avector(pcclusterbasis cb, pcavector x, pavector xt)
 {
+  if (cb->batch) {
+    assert(xt->dim == cb->ktree);
+    forward_batch(cb, x->v, NULL, 0, xt->v, xt->dim, 1);
+    return;
+  }
+
 #ifdef USE_OPENMP
   forward_parallel_clusterbasis_avector(cb, x, xt, max_pardepth);
 #else
@@ -723,17 +1220,28 @@ forward_notransfer_clusterbasis_avector(pcclusterbasis cb, pcavector x,
 {
   pavector  xp;
   avector   tmp;
+  size_t    mark;
+
+  mark = mark_scratch();
 
-  xp = init_avector(&tmp, cb->t->size);
+  xp = init_scratch_avector(&tmp, cb->t->size);
 
   forward_notransfer(cb, x, xt, xp);
 
   uninit_avector(xp);
+
+  release_scratch(mark);
 }
 
 void
 backward_clusterbasis_avector(pcclusterbasis cb, pavector yt, pavector y)
 {
+  if (cb->batch) {
+    assert(yt->dim == cb->ktree);
+    backward_batch(cb, y->v, NULL, 0, yt->v, yt->dim, 1);
+    return;
+  }
+
 #ifdef USE_OPENMP
   backward_parallel_clusterbasis_avector(cb, yt, y, max_pardepth);
 #else
@@ -941,13 +1449,18 @@ backward_notransfer_clusterbasis_avector(pcclusterbasis cb, pavector yt,
 {
   pavector  yp;
   avector   tmp;
+  size_t    mark;
 
-  yp = init_avector(&tmp, cb->t->size);
+  mark = mark_scratch();
+
+  yp = init_scratch_avector(&tmp, cb->t->size);
   clear_avector(yp);
 
   backward_notransfer(cb, yt, y, yp);
 
   uninit_avector(yp);
+
+  release_scratch(mark);
 }
 
 /* ------------------------------------------------------------
@@ -1144,6 +1657,17 @@ compress_parallel_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp,
 void
 forward_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp, pamatrix Xt)
 {
+  if (cb->batch) {
+    assert(Xp->rows == cb->t->size);
+    assert(Xt->rows == cb->ktree);
+    assert(Xp->cols == Xt->cols);
+    forward_batch(cb, NULL, Xp->a, Xp->ld, Xt->a, Xt->ld, Xt->cols);
+    return;
+  }
+
+#ifdef USE_OPENMP
+  forward_parallel_clusterbasis_amatrix(cb, Xp, Xt, max_pardepth);
+#else
   amatrix   loc1, loc2, loc3;
   pamatrix  Xp1, Xt1, Xc;
   uint      i, xpoff, xtoff;
@@ -1190,6 +1714,77 @@ forward_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp, pamatrix Xt)
     uninit_amatrix(Xt1);
   }
 
+  uninit_amatrix(Xc);
+#endif
+}
+
+void
+forward_parallel_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp,
+				      pamatrix Xt, uint pardepth)
+{
+  amatrix   loc1, loc2;
+  pamatrix *Xp1, *Xt1, Xr1, Xc;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i, xpoff, xtoff;
+
+  assert(Xp->rows == cb->t->size);
+  assert(Xt->rows == cb->ktree);
+  assert(Xp->cols == Xt->cols);
+
+  Xc = init_sub_amatrix(&loc1, Xt, cb->k, 0, Xt->cols, 0);
+  clear_amatrix(Xc);
+
+  if (cb->sons > 0) {
+    Xp1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * cb->sons);
+    Xt1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * cb->sons);
+    xpoff = 0;
+    xtoff = cb->k;
+    for (i = 0; i < cb->sons; i++) {
+      Xp1[i] = new_sub_amatrix((pamatrix) Xp, cb->t->son[i]->size, xpoff,
+			       Xp->cols, 0);
+      Xt1[i] = new_sub_amatrix(Xt, cb->son[i]->ktree, xtoff, Xt->cols, 0);
+
+      xpoff += cb->t->son[i]->size;
+      xtoff += cb->son[i]->ktree;
+    }
+    assert(xpoff == cb->t->size);
+    assert(xtoff == cb->ktree);
+
+#ifdef USE_OPENMP
+    nthreads = cb->sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth>0), num_threads(nthreads)
+#endif
+    for (i = 0; i < cb->sons; i++)
+      forward_parallel_clusterbasis_amatrix(cb->son[i], Xp1[i], Xt1[i],
+					    (pardepth >
+					     0 ? pardepth - 1 : 0));
+
+    /* Transfer matrices are applied sequentially, since all sons
+       contribute to the same coefficients */
+    for (i = 0; i < cb->sons; i++) {
+      Xr1 = init_sub_amatrix(&loc2, Xt1[i], cb->son[i]->k, 0, Xt->cols, 0);
+      addmul_amatrix(1.0, true, &cb->son[i]->E, false, Xr1, Xc);
+      uninit_amatrix(Xr1);
+
+      del_amatrix(Xt1[i]);
+      del_amatrix(Xp1[i]);
+    }
+    freemem(Xt1);
+    freemem(Xp1);
+  }
+  else {
+    Xr1 = init_sub_amatrix(&loc2, Xt, cb->t->size, cb->k, Xt->cols, 0);
+
+    copy_amatrix(false, Xp, Xr1);
+
+    addmul_amatrix(1.0, true, &cb->V, false, Xr1, Xc);
+
+    uninit_amatrix(Xr1);
+  }
+
   uninit_amatrix(Xc);
 }
 
@@ -1249,6 +1844,17 @@ forward_clusterbasis_trans_amatrix(pcclusterbasis cb, pcamatrix Xp,
 void
 backward_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt, pamatrix Yp)
 {
+  if (cb->batch) {
+    assert(Yp->rows == cb->t->size);
+    assert(Yt->rows == cb->ktree);
+    assert(Yp->cols == Yt->cols);
+    backward_batch(cb, NULL, Yp->a, Yp->ld, Yt->a, Yt->ld, Yt->cols);
+    return;
+  }
+
+#ifdef USE_OPENMP
+  backward_parallel_clusterbasis_amatrix(cb, Yt, Yp, max_pardepth);
+#else
   amatrix   loc1, loc2, loc3;
   pamatrix  Yt1, Yp1, Yc;
   uint      i, ypoff, ytoff;
@@ -1294,6 +1900,72 @@ backward_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt, pamatrix Yp)
     uninit_amatrix(Yt1);
   }
 
+  uninit_amatrix(Yc);
+#endif
+}
+
+void
+backward_parallel_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt,
+				       pamatrix Yp, uint pardepth)
+{
+  amatrix   loc1, loc2;
+  pamatrix *Yp1, *Yt1, Yr1, Yc;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i, ypoff, ytoff;
+
+  assert(Yp->rows == cb->t->size);
+  assert(Yt->rows == cb->ktree);
+  assert(Yp->cols == Yt->cols);
+
+  Yc = init_sub_amatrix(&loc1, Yt, cb->k, 0, Yt->cols, 0);
+
+  if (cb->sons > 0) {
+    Yp1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * cb->sons);
+    Yt1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * cb->sons);
+    ypoff = 0;
+    ytoff = cb->k;
+    for (i = 0; i < cb->sons; i++) {
+      Yp1[i] = new_sub_amatrix(Yp, cb->t->son[i]->size, ypoff, Yp->cols, 0);
+      Yt1[i] = new_sub_amatrix(Yt, cb->son[i]->ktree, ytoff, Yt->cols, 0);
+
+      ypoff += cb->t->son[i]->size;
+      ytoff += cb->son[i]->ktree;
+    }
+    assert(ypoff == cb->t->size);
+    assert(ytoff == cb->ktree);
+
+#ifdef USE_OPENMP
+    nthreads = cb->sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth>0), num_threads(nthreads), private(Yr1, loc2)
+#endif
+    for (i = 0; i < cb->sons; i++) {
+      Yr1 = init_sub_amatrix(&loc2, Yt1[i], cb->son[i]->k, 0, Yt->cols, 0);
+      addmul_amatrix(1.0, false, &cb->son[i]->E, false, Yc, Yr1);
+      uninit_amatrix(Yr1);
+
+      backward_parallel_clusterbasis_amatrix(cb->son[i], Yt1[i], Yp1[i],
+					     (pardepth >
+					      0 ? pardepth - 1 : 0));
+
+      del_amatrix(Yt1[i]);
+      del_amatrix(Yp1[i]);
+    }
+    freemem(Yt1);
+    freemem(Yp1);
+  }
+  else {
+    Yr1 = init_sub_amatrix(&loc2, Yt, cb->t->size, cb->k, Yt->cols, 0);
+
+    addmul_amatrix(1.0, false, &cb->V, false, Yc, Yr1);
+
+    add_amatrix(1.0, false, Yr1, Yp);
+
+    uninit_amatrix(Yr1);
+  }
+
   uninit_amatrix(Yc);
 }
 
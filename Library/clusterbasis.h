@@ -31,6 +31,15 @@ typedef clusterbasis *pclusterbasis;
 /** @brief Pointer to constant @ref clusterbasis object. */
 typedef const clusterbasis *pcclusterbasis;
 
+/** @brief Level-wise schedule for batched transformations. */
+typedef struct _clusterbasisbatch clusterbasisbatch;
+
+/** @brief Pointer to @ref clusterbasisbatch object. */
+typedef clusterbasisbatch *pclusterbasisbatch;
+
+/** @brief Pointer to constant @ref clusterbasisbatch object. */
+typedef const clusterbasisbatch *pcclusterbasisbatch;
+
 #include "cluster.h"
 #include "clusteroperator.h"
 #include "uniform.h"
@@ -68,6 +77,50 @@ struct _clusterbasis {
   puniform rlist;
   /** @brief List of matrices using this basis as column basis */
   puniform clist;
+
+  /** @brief Contiguous storage for leaf and transfer matrices, only set
+   *  in the root of a basis frozen by @ref freeze_clusterbasis */
+  pfield store;
+  /** @brief Number of coefficients in <tt>store</tt> */
+  size_t storesize;
+  /** @brief Binary file providing <tt>store</tt> if the basis has been
+   *  read by @ref get_binary_clusterbasis, <tt>NULL</tt> otherwise */
+  pbinarystore bin;
+
+  /** @brief Schedule for batched transformations, only set in the
+   *  root of a basis prepared by @ref prepare_batch_clusterbasis */
+  pclusterbasisbatch batch;
+};
+
+/** @brief Level-wise schedule for batched transformations.
+ *
+ *  All clusters of the cluster basis are listed level by level,
+ *  so that the transformations can handle one level at a time
+ *  instead of following the recursion. */
+struct _clusterbasisbatch {
+  /** @brief Number of levels */
+  uint levels;
+  /** @brief Number of clusters */
+  uint nodes;
+  /** @brief Start of each level in <tt>cb</tt>, <tt>levels+1</tt>
+   *  entries */
+  uint *levelstart;
+
+  /** @brief Clusters in level order */
+  pcclusterbasis *cb;
+  /** @brief Offsets of the coefficients of each cluster in the
+   *  coefficient vector of the root */
+  uint *off;
+  /** @brief Offsets of each cluster in the cluster numbering of
+   *  the root */
+  uint *poff;
+  /** @brief Index of the first son of each cluster in <tt>cb</tt>,
+   *  sons are stored consecutively */
+  uint *son;
+
+  /** @brief <tt>ktree</tt> of the root when the schedule was prepared,
+   *  used to detect changed ranks */
+  uint ktree;
 };
 
 /* ------------------------------------------------------------
@@ -269,6 +322,129 @@ clone_clusterbasis(pcclusterbasis cb);
 HEADER_PREFIX pclusterbasis
 clonestructure_clusterbasis(pcclusterbasis cb);
 
+/* ------------------------------------------------------------
+ Contiguous storage
+ ------------------------------------------------------------ */
+
+/** @brief Move all leaf and transfer matrices of a @ref clusterbasis
+ *  into one contiguous array.
+ *
+ *  The matrices are arranged in depth-first order, i.e., in the order
+ *  used by the backward transformation.
+ *  The array is released together with the root of the cluster basis.
+ *
+ *  @remark The coefficients of a frozen cluster basis may still be
+ *  changed, but its ranks must not, i.e., @ref resize_clusterbasis
+ *  cannot be used.
+ *
+ *  @param cb Root of the cluster basis that will be frozen. */
+HEADER_PREFIX void
+freeze_clusterbasis(pclusterbasis cb);
+
+/* ------------------------------------------------------------
+ Batched transformations
+ ------------------------------------------------------------ */
+
+/** @brief Prepare a cluster basis for batched transformations.
+ *
+ *  Collects all clusters level by level.
+ *  Afterwards @ref forward_clusterbasis_avector,
+ *  @ref backward_clusterbasis_avector,
+ *  @ref forward_clusterbasis_amatrix and
+ *  @ref backward_clusterbasis_amatrix called for the root apply all
+ *  transfer and leaf matrices of one level in a single batch,
+ *  using small inlined kernels instead of calling BLAS for every
+ *  cluster.
+ *  The clusters of one level are distributed among the threads if
+ *  OpenMP is used.
+ *
+ *  @remark Only the leaf and transfer matrices of the cluster basis
+ *  are batched.
+ *  The coupling matrices of an @ref h2matrix belong to the block tree,
+ *  not to the cluster basis, so the coupling products in
+ *  @ref fastaddeval_h2matrix_avector and its relatives are still
+ *  computed block by block.
+ *
+ *  @remark Like for @ref freeze_clusterbasis, the coefficients may
+ *  still be changed, but the ranks must not.
+ *  The schedule has to be released by @ref release_batch_clusterbasis
+ *  before calling @ref resize_clusterbasis.
+ *
+ *  @param cb Root of the cluster basis. */
+HEADER_PREFIX void
+prepare_batch_clusterbasis(pclusterbasis cb);
+
+/** @brief Release the schedule prepared by
+ *  @ref prepare_batch_clusterbasis.
+ *
+ *  @param cb Root of the cluster basis. */
+HEADER_PREFIX void
+release_batch_clusterbasis(pclusterbasis cb);
+
+/* ------------------------------------------------------------
+ File I/O
+ ------------------------------------------------------------ */
+
+/** @brief Write a cluster basis to a @ref binaryfile.
+ *
+ *  Writes the ranks and the dimensions of all leaf and transfer
+ *  matrices to the structure section.
+ *  The cluster tree has to be written separately by
+ *  @ref put_binary_cluster, and the coefficients are written by
+ *  @ref putdata_binary_clusterbasis after the data section has been
+ *  started.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param cb Root of the cluster basis. */
+HEADER_PREFIX void
+put_binary_clusterbasis(pbinaryfile bf, pcclusterbasis cb);
+
+/** @brief Write the coefficients of a cluster basis to the data
+ *  section of a @ref binaryfile.
+ *
+ *  The matrices are written in the order used by
+ *  @ref freeze_clusterbasis.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param cb Root of the cluster basis. */
+HEADER_PREFIX void
+putdata_binary_clusterbasis(pbinaryfile bf, pcclusterbasis cb);
+
+/** @brief Read a cluster basis from a @ref binaryfile.
+ *
+ *  The leaf and transfer matrices use the coefficients in the data
+ *  section directly.
+ *  If the file is damaged, the error flag of <tt>bf</tt> is set and
+ *  the returned basis should be discarded.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @param t Root of the cluster tree.
+ *  @returns Root of the cluster basis. */
+HEADER_PREFIX pclusterbasis
+get_binary_clusterbasis(pbinaryfile bf, pccluster t);
+
+/** @brief Write a cluster basis and its cluster tree into a binary file.
+ *
+ *  @param cb Cluster basis, <tt>cb->t</tt> has to be the root of its
+ *     cluster tree.
+ *  @param filename Name of the target file.
+ *  @returns <tt>true</tt> if the file has been written successfully. */
+HEADER_PREFIX bool
+write_binary_clusterbasis(pcclusterbasis cb, const char *filename);
+
+/** @brief Read a cluster basis and its cluster tree from a binary file.
+ *
+ *  @remark The cluster tree <tt>cb->t</tt> and its index array have to
+ *  be released by the caller.
+ *
+ *  @param filename Name of the source file.
+ *  @param map Set to map the coefficients into memory instead of
+ *     reading them.
+ *  @returns Cluster basis read from the file, or <tt>NULL</tt> if the
+ *     file could not be read. */
+HEADER_PREFIX pclusterbasis
+read_binary_clusterbasis(const char *filename, bool map);
+
 /* ------------------------------------------------------------
  Statistics
  ------------------------------------------------------------ */
@@ -653,6 +829,23 @@ compress_parallel_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp,
 HEADER_PREFIX void
 forward_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp, pamatrix Xt);
 
+/** @brief Parallel matrix forward transformation.
+ *
+ *  Parallel version of @ref forward_clusterbasis_amatrix.
+ *  The subtrees rooted in the sons of a cluster are handled in parallel,
+ *  the transfer matrices are applied by BLAS level 3 operations.
+ *
+ *  @param cb Cluster basis.
+ *  @param Xp Source matrix using cluster numbering corresponding
+ *         to <tt>cb->t</tt> in the rows.
+ *  @param Xt Target matrix with <tt>cb->ktree</tt> rows, will
+ *         be filled with a mix of transformed coefficients and
+ *         permuted coefficients.
+ *  @param pardepth Parallelization depth. */
+HEADER_PREFIX void
+forward_parallel_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix Xp,
+				      pamatrix Xt, uint pardepth);
+
 /** @brief Adjoint matrix forward transformation.
  *
  *  Compute @f$\widehat{X}_t = V_t^* X^*@f$ for all elements of the
@@ -685,6 +878,21 @@ forward_clusterbasis_trans_amatrix(pcclusterbasis cb, pcamatrix Xp, pamatrix Xt)
 HEADER_PREFIX void
 backward_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt, pamatrix Yp);
 
+/** @brief Parallel matrix backward transformation.
+ *
+ *  Parallel version of @ref backward_clusterbasis_amatrix.
+ *
+ *  @param cb Cluster basis.
+ *  @param Yt Source matrix with <tt>cb->ktree</tt> rows, filled
+ *         with a mix of transformed coefficients and permuted coefficients.
+ *         The matrix will be overwritten by the function.
+ *  @param Yp Target matrix using cluster numbering corresponding
+ *         to <tt>cb->t</tt> in the rows.
+ *  @param pardepth Parallelization depth. */
+HEADER_PREFIX void
+backward_parallel_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt,
+				       pamatrix Yp, uint pardepth);
+
 /** @brief Adjoint matrix backward transformation.
  *
  *  Compute @f$X^* \gets X^* + V_t \widehat{X}_t@f$ for all elements of the
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <stdint.h>
 
 #include "clustergeometry.h"
 
@@ -61,30 +62,211 @@ del_clustergeometry(pclustergeometry cf)
   freemem(cf);
 }
 
+/* ------------------------------------------------------------
+ Parallel partitioning
+ ------------------------------------------------------------ */
+
+/* Index sets with fewer elements are split sequentially */
+#define PARALLEL_MIN_CLUSTERGEOMETRY 4096
+
+/* Number of indices handled by one task of the parallel partitioning */
+#define CHUNK_CLUSTERGEOMETRY 1024
+
+/* Bounding box of the points idx[0], ..., idx[size-1] */
+static void
+bbox_clustergeometry(pclustergeometry cf, uint size, uint * idx,
+		     real * hmin, real * hmax, uint pardepth)
+{
+  const uint dim = cf->dim;
+  real     *lmin, *lmax;
+  uint      nc, c, i, i1, j;
+
+  if (pardepth == 0 || size < PARALLEL_MIN_CLUSTERGEOMETRY) {
+    for (j = 0; j < dim; j++) {
+      hmin[j] = cf->x[idx[0]][j];
+      hmax[j] = cf->x[idx[0]][j];
+    }
+
+    for (i = 1; i < size; i++) {
+      for (j = 0; j < dim; j++) {
+	if (cf->x[idx[i]][j] < hmin[j]) {
+	  hmin[j] = cf->x[idx[i]][j];
+	}
+	if (cf->x[idx[i]][j] > hmax[j]) {
+	  hmax[j] = cf->x[idx[i]][j];
+	}
+      }
+    }
+
+    return;
+  }
+
+  /* Minima and maxima are exact, so the order of the chunks does not
+     matter */
+  nc = (size + CHUNK_CLUSTERGEOMETRY - 1) / CHUNK_CLUSTERGEOMETRY;
+  lmin = allocreal(nc * dim);
+  lmax = allocreal(nc * dim);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for private(i, i1, j)
+#endif
+  for (c = 0; c < nc; c++) {
+    i = c * CHUNK_CLUSTERGEOMETRY;
+    i1 = UINT_MIN(size, i + CHUNK_CLUSTERGEOMETRY);
+
+    for (j = 0; j < dim; j++) {
+      lmin[j + c * dim] = cf->x[idx[i]][j];
+      lmax[j + c * dim] = cf->x[idx[i]][j];
+    }
+
+    for (i++; i < i1; i++) {
+      for (j = 0; j < dim; j++) {
+	if (cf->x[idx[i]][j] < lmin[j + c * dim]) {
+	  lmin[j + c * dim] = cf->x[idx[i]][j];
+	}
+	if (cf->x[idx[i]][j] > lmax[j + c * dim]) {
+	  lmax[j + c * dim] = cf->x[idx[i]][j];
+	}
+      }
+    }
+  }
+
+  for (j = 0; j < dim; j++) {
+    hmin[j] = lmin[j];
+    hmax[j] = lmax[j];
+  }
+  for (c = 1; c < nc; c++) {
+    for (j = 0; j < dim; j++) {
+      hmin[j] = REAL_MIN(hmin[j], lmin[j + c * dim]);
+      hmax[j] = REAL_MAX(hmax[j], lmax[j + c * dim]);
+    }
+  }
+
+  freemem(lmax);
+  freemem(lmin);
+}
+
+/* Move all indices with first[i] set to the front of idx and return
+   their number.
+   The result is identical to the sequential in-place partitioning
+     for (i = 0; i < size; i++)
+       if (first[i]) { swap idx[i] and idx[size0]; size0++; }
+   used by the clustering strategies:
+   the k-th index of the first son is swapped with position k, so it
+   ends up there, while an index of the second son at a position q
+   below the size of the first son is moved to the position of the q-th
+   index of the first son.
+   Every such move corresponds to one swap, so following these chains
+   costs no more than the sequential algorithm. */
+static    uint
+partition_clustergeometry(uint size, uint * idx, const bool * first)
+{
+  uint     *count, *pos, *tmp;
+  uint      nc, c, i, i1, k, q, size0;
+
+  nc = (size + CHUNK_CLUSTERGEOMETRY - 1) / CHUNK_CLUSTERGEOMETRY;
+  count = allocuint(nc + 1);
+
+  /* Count indices of the first son in every chunk */
+#ifdef USE_OPENMP
+#pragma omp parallel for private(i, i1, k)
+#endif
+  for (c = 0; c < nc; c++) {
+    i = c * CHUNK_CLUSTERGEOMETRY;
+    i1 = UINT_MIN(size, i + CHUNK_CLUSTERGEOMETRY);
+
+    k = 0;
+    for (; i < i1; i++)
+      k += (first[i] ? 1 : 0);
+
+    count[c + 1] = k;
+  }
+
+  count[0] = 0;
+  for (c = 0; c < nc; c++)
+    count[c + 1] += count[c];
+  size0 = count[nc];
+
+  pos = allocuint(size0);
+  tmp = allocuint(size);
+
+  /* Positions of the indices of the first son in ascending order */
+#ifdef USE_OPENMP
+#pragma omp parallel for private(i, i1, k)
+#endif
+  for (c = 0; c < nc; c++) {
+    i = c * CHUNK_CLUSTERGEOMETRY;
+    i1 = UINT_MIN(size, i + CHUNK_CLUSTERGEOMETRY);
+
+    k = count[c];
+    for (; i < i1; i++)
+      if (first[i])
+	pos[k++] = i;
+  }
+
+  /* Final positions of all indices */
+#ifdef USE_OPENMP
+#pragma omp parallel for private(i, i1, k, q)
+#endif
+  for (c = 0; c < nc; c++) {
+    i = c * CHUNK_CLUSTERGEOMETRY;
+    i1 = UINT_MIN(size, i + CHUNK_CLUSTERGEOMETRY);
+
+    k = count[c];
+    for (; i < i1; i++) {
+      if (first[i])
+	tmp[k++] = idx[i];
+      else {
+	for (q = i; q < size0; q = pos[q]);
+	tmp[q] = idx[i];
+      }
+    }
+  }
+
+#ifdef USE_OPENMP
+#pragma omp parallel for
+#endif
+  for (i = 0; i < size; i++)
+    idx[i] = tmp[i];
+
+  freemem(tmp);
+  freemem(pos);
+  freemem(count);
+
+  return size0;
+}
+
 /* ------------------------------------------------------------
  Clustering strategies
  ------------------------------------------------------------ */
 
-pcluster
-build_adaptive_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
+/* Adaptive clustering, hmin and hmax are used as temporary storage */
+static    pcluster
+build_adaptive(pclustergeometry cf, uint size, uint * idx, uint clf,
+	       real * hmin, real * hmax, uint pardepth)
 {
   pcluster  t;
 
+  real     *hbuf;
+  bool     *first;
   uint      direction;
   uint      size0, size1;
   uint      i, j;
   real      a, m;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
 
   if (size > clf) {
 
-    update_point_bbox_clustergeometry(cf, size, idx);
+    bbox_clustergeometry(cf, size, idx, hmin, hmax, pardepth);
 
     /* compute the direction of partition */
     direction = 0;
-    a = cf->hmax[0] - cf->hmin[0];
+    a = hmax[0] - hmin[0];
 
     for (j = 1; j < cf->dim; j++) {
-      m = cf->hmax[j] - cf->hmin[j];
+      m = hmax[j] - hmin[j];
       if (a < m) {
 	a = m;
 	direction = j;
@@ -93,25 +275,58 @@ build_adaptive_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
 
     /* build sons */
     if (a > 0.0) {
-      m = (cf->hmax[direction] + cf->hmin[direction]) / 2.0;
+      m = (hmax[direction] + hmin[direction]) / 2.0;
       size0 = 0;
       size1 = 0;
 
-      for (i = 0; i < size; i++) {
-	if (cf->x[idx[i]][direction] < m) {
-	  j = idx[i];
-	  idx[i] = idx[size0];
-	  idx[size0] = j;
-	  size0++;
-	}
-	else {
-	  size1++;
+      if (pardepth > 0 && size >= PARALLEL_MIN_CLUSTERGEOMETRY) {
+	first = (bool *) allocmem((size_t) sizeof(bool) * size);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for
+#endif
+	for (i = 0; i < size; i++)
+	  first[i] = (cf->x[idx[i]][direction] < m);
+
+	size0 = partition_clustergeometry(size, idx, first);
+	size1 = size - size0;
+
+	freemem(first);
+      }
+      else {
+	for (i = 0; i < size; i++) {
+	  if (cf->x[idx[i]][direction] < m) {
+	    j = idx[i];
+	    idx[i] = idx[size0];
+	    idx[size0] = j;
+	    size0++;
+	  }
+	  else {
+	    size1++;
+	  }
 	}
       }
       t = new_cluster(size, idx, 2, cf->dim);
 
-      t->son[0] = build_adaptive_cluster(cf, size0, idx, clf);
-      t->son[1] = build_adaptive_cluster(cf, size1, idx + size0, clf);
+      /* The second son needs its own temporary storage if both
+         sons are constructed in parallel */
+      hbuf = (pardepth > 0 ? allocreal(2 * cf->dim) : NULL);
+
+#ifdef USE_OPENMP
+      nthreads = 2;
+      (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+      for (i = 0; i < 2; i++)
+	t->son[i] = build_adaptive(cf, (i == 0 ? size0 : size1),
+				   (i == 0 ? idx : idx + size0), clf,
+				   (i == 0 || hbuf == NULL ? hmin : hbuf),
+				   (i == 0 || hbuf == NULL ? hmax :
+				    hbuf + cf->dim),
+				   (pardepth > 0 ? pardepth - 1 : 0));
+
+      if (hbuf)
+	freemem(hbuf);
 
       update_bbox_cluster(t);
     }
@@ -132,21 +347,35 @@ build_adaptive_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
 }
 
 pcluster
-build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
-		      uint clf, uint direction)
+build_adaptive_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
+{
+  return build_adaptive(cf, size, idx, clf, cf->hmin, cf->hmax, 0);
+}
+
+/* Regular clustering, hmin and hmax are used as temporary storage.
+   Every cluster recomputes the bounding box of its points, so the
+   sons do not depend on the box of their father. */
+static    pcluster
+build_regular(pclustergeometry cf, uint size, uint * idx, uint clf,
+	      uint direction, real * hmin, real * hmax, uint pardepth)
 {
   pcluster  t;
 
+  real     *hbuf;
+  bool     *first;
   uint      newd;
   uint      size0, size1;
   uint      i, j;
-  real      a, b, m;
+  real      m;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
 
   if (size > clf) {
     size0 = 0;
     size1 = 0;
 
-    update_point_bbox_clustergeometry(cf, size, idx);
+    bbox_clustergeometry(cf, size, idx, hmin, hmax, pardepth);
 
     if (direction < cf->dim - 1) {
       newd = direction + 1;
@@ -155,20 +384,36 @@ build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
       newd = 0;
     }
 
-    m = cf->hmax[direction] - cf->hmin[direction];
+    m = hmax[direction] - hmin[direction];
 
     if (m > 0.0) {
-      m = (cf->hmax[direction] + cf->hmin[direction]) / 2.0;
+      m = (hmax[direction] + hmin[direction]) / 2.0;
 
-      for (i = 0; i < size; i++) {
-	if (cf->x[idx[i]][direction] < m) {
-	  j = idx[i];
-	  idx[i] = idx[size0];
-	  idx[size0] = j;
-	  size0++;
-	}
-	else {
-	  size1++;
+      if (pardepth > 0 && size >= PARALLEL_MIN_CLUSTERGEOMETRY) {
+	first = (bool *) allocmem((size_t) sizeof(bool) * size);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for
+#endif
+	for (i = 0; i < size; i++)
+	  first[i] = (cf->x[idx[i]][direction] < m);
+
+	size0 = partition_clustergeometry(size, idx, first);
+	size1 = size - size0;
+
+	freemem(first);
+      }
+      else {
+	for (i = 0; i < size; i++) {
+	  if (cf->x[idx[i]][direction] < m) {
+	    j = idx[i];
+	    idx[i] = idx[size0];
+	    idx[size0] = j;
+	    size0++;
+	  }
+	  else {
+	    size1++;
+	  }
 	}
       }
 
@@ -178,19 +423,23 @@ build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
 	  /* both sons are not empty */
 	  t = new_cluster(size, idx, 2, cf->dim);
 
-	  a = cf->hmin[direction];
-	  b = cf->hmax[direction];
-	  cf->hmax[direction] = m;
-
-	  t->son[0] = build_regular_cluster(cf, size0, idx, clf, newd);
+	  hbuf = (pardepth > 0 ? allocreal(2 * cf->dim) : NULL);
 
-	  cf->hmax[direction] = b;
-	  cf->hmin[direction] = m;
+#ifdef USE_OPENMP
+	  nthreads = 2;
+	  (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+	  for (i = 0; i < 2; i++)
+	    t->son[i] = build_regular(cf, (i == 0 ? size0 : size1),
+				      (i == 0 ? idx : idx + size0), clf, newd,
+				      (i == 0 || hbuf == NULL ? hmin : hbuf),
+				      (i == 0 || hbuf == NULL ? hmax :
+				       hbuf + cf->dim),
+				      (pardepth > 0 ? pardepth - 1 : 0));
 
-	  t->son[1] =
-	    build_regular_cluster(cf, size1, idx + size0, clf, newd);
-
-	  cf->hmin[direction] = a;
+	  if (hbuf)
+	    freemem(hbuf);
 
 	  update_bbox_cluster(t);
 	}
@@ -198,27 +447,20 @@ build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
 	  /* only the first son is not empty */
 	  t = new_cluster(size, idx, 1, cf->dim);
 
-	  b = cf->hmax[direction];
-	  cf->hmax[direction] = m;
-
-	  t->son[0] = build_regular_cluster(cf, size, idx, clf, newd);
-
-	  cf->hmax[direction] = b;
+	  t->son[0] = build_regular(cf, size, idx, clf, newd, hmin, hmax,
+				    pardepth);
 
 	  update_bbox_cluster(t);
 	}
       }
       else {
-	/* only the second son is not empty */ assert(size1 > 0);
+	/* only the second son is not empty */
+	assert(size1 > 0);
 
 	t = new_cluster(size, idx, 1, cf->dim);
 
-	a = cf->hmin[direction];
-	cf->hmin[direction] = m;
-
-	t->son[0] = build_regular_cluster(cf, size, idx, clf, newd);
-
-	cf->hmin[direction] = a;
+	t->son[0] = build_regular(cf, size, idx, clf, newd, hmin, hmax,
+				  pardepth);
 
 	update_bbox_cluster(t);
       }
@@ -227,7 +469,8 @@ build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
       assert(m == 0.0);
       t = new_cluster(size, idx, 1, cf->dim);
 
-      t->son[0] = build_regular_cluster(cf, size, idx, clf, newd);
+      t->son[0] = build_regular(cf, size, idx, clf, newd, hmin, hmax,
+				pardepth);
 
       update_bbox_cluster(t);
     }
@@ -242,6 +485,13 @@ build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
   return t;
 }
 
+pcluster
+build_regular_cluster(pclustergeometry cf, uint size, uint * idx,
+		      uint clf, uint direction)
+{
+  return build_regular(cf, size, idx, clf, direction, cf->hmin, cf->hmax, 0);
+}
+
 /* auxiliary routine for build_simsub_cluster */
 static pcluster
 build_help_cluster(pclustergeometry cf, uint * idx, uint size,
@@ -388,16 +638,25 @@ build_simsub_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
   return t;
 }
 
-pcluster
-build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
+/* Clustering by principal component analysis.
+   The center of mass and the covariance matrix are always computed
+   sequentially, so the result does not depend on the number of threads. */
+static    pcluster
+build_pca(pclustergeometry cf, uint size, uint * idx, uint clf,
+	  uint pardepth)
 {
   const uint dim = cf->dim;
 
   pamatrix  C, Q;
+  avector   vtmp;
   pavector  lambda, v;
   real     *x, *y;
+  bool     *first;
   real      w;
   uint      i, j, k, size0, size1;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
 
   pcluster  t;
 
@@ -452,30 +711,52 @@ build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
     eig_amatrix(C, lambda, Q);
 
     /* get eigenvector from largest eigenvalue */
-    v = new_avector(0);
-    init_column_avector(v, Q, dim - 1);
+    v = init_column_avector(&vtmp, Q, dim - 1);
 
     /* separate cluster with v as separation-plane */
-    for (i = 0; i < size; ++i) {
-      /* x_i - X */
-      for (j = 0; j < dim; ++j) {
-	y[j] = cf->x[idx[i]][j] - x[j];
-      }
+    if (pardepth > 0 && size >= PARALLEL_MIN_CLUSTERGEOMETRY) {
+      first = (bool *) allocmem((size_t) sizeof(bool) * size);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for private(j, w)
+#endif
+      for (i = 0; i < size; ++i) {
+	/* <x_i - X,v> */
+	w = 0.0;
+	for (j = 0; j < dim; ++j) {
+	  w += (cf->x[idx[i]][j] - x[j]) * REAL(v->v[j]);
+	}
 
-      /* <y,v> */
-      w = 0.0;
-      for (j = 0; j < dim; ++j) {
-	w += y[j] * v->v[j];
+	first[i] = (w >= 0.0);
       }
 
-      if (w >= 0.0) {
-	j = idx[i];
-	idx[i] = idx[size0];
-	idx[size0] = j;
-	size0++;
-      }
-      else {
-	size1++;
+      size0 = partition_clustergeometry(size, idx, first);
+      size1 = size - size0;
+
+      freemem(first);
+    }
+    else {
+      for (i = 0; i < size; ++i) {
+	/* x_i - X */
+	for (j = 0; j < dim; ++j) {
+	  y[j] = cf->x[idx[i]][j] - x[j];
+	}
+
+	/* <y,v> */
+	w = 0.0;
+	for (j = 0; j < dim; ++j) {
+	  w += y[j] * REAL(v->v[j]);
+	}
+
+	if (w >= 0.0) {
+	  j = idx[i];
+	  idx[i] = idx[size0];
+	  idx[size0] = j;
+	  size0++;
+	}
+	else {
+	  size1++;
+	}
       }
     }
 
@@ -484,7 +765,7 @@ build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
     del_amatrix(Q);
     del_amatrix(C);
     del_avector(lambda);
-    del_avector(v);
+    uninit_avector(v);
     freemem(x);
     freemem(y);
 
@@ -493,14 +774,21 @@ build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
       if (size1 > 0) {
 	t = new_cluster(size, idx, 2, cf->dim);
 
-	t->son[0] = build_pca_cluster(cf, size0, idx, clf);
-	t->son[1] = build_pca_cluster(cf, size1, idx + size0, clf);
+#ifdef USE_OPENMP
+	nthreads = 2;
+	(void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+	for (i = 0; i < 2; i++)
+	  t->son[i] = build_pca(cf, (i == 0 ? size0 : size1),
+				(i == 0 ? idx : idx + size0), clf,
+				(pardepth > 0 ? pardepth - 1 : 0));
 
 	update_bbox_cluster(t);
       }
       else {
 	t = new_cluster(size, idx, 1, cf->dim);
-	t->son[0] = build_pca_cluster(cf, size0, idx, clf);
+	t->son[0] = build_pca(cf, size0, idx, clf, pardepth);
 
 	update_bbox_cluster(t);
       }
@@ -508,7 +796,7 @@ build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
     else {
       assert(size1 > 0);
       t = new_cluster(size, idx, 1, cf->dim);
-      t->son[0] = build_pca_cluster(cf, size1, idx, clf);
+      t->son[0] = build_pca(cf, size1, idx, clf, pardepth);
 
       update_bbox_cluster(t);
     }
@@ -524,6 +812,239 @@ build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
   return t;
 }
 
+pcluster
+build_pca_cluster(pclustergeometry cf, uint size, uint * idx, uint clf)
+{
+  return build_pca(cf, size, idx, clf, 0);
+}
+
+/* ------------------------------------------------------------
+ Space-filling curves
+ ------------------------------------------------------------ */
+
+/* Convert integer coordinates into the transposed representation of
+   the Hilbert index, following J. Skilling, "Programming the Hilbert
+   curve", AIP Conf. Proc. 707, 2004 */
+static void
+hilbert_transpose(uint * c, uint dim, uint bits)
+{
+  uint      m, p, q, t;
+  uint      j;
+
+  m = 1u << (bits - 1);
+
+  /* Inverse undo excess work */
+  for (q = m; q > 1; q >>= 1) {
+    p = q - 1;
+    for (j = 0; j < dim; j++) {
+      if (c[j] & q)
+	c[0] ^= p;
+      else {
+	t = (c[0] ^ c[j]) & p;
+	c[0] ^= t;
+	c[j] ^= t;
+      }
+    }
+  }
+
+  /* Gray encode */
+  for (j = 1; j < dim; j++)
+    c[j] ^= c[j - 1];
+
+  t = 0;
+  for (q = m; q > 1; q >>= 1)
+    if (c[dim - 1] & q)
+      t ^= q - 1;
+
+  for (j = 0; j < dim; j++)
+    c[j] ^= t;
+}
+
+/* Keys of all points, obtained by interleaving the bits of the
+   (possibly transformed) integer coordinates */
+static void
+sfc_keys(pclustergeometry cf, uint size, const uint * idx, bool hilbert,
+	 uint bits, uint64_t * key)
+{
+  const uint dim = cf->dim;
+  uint     *c;
+  real      a, scale;
+  uint      cmax, i, j, b;
+  uint64_t  k;
+
+  update_point_bbox_clustergeometry(cf, size, (uint *) idx);
+
+  /* Use the same scaling in all directions, so that each bit of the
+     key halves a box in one direction */
+  a = 0.0;
+  for (j = 0; j < dim; j++)
+    a = REAL_MAX(a, cf->hmax[j] - cf->hmin[j]);
+
+  cmax = (bits == 32 ? 0xffffffffu : (1u << bits) - 1);
+  scale = (a > 0.0 ? cmax / a : 0.0);
+
+  c = allocuint(dim);
+
+  for (i = 0; i < size; i++) {
+    for (j = 0; j < dim; j++) {
+      a = (cf->x[idx[i]][j] - cf->hmin[j]) * scale;
+      c[j] = (a < cmax ? (uint) a : cmax);
+    }
+
+    /* In one dimension both curves coincide */
+    if (hilbert && dim > 1)
+      hilbert_transpose(c, dim, bits);
+
+    k = 0;
+    for (b = bits; b-- > 0;)
+      for (j = 0; j < dim; j++)
+	k = (k << 1) | ((c[j] >> b) & 1);
+
+    key[i] = k;
+  }
+
+  freemem(c);
+}
+
+/* Stable least-significant-digit radix sort of keys and indices */
+static void
+radixsort_sfc(uint size, uint * idx, uint64_t * key, uint keybits)
+{
+  uint64_t *key2, *ktmp;
+  uint     *idx2, *itmp;
+  uint      count[256];
+  uint      d, i, sum, n;
+
+  key2 = (uint64_t *) allocmem((size_t) sizeof(uint64_t) * size);
+  idx2 = allocuint(size);
+
+  for (d = 0; d < keybits; d += 8) {
+    for (i = 0; i < 256; i++)
+      count[i] = 0;
+
+    for (i = 0; i < size; i++)
+      count[(key[i] >> d) & 255]++;
+
+    sum = 0;
+    for (i = 0; i < 256; i++) {
+      n = count[i];
+      count[i] = sum;
+      sum += n;
+    }
+
+    for (i = 0; i < size; i++) {
+      n = count[(key[i] >> d) & 255]++;
+      key2[n] = key[i];
+      idx2[n] = idx[i];
+    }
+
+    ktmp = key;
+    key = key2;
+    key2 = ktmp;
+    itmp = idx;
+    idx = idx2;
+    idx2 = itmp;
+  }
+
+  /* Odd number of passes, the result is in the auxiliary arrays */
+  if (((keybits + 7) / 8) % 2 == 1) {
+    for (i = 0; i < size; i++) {
+      key2[i] = key[i];
+      idx2[i] = idx[i];
+    }
+    ktmp = key;
+    key = key2;
+    key2 = ktmp;
+    itmp = idx;
+    idx = idx2;
+    idx2 = itmp;
+  }
+
+  freemem(idx2);
+  freemem(key2);
+}
+
+/* Split the sorted key range at the highest bit in which the first and
+   the last key differ, i.e., bisect the common box of the range */
+static    pcluster
+build_sfc(pclustergeometry cf, uint size, uint * idx, const uint64_t * key,
+	  uint clf)
+{
+  pcluster  t;
+
+  uint64_t  diff, bit;
+  uint      lo, hi, mid, size0;
+
+  if (size > clf) {
+    diff = key[0] ^ key[size - 1];
+
+    if (diff == 0) {
+      /* Identical keys, split the index set in the middle */
+      size0 = size / 2;
+    }
+    else {
+      bit = (uint64_t) 1 << 63;
+      while ((diff & bit) == 0)
+	bit >>= 1;
+
+      /* First key with this bit set */
+      lo = 0;
+      hi = size - 1;
+      while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (key[mid] & bit)
+	  hi = mid;
+	else
+	  lo = mid + 1;
+      }
+      size0 = lo;
+    }
+    assert(0 < size0 && size0 < size);
+
+    t = new_cluster(size, idx, 2, cf->dim);
+
+    t->son[0] = build_sfc(cf, size0, idx, key, clf);
+    t->son[1] = build_sfc(cf, size - size0, idx + size0, key + size0, clf);
+
+    update_bbox_cluster(t);
+  }
+  else {
+    t = new_cluster(size, idx, 0, cf->dim);
+    update_support_bbox_cluster(cf, t);
+  }
+
+  update_cluster(t);
+
+  return t;
+}
+
+pcluster
+build_sfc_cluster(pclustergeometry cf, uint size, uint * idx, uint clf,
+		  clustermode mode)
+{
+  pcluster  t;
+  uint64_t *key;
+  uint      bits;
+
+  assert(mode == H2_MORTON || mode == H2_HILBERT);
+  assert(cf->dim > 0 && cf->dim <= 64);
+
+  bits = UINT_MIN(32, 64 / cf->dim);
+
+  key = (uint64_t *) allocmem((size_t) sizeof(uint64_t) * size);
+
+  if (size > 0) {
+    sfc_keys(cf, size, idx, (mode == H2_HILBERT), bits, key);
+    radixsort_sfc(size, idx, key, bits * cf->dim);
+  }
+
+  t = build_sfc(cf, size, idx, key, clf);
+
+  freemem(key);
+
+  return t;
+}
+
 pcluster
 build_cluster(pclustergeometry cf, uint size, uint * idx, uint clf,
 	      clustermode mode)
@@ -540,7 +1061,44 @@ build_cluster(pclustergeometry cf, uint size, uint * idx, uint clf,
   else if (mode == H2_PCA) {
     t = build_pca_cluster(cf, size, idx, clf);
   }
+  else if (mode == H2_MORTON || mode == H2_HILBERT) {
+    t = build_sfc_cluster(cf, size, idx, clf, mode);
+  }
+  else {
+    assert(mode == H2_SIMSUB);
+    update_point_bbox_clustergeometry(cf, size, idx);
+    t = build_simsub_cluster(cf, size, idx, clf);
+  }
+
+  return t;
+}
+
+pcluster
+build_parallel_cluster(pclustergeometry cf, uint size, uint * idx, uint clf,
+		       clustermode mode, uint pardepth)
+{
+  pcluster  t;
+  real     *hbuf;
+
+  if (mode == H2_ADAPTIVE) {
+    hbuf = allocreal(2 * cf->dim);
+    t = build_adaptive(cf, size, idx, clf, hbuf, hbuf + cf->dim, pardepth);
+    freemem(hbuf);
+  }
+  else if (mode == H2_REGULAR) {
+    hbuf = allocreal(2 * cf->dim);
+    t = build_regular(cf, size, idx, clf, 0, hbuf, hbuf + cf->dim, pardepth);
+    freemem(hbuf);
+  }
+  else if (mode == H2_PCA) {
+    t = build_pca(cf, size, idx, clf, pardepth);
+  }
+  else if (mode == H2_MORTON || mode == H2_HILBERT) {
+    /* Sorting dominates, the tree is built sequentially */
+    t = build_sfc_cluster(cf, size, idx, clf, mode);
+  }
   else {
+    /* Simultaneous subdivision is only available sequentially */
     assert(mode == H2_SIMSUB);
     update_point_bbox_clustergeometry(cf, size, idx);
     t = build_simsub_cluster(cf, size, idx, clf);
@@ -556,23 +1114,7 @@ build_cluster(pclustergeometry cf, uint size, uint * idx, uint clf,
 void
 update_point_bbox_clustergeometry(pclustergeometry cf, uint size, uint * idx)
 {
-  uint      i, j;
-
-  for (j = 0; j < cf->dim; j++) {
-    cf->hmin[j] = cf->x[idx[0]][j];
-    cf->hmax[j] = cf->x[idx[0]][j];
-  }
-
-  for (i = 1; i < size; i++) {
-    for (j = 0; j < cf->dim; j++) {
-      if (cf->x[idx[i]][j] < cf->hmin[j]) {
-	cf->hmin[j] = cf->x[idx[i]][j];
-      }
-      if (cf->x[idx[i]][j] > cf->hmax[j]) {
-	cf->hmax[j] = cf->x[idx[i]][j];
-      }
-    }
-  }
+  bbox_clustergeometry(cf, size, idx, cf->hmin, cf->hmax, 0);
 }
 
 void
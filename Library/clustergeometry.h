@@ -111,7 +111,11 @@ typedef enum {
   /** @brief Simultaneous subdivision clustering. */
   H2_SIMSUB,
   /** @brief Geometrically clustering based principal component analysis (PCA).*/
-  H2_PCA
+  H2_PCA,
+  /** @brief Clustering along the Morton (Z-order) space-filling curve.*/
+  H2_MORTON,
+  /** @brief Clustering along the Hilbert space-filling curve.*/
+  H2_HILBERT
 } clustermode;
 
 /**
@@ -192,6 +196,31 @@ build_simsub_cluster(pclustergeometry cf, uint size, uint *idx, uint clf);
 HEADER_PREFIX pcluster
 build_pca_cluster(pclustergeometry cf, uint size, uint* idx, uint clf);
 
+/**
+ * @brief Build a @ref cluster tree from a @ref clustergeometry object
+ *  by sorting along a space-filling curve.
+ *
+ *  The points are mapped to integer coordinates in a common cube and
+ *  sorted by their Morton or Hilbert key using a radix sort, so
+ *  <tt>idx</tt> follows the curve afterwards.
+ *  A range of sorted keys is split at the highest bit in which its
+ *  first and last key differ, which bisects the common box of the range
+ *  along one coordinate direction.
+ *  Apart from sorting, the construction therefore takes only a binary
+ *  search per cluster.
+ *
+ * @param cf @ref clustergeometry object with geometrical information.
+ * @param size Number of indices.
+ * @param idx Index set.
+ * @param clf Maximal leaf size.
+ * @param mode Either <tt>H2_MORTON</tt> or <tt>H2_HILBERT</tt>.
+ * @return Returns a @ref cluster tree object basing on a space-filling
+ *  curve.
+ */
+HEADER_PREFIX pcluster
+build_sfc_cluster(pclustergeometry cf, uint size, uint *idx, uint clf,
+    clustermode mode);
+
 /**
  * @brief Build a @ref cluster tree from a @ref clustergeometry object using
  * cluster strategy @ref clustermode.
@@ -211,6 +240,32 @@ HEADER_PREFIX pcluster
 build_cluster(pclustergeometry cf, uint size, uint *idx, uint clf,
     clustermode mode);
 
+/**
+ * @brief Build a @ref cluster tree from a @ref clustergeometry object using
+ * cluster strategy @ref clustermode in parallel.
+ *
+ * The sons of clusters are constructed in parallel up to the level
+ * <tt>pardepth</tt>, and the bounding boxes and partitions of large index
+ * sets are computed by several threads.
+ * The result is identical to the tree and index permutation constructed
+ * by @ref build_adaptive_cluster, @ref build_regular_cluster with initial
+ * direction 0 and @ref build_pca_cluster, independently of the number of
+ * threads.
+ * Simultaneous subdivision and space-filling curve clustering are
+ * performed sequentially.
+ *
+ * @param cf @ref clustergeometry object with geometrical information.
+ * @param size Number of indices.
+ * @param idx Index set.
+ * @param clf Maximal leaf size.
+ * @param mode Cluster strategy
+ * @param pardepth Parallelization depth, usually <tt>max_pardepth</tt>.
+ * @return Returns a @ref cluster tree object.
+ */
+HEADER_PREFIX pcluster
+build_parallel_cluster(pclustergeometry cf, uint size, uint *idx, uint clf,
+    clustermode mode, uint pardepth);
+
 /* ------------------------------------------------------------
  Auxiliary routines
  ------------------------------------------------------------ */
@@ -12,6 +12,7 @@
 #include <stdlib.h>
 
 #include "basic.h"
+#include "blas.h"
 #include "factorizations.h"
 
 /** @brief "Machine accuracy" for QR eigenvalue iteration */
@@ -435,7 +436,10 @@ sb_muleig_tridiag(ptridiag T, pamatrix Q, uint maxiter)
   return iter;
 }
 
-#ifdef USE_BLAS
+/* The LAPACK routines for tridiagonal and bidiagonal matrices are only
+ * called for real matrices, complex matrices are handled by the
+ * implementations in this file. */
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
 IMPORT_PREFIX void
 dsteqr_(const char *compz,
 	const unsigned *n,
@@ -611,7 +615,7 @@ sb_tridiagonalize_amatrix(pamatrix A, ptridiag T, pamatrix Q)
   T->d[k] = aa[k + k * lda];
 }
 
-#ifdef USE_BLAS
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
 IMPORT_PREFIX void
 dlarf_(const char *side,
        const unsigned *m,
@@ -774,20 +778,14 @@ sb_eig_amatrix(pamatrix A, pavector lambda, pamatrix Q, uint maxiter)
  * gfortran does the right thing if called with "-frecursive", but this
  * appears not to be the standard in, e.g., OpenSUSE Linux. */
 #if defined(THREADSAFE_LAPACK) || !defined(USE_OPENMP)
-IMPORT_PREFIX void
-dsyev_(const char *jobz,
-       const char *uplo,
-       const unsigned *n,
-       double *a,
-       const unsigned *lda,
-       const double *w, double *work, const unsigned *lwork, int *info);
-
 uint
 eig_amatrix(pamatrix A, pavector lambda, pamatrix Q)
 {
-  double   *work;
+  pfield    work;
+  preal     w, rwork;
   unsigned  lwork;
   uint      n = A->rows;
+  uint      i;
   int       info = 0;
 
   /* Quick exit if trivial matrix */
@@ -799,16 +797,24 @@ eig_amatrix(pamatrix A, pavector lambda, pamatrix Q)
 
   lwork = 12 * n;
   work = allocfield(lwork);
+  w = allocreal(n);
+  rwork = allocreal(3 * n);
 
   if (Q) {
-    dsyev_("Vectors", "Lower triangle", &n, A->a, &A->ld, lambda->v,
-	   work, &lwork, &info);
+    h2_heev("Vectors", "Lower triangle", &n, A->a, &A->ld, w,
+	    work, &lwork, rwork, &info);
     copy_amatrix(false, A, Q);
   }
   else
-    dsyev_("No vectors", "Lower triangle", &n, A->a, &A->ld, lambda->v,
-	   work, &lwork, &info);
+    h2_heev("No vectors", "Lower triangle", &n, A->a, &A->ld, w,
+	    work, &lwork, rwork, &info);
 
+  /* Eigenvalues are real even if the matrix is complex */
+  for (i = 0; i < n; i++)
+    lambda->v[i] = w[i];
+
+  freemem(rwork);
+  freemem(w);
   freemem(work);
 
   return (info != 0);
@@ -1241,7 +1247,7 @@ sb_mulsvd_tridiag(ptridiag T, pamatrix U, pamatrix Vt, uint maxiter)
   return iter;
 }
 
-#ifdef USE_BLAS
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
 IMPORT_PREFIX void
 dbdsqr_(const char *uplo,
 	const unsigned *n,
@@ -1600,7 +1606,7 @@ sb_bidiagonalize_amatrix(pamatrix A, ptridiag T, pamatrix U, pamatrix Vt)
   }
 }
 
-#ifdef USE_BLAS
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
 IMPORT_PREFIX void
 dlarf_(const char *side,
        const unsigned *m,
@@ -1981,39 +1987,37 @@ sb_svd_amatrix(pamatrix A, pavector sigma, pamatrix U, pamatrix Vt,
 
 #ifdef USE_BLAS
 #if defined(THREADSAFE_LAPACK) || !defined(USE_OPENMP)
-IMPORT_PREFIX void
-dgesvd_(const char *jobu,
-	const char *jobvt,
-	const unsigned *m,
-	const unsigned *n,
-	double *a,
-	const unsigned *lda,
-	double *s,
-	double *u,
-	const unsigned *ldu,
-	double *vt,
-	const unsigned *ldvt, double *work, const unsigned *lwork, int *info);
-
 uint
 svd_amatrix(pamatrix A, pavector sigma, pamatrix U, pamatrix Vt)
 {
-  double   *work;
+  pfield    work;
+  preal     s, rwork;
   unsigned  lwork;
+  uint      k, i;
   int       info = 0;
 
   if (A->rows > 0 && A->cols > 0) {
     lwork = 10 * UINT_MAX(A->rows, A->cols);
     work = allocfield(lwork);
-
-    dgesvd_((U ? "Skinny left vectors" : "No left vectors"),
-	    (Vt ? "Skinny right vectors" : "No right vectors"),
-	    &A->rows, &A->cols,
-	    A->a, &A->ld,
-	    sigma->v,
-	    (U ? U->a : NULL), (U ? &U->ld : &u_one),
-	    (Vt ? Vt->a : NULL), (Vt ? &Vt->ld : &u_one),
-	    work, &lwork, &info);
-
+    k = UINT_MIN(A->rows, A->cols);
+    s = allocreal(k);
+    rwork = allocreal(5 * k);
+
+    h2_gesvd((U ? "Skinny left vectors" : "No left vectors"),
+	     (Vt ? "Skinny right vectors" : "No right vectors"),
+	     &A->rows, &A->cols,
+	     A->a, &A->ld,
+	     s,
+	     (U ? U->a : NULL), (U ? &U->ld : &u_one),
+	     (Vt ? Vt->a : NULL), (Vt ? &Vt->ld : &u_one),
+	     work, &lwork, rwork, &info);
+
+    /* Singular values are real even if the matrix is complex */
+    for (i = 0; i < k; i++)
+      sigma->v[i] = s[i];
+
+    freemem(rwork);
+    freemem(s);
     freemem(work);
   }
 
@@ -7,6 +7,7 @@
 
 #include "settings.h"
 #include "basic.h"
+#include "blas.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -35,31 +36,27 @@ diagsolve_amatrix_avector(bool atrans, pcamatrix a, pavector x)
 }
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dscal_(const unsigned *n,
-       const double *alpha, double *x, const unsigned *incx);
-
 void
 diagsolve_amatrix(bool atrans, pcamatrix a, bool xtrans, pamatrix x)
 {
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      lda = a->ld;
   uint      ldx = x->ld;
-  double   *aa = a->a;
-  double   *xa = x->a;
-  double    alpha;
+  pfield    aa = a->a;
+  pfield    xa = x->a;
+  field     alpha;
   uint      i;
 
   if (xtrans) {
     for (i = 0; i < n; i++) {
-      alpha = (atrans ? 1.0 / CONJ(aa[i + i * lda]) : 1.0 / aa[i + i * lda]);
-      dscal_(&x->rows, &alpha, xa + i * ldx, &u_one);
+      alpha = (atrans ? 1.0 / aa[i + i * lda] : 1.0 / CONJ(aa[i + i * lda]));
+      h2_scal(&x->rows, &alpha, xa + i * ldx, &u_one);
     }
   }
   else {
     for (i = 0; i < n; i++) {
       alpha = (atrans ? 1.0 / CONJ(aa[i + i * lda]) : 1.0 / aa[i + i * lda]);
-      dscal_(&x->cols, &alpha, xa + i, &ldx);
+      h2_scal(&x->cols, &alpha, xa + i, &ldx);
     }
   }
 }
@@ -70,14 +67,14 @@ diagsolve_amatrix(bool atrans, pcamatrix a, bool xtrans, pamatrix x)
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      lda = a->ld;
   uint      ldx = x->ld;
-  double   *aa = a->a;
-  double   *xa = x->a;
-  double    alpha;
+  pfield    aa = a->a;
+  pfield    xa = x->a;
+  field     alpha;
   uint      i, j;
 
   if (xtrans) {
     for (i = 0; i < n; i++) {
-      alpha = (atrans ? 1.0 / CONJ(aa[i + i * lda]) : 1.0 / aa[i + i * lda]);
+      alpha = (atrans ? 1.0 / aa[i + i * lda] : 1.0 / CONJ(aa[i + i * lda]));
       for (j = 0; j < x->rows; j++)
 	xa[j + i * ldx] *= alpha;
     }
@@ -93,31 +90,27 @@ diagsolve_amatrix(bool atrans, pcamatrix a, bool xtrans, pamatrix x)
 #endif
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dscal_(const unsigned *n,
-       const double *alpha, double *x, const unsigned *incx);
-
 void
 diageval_amatrix(bool atrans, pcamatrix a, bool xtrans, pamatrix x)
 {
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      lda = a->ld;
   uint      ldx = x->ld;
-  double   *aa = a->a;
-  double   *xa = x->a;
-  double    alpha;
+  pfield    aa = a->a;
+  pfield    xa = x->a;
+  field     alpha;
   uint      i;
 
   if (xtrans) {
     for (i = 0; i < n; i++) {
-      alpha = (atrans ? CONJ(aa[i + i * lda]) : aa[i + i * lda]);
-      dscal_(&x->rows, &alpha, xa + i * ldx, &u_one);
+      alpha = (atrans ? aa[i + i * lda] : CONJ(aa[i + i * lda]));
+      h2_scal(&x->rows, &alpha, xa + i * ldx, &u_one);
     }
   }
   else {
     for (i = 0; i < n; i++) {
       alpha = (atrans ? CONJ(aa[i + i * lda]) : aa[i + i * lda]);
-      dscal_(&x->cols, &alpha, xa + i, &ldx);
+      h2_scal(&x->cols, &alpha, xa + i, &ldx);
     }
   }
 }
@@ -128,14 +121,14 @@ diageval_amatrix(bool atrans, pcamatrix a, bool xtrans, pamatrix x)
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      lda = a->ld;
   uint      ldx = x->ld;
-  double   *aa = a->a;
-  double   *xa = x->a;
-  double    alpha;
+  pfield    aa = a->a;
+  pfield    xa = x->a;
+  field     alpha;
   uint      i, j;
 
   if (xtrans) {
     for (i = 0; i < n; i++) {
-      alpha = (atrans ? CONJ(aa[i + i * lda]) : aa[i + i * lda]);
+      alpha = (atrans ? aa[i + i * lda] : CONJ(aa[i + i * lda]));
       for (j = 0; j < x->rows; j++)
 	xa[j + i * ldx] *= alpha;
     }
@@ -155,15 +148,6 @@ diageval_amatrix(bool atrans, pcamatrix a, bool xtrans, pamatrix x)
  ------------------------------------------------------------ */
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dtrtrs_(const char *uplo,
-	const char *trans,
-	const char *diag,
-	const unsigned *n,
-	const unsigned *nrhs,
-	const double *a,
-	const unsigned *lda, double *b, const unsigned *ldb, int *info);
-
 static void
 lowersolve_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
 {
@@ -174,15 +158,15 @@ lowersolve_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
   assert(x->dim >= a->cols);
 
   if (atrans) {
-    dtrtrs_("Lower", "Transposed",
-	    (aunit ? "Unit triangular" : "Not unit-triangular"),
-	    &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
+    h2_trtrs("Lower", _h2_adj,
+	     (aunit ? "Unit triangular" : "Not unit-triangular"),
+	     &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
     assert(info == 0);
   }
   else {
-    dtrtrs_("Lower", "Not transposed",
-	    (aunit ? "Unit triangular" : "Not unit-triangular"),
-	    &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
+    h2_trtrs("Lower", _h2_ntrans,
+	     (aunit ? "Unit triangular" : "Not unit-triangular"),
+	     &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
     assert(info == 0);
   }
 }
@@ -197,15 +181,15 @@ uppersolve_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
   assert(x->dim >= a->cols);
 
   if (atrans) {
-    dtrtrs_("Upper", "Transposed",
-	    (aunit ? "Unit triangular" : "Non-unit triangular"),
-	    &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
+    h2_trtrs("Upper", _h2_adj,
+	     (aunit ? "Unit triangular" : "Non-unit triangular"),
+	     &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
     assert(info == 0);
   }
   else {
-    dtrtrs_("Upper", "Not transposed",
-	    (aunit ? "Unit triangular" : "Non-unit triangular"),
-	    &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
+    h2_trtrs("Upper", _h2_ntrans,
+	     (aunit ? "Unit triangular" : "Non-unit triangular"),
+	     &n, &u_one, a->a, &a->ld, x->v, &x->dim, &info);
     assert(info == 0);
   }
 }
@@ -280,56 +264,46 @@ triangularsolve_amatrix_avector(bool alower, bool aunit, bool atrans,
 }
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dtrsm_(const char *side,
-       const char *uplo,
-       const char *transa,
-       const char *diag,
-       const unsigned *m,
-       const unsigned *n,
-       const double *alpha,
-       const double *a, const unsigned *lda, double *b, const unsigned *ldb);
-
 static void
 lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 		   bool xtrans, pamatrix x)
 {
   uint      n = UINT_MIN(a->rows, a->cols);
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
-  double   *xa = x->a;
+  pfield    xa = x->a;
   uint      ldx = x->ld;
 
   if (atrans) {
     if (xtrans) {
       assert(x->cols >= n);
 
-      dtrsm_("Right", "Lower", "Not transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Right", "Lower", _h2_ntrans,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
     }
     else {
       assert(x->rows >= n);
 
-      dtrsm_("Left", "Lower", "Transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Left", "Lower", _h2_adj,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
     }
   }
   else {
     if (xtrans) {
       assert(x->cols >= n);
 
-      dtrsm_("Right", "Lower", "Transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Right", "Lower", _h2_adj,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
     }
     else {
       assert(x->rows >= n);
 
-      dtrsm_("Left", "Lower", "Not transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Left", "Lower", _h2_ntrans,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
     }
   }
 }
@@ -339,48 +313,53 @@ uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 		   bool xtrans, pamatrix x)
 {
   uint      n = UINT_MIN(a->rows, a->cols);
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
-  double   *xa = x->a;
+  pfield    xa = x->a;
   uint      ldx = x->ld;
 
   if (atrans) {
     if (xtrans) {
       assert(x->cols >= n);
 
-      dtrsm_("Right", "Upper", "Not transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Right", "Upper", _h2_ntrans,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
     }
     else {
       assert(x->rows >= n);
 
-      dtrsm_("Left", "Upper", "Transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Left", "Upper", _h2_adj,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
     }
   }
   else {
     if (xtrans) {
       assert(x->cols >= n);
 
-      dtrsm_("Right", "Upper", "Transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Right", "Upper", _h2_adj,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
     }
     else {
       assert(x->rows >= n);
 
-      dtrsm_("Left", "Upper", "Not transposed",
-	     (aunit ? "Unit diagonal" : "Non-unit diagonal"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trsm("Left", "Upper", _h2_ntrans,
+	      (aunit ? "Unit diagonal" : "Non-unit diagonal"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
     }
   }
 }
 #else
+/* Triangular matrices up to this size are handled by the unblocked
+ * algorithms, larger ones are split into two halves, and the products
+ * with the off-diagonal block are computed by addmul_amatrix. */
+#define TRIANGULAR_BLOCK 64
+
 static void
-lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
-		   bool xtrans, pamatrix x)
+lowersolve_unblocked_amatrix(bool aunit, bool atrans, pcamatrix a,
+			     bool xtrans, pamatrix x)
 {
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      lda = a->ld;
@@ -400,8 +379,8 @@ lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (i = 0; i < x->rows; i++)
 	    xa[i + k * ldx] *= alpha;
 	}
-	for (i = 0; i < x->rows; i++)
-	  for (j = 0; j < k; j++)
+	for (j = 0; j < k; j++)
+	  for (i = 0; i < x->rows; i++)
 	    xa[i + j * ldx] -= xa[i + k * ldx] * aa[k + j * lda];
       }
     }
@@ -414,8 +393,8 @@ lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (j = 0; j < x->cols; j++)
 	    xa[k + j * ldx] *= alpha;
 	}
-	for (i = 0; i < k; i++)
-	  for (j = 0; j < x->cols; j++)
+	for (j = 0; j < x->cols; j++)
+	  for (i = 0; i < k; i++)
 	    xa[i + j * ldx] -= CONJ(aa[k + i * lda]) * xa[k + j * ldx];
       }
     }
@@ -430,8 +409,8 @@ lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (i = 0; i < x->rows; i++)
 	    xa[i + k * ldx] *= alpha;
 	}
-	for (i = 0; i < x->rows; i++)
-	  for (j = k + 1; j < n; j++)
+	for (j = k + 1; j < n; j++)
+	  for (i = 0; i < x->rows; i++)
 	    xa[i + j * ldx] -= xa[i + k * ldx] * CONJ(aa[j + k * lda]);
       }
     }
@@ -444,8 +423,8 @@ lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (j = 0; j < x->cols; j++)
 	    xa[k + j * ldx] *= alpha;
 	}
-	for (i = k + 1; i < n; i++)
-	  for (j = 0; j < x->cols; j++)
+	for (j = 0; j < x->cols; j++)
+	  for (i = k + 1; i < n; i++)
 	    xa[i + j * ldx] -= aa[i + k * lda] * xa[k + j * ldx];
       }
     }
@@ -453,8 +432,8 @@ lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 }
 
 static void
-uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
-		   bool xtrans, pamatrix x)
+uppersolve_unblocked_amatrix(bool aunit, bool atrans, pcamatrix a,
+			     bool xtrans, pamatrix x)
 {
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      lda = a->ld;
@@ -474,8 +453,8 @@ uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (i = 0; i < x->rows; i++)
 	    xa[i + k * ldx] *= alpha;
 	}
-	for (i = 0; i < x->rows; i++)
-	  for (j = k + 1; j < n; j++)
+	for (j = k + 1; j < n; j++)
+	  for (i = 0; i < x->rows; i++)
 	    xa[i + j * ldx] -= xa[i + k * ldx] * aa[k + j * lda];
       }
     }
@@ -488,8 +467,8 @@ uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (j = 0; j < x->cols; j++)
 	    xa[k + j * ldx] *= alpha;
 	}
-	for (i = k + 1; i < n; i++)
-	  for (j = 0; j < x->cols; j++)
+	for (j = 0; j < x->cols; j++)
+	  for (i = k + 1; i < n; i++)
 	    xa[i + j * ldx] -= CONJ(aa[k + i * lda]) * xa[k + j * ldx];
       }
     }
@@ -504,8 +483,8 @@ uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (i = 0; i < x->rows; i++)
 	    xa[i + k * ldx] *= alpha;
 	}
-	for (i = 0; i < x->rows; i++)
-	  for (j = 0; j < k; j++)
+	for (j = 0; j < k; j++)
+	  for (i = 0; i < x->rows; i++)
 	    xa[i + j * ldx] -= xa[i + k * ldx] * CONJ(aa[j + k * lda]);
       }
     }
@@ -518,13 +497,129 @@ uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
 	  for (j = 0; j < x->cols; j++)
 	    xa[k + j * ldx] *= alpha;
 	}
-	for (i = 0; i < k; i++)
-	  for (j = 0; j < x->cols; j++)
+	for (j = 0; j < x->cols; j++)
+	  for (i = 0; i < k; i++)
 	    xa[i + j * ldx] -= aa[i + k * lda] * xa[k + j * ldx];
       }
     }
   }
 }
+
+static void
+lowersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
+		   bool xtrans, pamatrix x)
+{
+  uint      n = UINT_MIN(a->rows, a->cols);
+  uint      n1, n2;
+  amatrix   tmp1, tmp2, tmp3, tmp4, tmp5;
+  pamatrix  a11, a21, a22, x1, x2;
+
+  if (n <= TRIANGULAR_BLOCK) {
+    lowersolve_unblocked_amatrix(aunit, atrans, a, xtrans, x);
+    return;
+  }
+
+  n1 = n / 2;
+  n2 = n - n1;
+
+  a11 = init_sub_amatrix(&tmp1, (pamatrix) a, n1, 0, n1, 0);
+  a21 = init_sub_amatrix(&tmp2, (pamatrix) a, n2, n1, n1, 0);
+  a22 = init_sub_amatrix(&tmp3, (pamatrix) a, n2, n1, n2, n1);
+
+  if (xtrans) {
+    assert(x->cols >= n);
+
+    x1 = init_sub_amatrix(&tmp4, x, x->rows, 0, n1, 0);
+    x2 = init_sub_amatrix(&tmp5, x, x->rows, 0, n2, n1);
+  }
+  else {
+    assert(x->rows >= n);
+
+    x1 = init_sub_amatrix(&tmp4, x, n1, 0, x->cols, 0);
+    x2 = init_sub_amatrix(&tmp5, x, n2, n1, x->cols, 0);
+  }
+
+  if (atrans) {
+    lowersolve_amatrix(aunit, atrans, a22, xtrans, x2);
+    if (xtrans)
+      addmul_amatrix(-1.0, false, x2, false, a21, x1);
+    else
+      addmul_amatrix(-1.0, true, a21, false, x2, x1);
+    lowersolve_amatrix(aunit, atrans, a11, xtrans, x1);
+  }
+  else {
+    lowersolve_amatrix(aunit, atrans, a11, xtrans, x1);
+    if (xtrans)
+      addmul_amatrix(-1.0, false, x1, true, a21, x2);
+    else
+      addmul_amatrix(-1.0, false, a21, false, x1, x2);
+    lowersolve_amatrix(aunit, atrans, a22, xtrans, x2);
+  }
+
+  uninit_amatrix(x2);
+  uninit_amatrix(x1);
+  uninit_amatrix(a22);
+  uninit_amatrix(a21);
+  uninit_amatrix(a11);
+}
+
+static void
+uppersolve_amatrix(bool aunit, bool atrans, pcamatrix a,
+		   bool xtrans, pamatrix x)
+{
+  uint      n = UINT_MIN(a->rows, a->cols);
+  uint      n1, n2;
+  amatrix   tmp1, tmp2, tmp3, tmp4, tmp5;
+  pamatrix  a11, a12, a22, x1, x2;
+
+  if (n <= TRIANGULAR_BLOCK) {
+    uppersolve_unblocked_amatrix(aunit, atrans, a, xtrans, x);
+    return;
+  }
+
+  n1 = n / 2;
+  n2 = n - n1;
+
+  a11 = init_sub_amatrix(&tmp1, (pamatrix) a, n1, 0, n1, 0);
+  a12 = init_sub_amatrix(&tmp2, (pamatrix) a, n1, 0, n2, n1);
+  a22 = init_sub_amatrix(&tmp3, (pamatrix) a, n2, n1, n2, n1);
+
+  if (xtrans) {
+    assert(x->cols >= n);
+
+    x1 = init_sub_amatrix(&tmp4, x, x->rows, 0, n1, 0);
+    x2 = init_sub_amatrix(&tmp5, x, x->rows, 0, n2, n1);
+  }
+  else {
+    assert(x->rows >= n);
+
+    x1 = init_sub_amatrix(&tmp4, x, n1, 0, x->cols, 0);
+    x2 = init_sub_amatrix(&tmp5, x, n2, n1, x->cols, 0);
+  }
+
+  if (atrans) {
+    uppersolve_amatrix(aunit, atrans, a11, xtrans, x1);
+    if (xtrans)
+      addmul_amatrix(-1.0, false, x1, false, a12, x2);
+    else
+      addmul_amatrix(-1.0, true, a12, false, x1, x2);
+    uppersolve_amatrix(aunit, atrans, a22, xtrans, x2);
+  }
+  else {
+    uppersolve_amatrix(aunit, atrans, a22, xtrans, x2);
+    if (xtrans)
+      addmul_amatrix(-1.0, false, x2, true, a12, x1);
+    else
+      addmul_amatrix(-1.0, false, a12, false, x2, x1);
+    uppersolve_amatrix(aunit, atrans, a11, xtrans, x1);
+  }
+
+  uninit_amatrix(x2);
+  uninit_amatrix(x1);
+  uninit_amatrix(a22);
+  uninit_amatrix(a12);
+  uninit_amatrix(a11);
+}
 #endif
 
 void
@@ -538,29 +633,11 @@ triangularsolve_amatrix(bool alower, bool aunit, bool atrans, pcamatrix a,
 }
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dtrmv_(const char *uplo,
-       const char *trans,
-       const char *diag,
-       const unsigned *n,
-       const double *a, const unsigned *lda, double *x, const unsigned *incx);
-
-IMPORT_PREFIX void
-dgemv_(const char *trans,
-       const unsigned *m,
-       const unsigned *n,
-       const double *alpha,
-       const double *a,
-       const unsigned *lda,
-       const double *x,
-       const unsigned *incx,
-       const double *beta, double *y, const unsigned *incy);
-
 static void
 lowereval_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
 {
-  double   *aa = a->a;
-  double   *xv = x->v;
+  pfield    aa = a->a;
+  pfield    xv = x->v;
   uint      lda = a->ld;
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      n1, i;
@@ -573,15 +650,15 @@ lowereval_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
 
   if (atrans) {
     /* Left upper part, upper triangular */
-    dtrmv_("Lower", "Transposed",
-	   (aunit ? "Unit triangular" : "Non-unit triangular"),
-	   &n, aa, &lda, xv, &u_one);
+    h2_trmv("Lower", _h2_adj,
+	    (aunit ? "Unit triangular" : "Non-unit triangular"),
+	    &n, aa, &lda, xv, &u_one);
 
     /* Right part */
     if (n < a->rows) {
       n1 = a->rows - n;
-      dgemv_("Transposed", &n1, &n, &f_one,
-	     aa + n, &lda, xv + n, &u_one, &f_one, xv, &u_one);
+      h2_gemv(_h2_adj, &n1, &n, &f_one,
+	      aa + n, &lda, xv + n, &u_one, &f_one, xv, &u_one);
     }
 
     /* Lower part */
@@ -596,22 +673,22 @@ lowereval_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
 	xv[i] = 0.0;
 
       n1 = a->rows - n;
-      dgemv_("Not Transposed", &n1, &n, &f_one,
-	     aa + n, &lda, xv, &u_one, &f_one, xv + n, &u_one);
+      h2_gemv(_h2_ntrans, &n1, &n, &f_one,
+	      aa + n, &lda, xv, &u_one, &f_one, xv + n, &u_one);
     }
 
     /* Top part, lower triangular */
-    dtrmv_("Lower", "Not transposed",
-	   (aunit ? "Unit triangular" : "Non-unit triangular"),
-	   &n, aa, &lda, xv, &u_one);
+    h2_trmv("Lower", _h2_ntrans,
+	    (aunit ? "Unit triangular" : "Non-unit triangular"),
+	    &n, aa, &lda, xv, &u_one);
   }
 }
 
 static void
 uppereval_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
 {
-  double   *aa = a->a;
-  double   *xv = x->v;
+  pfield    aa = a->a;
+  pfield    xv = x->v;
   uint      lda = a->ld;
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      n1, i;
@@ -629,26 +706,26 @@ uppereval_amatrix_avector(bool aunit, bool atrans, pcamatrix a, pavector x)
 	xv[i] = 0.0;
 
       n1 = a->cols - n;
-      dgemv_("Transposed", &n, &n1, &f_one,
-	     aa + n * lda, &lda, xv, &u_one, &f_one, xv + n, &u_one);
+      h2_gemv(_h2_adj, &n, &n1, &f_one,
+	      aa + n * lda, &lda, xv, &u_one, &f_one, xv + n, &u_one);
     }
 
     /* Top part, lower triangular */
-    dtrmv_("Upper", "Transposed",
-	   (aunit ? "Unit triangular" : "Non-unit triangular"),
-	   &n, aa, &lda, xv, &u_one);
+    h2_trmv("Upper", _h2_adj,
+	    (aunit ? "Unit triangular" : "Non-unit triangular"),
+	    &n, aa, &lda, xv, &u_one);
   }
   else {
     /* Left upper part, upper triangular */
-    dtrmv_("Upper", "Not transposed",
-	   (aunit ? "Unit triangular" : "Non-unit triangular"),
-	   &n, aa, &lda, xv, &u_one);
+    h2_trmv("Upper", _h2_ntrans,
+	    (aunit ? "Unit triangular" : "Non-unit triangular"),
+	    &n, aa, &lda, xv, &u_one);
 
     /* Right part */
     if (n < a->cols) {
       n1 = a->cols - n;
-      dgemv_("Not transposed", &n, &n1, &f_one,
-	     aa + n * lda, &lda, xv + n, &u_one, &f_one, xv, &u_one);
+      h2_gemv(_h2_ntrans, &n, &n1, &f_one,
+	      aa + n * lda, &lda, xv + n, &u_one, &f_one, xv, &u_one);
     }
 
     /* Lower part */
@@ -782,36 +859,13 @@ triangulareval_amatrix_avector(bool alower, bool aunit, bool atrans,
 }
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dtrmm_(const char *side,
-       const char *uplo,
-       const char *trans,
-       const char *diag,
-       const unsigned *m,
-       const unsigned *n,
-       const double *alpha,
-       const double *a, const unsigned *lda, double *b, const unsigned *ldb);
-
-IMPORT_PREFIX void
-dgemm_(const char *transa,
-       const char *transb,
-       const unsigned *m,
-       const unsigned *n,
-       const unsigned *k,
-       const double *alpha,
-       const double *a,
-       const unsigned *lda,
-       const double *b,
-       const unsigned *ldb,
-       const double *beta, double *c, const unsigned *ldc);
-
 static void
 lowereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 		  bool xtrans, pamatrix x)
 {
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
-  double   *xa = x->a;
+  pfield    xa = x->a;
   uint      ldx = x->ld;
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      n1, i, j;
@@ -825,15 +879,15 @@ lowereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 
     if (atrans) {
       /* Left upper part, upper triangular */
-      dtrmm_("Right", "Lower", "Not transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Right", "Lower", _h2_ntrans,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
 
       /* Right part */
       if (n < a->rows) {
 	n1 = a->rows - n;
-	dgemm_("Not transposed", "Not transposed", &x->rows, &n, &n1, &f_one,
-	       xa + n * ldx, &ldx, aa + n, &lda, &f_one, xa, &ldx);
+	h2_gemm(_h2_ntrans, _h2_ntrans, &x->rows, &n, &n1, &f_one,
+		xa + n * ldx, &ldx, aa + n, &lda, &f_one, xa, &ldx);
       }
 
       /* Lower part */
@@ -850,14 +904,14 @@ lowereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 	    xa[j + i * ldx] = 0.0;
 
 	n1 = a->rows - n;
-	dgemm_("Not transposed", "Transposed", &x->rows, &n1, &n, &f_one,
-	       xa, &ldx, aa + n, &lda, &f_one, xa + n * ldx, &ldx);
+	h2_gemm(_h2_ntrans, _h2_adj, &x->rows, &n1, &n, &f_one,
+		xa, &ldx, aa + n, &lda, &f_one, xa + n * ldx, &ldx);
       }
 
       /* Top part, lower triangular */
-      dtrmm_("Right", "Lower", "Transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Right", "Lower", _h2_adj,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
     }
   }
   else {
@@ -866,15 +920,15 @@ lowereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 
     if (atrans) {
       /* Left upper part, upper triangular */
-      dtrmm_("Left", "Lower", "Transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Left", "Lower", _h2_adj,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
 
       /* Right part */
       if (n < a->rows) {
 	n1 = a->rows - n;
-	dgemm_("Transposed", "Not Transposed", &n, &x->cols, &n1, &f_one,
-	       aa + n, &lda, xa + n, &ldx, &f_one, xa, &ldx);
+	h2_gemm(_h2_adj, _h2_ntrans, &n, &x->cols, &n1, &f_one,
+		aa + n, &lda, xa + n, &ldx, &f_one, xa, &ldx);
       }
 
       /* Lower part */
@@ -891,14 +945,14 @@ lowereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 	    xa[i + j * ldx] = 0.0;
 
 	n1 = a->rows - n;
-	dgemm_("Not Transposed", "Not Transposed", &n1, &x->cols, &n, &f_one,
-	       aa + n, &lda, xa, &ldx, &f_one, xa + n, &ldx);
+	h2_gemm(_h2_ntrans, _h2_ntrans, &n1, &x->cols, &n, &f_one,
+		aa + n, &lda, xa, &ldx, &f_one, xa + n, &ldx);
       }
 
       /* Top part, lower triangular */
-      dtrmm_("Left", "Lower", "Not transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Left", "Lower", _h2_ntrans,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
     }
   }
 }
@@ -907,9 +961,9 @@ static void
 uppereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 		  bool xtrans, pamatrix x)
 {
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
-  double   *xa = x->a;
+  pfield    xa = x->a;
   uint      ldx = x->ld;
   uint      n = UINT_MIN(a->rows, a->cols);
   uint      n1, i, j;
@@ -929,26 +983,26 @@ uppereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 	    xa[j + i * ldx] = 0.0;
 
 	n1 = a->cols - n;
-	dgemm_("Not Transposed", "Not transposed", &x->rows, &n1, &n, &f_one,
-	       xa, &ldx, aa + n * lda, &lda, &f_one, xa + n * ldx, &ldx);
+	h2_gemm(_h2_ntrans, _h2_ntrans, &x->rows, &n1, &n, &f_one,
+		xa, &ldx, aa + n * lda, &lda, &f_one, xa + n * ldx, &ldx);
       }
 
       /* Top part, lower triangular */
-      dtrmm_("Right", "Upper", "Not transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Right", "Upper", _h2_ntrans,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
     }
     else {
       /* Left upper part, upper triangular */
-      dtrmm_("Right", "Upper", "Transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Right", "Upper", _h2_adj,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &x->rows, &n, &f_one, aa, &lda, xa, &ldx);
 
       /* Right part */
       if (n < a->cols) {
 	n1 = a->cols - n;
-	dgemm_("Not transposed", "Transposed", &x->rows, &n, &n1, &f_one,
-	       xa + n * ldx, &ldx, aa + n * lda, &lda, &f_one, xa, &ldx);
+	h2_gemm(_h2_ntrans, _h2_adj, &x->rows, &n, &n1, &f_one,
+		xa + n * ldx, &ldx, aa + n * lda, &lda, &f_one, xa, &ldx);
       }
 
       /* Lower part */
@@ -970,26 +1024,26 @@ uppereval_amatrix(bool aunit, bool atrans, pcamatrix a,
 	    xa[i + j * ldx] = 0.0;
 
 	n1 = a->cols - n;
-	dgemm_("Transposed", "Not Transposed", &n1, &x->cols, &n, &f_one,
-	       aa + n * lda, &lda, xa, &ldx, &f_one, xa + n, &ldx);
+	h2_gemm(_h2_adj, _h2_ntrans, &n1, &x->cols, &n, &f_one,
+		aa + n * lda, &lda, xa, &ldx, &f_one, xa + n, &ldx);
       }
 
       /* Top part, lower triangular */
-      dtrmm_("Left", "Upper", "Transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Left", "Upper", _h2_adj,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
     }
     else {
       /* Left upper part, upper triangular */
-      dtrmm_("Left", "Upper", "Not transposed",
-	     (aunit ? "Unit triangular" : "Non-unit triangular"),
-	     &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
+      h2_trmm("Left", "Upper", _h2_ntrans,
+	      (aunit ? "Unit triangular" : "Non-unit triangular"),
+	      &n, &x->cols, &f_one, aa, &lda, xa, &ldx);
 
       /* Right part */
       if (n < a->cols) {
 	n1 = a->cols - n;
-	dgemm_("Not transposed", "Not Transposed", &n, &x->cols, &n1, &f_one,
-	       aa + n * lda, &lda, xa + n, &ldx, &f_one, xa, &ldx);
+	h2_gemm(_h2_ntrans, _h2_ntrans, &n, &x->cols, &n1, &f_one,
+		aa + n * lda, &lda, xa + n, &ldx, &f_one, xa, &ldx);
       }
 
       /* Lower part */
@@ -1252,16 +1306,6 @@ triangulareval_amatrix(bool alower, bool aunit, bool atrans, pcamatrix a,
     uppereval_amatrix(aunit, atrans, a, xtrans, x);
 }
 
-#ifdef USE_BLAS
-IMPORT_PREFIX void
-dger_(const unsigned *m,
-      const unsigned *n,
-      const double *alpha,
-      const double *x,
-      const unsigned *incx,
-      const double *y, const unsigned *incy, double *a, const unsigned *lda);
-#endif
-
 void
 triangularaddmul_amatrix(field alpha, bool alower, bool atrans,
 			 pcamatrix a, bool blower, bool btrans, pcamatrix b,
@@ -1275,7 +1319,7 @@ triangularaddmul_amatrix(field alpha, bool alower, bool atrans,
   uint      ldc = c->ld;
   uint      aoff, adim, ainc, boff, bdim, binc;
   uint      j;
-#ifndef USE_BLAS
+#if !defined(USE_BLAS) || defined(USE_COMPLEX)
   uint      i, k;
 #endif
 
@@ -1310,11 +1354,12 @@ triangularaddmul_amatrix(field alpha, bool alower, bool atrans,
 	  bdim = UINT_MIN(j + 1, b->rows);
 	}
 
-#ifdef USE_BLAS
-	dger_(&adim, &bdim, &alpha,
-	      aa + aoff * ainc + j * lda, &ainc,
-	      ba + boff * binc + j * ldb, &binc,
-	      ca + aoff + boff * ldc, &ldc);
+	/* BLAS has no rank-one update with a conjugated left factor */
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
+	h2_geru(&adim, &bdim, &alpha,
+		aa + aoff * ainc + j * lda, &ainc,
+		ba + boff * binc + j * ldb, &binc,
+		ca + aoff + boff * ldc, &ldc);
 #else
 	for (k = 0; k < bdim; k++)
 	  for (i = 0; i < adim; i++)
@@ -1350,11 +1395,12 @@ triangularaddmul_amatrix(field alpha, bool alower, bool atrans,
 	  bdim = b->cols - UINT_MIN(j, b->cols);
 	}
 
-#ifdef USE_BLAS
-	dger_(&adim, &bdim, &alpha,
-	      aa + aoff * ainc + j * lda, &ainc,
-	      ba + boff * binc + j * ldb, &binc,
-	      ca + aoff + boff * ldc, &ldc);
+	/* BLAS has no rank-one update with a conjugated left factor */
+#if defined(USE_BLAS) && !defined(USE_COMPLEX)
+	h2_geru(&adim, &bdim, &alpha,
+		aa + aoff * ainc + j * lda, &ainc,
+		ba + boff * binc + j * ldb, &binc,
+		ca + aoff + boff * ldc, &ldc);
 #else
 	for (k = 0; k < bdim; k++)
 	  for (i = 0; i < adim; i++)
@@ -1396,10 +1442,10 @@ triangularaddmul_amatrix(field alpha, bool alower, bool atrans,
 	}
 
 #ifdef USE_BLAS
-	dger_(&adim, &bdim, &alpha,
-	      aa + aoff * ainc + j * lda, &ainc,
-	      ba + boff * binc + j * ldb, &binc,
-	      ca + aoff + boff * ldc, &ldc);
+	h2_gerc(&adim, &bdim, &alpha,
+		aa + aoff * ainc + j * lda, &ainc,
+		ba + boff * binc + j * ldb, &binc,
+		ca + aoff + boff * ldc, &ldc);
 #else
 	for (k = 0; k < bdim; k++)
 	  for (i = 0; i < adim; i++)
@@ -1436,10 +1482,10 @@ triangularaddmul_amatrix(field alpha, bool alower, bool atrans,
 	}
 
 #ifdef USE_BLAS
-	dger_(&adim, &bdim, &alpha,
-	      aa + aoff * ainc + j * lda, &ainc,
-	      ba + boff * binc + j * ldb, &binc,
-	      ca + aoff + boff * ldc, &ldc);
+	h2_geru(&adim, &bdim, &alpha,
+		aa + aoff * ainc + j * lda, &ainc,
+		ba + boff * binc + j * ldb, &binc,
+		ca + aoff + boff * ldc, &ldc);
 #else
 
 	for (k = 0; k < bdim; k++)
@@ -1528,25 +1574,13 @@ copy_upper_amatrix(pcamatrix a, bool aunit, pamatrix b)
  ------------------------------------------------------------ */
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dscal_(const unsigned *n,
-       const double *alpha, double *x, const unsigned *incx);
-
-IMPORT_PREFIX void
-dger_(const unsigned *m,
-      const unsigned *n,
-      const double *alpha,
-      const double *x,
-      const unsigned *incx,
-      const double *y, const unsigned *incy, double *a, const unsigned *lda);
-
 uint
 lrdecomp_amatrix(pamatrix a)
 {
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
   uint      n = a->rows;
-  double    alpha;
+  field     alpha;
   uint      i, n1;
 
   assert(n == a->cols);
@@ -1558,11 +1592,11 @@ lrdecomp_amatrix(pamatrix a)
     alpha = 1.0 / aa[i + i * lda];
 
     n1 = n - i - 1;
-    dscal_(&n1, &alpha, aa + (i + 1) + i * lda, &u_one);
-    dger_(&n1, &n1,
-	  &f_minusone,
-	  aa + (i + 1) + i * lda, &u_one,
-	  aa + i + (i + 1) * lda, &lda, aa + (i + 1) + (i + 1) * lda, &lda);
+    h2_scal(&n1, &alpha, aa + (i + 1) + i * lda, &u_one);
+    h2_geru(&n1, &n1,
+	    &f_minusone,
+	    aa + (i + 1) + i * lda, &u_one,
+	    aa + i + (i + 1) * lda, &lda, aa + (i + 1) + (i + 1) * lda, &lda);
   }
 
   if (aa[i + i * lda] == 0.0)
@@ -1571,8 +1605,8 @@ lrdecomp_amatrix(pamatrix a)
   return 0;
 }
 #else
-uint
-lrdecomp_amatrix(pamatrix a)
+static    uint
+lrdecomp_unblocked_amatrix(pamatrix a)
 {
   pfield    aa = a->a;
   uint      lda = a->ld;
@@ -1588,11 +1622,12 @@ lrdecomp_amatrix(pamatrix a)
 
     alpha = 1.0 / aa[i + i * lda];
 
-    for (j = i + 1; j < n; j++) {
+    for (j = i + 1; j < n; j++)
       aa[j + i * lda] *= alpha;
-      for (k = i + 1; k < n; k++)
+
+    for (k = i + 1; k < n; k++)
+      for (j = i + 1; j < n; j++)
 	aa[j + k * lda] -= aa[j + i * lda] * aa[i + k * lda];
-    }
   }
 
   if (aa[i + i * lda] == 0.0)
@@ -1600,6 +1635,48 @@ lrdecomp_amatrix(pamatrix a)
 
   return 0;
 }
+
+uint
+lrdecomp_amatrix(pamatrix a)
+{
+  uint      n = a->rows;
+  amatrix   tmp1, tmp2, tmp3, tmp4;
+  pamatrix  a11, a12, a21, a22;
+  uint      k, m, r, info;
+
+  assert(n == a->cols);
+
+  for (k = 0; k < n; k += m) {
+    m = UINT_MIN(TRIANGULAR_BLOCK, n - k);
+    r = n - k - m;
+
+    a11 = init_sub_amatrix(&tmp1, a, m, k, m, k);
+    info = lrdecomp_unblocked_amatrix(a11);
+
+    if (info == 0 && r > 0) {
+      a12 = init_sub_amatrix(&tmp2, a, m, k, r, k + m);
+      a21 = init_sub_amatrix(&tmp3, a, r, k + m, m, k);
+      a22 = init_sub_amatrix(&tmp4, a, r, k + m, r, k + m);
+
+      /* A_{12} := L_{11}^{-1} A_{12}, A_{21} := A_{21} R_{11}^{-1} */
+      lowersolve_amatrix(true, false, a11, false, a12);
+      uppersolve_amatrix(false, true, a11, true, a21);
+
+      addmul_amatrix(-1.0, false, a21, false, a12, a22);
+
+      uninit_amatrix(a22);
+      uninit_amatrix(a21);
+      uninit_amatrix(a12);
+    }
+
+    uninit_amatrix(a11);
+
+    if (info)
+      return k + info;
+  }
+
+  return 0;
+}
 #endif
 
 void
@@ -1614,14 +1691,10 @@ lrsolve_amatrix_avector(pcamatrix a, pavector x)
  ------------------------------------------------------------ */
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dpotrf_(const char *uplo,
-	const unsigned *n, double *a, const unsigned *lda, int *info);
-
 uint
 choldecomp_amatrix(pamatrix a)
 {
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
   uint      n = a->rows;
 
@@ -1629,13 +1702,13 @@ choldecomp_amatrix(pamatrix a)
 
   assert(n == a->cols);
 
-  dpotrf_("Lower Part", &n, aa, &lda, &info);
+  h2_potrf("Lower Part", &n, aa, &lda, &info);
 
   return info;
 }
 #else
-uint
-choldecomp_amatrix(pamatrix a)
+static    uint
+choldecomp_unblocked_amatrix(pamatrix a)
 {
   pfield    aa = a->a;
   uint      lda = a->ld;
@@ -1656,8 +1729,8 @@ choldecomp_amatrix(pamatrix a)
     for (j = i + 1; j < n; j++)
       aa[j + i * lda] *= alpha;
 
-    for (j = i + 1; j < n; j++)
-      for (k = i + 1; k <= j; k++)
+    for (k = i + 1; k < n; k++)
+      for (j = k; j < n; j++)
 	aa[j + k * lda] -= aa[j + i * lda] * CONJ(aa[k + i * lda]);
   }
 
@@ -1669,6 +1742,72 @@ choldecomp_amatrix(pamatrix a)
 
   return 0;
 }
+
+uint
+choldecomp_amatrix(pamatrix a)
+{
+  pfield    aa = a->a;
+  uint      lda = a->ld;
+  uint      n = a->rows;
+  amatrix   tmp1, tmp2, tmp3, tmp4, tmp5;
+  pamatrix  a11, a21, l1, l2, a32;
+  pfield    la;
+  field     beta;
+  uint      ldl, k, m, r, h, i, j, l, p, q, info;
+
+  assert(n == a->cols);
+
+  for (k = 0; k < n; k += m) {
+    m = UINT_MIN(TRIANGULAR_BLOCK, n - k);
+    r = n - k - m;
+
+    a11 = init_sub_amatrix(&tmp1, a, m, k, m, k);
+    info = choldecomp_unblocked_amatrix(a11);
+
+    if (info == 0 && r > 0) {
+      a21 = init_sub_amatrix(&tmp2, a, r, k + m, m, k);
+
+      /* L_{21} := A_{21} L_{11}^{-*} */
+      lowersolve_amatrix(false, false, a11, true, a21);
+
+      /* A_{22} := A_{22} - L_{21} L_{21}^*, only the lower triangle */
+      la = a21->a;
+      ldl = a21->ld;
+      for (j = 0; j < r; j += l) {
+	l = UINT_MIN(TRIANGULAR_BLOCK, r - j);
+	q = k + m + j;
+
+	for (i = 0; i < l; i++)
+	  for (p = 0; p < m; p++) {
+	    beta = CONJ(la[j + i + p * ldl]);
+	    for (h = i; h < l; h++)
+	      aa[(q + h) + (q + i) * lda] -= la[j + h + p * ldl] * beta;
+	  }
+
+	if (j + l < r) {
+	  l1 = init_sub_amatrix(&tmp3, a21, l, j, m, 0);
+	  l2 = init_sub_amatrix(&tmp4, a21, r - j - l, j + l, m, 0);
+	  a32 = init_sub_amatrix(&tmp5, a, r - j - l, q + l, l, q);
+
+	  addmul_amatrix(-1.0, false, l2, true, l1, a32);
+
+	  uninit_amatrix(a32);
+	  uninit_amatrix(l2);
+	  uninit_amatrix(l1);
+	}
+      }
+
+      uninit_amatrix(a21);
+    }
+
+    uninit_amatrix(a11);
+
+    if (info)
+      return k + info;
+  }
+
+  return 0;
+}
 #endif
 
 void
@@ -1683,23 +1822,14 @@ cholsolve_amatrix_avector(pcamatrix a, pavector x)
  ------------------------------------------------------------ */
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dscal_(const unsigned *n,
-       const double *alpha, double *x, const unsigned *incx);
-
-IMPORT_PREFIX void
-dsyr_(const char *uplo,
-      const unsigned *n,
-      const double *alpha,
-      const double *x, const unsigned *incx, double *a, const unsigned *lda);
-
 uint
 ldltdecomp_amatrix(pamatrix a)
 {
-  double   *aa = a->a;
+  pfield    aa = a->a;
   uint      lda = a->ld;
   uint      n = a->rows;
-  double    diag, alpha;
+  real      diag, alpha;
+  field     beta;
   uint      i, n1;
 
   assert(n == a->cols);
@@ -1710,14 +1840,14 @@ ldltdecomp_amatrix(pamatrix a)
     if (ABS(aa[i + i * lda] - diag) > 1e-12 || diag == 0.0)
       return i + 1;
 
-    alpha = 1.0 / diag;
+    beta = 1.0 / diag;
     n1 = n - i - 1;
-    dscal_(&n1, &alpha, aa + (i + 1) + i * lda, &u_one);
+    h2_scal(&n1, &beta, aa + (i + 1) + i * lda, &u_one);
 
     alpha = -diag;
-    dsyr_("Lower part", &n1,
-	  &alpha,
-	  aa + (i + 1) + i * lda, &u_one, aa + (i + 1) + (i + 1) * lda, &lda);
+    h2_syr("Lower part", &n1,
+	   &alpha,
+	   aa + (i + 1) + i * lda, &u_one, aa + (i + 1) + (i + 1) * lda, &lda);
   }
 
   diag = REAL(aa[i + i * lda]);
@@ -1774,21 +1904,15 @@ ldltsolve_amatrix_avector(pcamatrix a, pavector x)
  ------------------------------------------------------------ */
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dgeqrf_(const unsigned *m,
-	const unsigned *n,
-	double *a,
-	const unsigned *lda,
-	double *tau, double *work, const int *lwork, int *info);
-
 void
 qrdecomp_amatrix(pamatrix a, pavector tau)
 {
   uint      rows = a->rows;
   uint      cols = a->cols;
   uint      refl = UINT_MIN(rows, cols);
-  double   *work;
-  int       lwork, info;
+  pfield    work;
+  uint      lwork;
+  int       info;
 
   assert(a->ld >= rows);
   /* Quick exit if no reflections used */
@@ -1801,7 +1925,7 @@ qrdecomp_amatrix(pamatrix a, pavector tau)
   if (tau->dim < refl)
     resize_avector(tau, refl);
 
-  dgeqrf_(&rows, &cols, a->a, &a->ld, tau->v, work, &lwork, &info);
+  h2_geqrf(&rows, &cols, a->a, &a->ld, tau->v, work, &lwork, &info);
   assert(info == 0);
 
   freemem(work);
@@ -1874,26 +1998,15 @@ qrdecomp_amatrix(pamatrix a, pavector tau)
  * gfortran does the right thing if called with "-frecursive", but this
  * appears not to be the standard in, e.g., OpenSUSE Linux. */
 #if defined(USE_BLAS) && (defined(THREADSAFE_LAPACK) || !defined(USE_OPENMP))
-IMPORT_PREFIX void
-dormqr_(const char *side,
-	const char *trans,
-	const unsigned *m,
-	const unsigned *n,
-	const unsigned *k,
-	const double *a,
-	const unsigned *lda,
-	const double *tau,
-	double *c,
-	const unsigned *ldc, double *work, const int *lwork, int *info);
-
 void
 qreval_amatrix_avector(bool qtrans, pcamatrix a, pcavector tau, pavector x)
 {
   uint      rows = a->rows;
   uint      cols = a->cols;
   uint      refl;
-  double    work[4];
-  int       lwork, info;
+  field     work[4];
+  uint      lwork;
+  int       info;
 
   refl = UINT_MIN(rows, cols);
 
@@ -1906,15 +2019,15 @@ qreval_amatrix_avector(bool qtrans, pcamatrix a, pcavector tau, pavector x)
   lwork = 4;
 
   if (qtrans) {
-    dormqr_("Left", "Transposed",
-	    &rows, &u_one, &refl,
-	    a->a, &a->ld, tau->v, x->v, &x->dim, work, &lwork, &info);
+    h2_ormqr("Left", _h2_adj,
+	     &rows, &u_one, &refl,
+	     a->a, &a->ld, tau->v, x->v, &x->dim, work, &lwork, &info);
     assert(info == 0);
   }
   else {
-    dormqr_("Left", "Not Transposed",
-	    &rows, &u_one, &refl,
-	    a->a, &a->ld, tau->v, x->v, &x->dim, work, &lwork, &info);
+    h2_ormqr("Left", _h2_ntrans,
+	     &rows, &u_one, &refl,
+	     a->a, &a->ld, tau->v, x->v, &x->dim, work, &lwork, &info);
     assert(info == 0);
   }
 }
@@ -1925,8 +2038,9 @@ qreval_amatrix(bool qtrans, pcamatrix a, pcavector tau, pamatrix x)
   uint      rows = a->rows;
   uint      cols = a->cols;
   uint      refl;
-  double   *work;
-  int       lwork, info;
+  pfield    work;
+  uint      lwork;
+  int       info;
 
   refl = UINT_MIN(rows, cols);
 
@@ -1937,18 +2051,18 @@ qreval_amatrix(bool qtrans, pcamatrix a, pcavector tau, pamatrix x)
   assert(x->rows >= rows);
 
   lwork = 4 * x->cols;
-  work = (double *) allocmem((size_t) sizeof(double) * lwork);
+  work = allocfield(lwork);
 
   if (qtrans) {
-    dormqr_("Left", "Transposed",
-	    &rows, &x->cols, &refl,
-	    a->a, &a->ld, tau->v, x->a, &x->ld, work, &lwork, &info);
+    h2_ormqr("Left", _h2_adj,
+	     &rows, &x->cols, &refl,
+	     a->a, &a->ld, tau->v, x->a, &x->ld, work, &lwork, &info);
     assert(info == 0);
   }
   else {
-    dormqr_("Left", "Not Transposed",
-	    &rows, &x->cols, &refl,
-	    a->a, &a->ld, tau->v, x->a, &x->ld, work, &lwork, &info);
+    h2_ormqr("Left", _h2_ntrans,
+	     &rows, &x->cols, &refl,
+	     a->a, &a->ld, tau->v, x->a, &x->ld, work, &lwork, &info);
     assert(info == 0);
   }
 
@@ -1973,9 +2087,11 @@ qreval_amatrix_avector(bool qtrans, pcamatrix a, pcavector tau, pavector x)
   assert(tau->dim >= refl);
   assert(x->dim >= rows);
 
+  /* H_k = I - tau_k v_k v_k^*, so Q^* uses the conjugate of tau_k,
+     which is complex if the factorization has been computed by LAPACK */
   if (qtrans) {
     for (k = 0; k < refl; k++) {
-      beta = tauv[k];
+      beta = CONJ(tauv[k]);
 
       if (beta != 0.0) {
 	gamma = xv[k];
@@ -2028,9 +2144,10 @@ qreval_amatrix(bool qtrans, pcamatrix a, pcavector tau, pamatrix x)
   assert(tau->dim >= refl);
   assert(x->rows >= rows);
 
+  /* Conjugate tau_k for Q^*, see qreval_amatrix_avector */
   if (qtrans) {
     for (k = 0; k < refl; k++) {
-      beta = tauv[k];
+      beta = CONJ(tauv[k]);
 
       if (beta != 0.0)
 	for (j = 0; j < x->cols; j++) {
@@ -2106,19 +2223,12 @@ qrinvert_amatrix(pamatrix a)
 }
 
 #ifdef USE_BLAS
-IMPORT_PREFIX void
-dorgqr_(const unsigned *m,
-	const unsigned *n,
-	const unsigned *k,
-	double *a,
-	const unsigned *lda,
-	double *tau, double *work, const unsigned *lwork, unsigned *info);
-
 void
 qrexpand_amatrix(pcamatrix a, pcavector tau, pamatrix q)
 {
-  double   *work;
-  uint      refl, lwork, info;
+  pfield    work;
+  uint      refl, lwork;
+  int       info;
 
   refl = UINT_MIN3(q->cols, a->rows, a->cols);
 
@@ -2133,8 +2243,8 @@ qrexpand_amatrix(pcamatrix a, pcavector tau, pamatrix q)
   lwork = 4 * a->rows;
   work = allocfield(lwork);
 
-  dorgqr_(&q->rows, &q->cols, &refl,
-	  q->a, &q->ld, tau->v, work, &lwork, &info);
+  h2_orgqr(&q->rows, &q->cols, &refl,
+	   q->a, &q->ld, tau->v, work, &lwork, &info);
   assert(info == 0);
 
   freemem(work);
@@ -28,7 +28,7 @@ assemble_gauss(uint m, preal x, preal w)
   assert(info == 0);
 
   for (i = 0; i < m; i++) {
-    x[i] = T->d[i];
+    x[i] = REAL(T->d[i]);
     w[i] = 2.0 * ABSSQR(getentry_amatrix(Q, 0, i));
   }
 
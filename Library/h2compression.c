@@ -1149,7 +1149,7 @@ computebasis_pre(pccluster t, uint tname, uint pardepth,
   pamatrix  Zhat, Zhat1;
   pavector  tau;
   pch2matrixlist hl0;
-  field     norm;
+  real      norm;
   uint      n, k;
   uint      i, off, tname1;
 
@@ -33,6 +33,10 @@ new_h2matrix(pclusterbasis rb, pclusterbasis cb)
   h2->refs = 0;
   h2->desc = 0;
 
+  h2->store = NULL;
+  h2->storesize = 0;
+  h2->bin = NULL;
+
   return h2;
 }
 
@@ -250,6 +254,11 @@ del_h2matrix(ph2matrix h2)
   if (h2->u)
     del_uniform(h2->u);
 
+  if (h2->bin)
+    unref_binarystore(h2->bin);
+  else if (h2->store)
+    freemem(h2->store);
+
   unref_clusterbasis(h2->cb);
   unref_clusterbasis(h2->rb);
 
@@ -283,6 +292,347 @@ unref_h2matrix(ph2matrix h2)
     del_h2matrix(h2);
 }
 
+/* ------------------------------------------------------------
+ Contiguous storage
+ ------------------------------------------------------------ */
+
+static    size_t
+count_store(pch2matrix h2)
+{
+  size_t    size;
+  uint      rsons = h2->rsons;
+  uint      csons = h2->csons;
+  uint      i, j;
+
+  size = 0;
+
+  if (h2->u) {
+    if (h2->u->S.owner == NULL)
+      size += (size_t) h2->u->S.rows * h2->u->S.cols;
+  }
+  else if (h2->f) {
+    if (h2->f->owner == NULL)
+      size += (size_t) h2->f->rows * h2->f->cols;
+  }
+  else
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++)
+	size += count_store(h2->son[i + j * rsons]);
+
+  return size;
+}
+
+static void
+move_to_store(pamatrix a, pfield store, void *owner, size_t *off)
+{
+  if (a->owner == NULL && a->rows > 0 && a->cols > 0) {
+    move_amatrix(a, store + *off, owner);
+    *off += (size_t) a->rows * a->cols;
+  }
+}
+
+static void
+freeze_store(ph2matrix h2, pfield store, void *owner, size_t *off)
+{
+  uint      rsons = h2->rsons;
+  uint      csons = h2->csons;
+  uint      i, j;
+
+  if (h2->u)
+    move_to_store(&h2->u->S, store, owner, off);
+  else if (h2->f)
+    move_to_store(h2->f, store, owner, off);
+  else
+    /* Block rows first, as in the parallel interaction phase */
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++)
+	freeze_store(h2->son[i + j * rsons], store, owner, off);
+}
+
+void
+freeze_h2matrix(ph2matrix h2)
+{
+  size_t    size, off;
+
+  assert(h2->store == NULL);
+
+  size = count_store(h2);
+  if (size == 0)
+    return;
+
+  h2->store = allocfield(size);
+  h2->storesize = size;
+
+  off = 0;
+  freeze_store(h2, h2->store, h2, &off);
+  assert(off == size);
+}
+
+/* ------------------------------------------------------------
+ File I/O
+ ------------------------------------------------------------ */
+
+/* Sons of a matrix use either the father's basis or one of its sons */
+static    uint
+son_index(pcclusterbasis t, pcclusterbasis s)
+{
+  uint      i;
+
+  if (s == t)
+    return 0;
+
+  for (i = 0; i < t->sons && t->son[i] != s; i++);
+  assert(i < t->sons);
+
+  return i + 1;
+}
+
+static    pclusterbasis
+son_clusterbasis(pbinaryfile bf, pclusterbasis t, uint k)
+{
+  if (!check_binaryfile(bf, k <= t->sons))
+    return t;
+
+  return (k == 0 ? t : t->son[k - 1]);
+}
+
+void
+put_binary_h2matrix(pbinaryfile bf, pch2matrix h2)
+{
+  pch2matrix h21;
+  uint      rsons = h2->rsons;
+  uint      csons = h2->csons;
+  uint      i, j;
+
+  if (h2->u) {
+    assert(h2->u->S.rows == h2->rb->k);
+    assert(h2->u->S.cols == h2->cb->k);
+
+    put_uint_binaryfile(bf, 1);
+  }
+  else if (h2->f) {
+    assert(h2->f->rows == h2->rb->t->size);
+    assert(h2->f->cols == h2->cb->t->size);
+
+    put_uint_binaryfile(bf, 2);
+  }
+  else if (h2->son) {
+    put_uint_binaryfile(bf, 3);
+    put_uint_binaryfile(bf, rsons);
+    put_uint_binaryfile(bf, csons);
+
+    /* Block rows first, as in freeze_h2matrix */
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	h21 = h2->son[i + j * rsons];
+
+	put_uint_binaryfile(bf, son_index(h2->rb, h21->rb));
+	put_uint_binaryfile(bf, son_index(h2->cb, h21->cb));
+	put_binary_h2matrix(bf, h21);
+      }
+  }
+  else
+    put_uint_binaryfile(bf, 0);
+}
+
+void
+putdata_binary_h2matrix(pbinaryfile bf, pch2matrix h2)
+{
+  uint      rsons = h2->rsons;
+  uint      csons = h2->csons;
+  uint      i, j;
+
+  if (h2->u)
+    put_amatrix_binaryfile(bf, &h2->u->S);
+  else if (h2->f)
+    put_amatrix_binaryfile(bf, h2->f);
+  else
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++)
+	putdata_binary_h2matrix(bf, h2->son[i + j * rsons]);
+}
+
+static    ph2matrix
+get_binary_node(pbinaryfile bf, pclusterbasis rb, pclusterbasis cb)
+{
+  ph2matrix h2, h21;
+  pclusterbasis rb1, cb1;
+  uint      rows = rb->t->size;
+  uint      cols = cb->t->size;
+  uint      type, rsons, csons;
+  uint      i, j;
+
+  type = get_uint_binaryfile(bf);
+
+  if (type == 1) {
+    h2 = new_uniform_h2matrix(rb, cb);
+
+    uninit_amatrix(&h2->u->S);
+    init_pointer_amatrix(&h2->u->S,
+			 get_data_binaryfile(bf, (size_t) rb->k * cb->k),
+			 rb->k, cb->k);
+  }
+  else if (type == 2) {
+    h2 = new_h2matrix(rb, cb);
+
+    h2->f = new_pointer_amatrix(get_data_binaryfile(bf, (size_t) rows *
+						    cols), rows, cols);
+  }
+  else if (type == 3) {
+    /* Every son needs at least two indices and its type */
+    rsons = get_count_binaryfile(bf, 3 * sizeof(uint));
+    csons = get_count_binaryfile(bf, (size_t) (rsons > 0 ? rsons : 1)
+				 * 3 * sizeof(uint));
+    if (!check_binaryfile(bf, rsons > 0 && csons > 0))
+      rsons = csons = 1;
+
+    h2 = new_super_h2matrix(rb, cb, rsons, csons);
+
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	rb1 = son_clusterbasis(bf, rb, get_uint_binaryfile(bf));
+	cb1 = son_clusterbasis(bf, cb, get_uint_binaryfile(bf));
+
+	h21 = get_binary_node(bf, rb1, cb1);
+	ref_h2matrix(h2->son + i + j * rsons, h21);
+      }
+  }
+  else {
+    check_binaryfile(bf, type == 0);
+
+    h2 = new_h2matrix(rb, cb);
+  }
+
+  update_h2matrix(h2);
+
+  return h2;
+}
+
+ph2matrix
+get_binary_h2matrix(pbinaryfile bf, pclusterbasis rb, pclusterbasis cb)
+{
+  ph2matrix h2;
+  size_t    base;
+
+  base = bf->pos;
+
+  h2 = get_binary_node(bf, rb, cb);
+
+  /* The coefficients remain in the storage provided by the file */
+  h2->storesize = bf->pos - base;
+  if (h2->storesize > 0) {
+    h2->store = bf->store->data + base;
+    ref_binarystore(&h2->bin, bf->store);
+  }
+
+  return h2;
+}
+
+bool
+write_binary_h2matrix(pch2matrix h2, const char *filename)
+{
+  pbinaryfile bf;
+
+  bf = new_write_binaryfile(filename, BINARY_H2MATRIX);
+  if (bf == NULL)
+    return false;
+
+  put_binary_cluster(bf, h2->rb->t);
+  put_uint_binaryfile(bf, (h2->rb->t == h2->cb->t));
+  if (h2->rb->t != h2->cb->t)
+    put_binary_cluster(bf, h2->cb->t);
+
+  put_binary_clusterbasis(bf, h2->rb);
+  put_uint_binaryfile(bf, (h2->rb == h2->cb));
+  if (h2->rb != h2->cb)
+    put_binary_clusterbasis(bf, h2->cb);
+
+  put_binary_h2matrix(bf, h2);
+
+  start_data_binaryfile(bf);
+
+  putdata_binary_clusterbasis(bf, h2->rb);
+  if (h2->rb != h2->cb)
+    putdata_binary_clusterbasis(bf, h2->cb);
+
+  putdata_binary_h2matrix(bf, h2);
+
+  return del_binaryfile(bf);
+}
+
+ph2matrix
+read_binary_h2matrix(const char *filename, bool map)
+{
+  pbinaryfile bf;
+  ph2matrix h2;
+  pcluster  rc, cc;
+  pclusterbasis rb, cb;
+
+  bf = new_read_binaryfile(filename, BINARY_H2MATRIX, map);
+  if (bf == NULL)
+    return NULL;
+
+  rc = get_binary_cluster(bf);
+  cc = (get_uint_binaryfile(bf) ? rc : get_binary_cluster(bf));
+
+  rb = get_binary_clusterbasis(bf, rc);
+  cb = (get_uint_binaryfile(bf) ? rb : get_binary_clusterbasis(bf, cc));
+
+  h2 = get_binary_h2matrix(bf, rb, cb);
+
+  if (!del_binaryfile(bf)) {
+    /* Releases the cluster bases as well */
+    del_h2matrix(h2);
+    if (cc != rc) {
+      freemem(cc->idx);
+      del_cluster(cc);
+    }
+    freemem(rc->idx);
+    del_cluster(rc);
+    return NULL;
+  }
+
+  return h2;
+}
+
+/* ------------------------------------------------------------
+ Single precision storage
+ ------------------------------------------------------------ */
+
+void
+tosingle_h2matrix(ph2matrix h2)
+{
+  uint      rsons = h2->rsons;
+  uint      csons = h2->csons;
+  uint      i, j;
+
+  if (h2->u) {
+    if (h2->u->s == NULL)
+      tosingle_uniform(h2->u);
+  }
+  else
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	tosingle_h2matrix(h2->son[i + j * rsons]);
+}
+
+void
+todouble_h2matrix(ph2matrix h2)
+{
+  uint      rsons = h2->rsons;
+  uint      csons = h2->csons;
+  uint      i, j;
+
+  if (h2->u) {
+    if (h2->u->s)
+      todouble_uniform(h2->u);
+  }
+  else
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	todouble_h2matrix(h2->son[i + j * rsons]);
+}
+
 /* ------------------------------------------------------------
  Statistics
  ------------------------------------------------------------ */
@@ -297,6 +647,8 @@ getsize_h2matrix(pch2matrix h2)
 
   sz = (size_t) sizeof(h2matrix);
 
+  sz += (size_t) sizeof(field) * h2->storesize;
+
   if (h2->u)
     sz += getsize_uniform(h2->u);
 
@@ -320,9 +672,14 @@ getnearsize_h2matrix(pch2matrix h2)
 
   sz = 0;
 
-  if (h2->f)
+  if (h2->f) {
     sz += getsize_amatrix(h2->f);
 
+    /* Coefficients stored in the array of a frozen matrix */
+    if (h2->f->owner)
+      sz += (size_t) sizeof(field) * h2->f->rows * h2->f->cols;
+  }
+
   for (j = 0; j < csons; j++)
     for (i = 0; i < rsons; i++)
       sz += getnearsize_h2matrix(h2->son[i + j * rsons]);
@@ -340,9 +697,14 @@ getfarsize_h2matrix(pch2matrix h2)
 
   sz = 0;
 
-  if (h2->u)
+  if (h2->u) {
     sz += getsize_uniform(h2->u);
 
+    /* Coefficients stored in the array of a frozen matrix */
+    if (h2->u->S.owner)
+      sz += (size_t) sizeof(field) * h2->u->S.rows * h2->u->S.cols;
+  }
+
   for (j = 0; j < csons; j++)
     for (i = 0; i < rsons; i++)
       sz += getfarsize_h2matrix(h2->son[i + j * rsons]);
@@ -1179,7 +1541,7 @@ fastaddeval_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
   uint      i, j;
 
   if (h2->u) {
-    addeval_amatrix_avector(alpha, &h2->u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, false, h2->u, xt, yt);
   }
   else if (h2->f) {
     xp = init_sub_avector(&loc1, xt, cb->t->size, cb->k);
@@ -1223,24 +1585,109 @@ fastaddeval_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
   }
 }
 
+/* Subvectors of a coefficient vector corresponding to the block rows
+   or block columns of a subdivided matrix */
+static pavector *
+new_sub_coeffs(pcclusterbasis cb, uint sons, pavector xt)
+{
+  pavector *xt1;
+  uint      xtoff, j;
+
+  xt1 = (pavector *) allocmem((size_t) sizeof(pavector) * sons);
+
+  xtoff = cb->k;
+  for (j = 0; j < sons; j++) {
+    assert(sons == 1 || cb->sons > 0);
+
+    if (cb->sons > 0) {
+      xt1[j] = new_sub_avector(xt, cb->son[j]->ktree, xtoff);
+      xtoff += cb->son[j]->ktree;
+    }
+    else {
+      xt1[j] = new_sub_avector(xt, cb->ktree, 0);
+      xtoff += cb->t->size;
+    }
+  }
+  assert(xtoff == cb->ktree);
+
+  return xt1;
+}
+
+static void
+del_sub_coeffs(pavector *xt1, uint sons)
+{
+  uint      j;
+
+  for (j = 0; j < sons; j++)
+    del_avector(xt1[j]);
+  freemem(xt1);
+}
+
+void
+fastaddeval_parallel_h2matrix_avector(field alpha, pch2matrix h2,
+				      pavector xt, pavector yt, uint pardepth)
+{
+  pavector *xt1, *yt1;
+  uint      rsons, csons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i, j;
+
+  if (pardepth == 0 || h2->son == NULL) {
+    fastaddeval_h2matrix_avector(alpha, h2, xt, yt);
+    return;
+  }
+
+  rsons = h2->rsons;
+  csons = h2->csons;
+
+  xt1 = new_sub_coeffs(h2->cb, csons, xt);
+  yt1 = new_sub_coeffs(h2->rb, rsons, yt);
+
+  /* Every thread owns the coefficients of one block row */
+#ifdef USE_OPENMP
+  nthreads = rsons;
+  (void) nthreads;
+#pragma omp parallel for if(rsons > 1), num_threads(nthreads), private(j)
+#endif
+  for (i = 0; i < rsons; i++)
+    for (j = 0; j < csons; j++)
+      fastaddeval_parallel_h2matrix_avector(alpha, h2->son[i + j * rsons],
+					    xt1[j], yt1[i], pardepth - 1);
+
+  del_sub_coeffs(yt1, rsons);
+  del_sub_coeffs(xt1, csons);
+}
+
 void
 addeval_h2matrix_avector(field alpha, pch2matrix h2, pcavector x, pavector y)
 {
+  avector   xtmp, ytmp;
   pavector  xt, yt;
+  size_t    mark;
 
-  xt = new_coeffs_clusterbasis_avector(h2->cb);
-  yt = new_coeffs_clusterbasis_avector(h2->rb);
+  mark = mark_scratch();
+
+  xt = init_scratch_avector(&xtmp, h2->cb->ktree);
+  yt = init_scratch_avector(&ytmp, h2->rb->ktree);
 
   clear_avector(yt);
 
   forward_clusterbasis_avector(h2->cb, x, xt);
 
+#ifdef USE_OPENMP
+  fastaddeval_parallel_h2matrix_avector(alpha, h2, xt, yt, max_pardepth);
+#else
   fastaddeval_h2matrix_avector(alpha, h2, xt, yt);
+#endif
 
   backward_clusterbasis_avector(h2->rb, yt, y);
 
-  del_avector(yt);
-  del_avector(xt);
+  uninit_avector(yt);
+  uninit_avector(xt);
+
+  release_scratch(mark);
 }
 
 void
@@ -1257,7 +1704,7 @@ fastaddevaltrans_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
   uint      i, j;
 
   if (h2->u) {
-    addevaltrans_amatrix_avector(alpha, &h2->u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, true, h2->u, xt, yt);
   }
   else if (h2->f) {
     xp = init_sub_avector(&loc1, xt, rb->t->size, rb->k);
@@ -1300,25 +1747,76 @@ fastaddevaltrans_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
   }
 }
 
+void
+fastaddevaltrans_parallel_h2matrix_avector(field alpha, pch2matrix h2,
+					   pavector xt, pavector yt,
+					   uint pardepth)
+{
+  pavector *xt1, *yt1;
+  uint      rsons, csons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i, j;
+
+  if (pardepth == 0 || h2->son == NULL) {
+    fastaddevaltrans_h2matrix_avector(alpha, h2, xt, yt);
+    return;
+  }
+
+  rsons = h2->rsons;
+  csons = h2->csons;
+
+  xt1 = new_sub_coeffs(h2->rb, rsons, xt);
+  yt1 = new_sub_coeffs(h2->cb, csons, yt);
+
+  /* Every thread owns the coefficients of one block column */
+#ifdef USE_OPENMP
+  nthreads = csons;
+  (void) nthreads;
+#pragma omp parallel for if(csons > 1), num_threads(nthreads), private(i)
+#endif
+  for (j = 0; j < csons; j++)
+    for (i = 0; i < rsons; i++)
+      fastaddevaltrans_parallel_h2matrix_avector(alpha,
+						 h2->son[i + j * rsons],
+						 xt1[i], yt1[j],
+						 pardepth - 1);
+
+  del_sub_coeffs(yt1, csons);
+  del_sub_coeffs(xt1, rsons);
+}
+
 void
 addevaltrans_h2matrix_avector(field alpha, pch2matrix h2, pcavector x,
 			      pavector y)
 {
+  avector   xtmp, ytmp;
   pavector  xt, yt;
+  size_t    mark;
+
+  mark = mark_scratch();
 
-  xt = new_coeffs_clusterbasis_avector(h2->rb);
-  yt = new_coeffs_clusterbasis_avector(h2->cb);
+  xt = init_scratch_avector(&xtmp, h2->rb->ktree);
+  yt = init_scratch_avector(&ytmp, h2->cb->ktree);
 
   clear_avector(yt);
 
   forward_clusterbasis_avector(h2->rb, x, xt);
 
+#ifdef USE_OPENMP
+  fastaddevaltrans_parallel_h2matrix_avector(alpha, h2, xt, yt,
+					     max_pardepth);
+#else
   fastaddevaltrans_h2matrix_avector(alpha, h2, xt, yt);
+#endif
 
   backward_clusterbasis_avector(h2->cb, yt, y);
 
-  del_avector(yt);
-  del_avector(xt);
+  uninit_avector(yt);
+  uninit_avector(xt);
+
+  release_scratch(mark);
 }
 
 static void
@@ -1357,8 +1855,8 @@ addevalsymm_offdiag(field alpha, pch2matrix h2, pavector xt,
     uninit_avector(xp);
   }
   else if (h2->u) {
-    addeval_amatrix_avector(alpha, &h2->u->S, xt, yt);
-    addevaltrans_amatrix_avector(alpha, &h2->u->S, xta, yta);
+    mvm_coupling_uniform_avector(alpha, false, h2->u, xt, yt);
+    mvm_coupling_uniform_avector(alpha, true, h2->u, xta, yta);
   }
   else {
     assert(h2->son != 0);
@@ -1525,6 +2023,120 @@ addevalsymm_diag(field alpha, pch2matrix h2, pavector xt,
   }
 }
 
+#ifdef USE_OPENMP
+/* Parallel counterpart of addevalsymm_diag for the row coefficients:
+   every thread handles one block row of the lower triangular part,
+   including the symmetric products for diagonal nearfield blocks. */
+static void
+addevalsymm_rows_parallel(field alpha, pch2matrix h2, pavector xt,
+			  pavector yt, uint pardepth)
+{
+  avector   tmp1, tmp2;
+  pavector *xt1, *yt1;
+  pavector  xp, yp;
+  pcclusterbasis rb = h2->rb;
+  pcclusterbasis cb = h2->cb;
+  pfield    aa;
+  uint      lda, sons;
+  uint      nthreads;		/* HACK: Solaris workaround */
+  uint      n;
+  uint      i, j;
+
+  assert(h2->rb->t == h2->cb->t);
+  assert(xt->dim == h2->cb->ktree);
+  assert(yt->dim == h2->rb->ktree);
+
+  if (h2->f) {
+    aa = h2->f->a;
+    lda = h2->f->ld;
+
+    n = rb->t->size;
+    xp = init_sub_avector(&tmp1, xt, n, cb->k);
+    yp = init_sub_avector(&tmp2, yt, n, rb->k);
+
+    for (j = 0; j < n; j++) {
+      yp->v[j] += alpha * aa[j + j * lda] * xp->v[j];
+      for (i = j + 1; i < n; i++) {
+	yp->v[i] += alpha * aa[i + j * lda] * xp->v[j];
+	yp->v[j] += alpha * CONJ(aa[i + j * lda]) * xp->v[i];
+      }
+    }
+
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
+  else {
+    assert(h2->son != 0);
+    assert(h2->rsons == h2->csons);
+
+    sons = h2->rsons;
+
+    xt1 = new_sub_coeffs(cb, sons, xt);
+    yt1 = new_sub_coeffs(rb, sons, yt);
+
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads), private(j)
+    for (i = 0; i < sons; i++) {
+      for (j = 0; j < i; j++)
+	fastaddeval_parallel_h2matrix_avector(alpha, h2->son[i + j * sons],
+					      xt1[j], yt1[i],
+					      (pardepth > 0 ? pardepth - 1 : 0));
+
+      addevalsymm_rows_parallel(alpha, h2->son[i + i * sons], xt1[i], yt1[i],
+				(pardepth > 0 ? pardepth - 1 : 0));
+    }
+
+    del_sub_coeffs(yt1, sons);
+    del_sub_coeffs(xt1, sons);
+  }
+}
+
+/* Parallel counterpart of addevalsymm_diag for the column coefficients:
+   every thread handles one block column of the strictly lower
+   triangular part. */
+static void
+addevalsymm_cols_parallel(field alpha, pch2matrix h2, pavector xta,
+			  pavector yta, uint pardepth)
+{
+  pavector *xta1, *yta1;
+  uint      sons;
+  uint      nthreads;		/* HACK: Solaris workaround */
+  uint      i, j;
+
+  assert(h2->rb->t == h2->cb->t);
+  assert(xta->dim == h2->rb->ktree);
+  assert(yta->dim == h2->cb->ktree);
+
+  if (h2->son) {
+    assert(h2->rsons == h2->csons);
+
+    sons = h2->rsons;
+
+    xta1 = new_sub_coeffs(h2->rb, sons, xta);
+    yta1 = new_sub_coeffs(h2->cb, sons, yta);
+
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads), private(i)
+    for (j = 0; j < sons; j++) {
+      addevalsymm_cols_parallel(alpha, h2->son[j + j * sons], xta1[j],
+				yta1[j], (pardepth > 0 ? pardepth - 1 : 0));
+
+      for (i = j + 1; i < sons; i++)
+	fastaddevaltrans_parallel_h2matrix_avector(alpha,
+						   h2->son[i + j * sons],
+						   xta1[i], yta1[j],
+						   (pardepth >
+						    0 ? pardepth - 1 : 0));
+    }
+
+    del_sub_coeffs(yta1, sons);
+    del_sub_coeffs(xta1, sons);
+  }
+}
+#endif
+
 void
 addevalsymm_h2matrix_avector(field alpha, pch2matrix h2, pcavector x,
 			     pavector y)
@@ -1548,17 +2160,24 @@ addevalsymm_h2matrix_avector(field alpha, pch2matrix h2, pcavector x,
   forward_clusterbasis_avector(h2->rb, x, xta);
 
   /* Multiplication step */
-  addevalsymm_diag(alpha, h2, xt, xta, yt, yta);
+#ifdef USE_OPENMP
+  if (max_pardepth > 0) {
+    addevalsymm_rows_parallel(alpha, h2, xt, yt, max_pardepth);
+    addevalsymm_cols_parallel(alpha, h2, xta, yta, max_pardepth);
+  }
+  else
+#endif
+    addevalsymm_diag(alpha, h2, xt, xta, yt, yta);
 
   /* Row coefficients added to result by backward transformation */
   backward_clusterbasis_avector(h2->rb, yt, y);
   backward_clusterbasis_avector(h2->cb, yta, y);
 
   /* Clean up */
-  uninit_avector(yta);
-  uninit_avector(yt);
-  uninit_avector(xta);
-  uninit_avector(xt);
+  del_avector(yta);
+  del_avector(yt);
+  del_avector(xta);
+  del_avector(xt);
 }
 
 /* ------------------------------------------------------------
@@ -1570,6 +2189,7 @@ fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
 				    pch2matrix h2, pcamatrix Xt, pamatrix Yt)
 {
   amatrix   loc1, loc2;
+  avector   xc, yc;
   pamatrix  Xp, Yp, Xt1, Yt1;
   pcclusterbasis rb = (h2trans ? h2->cb : h2->rb);
   pcclusterbasis cb = (h2trans ? h2->rb : h2->cb);
@@ -1582,7 +2202,18 @@ fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
   if (h2->u) {
     Xt1 = init_sub_amatrix(&loc1, (pamatrix) Xt, cb->k, 0, Xt->cols, 0);
     Yt1 = init_sub_amatrix(&loc2, Yt, rb->k, 0, Yt->cols, 0);
-    addmul_amatrix(alpha, h2trans, &h2->u->S, false, Xt1, Yt1);
+    if (h2->u->s) {
+      /* Single precision coupling matrix, handle columns separately */
+      for (k = 0; k < cols; k++) {
+	init_column_avector(&xc, Xt1, k);
+	init_column_avector(&yc, Yt1, k);
+	mvm_coupling_uniform_avector(alpha, h2trans, h2->u, &xc, &yc);
+	uninit_avector(&yc);
+	uninit_avector(&xc);
+      }
+    }
+    else
+      addmul_amatrix(alpha, h2trans, &h2->u->S, false, Xt1, Yt1);
     uninit_amatrix(Yt1);
     uninit_amatrix(Xt1);
   }
@@ -1626,6 +2257,105 @@ fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
   }
 }
 
+/* Submatrices of a coefficient matrix corresponding to the block rows
+   or block columns of a subdivided matrix */
+static pamatrix *
+new_sub_coeffs_amatrix(pcclusterbasis cb, uint sons, pamatrix Xt)
+{
+  pamatrix *Xt1;
+  uint      xtoff, j;
+
+  Xt1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * sons);
+
+  xtoff = cb->k;
+  for (j = 0; j < sons; j++) {
+    assert(sons == 1 || cb->sons > 0);
+
+    if (cb->sons > 0) {
+      Xt1[j] = new_sub_amatrix(Xt, cb->son[j]->ktree, xtoff, Xt->cols, 0);
+      xtoff += cb->son[j]->ktree;
+    }
+    else {
+      Xt1[j] = new_sub_amatrix(Xt, cb->ktree, 0, Xt->cols, 0);
+      xtoff += cb->t->size;
+    }
+  }
+  assert(xtoff == cb->ktree);
+
+  return Xt1;
+}
+
+static void
+del_sub_coeffs_amatrix(pamatrix *Xt1, uint sons)
+{
+  uint      j;
+
+  for (j = 0; j < sons; j++)
+    del_amatrix(Xt1[j]);
+  freemem(Xt1);
+}
+
+void
+fastaddmul_parallel_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
+					     pch2matrix h2, pcamatrix Xt,
+					     pamatrix Yt, uint pardepth)
+{
+  pamatrix *Xt1, *Yt1;
+  pcclusterbasis rb, cb;
+  uint      rsons, csons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i, j, k;
+
+  assert(Xt->cols == Yt->cols);
+
+  if (pardepth == 0 || h2->son == NULL) {
+    fastaddmul_h2matrix_amatrix_amatrix(alpha, h2trans, h2, Xt, Yt);
+    return;
+  }
+
+  rb = (h2trans ? h2->cb : h2->rb);
+  cb = (h2trans ? h2->rb : h2->cb);
+  rsons = (h2trans ? h2->csons : h2->rsons);
+  csons = (h2trans ? h2->rsons : h2->csons);
+
+  Xt1 = new_sub_coeffs_amatrix(cb, csons, (pamatrix) Xt);
+  Yt1 = new_sub_coeffs_amatrix(rb, rsons, Yt);
+
+  /* Every thread owns the coefficients of one block row of the
+     (possibly adjoint) matrix */
+#ifdef USE_OPENMP
+  nthreads = rsons;
+  (void) nthreads;
+#pragma omp parallel for if(rsons > 1), num_threads(nthreads), private(j, k)
+#endif
+  for (i = 0; i < rsons; i++)
+    for (j = 0; j < csons; j++) {
+      k = (h2trans ? i * csons + j : i + j * rsons);
+      fastaddmul_parallel_h2matrix_amatrix_amatrix(alpha, h2trans,
+						   h2->son[k], Xt1[j], Yt1[i],
+						   pardepth - 1);
+    }
+
+  del_sub_coeffs_amatrix(Yt1, rsons);
+  del_sub_coeffs_amatrix(Xt1, csons);
+}
+
+/* Interaction phase used by the matrix-matrix products, parallel if
+   OpenMP is available */
+static void
+interaction_h2matrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
+			     pcamatrix Xt, pamatrix Yt)
+{
+#ifdef USE_OPENMP
+  fastaddmul_parallel_h2matrix_amatrix_amatrix(alpha, h2trans, h2, Xt, Yt,
+					       max_pardepth);
+#else
+  fastaddmul_h2matrix_amatrix_amatrix(alpha, h2trans, h2, Xt, Yt);
+#endif
+}
+
 void
 addmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
 				bool xtrans, pcamatrix X, pamatrix Y)
@@ -1642,7 +2372,7 @@ addmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
       Yt = new_amatrix(h2->rb->ktree, Y->cols);
       clear_amatrix(Yt);
       forward_clusterbasis_amatrix(h2->cb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, false, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, false, h2, Xt, Yt);
       backward_clusterbasis_amatrix(h2->rb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1657,7 +2387,7 @@ addmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
       Yt = new_amatrix(h2->rb->ktree, Y->cols);
       clear_amatrix(Yt);
       forward_clusterbasis_trans_amatrix(h2->cb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, false, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, false, h2, Xt, Yt);
       backward_clusterbasis_amatrix(h2->rb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1674,7 +2404,7 @@ addmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
       Yt = new_amatrix(h2->cb->ktree, Y->cols);
       clear_amatrix(Yt);
       forward_clusterbasis_amatrix(h2->rb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, true, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, true, h2, Xt, Yt);
       backward_clusterbasis_amatrix(h2->cb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1689,7 +2419,7 @@ addmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
       Yt = new_amatrix(h2->cb->ktree, Y->cols);
       clear_amatrix(Yt);
       forward_clusterbasis_trans_amatrix(h2->rb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, true, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, true, h2, Xt, Yt);
       backward_clusterbasis_amatrix(h2->cb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1713,7 +2443,7 @@ addmul_amatrix_h2matrix_amatrix(field alpha, bool xtrans, pcamatrix X,
       Yt = new_amatrix(h2->rb->ktree, Y->rows);
       clear_amatrix(Yt);
       forward_clusterbasis_amatrix(h2->cb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, false, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, false, h2, Xt, Yt);
       backward_clusterbasis_amatrix(h2->rb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1728,7 +2458,7 @@ addmul_amatrix_h2matrix_amatrix(field alpha, bool xtrans, pcamatrix X,
       Yt = new_amatrix(h2->rb->ktree, Y->rows);
       clear_amatrix(Yt);
       forward_clusterbasis_trans_amatrix(h2->cb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, false, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, false, h2, Xt, Yt);
       backward_clusterbasis_trans_amatrix(h2->rb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1745,7 +2475,7 @@ addmul_amatrix_h2matrix_amatrix(field alpha, bool xtrans, pcamatrix X,
       Yt = new_amatrix(h2->cb->ktree, Y->rows);
       clear_amatrix(Yt);
       forward_clusterbasis_amatrix(h2->rb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, true, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, true, h2, Xt, Yt);
       backward_clusterbasis_trans_amatrix(h2->cb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1760,7 +2490,7 @@ addmul_amatrix_h2matrix_amatrix(field alpha, bool xtrans, pcamatrix X,
       Yt = new_amatrix(h2->cb->ktree, Y->rows);
       clear_amatrix(Yt);
       forward_clusterbasis_trans_amatrix(h2->rb, X, Xt);
-      fastaddmul_h2matrix_amatrix_amatrix(alpha, true, h2, Xt, Yt);
+      interaction_h2matrix_amatrix(alpha, true, h2, Xt, Yt);
       backward_clusterbasis_trans_amatrix(h2->cb, Yt, Y);
       del_amatrix(Yt);
       del_amatrix(Xt);
@@ -1768,6 +2498,77 @@ addmul_amatrix_h2matrix_amatrix(field alpha, bool xtrans, pcamatrix X,
   }
 }
 
+void
+addeval_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X, pamatrix Y)
+{
+  pamatrix  Xp, Yp;
+  pccluster rc = h2->rb->t;
+  pccluster cc = h2->cb->t;
+  uint      i, j;
+
+  assert(X->rows == cc->size);
+  assert(Y->rows == rc->size);
+  assert(X->cols == Y->cols);
+
+  /* Permute the rows of the source matrix into cluster numbering */
+  Xp = new_amatrix(X->rows, X->cols);
+  for (j = 0; j < X->cols; j++)
+    for (i = 0; i < X->rows; i++)
+      Xp->a[i + j * Xp->ld] = X->a[cc->idx[i] + j * X->ld];
+
+  Yp = new_zero_amatrix(Y->rows, Y->cols);
+
+  addmul_h2matrix_amatrix_amatrix(alpha, false, h2, false, Xp, Yp);
+
+  /* Add the result using the original numbering */
+  for (j = 0; j < Y->cols; j++)
+    for (i = 0; i < Y->rows; i++)
+      Y->a[rc->idx[i] + j * Y->ld] += Yp->a[i + j * Yp->ld];
+
+  del_amatrix(Yp);
+  del_amatrix(Xp);
+}
+
+void
+addevaltrans_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X,
+			      pamatrix Y)
+{
+  pamatrix  Xp, Yp;
+  pccluster rc = h2->rb->t;
+  pccluster cc = h2->cb->t;
+  uint      i, j;
+
+  assert(X->rows == rc->size);
+  assert(Y->rows == cc->size);
+  assert(X->cols == Y->cols);
+
+  Xp = new_amatrix(X->rows, X->cols);
+  for (j = 0; j < X->cols; j++)
+    for (i = 0; i < X->rows; i++)
+      Xp->a[i + j * Xp->ld] = X->a[rc->idx[i] + j * X->ld];
+
+  Yp = new_zero_amatrix(Y->rows, Y->cols);
+
+  addmul_h2matrix_amatrix_amatrix(alpha, true, h2, false, Xp, Yp);
+
+  for (j = 0; j < Y->cols; j++)
+    for (i = 0; i < Y->rows; i++)
+      Y->a[cc->idx[i] + j * Y->ld] += Yp->a[i + j * Yp->ld];
+
+  del_amatrix(Yp);
+  del_amatrix(Xp);
+}
+
+void
+mvm_h2matrix_amatrix(field alpha, bool h2trans, pch2matrix h2, pcamatrix X,
+		     pamatrix Y)
+{
+  if (h2trans)
+    addevaltrans_h2matrix_amatrix(alpha, h2, X, Y);
+  else
+    addeval_h2matrix_amatrix(alpha, h2, X, Y);
+}
+
 /* ------------------------------------------------------------
  Orthogonal projection
  ------------------------------------------------------------ */
@@ -67,6 +67,15 @@ struct _h2matrix {
   uint refs;
   /** @brief Number of descendants in matrix tree. */
   uint desc;
+
+  /** @brief Contiguous storage for coupling and nearfield matrices,
+   *  only set in the root of a matrix frozen by @ref freeze_h2matrix. */
+  pfield store;
+  /** @brief Number of coefficients in <tt>store</tt>. */
+  size_t storesize;
+  /** @brief Binary file providing <tt>store</tt> if the matrix has been
+   *  read by @ref get_binary_h2matrix, <tt>NULL</tt> otherwise. */
+  pbinarystore bin;
 };
 
 /* ------------------------------------------------------------
@@ -229,6 +238,128 @@ ref_h2matrix(ph2matrix *ptr, ph2matrix h2);
 HEADER_PREFIX void
 unref_h2matrix(ph2matrix h2);
 
+/* ------------------------------------------------------------
+ Contiguous storage
+ ------------------------------------------------------------ */
+
+/** @brief Move all coupling and nearfield matrices of an
+ *  @ref h2matrix into one contiguous array.
+ *
+ *  The matrices are arranged block row by block row, i.e., in the
+ *  order used by the parallel interaction phase
+ *  @ref fastaddeval_parallel_h2matrix_avector.
+ *  The array is released together with the matrix by @ref del_h2matrix.
+ *  The cluster bases can be frozen by @ref freeze_clusterbasis.
+ *
+ *  @remark The coefficients of a frozen matrix may still be changed,
+ *  but its structure and the ranks of its cluster bases must not.
+ *
+ *  @param h2 Matrix that will be frozen. */
+HEADER_PREFIX void
+freeze_h2matrix(ph2matrix h2);
+
+/* ------------------------------------------------------------
+ File I/O
+ ------------------------------------------------------------ */
+
+/** @brief Write an @f$\mathcal{H}^2@f$-matrix to a @ref binaryfile.
+ *
+ *  Writes the structure of the matrix to the structure section.
+ *  The cluster trees and cluster bases have to be written separately
+ *  by @ref put_binary_cluster and @ref put_binary_clusterbasis, and
+ *  the coefficients are written by @ref putdata_binary_h2matrix after
+ *  the data section has been started.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param h2 Matrix. */
+HEADER_PREFIX void
+put_binary_h2matrix(pbinaryfile bf, pch2matrix h2);
+
+/** @brief Write the coupling and nearfield matrices of an
+ *  @f$\mathcal{H}^2@f$-matrix to the data section of a @ref binaryfile.
+ *
+ *  The matrices are written in the order used by @ref freeze_h2matrix.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param h2 Matrix. */
+HEADER_PREFIX void
+putdata_binary_h2matrix(pbinaryfile bf, pch2matrix h2);
+
+/** @brief Read an @f$\mathcal{H}^2@f$-matrix from a @ref binaryfile.
+ *
+ *  The coupling and nearfield matrices use the coefficients in the
+ *  data section directly.
+ *  If the file is damaged, the error flag of <tt>bf</tt> is set and
+ *  the returned matrix should be discarded.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @param rb Row cluster basis.
+ *  @param cb Column cluster basis.
+ *  @returns Matrix read from the file. */
+HEADER_PREFIX ph2matrix
+get_binary_h2matrix(pbinaryfile bf, pclusterbasis rb, pclusterbasis cb);
+
+/** @brief Write an @f$\mathcal{H}^2@f$-matrix together with its
+ *  cluster bases and cluster trees into a binary file.
+ *
+ *  @param h2 Matrix, <tt>h2->rb</tt> and <tt>h2->cb</tt> have to be
+ *     the roots of their cluster bases.
+ *  @param filename Name of the target file.
+ *  @returns <tt>true</tt> if the file has been written successfully. */
+HEADER_PREFIX bool
+write_binary_h2matrix(pch2matrix h2, const char *filename);
+
+/** @brief Read an @f$\mathcal{H}^2@f$-matrix together with its
+ *  cluster bases and cluster trees from a binary file.
+ *
+ *  If <tt>map</tt> is set, the coefficients are mapped into memory
+ *  instead of being read, so they are only loaded from disk when they
+ *  are used.
+ *  Changes to the coefficients are not written back to the file.
+ *
+ *  @remark The cluster trees <tt>h2->rb->t</tt> and <tt>h2->cb->t</tt>
+ *  and their index arrays have to be released by the caller after
+ *  the matrix has been deleted.
+ *  If both trees or both bases were identical when the file was
+ *  written, they are identical in the result as well.
+ *
+ *  @param filename Name of the source file.
+ *  @param map Set to map the coefficients into memory.
+ *  @returns Matrix read from the file, or <tt>NULL</tt> if the file
+ *     could not be read. */
+HEADER_PREFIX ph2matrix
+read_binary_h2matrix(const char *filename, bool map);
+
+/* ------------------------------------------------------------
+ Single precision storage
+ ------------------------------------------------------------ */
+
+/** @brief Store the coupling matrices of all admissible leaves in
+ *  single precision.
+ *
+ *  Applies @ref tosingle_uniform to all @ref uniform leaves, while
+ *  the nearfield matrices and the cluster bases remain in double
+ *  precision.
+ *
+ *  @remark The resulting matrix can only be used for matrix-vector
+ *  multiplications.
+ *  Use @ref todouble_h2matrix before any other operation.
+ *  If the matrix is to be frozen by @ref freeze_h2matrix, this function
+ *  has to be called first.
+ *
+ *  @param h2 Target matrix. */
+HEADER_PREFIX void
+tosingle_h2matrix(ph2matrix h2);
+
+/** @brief Restore the coupling matrices of all admissible leaves from
+ *  single precision.
+ *
+ *  Reverses @ref tosingle_h2matrix.
+ *
+ *  @param h2 Target matrix. */
+HEADER_PREFIX void
+todouble_h2matrix(ph2matrix h2);
+
 /* ------------------------------------------------------------
  Statistics
  ------------------------------------------------------------ */
@@ -511,6 +642,27 @@ HEADER_PREFIX void
 fastaddeval_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
     pavector yt);
 
+/** @brief Parallel interaction phase of the matrix-vector multiplication.
+ *
+ *  Equivalent to @ref fastaddeval_h2matrix_avector, but the block rows
+ *  are handled in parallel up to the given depth.
+ *  Since every thread only updates the coefficients
+ *  @f$\hat y_t@f$ of its own block row, no synchronization is required
+ *  and the result coincides with the sequential one.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param xt Coefficients @f$(\hat x_s)_{s\in\mathcal{T}_{\mathcal J}}@f$
+ *            of the source vector with respect to the
+ *            column basis <tt>h2->cb</tt>.
+ *  @param yt Coefficients @f$(\hat y_t)_{t\in\mathcal{T}_{\mathcal I}}@f$
+ *            of the target vector with respect to the
+ *            row basis <tt>h2->rb</tt>.
+ *  @param pardepth Parallelization depth, typically @ref max_pardepth. */
+HEADER_PREFIX void
+fastaddeval_parallel_h2matrix_avector(field alpha, pch2matrix h2,
+    pavector xt, pavector yt, uint pardepth);
+
 /** @brief Matrix-vector multiplication
  *  @f$y \gets y + \alpha A x@f$.
  *
@@ -548,6 +700,28 @@ HEADER_PREFIX void
 fastaddevaltrans_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
     pavector yt);
 
+/** @brief Parallel interaction phase of the adjoint matrix-vector
+ *  multiplication.
+ *
+ *  Equivalent to @ref fastaddevaltrans_h2matrix_avector, but the block
+ *  columns are handled in parallel up to the given depth.
+ *  Since every thread only updates the coefficients
+ *  @f$\hat y_s@f$ of its own block column, no synchronization is required
+ *  and the result coincides with the sequential one.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param xt Coefficients @f$(\hat x_t)_{t\in\mathcal{T}_{\mathcal I}}@f$
+ *            of the source vector with respect to the
+ *            row basis <tt>h2->rb</tt>.
+ *  @param yt Coefficients @f$(\hat y_s)_{s\in\mathcal{T}_{\mathcal J}}@f$
+ *            of the target vector with respect to the
+ *            column basis <tt>h2->cb</tt>.
+ *  @param pardepth Parallelization depth, typically @ref max_pardepth. */
+HEADER_PREFIX void
+fastaddevaltrans_parallel_h2matrix_avector(field alpha, pch2matrix h2,
+    pavector xt, pavector yt, uint pardepth);
+
 /** @brief Adjoint matrix-vector multiplication
  *  @f$y \gets y + \alpha A^* x@f$.
  *
@@ -617,6 +791,27 @@ HEADER_PREFIX void
 fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool atrans, pch2matrix A,
     pcamatrix Bt, pamatrix Ct);
 
+/** @brief Parallel interaction phase of the @ref h2matrix - @ref amatrix
+ *  multiplication.
+ *
+ *  Equivalent to @ref fastaddmul_h2matrix_amatrix_amatrix, but the block
+ *  rows of @f$A@f$ (or the block columns if <tt>atrans==true</tt>) are
+ *  handled in parallel up to the given depth.
+ *  Every thread only updates the coefficient matrices of its own block row,
+ *  so the result coincides with the sequential one.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param atrans Set if @f$A^*@f$ is to be used instead of @f$A@f$.
+ *  @param A First source matrix @f$A@f$.
+ *  @param Bt Coefficient matrices of the second source matrix, see
+ *            @ref fastaddmul_h2matrix_amatrix_amatrix.
+ *  @param Ct Coefficient matrices of the target matrix, see
+ *            @ref fastaddmul_h2matrix_amatrix_amatrix.
+ *  @param pardepth Parallelization depth, typically @ref max_pardepth. */
+HEADER_PREFIX void
+fastaddmul_parallel_h2matrix_amatrix_amatrix(field alpha, bool atrans,
+    pch2matrix A, pcamatrix Bt, pamatrix Ct, uint pardepth);
+
 /** @brief Matrix multiplication @f$ C \gets C + \alpha A B @f$,
  *  @f$ C \gets C + \alpha A^* B @f$, @f$ C \gets C + \alpha A B^* @f$ or
  *  @f$ C \gets C + \alpha A^* B^* @f$.
@@ -653,6 +848,49 @@ HEADER_PREFIX void
 addmul_amatrix_h2matrix_amatrix(field alpha, bool atrans, pcamatrix A,
     bool btrans, pch2matrix B, pamatrix C);
 
+/** @brief Multiplication with multiple vectors,
+ *  @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  Matrix version of @ref addeval_h2matrix_avector: every column of
+ *  @f$X@f$ is multiplied by @f$A@f$, but the cluster bases and coupling
+ *  matrices are applied to all columns at once by BLAS level 3 operations.
+ *  The rows of @f$X@f$ and @f$Y@f$ use the original numbering of
+ *  the index sets, so this function can be used as a
+ *  <tt>addevalmat_t</tt> callback in the block Krylov solvers.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param X Source matrix with <tt>h2->cb->t->size</tt> rows.
+ *  @param Y Target matrix with <tt>h2->rb->t->size</tt> rows. */
+HEADER_PREFIX void
+addeval_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X,
+    pamatrix Y);
+
+/** @brief Adjoint multiplication with multiple vectors,
+ *  @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  Matrix version of @ref addevaltrans_h2matrix_avector.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param X Source matrix with <tt>h2->rb->t->size</tt> rows.
+ *  @param Y Target matrix with <tt>h2->cb->t->size</tt> rows. */
+HEADER_PREFIX void
+addevaltrans_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X,
+    pamatrix Y);
+
+/** @brief Multiplication with multiple vectors,
+ *  @f$Y \gets Y + \alpha A X@f$ or @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2trans Set if @f$A^*@f$ is to be used instead of @f$A@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+mvm_h2matrix_amatrix(field alpha, bool h2trans, pch2matrix h2, pcamatrix X,
+    pamatrix Y);
+
 /* ------------------------------------------------------------
  Orthogonal projection
  ------------------------------------------------------------ */
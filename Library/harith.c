@@ -12,6 +12,37 @@
  * Truncation of an rkmatrix
  * ------------------------------------------------------------ */
 
+/* Append alpha A_src and B_src to the factors of trg without
+ * truncation */
+static void
+append_rkmatrix(field alpha, pcrkmatrix src, prkmatrix trg)
+{
+  pfield    aa, sa;
+  longindex lda, lds;
+  uint      i, j, k0;
+
+  k0 = trg->k;
+  resizecopy_amatrix(&trg->A, trg->A.rows, k0 + src->k);
+  resizecopy_amatrix(&trg->B, trg->B.rows, k0 + src->k);
+  trg->k = k0 + src->k;
+
+  aa = trg->A.a + (size_t) trg->A.ld * k0;
+  lda = trg->A.ld;
+  sa = src->A.a;
+  lds = src->A.ld;
+  for (j = 0; j < src->k; j++)
+    for (i = 0; i < src->A.rows; i++)
+      aa[i + j * lda] = alpha * sa[i + j * lds];
+
+  aa = trg->B.a + (size_t) trg->B.ld * k0;
+  lda = trg->B.ld;
+  sa = src->B.a;
+  lds = src->B.ld;
+  for (j = 0; j < src->k; j++)
+    for (i = 0; i < src->B.rows; i++)
+      aa[i + j * lda] = sa[i + j * lds];
+}
+
 /* First version: apply SVD directly to A B^*.
  * This approach is only advisable if the rank is high compared to
  * the number of rows and columns. */
@@ -25,6 +56,7 @@ trunc_ab_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uint      rows, cols;
   uint      k1, knew;
   uint      i;
+  size_t    mark;
 
   assert(r->A.cols == r->k);
   assert(r->B.cols == r->k);
@@ -34,16 +66,18 @@ trunc_ab_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   a = &r->A;
   b = &r->B;
 
+  mark = mark_scratch();
+
   /* Compute C = A B^* */
-  c = init_amatrix(&tmp1, rows, cols);
+  c = init_scratch_amatrix(&tmp1, rows, cols);
   clear_amatrix(c);
   addmul_amatrix(1.0, false, a, true, b, c);
   k1 = UINT_MIN(rows, cols);
 
   /* Compute singular value decomposition */
-  u = init_amatrix(&tmp2, rows, k1);
-  vt = init_amatrix(&tmp3, k1, cols);
-  sigma = init_avector(&tmp4, k1);
+  u = init_scratch_amatrix(&tmp2, rows, k1);
+  vt = init_scratch_amatrix(&tmp3, k1, cols);
+  sigma = init_scratch_avector(&tmp4, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -68,6 +102,8 @@ trunc_ab_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uninit_amatrix(vt);
   uninit_amatrix(u);
   uninit_amatrix(c);
+
+  release_scratch(mark);
 }
 
 /* Second version: Turn A into an upper triangular matrix by a QR
@@ -84,6 +120,7 @@ trunc_qb_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uint      rows, cols;
   uint      k, kr, k1, knew;
   uint      i;
+  size_t    mark;
 
   assert(r->A.cols == r->k);
   assert(r->B.cols == r->k);
@@ -93,12 +130,14 @@ trunc_qb_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   k = r->k;
   b = &r->B;
 
+  mark = mark_scratch();
+
   /* Copy factor A */
-  a = init_amatrix(&tmp1, rows, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
   copy_amatrix(false, &r->A, a);
 
   /* Compute QR factorization of A */
-  tau = init_avector(&tmp5, k);
+  tau = init_scratch_avector(&tmp5, k);
   qrdecomp_amatrix(a, tau);
 
   /* Overwrite B by C = B A^* (C^* = A B^*) */
@@ -110,9 +149,9 @@ trunc_qb_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(cols, kr);
-  u = init_amatrix(&tmp2, cols, k1);
-  vt = init_amatrix(&tmp3, k1, kr);
-  sigma = init_avector(&tmp6, k1);
+  u = init_scratch_amatrix(&tmp2, cols, k1);
+  vt = init_scratch_amatrix(&tmp3, k1, kr);
+  sigma = init_scratch_avector(&tmp6, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -141,6 +180,8 @@ trunc_qb_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uninit_amatrix(u);
   uninit_amatrix(c);
   uninit_amatrix(a);
+
+  release_scratch(mark);
 }
 
 /* Third version: Turn B into an upper triangular matrix by a QR
@@ -157,6 +198,7 @@ trunc_aq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uint      rows, cols;
   uint      k, kc, k1, knew;
   uint      i;
+  size_t    mark;
 
   assert(r->A.cols == r->k);
   assert(r->B.cols == r->k);
@@ -166,12 +208,14 @@ trunc_aq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   k = r->k;
   a = &r->A;
 
+  mark = mark_scratch();
+
   /* Copy factor B */
-  b = init_amatrix(&tmp1, cols, k);
+  b = init_scratch_amatrix(&tmp1, cols, k);
   copy_amatrix(false, &r->B, b);
 
   /* Compute QR factorization of B */
-  tau = init_avector(&tmp5, k);
+  tau = init_scratch_avector(&tmp5, k);
   qrdecomp_amatrix(b, tau);
 
   /* Overwrite A by C = A B^* (C^* = B A^*) */
@@ -183,9 +227,9 @@ trunc_aq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(rows, kc);
-  u = init_amatrix(&tmp2, rows, k1);
-  vt = init_amatrix(&tmp3, k1, kc);
-  sigma = init_avector(&tmp6, k1);
+  u = init_scratch_amatrix(&tmp2, rows, k1);
+  vt = init_scratch_amatrix(&tmp3, k1, kc);
+  sigma = init_scratch_avector(&tmp6, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -214,6 +258,8 @@ trunc_aq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uninit_amatrix(u);
   uninit_amatrix(c);
   uninit_amatrix(b);
+
+  release_scratch(mark);
 }
 
 /* Fourth version: Reduce both A and B to upper triangular matrices
@@ -230,6 +276,7 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uint      rows, cols;
   uint      k, ak, bk, k1, knew;
   uint      i;
+  size_t    mark;
 
   assert(r->A.cols == r->k);
   assert(r->B.cols == r->k);
@@ -238,24 +285,26 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   cols = r->B.rows;
   k = r->k;
 
+  mark = mark_scratch();
+
   /* Copy factor A and B */
-  a = init_amatrix(&tmp1, rows, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
   copy_amatrix(false, &r->A, a);
-  b = init_amatrix(&tmp2, cols, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
   copy_amatrix(false, &r->B, b);
 
   /* Compute QR factorization Q_A R_A = A */
-  atau = init_avector(&tmp6, k);
+  atau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(a, atau);
   ak = UINT_MIN(k, rows);
 
   /* Compute QR factorization Q_B R_B = B */
-  btau = init_avector(&tmp7, k);
+  btau = init_scratch_avector(&tmp7, k);
   qrdecomp_amatrix(b, btau);
   bk = UINT_MIN(k, cols);
 
   /* Compute condensed matrix C = R_A R_B^* */
-  c = init_amatrix(&tmp3, ak, bk);
+  c = init_scratch_amatrix(&tmp3, ak, bk);
   clear_amatrix(c);
   a1 = init_sub_amatrix(&tmp4, a, ak, 0, k, 0);
   b1 = init_sub_amatrix(&tmp5, b, bk, 0, k, 0);
@@ -265,9 +314,9 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 
   /* Find singular value decomposition of Z */
   k1 = UINT_MIN(ak, bk);
-  u = init_amatrix(&tmp4, ak, k1);
-  vt = init_amatrix(&tmp5, k1, bk);
-  sigma = init_avector(&tmp8, k1);
+  u = init_scratch_amatrix(&tmp4, ak, k1);
+  vt = init_scratch_amatrix(&tmp5, k1, bk);
+  sigma = init_scratch_avector(&tmp8, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -302,6 +351,229 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uninit_avector(atau);
   uninit_amatrix(b);
   uninit_amatrix(a);
+
+  release_scratch(mark);
+}
+
+/* Fifth version: randomized range finder.
+ * Blocks of random samples of the range of A B^* are orthonormalized
+ * until the part of the latest block not yet covered by the basis Q
+ * is small compared to the truncation accuracy.
+ * Then Q^* A B^* = R_W^* Q_W^* is obtained from a QR factorization of
+ * W = B (A^* Q), and the SVD is only computed for the small matrix R_W^*.
+ * The cost is proportional to the new rank instead of the old one,
+ * so this pays off only if the rank is reduced significantly.
+ * Returns false without changing r if more than half of the old rank
+ * would be required. */
+
+/* Number of random samples per block */
+#define SAMPLES_RANDTRUNC 16
+
+/* Uniformly distributed random numbers in [-1,1], using a private
+   xorshift generator to make the truncation reproducible and to
+   leave the state of rand() untouched */
+static void
+random_randtrunc(uint * state, pamatrix a)
+{
+  longindex lda = a->ld;
+  uint      x = *state;
+  uint      i, j;
+
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      a->a[i + j * lda] = 2.0 * x / 4294967295.0 - 1.0;
+    }
+
+  *state = x;
+}
+
+static    bool
+trunc_rand_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
+{
+  amatrix   tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7, tmp8, tmp9;
+  avector   tmp10, tmp11, tmp12;
+  pamatrix  q, q0, omega, bo, yb, yc, c, atq, w, u, vt;
+  pavector  tau, sigma, uc;
+  uint      rows, cols;
+  uint      k, l, lmax, b, knew;
+  uint      state, pass;
+  real      first, norm, nrm;
+  bool      done;
+  uint      i, j;
+  size_t    mark;
+
+  assert(r->A.cols == r->k);
+  assert(r->B.cols == r->k);
+
+  rows = r->A.rows;
+  cols = r->B.rows;
+  k = r->k;
+  b = SAMPLES_RANDTRUNC;
+  lmax = UINT_MIN3(k, rows, cols) / 2;
+
+  if (lmax < b)
+    return false;
+
+  state = 2463534242U;
+
+  mark = mark_scratch();
+
+  /* Orthonormal basis of the sampled range */
+  q = init_scratch_amatrix(&tmp1, rows, lmax);
+
+  l = 0;
+  first = 0.0;
+  done = false;
+  while (!done) {
+    if (l + b > lmax) {
+      uninit_amatrix(q);
+      release_scratch(mark);
+      return false;
+    }
+
+    /* Sample the range, Y = A B^* Omega */
+    omega = init_scratch_amatrix(&tmp2, cols, b);
+    random_randtrunc(&state, omega);
+    bo = init_scratch_amatrix(&tmp3, k, b);
+    clear_amatrix(bo);
+    addmul_amatrix(1.0, true, &r->B, false, omega, bo);
+    yb = init_sub_amatrix(&tmp4, q, rows, 0, b, l);
+    clear_amatrix(yb);
+    addmul_amatrix(1.0, false, &r->A, false, bo, yb);
+    uninit_amatrix(bo);
+    uninit_amatrix(omega);
+
+    /* Remove the part already covered and orthonormalize the block.
+       This is done twice, since the block may be dominated by
+       rounding errors once the range has been found. */
+    for (pass = 0; pass < 2; pass++) {
+      if (l > 0) {
+	q0 = init_sub_amatrix(&tmp2, q, rows, 0, l, 0);
+	c = init_scratch_amatrix(&tmp3, l, b);
+	clear_amatrix(c);
+	addmul_amatrix(1.0, true, q0, false, yb, c);
+	addmul_amatrix(-1.0, false, q0, false, c, yb);
+	uninit_amatrix(c);
+	uninit_amatrix(q0);
+      }
+
+      if (pass == 0) {
+	/* Largest norm of the remaining samples */
+	norm = 0.0;
+	for (j = 0; j < b; j++) {
+	  nrm = 0.0;
+	  for (i = 0; i < rows; i++)
+	    nrm += ABSSQR(yb->a[i + j * yb->ld]);
+	  norm = REAL_MAX(norm, REAL_SQRT(nrm));
+	}
+
+	if (l == 0) {
+	  first = norm;
+
+	  /* Zero matrix */
+	  if (first == 0.0) {
+	    uninit_amatrix(yb);
+	    uninit_amatrix(q);
+	    setrank_rkmatrix(r, 0);
+	    release_scratch(mark);
+	    return true;
+	  }
+	}
+
+	/* With high probability, the norm of the remainder
+	   (I - Q Q^*) A B^* is bounded by 10 sqrt(2/pi) times the
+	   largest norm of a block of Gaussian samples, and by sqrt(3)
+	   times this for our uniform samples. The norm of A B^* is
+	   estimated by the first block in the same way. */
+	if (tm && tm->absolute)
+	  done = (13.8 * norm <= eps);
+	else
+	  done = (8.0 * norm <= eps * first);
+      }
+
+      yc = init_scratch_amatrix(&tmp2, rows, b);
+      copy_amatrix(false, yb, yc);
+      tau = init_scratch_avector(&tmp10, b);
+      qrdecomp_amatrix(yc, tau);
+      qrexpand_amatrix(yc, tau, yb);
+      uninit_avector(tau);
+      uninit_amatrix(yc);
+    }
+    uninit_amatrix(yb);
+
+    l += b;
+  }
+
+  /* Compute W = (Q^* A B^*)^* = B (A^* Q) */
+  q0 = init_sub_amatrix(&tmp2, q, rows, 0, l, 0);
+  atq = init_scratch_amatrix(&tmp3, k, l);
+  clear_amatrix(atq);
+  addmul_amatrix(1.0, true, &r->A, false, q0, atq);
+  w = init_scratch_amatrix(&tmp4, cols, l);
+  clear_amatrix(w);
+  addmul_amatrix(1.0, false, &r->B, false, atq, w);
+  uninit_amatrix(atq);
+
+  /* Compute QR factorization Q_W R_W = W */
+  tau = init_scratch_avector(&tmp10, l);
+  qrdecomp_amatrix(w, tau);
+
+  /* Condensed matrix C = R_W^* */
+  c = init_scratch_amatrix(&tmp5, l, l);
+  for (j = 0; j < l; j++) {
+    for (i = 0; i < j; i++)
+      c->a[i + j * c->ld] = 0.0;
+    for (; i < l; i++)
+      c->a[i + j * c->ld] = CONJ(w->a[j + i * w->ld]);
+  }
+
+  /* Find singular value decomposition of C */
+  u = init_scratch_amatrix(&tmp6, l, l);
+  vt = init_scratch_amatrix(&tmp7, l, l);
+  sigma = init_scratch_avector(&tmp11, l);
+  svd_amatrix(c, sigma, u, vt);
+
+  /* Determine rank */
+  knew = findrank_truncmode(tm, eps, sigma);
+
+  /* Set new rank */
+  setrank_rkmatrix(r, knew);
+
+  /* Scale singular vectors */
+  for (i = 0; i < knew; i++) {
+    uc = init_column_avector(&tmp12, u, i);
+    scale_avector(sigma->v[i], uc);
+    uninit_avector(uc);
+  }
+
+  /* New factors A = Q U Sigma and B = Q_W V */
+  yb = init_sub_amatrix(&tmp8, u, l, 0, knew, 0);
+  clear_amatrix(&r->A);
+  addmul_amatrix(1.0, false, q0, false, yb, &r->A);
+  uninit_amatrix(yb);
+
+  yc = init_sub_amatrix(&tmp9, vt, knew, 0, l, 0);
+  clear_amatrix(&r->B);
+  copy_sub_amatrix(true, yc, &r->B);
+  uninit_amatrix(yc);
+  qreval_amatrix(false, w, tau, &r->B);
+
+  /* Clean up */
+  uninit_avector(sigma);
+  uninit_amatrix(vt);
+  uninit_amatrix(u);
+  uninit_amatrix(c);
+  uninit_avector(tau);
+  uninit_amatrix(w);
+  uninit_amatrix(q0);
+  uninit_amatrix(q);
+
+  release_scratch(mark);
+
+  return true;
 }
 
 void
@@ -316,6 +588,11 @@ trunc_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   cols = r->B.rows;
   k = r->k;
 
+  /* Try randomized truncation if requested and if the rank is large */
+  if (tm && tm->randomized && k < rows && k < cols
+      && trunc_rand_rkmatrix(tm, eps, r))
+    return;
+
   /* Choose most efficient truncation algorithm */
   if (k < rows) {
     if (k < cols)
@@ -353,6 +630,7 @@ add_ab_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uint      rows, cols;
   uint      k, k1, knew;
   uint      i;
+  size_t    mark;
 
   rows = trg->A.rows;
   cols = trg->B.rows;
@@ -361,9 +639,11 @@ add_ab_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->A.rows == rows);
   assert(src->B.rows == cols);
 
+  mark = mark_scratch();
+
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -384,15 +664,15 @@ add_ab_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute C = A B^* */
-  c = init_amatrix(&tmp3, rows, cols);
+  c = init_scratch_amatrix(&tmp3, rows, cols);
   clear_amatrix(c);
   addmul_amatrix(1.0, false, a, true, b, c);
   k1 = UINT_MIN(rows, cols);
 
   /* Compute singular value decomposition */
-  u = init_amatrix(&tmp4, rows, k1);
-  vt = init_amatrix(&tmp5, k1, cols);
-  sigma = init_avector(&tmp6, k1);
+  u = init_scratch_amatrix(&tmp4, rows, k1);
+  vt = init_scratch_amatrix(&tmp5, k1, cols);
+  sigma = init_scratch_avector(&tmp6, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -419,6 +699,8 @@ add_ab_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(c);
   uninit_amatrix(b);
   uninit_amatrix(a);
+
+  release_scratch(mark);
 }
 
 /* Second version: Turn A into an upper triangular matrix by a QR
@@ -436,6 +718,7 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uint      rows, cols;
   uint      k, kr, k1, knew;
   uint      i;
+  size_t    mark;
 
   rows = trg->A.rows;
   cols = trg->B.rows;
@@ -444,9 +727,11 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->A.rows == rows);
   assert(src->B.rows == cols);
 
+  mark = mark_scratch();
+
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -467,7 +752,7 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute QR factorization of A */
-  tau = init_avector(&tmp6, k);
+  tau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(a, tau);
 
   /* Overwrite B by C = B A^* (C^* = A B^*) */
@@ -479,9 +764,9 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(cols, kr);
-  u = init_amatrix(&tmp3, cols, k1);
-  vt = init_amatrix(&tmp4, k1, kr);
-  sigma = init_avector(&tmp7, k1);
+  u = init_scratch_amatrix(&tmp3, cols, k1);
+  vt = init_scratch_amatrix(&tmp4, k1, kr);
+  sigma = init_scratch_avector(&tmp7, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -511,6 +796,8 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(c);
   uninit_amatrix(b);
   uninit_amatrix(a);
+
+  release_scratch(mark);
 }
 
 /* Third version: Turn B into an upper triangular matrix by a QR
@@ -528,6 +815,7 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uint      rows, cols;
   uint      k, kc, k1, knew;
   uint      i;
+  size_t    mark;
 
   rows = trg->A.rows;
   cols = trg->B.rows;
@@ -536,9 +824,11 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->A.rows == rows);
   assert(src->B.rows == cols);
 
+  mark = mark_scratch();
+
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -559,7 +849,7 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute QR factorization of B */
-  tau = init_avector(&tmp6, k);
+  tau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(b, tau);
 
   /* Overwrite A by C = A B^* (C^* = B A^*) */
@@ -571,9 +861,9 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(rows, kc);
-  u = init_amatrix(&tmp3, rows, k1);
-  vt = init_amatrix(&tmp4, k1, kc);
-  sigma = init_avector(&tmp7, k1);
+  u = init_scratch_amatrix(&tmp3, rows, k1);
+  vt = init_scratch_amatrix(&tmp4, k1, kc);
+  sigma = init_scratch_avector(&tmp7, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -603,6 +893,8 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(c);
   uninit_amatrix(b);
   uninit_amatrix(a);
+
+  release_scratch(mark);
 }
 
 /* Fourth version: Reduce both A and B to upper triangular matrices
@@ -620,6 +912,7 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uint      rows, cols;
   uint      k, ak, bk, k1, knew;
   uint      i;
+  size_t    mark;
 
   rows = trg->A.rows;
   cols = trg->B.rows;
@@ -628,9 +921,11 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->A.rows == rows);
   assert(src->B.rows == cols);
 
+  mark = mark_scratch();
+
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -651,17 +946,17 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute QR factorization Q_A R_A = A */
-  atau = init_avector(&tmp6, k);
+  atau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(a, atau);
   ak = UINT_MIN(k, a->rows);
 
   /* Compute QR factorization Q_B R_B = B */
-  btau = init_avector(&tmp7, k);
+  btau = init_scratch_avector(&tmp7, k);
   qrdecomp_amatrix(b, btau);
   bk = UINT_MIN(k, b->rows);
 
   /* Compute condensed matrix C = R_A R_B^* */
-  c = init_amatrix(&tmp3, ak, bk);
+  c = init_scratch_amatrix(&tmp3, ak, bk);
   clear_amatrix(c);
   a1 = init_sub_amatrix(&tmp4, a, ak, 0, k, 0);
   b1 = init_sub_amatrix(&tmp5, b, bk, 0, k, 0);
@@ -671,9 +966,9 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
 
   /* Find singular value decomposition of Z */
   k1 = UINT_MIN(ak, bk);
-  u = init_amatrix(&tmp4, ak, k1);
-  vt = init_amatrix(&tmp5, k1, bk);
-  sigma = init_avector(&tmp8, k1);
+  u = init_scratch_amatrix(&tmp4, ak, k1);
+  vt = init_scratch_amatrix(&tmp5, k1, bk);
+  sigma = init_scratch_avector(&tmp8, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -708,6 +1003,8 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b);
   uninit_avector(atau);
   uninit_amatrix(a);
+
+  release_scratch(mark);
 }
 
 /* User-visible function, chooses appropriate truncation function by
@@ -722,6 +1019,14 @@ add_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm, real eps,
   cols = trg->B.rows;
   k = src->k + trg->k;
 
+  /* Randomized truncation of the combined factors */
+  if (tm && tm->randomized && k >= 4 * SAMPLES_RANDTRUNC && k < rows
+      && k < cols) {
+    append_rkmatrix(alpha, src, trg);
+    trunc_rkmatrix(tm, eps, trg);
+    return;
+  }
+
   /* Choose most efficient truncation algorithm */
   if (k < rows) {
     if (k < cols)
@@ -786,6 +1091,163 @@ add_rkmatrix_hmatrix(field alpha, pcrkmatrix r, pctruncmode tm, real eps,
   }
 }
 
+/* ------------------------------------------------------------
+ Accumulated low-rank updates.
+ ------------------------------------------------------------ */
+
+/* During a multiplication, every admissible leaf of the target
+ * usually receives a large number of low-rank contributions.
+ * If tm->accum_rank is positive, the contributions are appended to
+ * the leaf instead of truncating after each of them, and the leaf is
+ * recorded in an accumulator.
+ * All recorded leaves are truncated once when the accumulator is
+ * flushed, or earlier if their rank exceeds a budget.
+ * A null pointer instead of an accumulator means that every
+ * contribution is truncated immediately. */
+
+typedef struct _rkaccum rkaccum;
+
+typedef rkaccum *prkaccum;
+
+struct _rkaccum {
+  /* Leaves with pending contributions, may contain duplicates */
+  phmatrix *leaf;
+  /* Number of recorded leaves */
+  uint      leaves;
+  /* Length of the array leaf */
+  uint      size;
+};
+
+static void
+init_rkaccum(prkaccum acc)
+{
+  acc->leaf = NULL;
+  acc->leaves = 0;
+  acc->size = 0;
+}
+
+static void
+uninit_rkaccum(prkaccum acc)
+{
+  assert(acc->leaves == 0);
+
+  if (acc->leaf)
+    freemem(acc->leaf);
+}
+
+static int
+compare_leaves(const void *a, const void *b)
+{
+  const phmatrix *la = (const phmatrix *) a;
+  const phmatrix *lb = (const phmatrix *) b;
+
+  return (*la < *lb ? -1 : (*la > *lb ? 1 : 0));
+}
+
+/* Truncate all leaves with pending contributions */
+static void
+flush_rkaccum(pctruncmode tm, real eps, prkaccum acc)
+{
+  phmatrix *leaf;
+  uint      i;
+
+  leaf = acc->leaf;
+
+  /* Sort to skip duplicates, the order of independent truncations
+     does not matter */
+  qsort(leaf, acc->leaves, sizeof(phmatrix), compare_leaves);
+
+  for (i = 0; i < acc->leaves; i++)
+    if (i == 0 || leaf[i] != leaf[i - 1])
+      trunc_rkmatrix(tm, eps, leaf[i]->r);
+
+  acc->leaves = 0;
+}
+
+/* Rank budget of a leaf: once it is exceeded, the leaf is truncated
+ * immediately to bound the cost of the final truncation.
+ * Beyond half the size of the block, a low-rank representation
+ * no longer pays off anyway. */
+static uint
+budget_rkaccum(pctruncmode tm, pcrkmatrix r)
+{
+  uint      rows, cols, budget;
+
+  rows = r->A.rows;
+  cols = r->B.rows;
+
+  budget = UINT_MIN(rows, cols) / 2;
+
+  return UINT_MIN(budget, tm->accum_rank);
+}
+
+/* Compute a <- a + alpha r without truncating admissible leaves */
+static void
+accum_rkmatrix_hmatrix(field alpha, pcrkmatrix r, pctruncmode tm,
+		       real eps, phmatrix a, prkaccum acc)
+{
+  rkmatrix  tmp;
+  phmatrix  a1;
+  pcrkmatrix r1;
+  prkmatrix ar;
+  phmatrix *leaf;
+  uint      rsons, csons;
+  uint      roff, coff;
+  uint      i, j;
+
+  if (acc == NULL)
+    add_rkmatrix_hmatrix(alpha, r, tm, eps, a);
+  else if (a->r) {
+    ar = a->r;
+
+    if (r->k > 0) {
+      append_rkmatrix(alpha, r, ar);
+
+      if (ar->k > budget_rkaccum(tm, ar))
+	trunc_rkmatrix(tm, eps, ar);
+      else {
+	/* Record leaf for the final truncation */
+	if (acc->leaves == acc->size) {
+	  acc->size = 2 * acc->size + 16;
+	  leaf = (phmatrix *) allocmem(sizeof(phmatrix) * acc->size);
+	  for (i = 0; i < acc->leaves; i++)
+	    leaf[i] = acc->leaf[i];
+	  if (acc->leaf)
+	    freemem(acc->leaf);
+	  acc->leaf = leaf;
+	}
+	acc->leaf[acc->leaves++] = a;
+      }
+    }
+  }
+  else if (a->f)
+    addmul_amatrix(alpha, false, &r->A, true, &r->B, a->f);
+  else {
+    rsons = a->rsons;
+    csons = a->csons;
+
+    coff = 0;
+    for (j = 0; j < csons; j++) {
+      roff = 0;
+      for (i = 0; i < rsons; i++) {
+	a1 = a->son[i + j * rsons];
+	r1 =
+	  init_sub_rkmatrix(&tmp, r, a1->rc->size, roff, a1->cc->size, coff);
+
+	accum_rkmatrix_hmatrix(alpha, r1, tm, eps, a1, acc);
+
+	uninit_rkmatrix((prkmatrix) r1);
+
+	roff += a1->rc->size;
+      }
+      assert(roff == a->rc->size);
+
+      coff += a->son[j * rsons]->cc->size;
+    }
+    assert(coff == a->cc->size);
+  }
+}
+
 void
 add_hmatrix(field alpha, pchmatrix a, pctruncmode tm, real eps, phmatrix b)
 {
@@ -1790,7 +2252,7 @@ addmul_hmatrix_amatrix_amatrix(field alpha, bool atrans, pchmatrix a,
 
 static void
 addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
-		  pctruncmode tm, real eps, phmatrix z)
+		  pctruncmode tm, real eps, phmatrix z, prkaccum acc)
 {
   prkmatrix xy;
   pamatrix  id;
@@ -1800,6 +2262,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   rkmatrix  tmp1;
   amatrix   tmp2;
   hmatrix   tmp3;
+  rkaccum   zacc;
   pccluster rc, cc;
   uint      rsons, msons, csons;
   uint      roff, coff;
@@ -1828,7 +2291,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_amatrix(id);
@@ -1843,7 +2306,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_rkmatrix(xy);
@@ -1859,7 +2322,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				   &xy->B);
 
     /* Add rkmatrix to Z */
-    add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+    accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
     /* Clean up */
     uninit_rkmatrix(xy);
@@ -1884,7 +2347,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  uninit_amatrix(id);
 	  uninit_rkmatrix(xy);
@@ -1898,7 +2361,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  /* Clean up */
 	  uninit_rkmatrix(xy);
@@ -1914,7 +2377,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				     &xy->A);
 
       /* Add rkmatrix to Z */
-      add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+      accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
       /* Clean up */
       uninit_rkmatrix(xy);
@@ -1938,7 +2401,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 	    /* Multiplications of submatrices */
 	    for (j = 0; j < msons; j++)
-	      addmul_nn_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z);
+	      addmul_nn_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z, acc);
 	  }
 	  else {
 	    /* Only row subdivided */
@@ -1955,7 +2418,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_nn_hmatrix(alpha, x->son[i + j * rsons], y->son[j], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -1983,7 +2446,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_nn_hmatrix(alpha, x->son[j], y->son[j + k * msons], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2010,7 +2473,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 		/* Multiplications of submatrices */
 		for (j = 0; j < msons; j++)
 		  addmul_nn_hmatrix(alpha, x->son[i + j * rsons],
-				    y->son[j + k * msons], tm, eps, z1);
+				    y->son[j + k * msons], tm, eps, z1, acc);
 
 		/* Clean up */
 		z1->f = 0;
@@ -2030,16 +2493,22 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else if (z->r) {
 	ztmp = split_hmatrix(z, (x->rc != x->son[0]->rc),
 			     (y->cc != y->son[0]->cc), false);
+	init_rkaccum(&zacc);
 
 	for (k = 0; k < csons; k++)
 	  for (i = 0; i < rsons; i++)
 	    for (j = 0; j < msons; j++)
 	      addmul_nn_hmatrix(alpha, x->son[i + j * rsons],
 				y->son[j + k * msons], tm, eps,
-				ztmp->son[i + k * rsons]);
+				ztmp->son[i + k * rsons],
+				(acc ? &zacc : NULL));
+
+	/* Truncate pending contributions before merging */
+	flush_rkaccum(tm, eps, &zacc);
+	uninit_rkaccum(&zacc);
 
 	xy = merge_hmatrix_rkmatrix(ztmp, tm, eps);
-	add_rkmatrix(1.0, xy, tm, eps, z->r);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	del_rkmatrix(xy);
 	del_hmatrix(ztmp);
@@ -2050,7 +2519,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	    for (j = 0; j < msons; j++)
 	      addmul_nn_hmatrix(alpha, x->son[i + j * rsons],
 				y->son[j + k * msons], tm, eps,
-				z->son[i + k * rsons]);
+				z->son[i + k * rsons], acc);
       }
     }
   }
@@ -2058,7 +2527,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 static void
 addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
-		  pctruncmode tm, real eps, phmatrix z)
+		  pctruncmode tm, real eps, phmatrix z, prkaccum acc)
 {
   prkmatrix xy;
   pamatrix  id;
@@ -2068,6 +2537,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   rkmatrix  tmp1;
   amatrix   tmp2;
   hmatrix   tmp3;
+  rkaccum   zacc;
   pccluster rc, cc;
   uint      rsons, msons, csons;
   uint      roff, coff;
@@ -2096,7 +2566,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_amatrix(id);
@@ -2111,7 +2581,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_rkmatrix(xy);
@@ -2127,7 +2597,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				   &xy->B);
 
     /* Add rkmatrix to Z */
-    add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+    accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
     /* Clean up */
     uninit_rkmatrix(xy);
@@ -2152,7 +2622,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  uninit_amatrix(id);
 	  uninit_rkmatrix(xy);
@@ -2166,7 +2636,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  /* Clean up */
 	  uninit_rkmatrix(xy);
@@ -2182,7 +2652,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				     &xy->A);
 
       /* Add rkmatrix to Z */
-      add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+      accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
       /* Clean up */
       uninit_rkmatrix(xy);
@@ -2206,7 +2676,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 	    /* Multiplications of submatrices */
 	    for (j = 0; j < msons; j++)
-	      addmul_nt_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z);
+	      addmul_nt_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z, acc);
 	  }
 	  else {
 	    /* Only row subdivided */
@@ -2223,7 +2693,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_nt_hmatrix(alpha, x->son[i + j * rsons], y->son[j], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2251,7 +2721,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_nt_hmatrix(alpha, x->son[j], y->son[k + j * csons], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2278,7 +2748,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 		/* Multiplications of submatrices */
 		for (j = 0; j < msons; j++)
 		  addmul_nt_hmatrix(alpha, x->son[i + j * rsons],
-				    y->son[k + j * csons], tm, eps, z1);
+				    y->son[k + j * csons], tm, eps, z1, acc);
 
 		/* Clean up */
 		z1->f = 0;
@@ -2298,16 +2768,22 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else if (z->r) {
 	ztmp = split_hmatrix(z, (x->rc != x->son[0]->rc),
 			     (y->rc != y->son[0]->rc), false);
+	init_rkaccum(&zacc);
 
 	for (k = 0; k < csons; k++)
 	  for (i = 0; i < rsons; i++)
 	    for (j = 0; j < msons; j++)
 	      addmul_nt_hmatrix(alpha, x->son[i + j * rsons],
 				y->son[k + j * csons], tm, eps,
-				ztmp->son[i + k * rsons]);
+				ztmp->son[i + k * rsons],
+				(acc ? &zacc : NULL));
+
+	/* Truncate pending contributions before merging */
+	flush_rkaccum(tm, eps, &zacc);
+	uninit_rkaccum(&zacc);
 
 	xy = merge_hmatrix_rkmatrix(ztmp, tm, eps);
-	add_rkmatrix(1.0, xy, tm, eps, z->r);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	del_rkmatrix(xy);
 	del_hmatrix(ztmp);
@@ -2318,7 +2794,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	    for (j = 0; j < msons; j++)
 	      addmul_nt_hmatrix(alpha, x->son[i + j * rsons],
 				y->son[k + j * csons], tm, eps,
-				z->son[i + k * rsons]);
+				z->son[i + k * rsons], acc);
       }
     }
   }
@@ -2326,7 +2802,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 static void
 addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
-		  pctruncmode tm, real eps, phmatrix z)
+		  pctruncmode tm, real eps, phmatrix z, prkaccum acc)
 {
   prkmatrix xy;
   pamatrix  id;
@@ -2336,6 +2812,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   rkmatrix  tmp1;
   amatrix   tmp2;
   hmatrix   tmp3;
+  rkaccum   zacc;
   pccluster rc, cc;
   uint      rsons, msons, csons;
   uint      roff, coff;
@@ -2364,7 +2841,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_amatrix(id);
@@ -2379,7 +2856,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_rkmatrix(xy);
@@ -2395,7 +2872,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				   &xy->B);
 
     /* Add rkmatrix to Z */
-    add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+    accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
     /* Clean up */
     uninit_rkmatrix(xy);
@@ -2420,7 +2897,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  uninit_amatrix(id);
 	  uninit_rkmatrix(xy);
@@ -2434,7 +2911,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  /* Clean up */
 	  uninit_rkmatrix(xy);
@@ -2450,7 +2927,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				     &xy->A);
 
       /* Add rkmatrix to Z */
-      add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+      accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
       /* Clean up */
       uninit_rkmatrix(xy);
@@ -2474,7 +2951,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 	    /* Multiplications of submatrices */
 	    for (j = 0; j < msons; j++)
-	      addmul_tn_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z);
+	      addmul_tn_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z, acc);
 	  }
 	  else {
 	    /* Only row subdivided */
@@ -2491,7 +2968,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_tn_hmatrix(alpha, x->son[j + i * msons], y->son[j], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2519,7 +2996,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_tn_hmatrix(alpha, x->son[j], y->son[j + k * msons], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2546,7 +3023,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 		/* Multiplications of submatrices */
 		for (j = 0; j < msons; j++)
 		  addmul_tn_hmatrix(alpha, x->son[j + i * msons],
-				    y->son[j + k * msons], tm, eps, z1);
+				    y->son[j + k * msons], tm, eps, z1, acc);
 
 		/* Clean up */
 		z1->f = 0;
@@ -2566,16 +3043,22 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else if (z->r) {
 	ztmp = split_hmatrix(z, (x->cc != x->son[0]->cc),
 			     (y->cc != y->son[0]->cc), false);
+	init_rkaccum(&zacc);
 
 	for (k = 0; k < csons; k++)
 	  for (i = 0; i < rsons; i++)
 	    for (j = 0; j < msons; j++)
 	      addmul_tn_hmatrix(alpha, x->son[j + i * msons],
 				y->son[j + k * msons], tm, eps,
-				ztmp->son[i + k * rsons]);
+				ztmp->son[i + k * rsons],
+				(acc ? &zacc : NULL));
+
+	/* Truncate pending contributions before merging */
+	flush_rkaccum(tm, eps, &zacc);
+	uninit_rkaccum(&zacc);
 
 	xy = merge_hmatrix_rkmatrix(ztmp, tm, eps);
-	add_rkmatrix(1.0, xy, tm, eps, z->r);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	del_rkmatrix(xy);
 	del_hmatrix(ztmp);
@@ -2586,7 +3069,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	    for (j = 0; j < msons; j++)
 	      addmul_tn_hmatrix(alpha, x->son[j + i * msons],
 				y->son[j + k * msons], tm, eps,
-				z->son[i + k * rsons]);
+				z->son[i + k * rsons], acc);
       }
     }
   }
@@ -2594,7 +3077,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 static void
 addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
-		  pctruncmode tm, real eps, phmatrix z)
+		  pctruncmode tm, real eps, phmatrix z, prkaccum acc)
 {
   prkmatrix xy;
   pamatrix  id;
@@ -2604,6 +3087,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   rkmatrix  tmp1;
   amatrix   tmp2;
   hmatrix   tmp3;
+  rkaccum   zacc;
   pccluster rc, cc;
   uint      rsons, msons, csons;
   uint      roff, coff;
@@ -2632,7 +3116,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_amatrix(id);
@@ -2647,7 +3131,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				       &xy->B);
 
 	/* Add rkmatrix to Z */
-	add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	/* Clean up */
 	uninit_rkmatrix(xy);
@@ -2663,7 +3147,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				   &xy->B);
 
     /* Add rkmatrix to Z */
-    add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+    accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
     /* Clean up */
     uninit_rkmatrix(xy);
@@ -2687,7 +3171,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  uninit_amatrix(id);
 	  uninit_rkmatrix(xy);
@@ -2701,7 +3185,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 					 &xy->A);
 
 	  /* Add rkmatrix to Z */
-	  add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+	  accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	  /* Clean up */
 	  uninit_rkmatrix(xy);
@@ -2717,7 +3201,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 				     &xy->A);
 
       /* Add rkmatrix to Z */
-      add_rkmatrix_hmatrix(1.0, xy, tm, eps, z);
+      accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
       /* Clean up */
       uninit_rkmatrix(xy);
@@ -2741,7 +3225,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 
 	    /* Multiplications of submatrices */
 	    for (j = 0; j < msons; j++)
-	      addmul_tt_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z);
+	      addmul_tt_hmatrix(alpha, x->son[j], y->son[j], tm, eps, z, acc);
 	  }
 	  else {
 	    /* Only row subdivided */
@@ -2758,7 +3242,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_tt_hmatrix(alpha, x->son[j + i * msons], y->son[j], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2786,7 +3270,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	      /* Multiplications of submatrices */
 	      for (j = 0; j < msons; j++)
 		addmul_tt_hmatrix(alpha, x->son[j], y->son[k + j * csons], tm,
-				  eps, z1);
+				  eps, z1, acc);
 
 	      /* Clean up */
 	      z1->f = 0;
@@ -2813,7 +3297,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 		/* Multiplications of submatrices */
 		for (j = 0; j < msons; j++)
 		  addmul_tt_hmatrix(alpha, x->son[j + i * msons],
-				    y->son[k + j * csons], tm, eps, z1);
+				    y->son[k + j * csons], tm, eps, z1, acc);
 
 		/* Clean up */
 		z1->f = 0;
@@ -2833,16 +3317,22 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else if (z->r) {
 	ztmp = split_hmatrix(z, (x->cc != x->son[0]->cc),
 			     (y->rc != y->son[0]->rc), false);
+	init_rkaccum(&zacc);
 
 	for (k = 0; k < csons; k++)
 	  for (i = 0; i < rsons; i++)
 	    for (j = 0; j < msons; j++)
 	      addmul_tt_hmatrix(alpha, x->son[j + i * msons],
 				y->son[k + j * csons], tm, eps,
-				ztmp->son[i + k * rsons]);
+				ztmp->son[i + k * rsons],
+				(acc ? &zacc : NULL));
+
+	/* Truncate pending contributions before merging */
+	flush_rkaccum(tm, eps, &zacc);
+	uninit_rkaccum(&zacc);
 
 	xy = merge_hmatrix_rkmatrix(ztmp, tm, eps);
-	add_rkmatrix(1.0, xy, tm, eps, z->r);
+	accum_rkmatrix_hmatrix(1.0, xy, tm, eps, z, acc);
 
 	del_rkmatrix(xy);
 	del_hmatrix(ztmp);
@@ -2853,30 +3343,46 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	    for (j = 0; j < msons; j++)
 	      addmul_tt_hmatrix(alpha, x->son[j + i * msons],
 				y->son[k + j * csons], tm, eps,
-				z->son[i + k * rsons]);
+				z->son[i + k * rsons], acc);
       }
     }
   }
 }
 
-void
-addmul_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
-	       pchmatrix y, pctruncmode tm, real eps, phmatrix z)
+static void
+addmul_accum_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
+		     pchmatrix y, pctruncmode tm, real eps, phmatrix z,
+		     prkaccum acc)
 {
   if (xtrans) {
     if (ytrans)
-      addmul_tt_hmatrix(alpha, x, y, tm, eps, z);
+      addmul_tt_hmatrix(alpha, x, y, tm, eps, z, acc);
     else
-      addmul_tn_hmatrix(alpha, x, y, tm, eps, z);
+      addmul_tn_hmatrix(alpha, x, y, tm, eps, z, acc);
   }
   else {
     if (ytrans)
-      addmul_nt_hmatrix(alpha, x, y, tm, eps, z);
+      addmul_nt_hmatrix(alpha, x, y, tm, eps, z, acc);
     else
-      addmul_nn_hmatrix(alpha, x, y, tm, eps, z);
+      addmul_nn_hmatrix(alpha, x, y, tm, eps, z, acc);
   }
 }
 
+void
+addmul_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
+	       pchmatrix y, pctruncmode tm, real eps, phmatrix z)
+{
+  rkaccum   acc;
+
+  init_rkaccum(&acc);
+
+  addmul_accum_hmatrix(alpha, xtrans, x, ytrans, y, tm, eps, z,
+		       (tm && tm->accum_rank > 0 ? &acc : NULL));
+
+  flush_rkaccum(tm, eps, &acc);
+  uninit_rkaccum(&acc);
+}
+
 /* ------------------------------------------------------------
  * Inversion of an H-matrix
  * ------------------------------------------------------------ */
@@ -5514,3 +6020,218 @@ cholsolve_hmatrix_avector(pchmatrix a, pavector x)
     x->v[idx[i]] = xp->v[i];
   uninit_avector(xp);
 }
+
+/* ------------------------------------------------------------
+ * Parallel triangular factorizations
+ * ------------------------------------------------------------ */
+
+/* Update z <- z + alpha x y or z <- z + alpha x y^*.
+   If all matrices are subdivided, every son of z is updated by its
+   own task, and the products of the sons are split recursively up to
+   the parallelization depth. Every task owns an accumulator that
+   collects the products of its son in the same order as
+   addmul_hmatrix and truncates the leaves once at the end, so the
+   result does not depend on the scheduling.
+   If acc is not null, it is the accumulator of the calling task and
+   receives the products if z is not split further. */
+static void
+addmul_task_hmatrix(field alpha, bool ytrans, pchmatrix x, pchmatrix y,
+		    pctruncmode tm, real eps, phmatrix z, prkaccum acc,
+		    uint pardepth)
+{
+  pchmatrix yj;
+  phmatrix  zik;
+  rkaccum   acc1;
+  uint      rsons, msons, csons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || x->son == 0 || y->son == 0 || z->son == 0) {
+    if (acc)
+      addmul_accum_hmatrix(alpha, false, x, ytrans, y, tm, eps, z, acc);
+    else
+      addmul_hmatrix(alpha, false, x, ytrans, y, tm, eps, z);
+  }
+  else {
+    rsons = x->rsons;
+    msons = x->csons;
+    csons = (ytrans ? y->rsons : y->csons);
+
+    assert(msons == (ytrans ? y->csons : y->rsons));
+    assert(z->rsons == rsons);
+    assert(z->csons == csons);
+
+    for (k = 0; k < csons; k++)
+      for (i = 0; i < rsons; i++) {
+	zik = z->son[i + k * rsons];
+
+#ifdef USE_OPENMP
+#pragma omp task private(j, yj, acc1)
+#endif
+	{
+	  init_rkaccum(&acc1);
+
+	  for (j = 0; j < msons; j++) {
+	    yj = (ytrans ? y->son[k + j * csons] : y->son[j + k * msons]);
+	    addmul_task_hmatrix(alpha, ytrans, x->son[i + j * rsons], yj, tm,
+				eps, zik,
+				(tm && tm->accum_rank > 0 ? &acc1 : NULL),
+				pardepth - 1);
+	  }
+
+	  flush_rkaccum(tm, eps, &acc1);
+	  uninit_rkaccum(&acc1);
+	}
+      }
+
+#ifdef USE_OPENMP
+#pragma omp taskwait
+#endif
+  }
+}
+
+/* Every operation of the block LR factorization becomes a task.
+   The dependencies between the tasks are given by the submatrices
+   they read and write, so operations on independent submatrices
+   run concurrently, while every submatrix is still modified in the
+   same order as by lrdecomp_hmatrix. */
+static void
+lrdecomp_task_hmatrix(phmatrix a, pctruncmode tm, real eps, uint pardepth)
+{
+  phmatrix  akk, aik, akj, aij;
+  uint      sons;
+  uint      i, j, k;
+
+  assert(a->rc == a->cc);
+
+  if (pardepth == 0 || a->son == 0) {
+    lrdecomp_hmatrix(a, tm, eps);
+  }
+  else {
+    assert(a->rsons == a->csons);
+
+    sons = a->rsons;
+
+    for (k = 0; k < sons; k++) {
+      akk = a->son[k + k * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(inout: akk[0])
+#endif
+      lrdecomp_task_hmatrix(akk, tm, eps, pardepth - 1);
+
+      for (j = k + 1; j < sons; j++) {
+	akj = a->son[k + j * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(in: akk[0]) depend(inout: akj[0])
+#endif
+	lowersolve_hmatrix(true, false, akk, tm, eps, false, akj);
+      }
+
+      for (i = k + 1; i < sons; i++) {
+	aik = a->son[i + k * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(in: akk[0]) depend(inout: aik[0])
+#endif
+	uppersolve_hmatrix(false, true, akk, tm, eps, true, aik);
+      }
+
+      for (j = k + 1; j < sons; j++)
+	for (i = k + 1; i < sons; i++) {
+	  aik = a->son[i + k * sons];
+	  akj = a->son[k + j * sons];
+	  aij = a->son[i + j * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(in: aik[0], akj[0]) depend(inout: aij[0])
+#endif
+	  addmul_task_hmatrix(-1.0, false, aik, akj, tm, eps, aij, NULL,
+			      pardepth - 1);
+	}
+    }
+
+#ifdef USE_OPENMP
+#pragma omp taskwait
+#endif
+  }
+}
+
+void
+lrdecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps,
+			  uint pardepth)
+{
+#ifdef USE_OPENMP
+#pragma omp parallel if(pardepth > 0)
+#pragma omp single
+#endif
+  lrdecomp_task_hmatrix(a, tm, eps, pardepth);
+}
+
+/* Task-based counterpart of choldecomp_hmatrix, see
+   lrdecomp_task_hmatrix. */
+static void
+choldecomp_task_hmatrix(phmatrix a, pctruncmode tm, real eps,
+			uint pardepth)
+{
+  phmatrix  akk, aik, ajk, aij;
+  uint      sons;
+  uint      i, j, k;
+
+  assert(a->rc == a->cc);
+
+  if (pardepth == 0 || a->son == 0) {
+    choldecomp_hmatrix(a, tm, eps);
+  }
+  else {
+    assert(a->rsons == a->csons);
+
+    sons = a->rsons;
+
+    for (k = 0; k < sons; k++) {
+      akk = a->son[k + k * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(inout: akk[0])
+#endif
+      choldecomp_task_hmatrix(akk, tm, eps, pardepth - 1);
+
+      for (i = k + 1; i < sons; i++) {
+	aik = a->son[i + k * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(in: akk[0]) depend(inout: aik[0])
+#endif
+	lowersolve_hmatrix(false, false, akk, tm, eps, true, aik);
+      }
+
+      for (j = k + 1; j < sons; j++)
+	for (i = j; i < sons; i++) {
+	  aik = a->son[i + k * sons];
+	  ajk = a->son[j + k * sons];
+	  aij = a->son[i + j * sons];
+
+#ifdef USE_OPENMP
+#pragma omp task depend(in: aik[0], ajk[0]) depend(inout: aij[0])
+#endif
+	  addmul_task_hmatrix(-1.0, true, aik, ajk, tm, eps, aij, NULL,
+			      pardepth - 1);
+	}
+    }
+
+#ifdef USE_OPENMP
+#pragma omp taskwait
+#endif
+  }
+}
+
+void
+choldecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps,
+			    uint pardepth)
+{
+#ifdef USE_OPENMP
+#pragma omp parallel if(pardepth > 0)
+#pragma omp single
+#endif
+  choldecomp_task_hmatrix(a, tm, eps, pardepth);
+}
@@ -24,6 +24,10 @@
 /** @brief Truncate an rkmatrix,
  *  @f$A \gets \operatorname{trunc}(A,\epsilon)@f$.
  *
+ *  If <tt>tm->randomized</tt> is set, a randomized range finder is
+ *  tried first. It is only used if the new rank is at most half
+ *  of the old rank, otherwise the SVD-based algorithms take over.
+ *
  *  @param tm Truncation mode.
  *  @param eps Truncation accuracy @f$\epsilon@f$.
  *  @param r Source matrix, will be overwritten by truncated matrix. */
@@ -159,6 +163,13 @@ addmul_hmatrix_amatrix_amatrix(field alpha, bool atrans, pchmatrix a,
 /** @brief Multiply two H-matrices,
  *  @f$Z \gets \operatorname{succtrunc}(Z + \alpha X Y,\epsilon)@f$.
  *
+ *  If <tt>tm->accum_rank</tt> is positive, the low-rank contributions
+ *  to an admissible leaf of @f$Z@f$ are collected and the leaf is
+ *  truncated only once at the end, or earlier if its rank exceeds
+ *  <tt>tm->accum_rank</tt>.
+ *  Since the truncation mode is passed on, this also applies to
+ *  inversion, triangular solves and factorizations.
+ *
  *  @param alpha Scaling factor @f$\alpha@f$.
  *  @param xtrans Set if @f$X^*@f$ is to be used instead of @f$X@f$.
  *  @param x Hierarchical matrix @f$X@f$.
@@ -431,6 +442,46 @@ choldecomp_hmatrix(phmatrix a, pctruncmode tm, real eps);
 HEADER_PREFIX void
 cholsolve_hmatrix_avector(pchmatrix a, pavector x);
 
+/* ------------------------------------------------------------
+ * Parallel triangular factorizations
+ * ------------------------------------------------------------ */
+
+/** @brief Compute the LR factorization,
+ *  @f$A \approx L R@f$, using OpenMP tasks.
+ *
+ *  The factorization, the triangular solves and the updates of
+ *  the Schur complement on the first <tt>pardepth</tt> levels of
+ *  the block tree are handled by tasks that only wait for the
+ *  operations providing their input submatrices.
+ *  Since every submatrix is modified in the same order as by
+ *  @ref lrdecomp_hmatrix, the result is identical.
+ *
+ *  @param a Source matrix @f$A@f$, will be overwritten
+ *     by @f$L@f$ and @f$R@f$.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy.
+ *  @param pardepth Parallelization depth, usually @ref max_pardepth.
+ *     If it is zero, @ref lrdecomp_hmatrix is used. */
+HEADER_PREFIX void
+lrdecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps,
+			  uint pardepth);
+
+/** @brief Compute the Cholesky factorization,
+ *  @f$A \approx L L^*@f$, using OpenMP tasks.
+ *
+ *  The tasks are organized as in @ref lrdecomp_parallel_hmatrix,
+ *  the result is identical to that of @ref choldecomp_hmatrix.
+ *
+ *  @param a Source matrix @f$A@f$, lower triangular part will be overwritten
+ *    by @f$L@f$.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy.
+ *  @param pardepth Parallelization depth, usually @ref max_pardepth.
+ *     If it is zero, @ref choldecomp_hmatrix is used. */
+HEADER_PREFIX void
+choldecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps,
+			    uint pardepth);
+
 /** @} */
 
 #endif
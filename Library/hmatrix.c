@@ -29,6 +29,8 @@ init_hmatrix(phmatrix hm, pccluster rc, pccluster cc)
   hm->refs = 0;
   hm->desc = 0;
 
+  hm->flat = NULL;
+
   return hm;
 }
 
@@ -53,6 +55,19 @@ uninit_hmatrix(phmatrix hm)
 
   if (hm->r)
     del_rkmatrix(hm->r);
+
+  if (hm->flat) {
+    freemem(hm->flat->cperm);
+    freemem(hm->flat->doff);
+    freemem(hm->flat->coff);
+    freemem(hm->flat->roff);
+    freemem(hm->flat->leaf);
+    if (hm->flat->bin)
+      unref_binarystore(hm->flat->bin);
+    else
+      freemem(hm->flat->data);
+    freemem(hm->flat);
+  }
 }
 
 phmatrix
@@ -240,6 +255,375 @@ unref_hmatrix(phmatrix hm)
     del_hmatrix(hm);
 }
 
+/* ------------------------------------------------------------
+ Contiguous storage
+ ------------------------------------------------------------ */
+
+/* Count leaves and coefficients, only owned coefficients unless all is set */
+static void
+count_leaves(pchmatrix hm, bool all, uint *leaves, size_t *size)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    (*leaves)++;
+    if (all || hm->r->A.owner == NULL)
+      *size += (size_t) hm->r->A.rows * hm->r->A.cols;
+    if (all || hm->r->B.owner == NULL)
+      *size += (size_t) hm->r->B.rows * hm->r->B.cols;
+  }
+  else if (hm->f) {
+    (*leaves)++;
+    if (all || hm->f->owner == NULL)
+      *size += (size_t) hm->f->rows * hm->f->cols;
+  }
+  else
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++)
+	count_leaves(hm->son[i + j * rsons], all, leaves, size);
+}
+
+/* Move the coefficients of a matrix owning its storage to the arena */
+static void
+move_to_arena(pamatrix a, phmatrixflat flat, size_t *off)
+{
+  if (a->owner == NULL && a->rows > 0 && a->cols > 0) {
+    move_amatrix(a, flat->data + *off, flat);
+    *off += (size_t) a->rows * a->cols;
+  }
+}
+
+static void
+freeze_leaves(phmatrix hm, uint roff, uint coff, phmatrixflat flat,
+	      uint *n, size_t *off)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      ioff, joff, i, j;
+
+  if (hm->r || hm->f) {
+    flat->leaf[*n] = hm;
+    flat->roff[*n] = roff;
+    flat->coff[*n] = coff;
+    flat->doff[*n] = *off;
+    (*n)++;
+
+    if (hm->r) {
+      move_to_arena(&hm->r->A, flat, off);
+      move_to_arena(&hm->r->B, flat, off);
+    }
+    else
+      move_to_arena(hm->f, flat, off);
+  }
+  else {
+    /* Block rows first, as in the parallel matrix-vector multiplication */
+    ioff = roff;
+    for (i = 0; i < rsons; i++) {
+      joff = coff;
+      for (j = 0; j < csons; j++) {
+	freeze_leaves(hm->son[i + j * rsons], ioff, joff, flat, n, off);
+
+	joff += hm->son[i + j * rsons]->cc->size;
+      }
+      assert(csons == 0 || joff == coff + hm->cc->size);
+
+      ioff += hm->son[i]->rc->size;
+    }
+    assert(rsons == 0 || ioff == roff + hm->rc->size);
+  }
+}
+
+/* Collect the indices of the leaves block column by block column,
+   base is the index of the first leaf of hm in the flat leaf list */
+static void
+transpose_leaves(pchmatrix hm, uint base, uint *cperm, uint *n)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint     *sbase;
+  size_t    size;
+  uint      i, j;
+
+  if (hm->r || hm->f) {
+    cperm[*n] = base;
+    (*n)++;
+  }
+  else if (hm->son) {
+    /* First leaves of the sons in the block row ordering */
+    sbase = allocuint(rsons * csons);
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	sbase[i + j * rsons] = base;
+	size = 0;
+	count_leaves(hm->son[i + j * rsons], false, &base, &size);
+      }
+
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	transpose_leaves(hm->son[i + j * rsons], sbase[i + j * rsons], cperm,
+			 n);
+
+    freemem(sbase);
+  }
+}
+
+void
+freeze_hmatrix(phmatrix hm)
+{
+  phmatrixflat flat;
+  uint      leaves, n;
+  size_t    size, off;
+
+  assert(hm->flat == NULL);
+
+  leaves = 0;
+  size = 0;
+  count_leaves(hm, false, &leaves, &size);
+
+  flat = (phmatrixflat) allocmem(sizeof(hmatrixflat));
+  flat->data = (size > 0 ? allocfield(size) : NULL);
+  flat->size = size;
+  flat->leaves = leaves;
+  flat->leaf = (pchmatrix *) allocmem((size_t) sizeof(pchmatrix) * leaves);
+  flat->roff = allocuint(leaves);
+  flat->coff = allocuint(leaves);
+  flat->doff = (size_t *) allocmem((size_t) sizeof(size_t) * leaves);
+  flat->bin = NULL;
+
+  n = 0;
+  off = 0;
+  freeze_leaves(hm, 0, 0, flat, &n, &off);
+  assert(n == leaves);
+  assert(off == size);
+
+  flat->cperm = allocuint(leaves);
+  n = 0;
+  transpose_leaves(hm, 0, flat->cperm, &n);
+  assert(n == leaves);
+
+  hm->flat = flat;
+}
+
+/* Multiply by the leaves first to last-1 of the flat leaf list,
+   in the block column ordering if atrans is set */
+static void
+addeval_frozen_leaves(field alpha, bool atrans, pchmatrixflat flat,
+		      uint first, uint last, pcavector xp, pavector yp)
+{
+  pchmatrix hl;
+  avector   xtmp, ytmp;
+  pavector  x1, y1;
+  uint      l, k;
+
+  for (l = first; l < last; l++) {
+    if (atrans) {
+      k = flat->cperm[l];
+      hl = flat->leaf[k];
+
+      x1 = init_sub_avector(&xtmp, (pavector) xp, hl->rc->size,
+			    flat->roff[k]);
+      y1 = init_sub_avector(&ytmp, yp, hl->cc->size, flat->coff[k]);
+
+      if (hl->r)
+	addevaltrans_rkmatrix_avector(alpha, hl->r, x1, y1);
+      else
+	mvm_amatrix_avector(alpha, true, hl->f, x1, y1);
+    }
+    else {
+      hl = flat->leaf[l];
+
+      x1 = init_sub_avector(&xtmp, (pavector) xp, hl->cc->size,
+			    flat->coff[l]);
+      y1 = init_sub_avector(&ytmp, yp, hl->rc->size, flat->roff[l]);
+
+      if (hl->r)
+	addeval_rkmatrix_avector(alpha, hl->r, x1, y1);
+      else
+	mvm_amatrix_avector(alpha, false, hl->f, x1, y1);
+    }
+
+    uninit_avector(y1);
+    uninit_avector(x1);
+  }
+}
+
+/* Split the leaves of hm, starting at index first of the flat leaf
+   list, by block rows (or block columns if atrans is set) as in the
+   parallel matrix-vector multiplication, and process the leaves
+   below the parallelization depth in storage order */
+static void
+addeval_frozen_parallel(field alpha, bool atrans, pchmatrix hm,
+			pchmatrixflat flat, uint first, uint last,
+			pcavector xp, pavector yp, uint pardepth)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint     *sfirst, *slast;
+  size_t    size;
+  uint      l, i, j;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+
+  if (pardepth == 0 || hm->son == NULL) {
+    addeval_frozen_leaves(alpha, atrans, flat, first, last, xp, yp);
+    return;
+  }
+
+  /* Ranges of the sons in the flat leaf list */
+  sfirst = allocuint(rsons * csons);
+  slast = allocuint(rsons * csons);
+  l = first;
+  size = 0;
+  if (atrans)
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++) {
+	sfirst[i + j * rsons] = l;
+	count_leaves(hm->son[i + j * rsons], false, &l, &size);
+	slast[i + j * rsons] = l;
+      }
+  else
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	sfirst[i + j * rsons] = l;
+	count_leaves(hm->son[i + j * rsons], false, &l, &size);
+	slast[i + j * rsons] = l;
+      }
+  assert(l == last);
+
+  if (atrans) {
+    /* Every thread owns one block column, i.e., a disjoint part of yp */
+#ifdef USE_OPENMP
+    nthreads = csons;
+    (void) nthreads;
+#pragma omp parallel for if(csons > 1), num_threads(nthreads), private(i)
+#endif
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	addeval_frozen_parallel(alpha, atrans, hm->son[i + j * rsons], flat,
+				sfirst[i + j * rsons], slast[i + j * rsons],
+				xp, yp, pardepth - 1);
+  }
+  else {
+    /* Every thread owns one block row, i.e., a disjoint part of yp */
+#ifdef USE_OPENMP
+    nthreads = rsons;
+    (void) nthreads;
+#pragma omp parallel for if(rsons > 1), num_threads(nthreads), private(j)
+#endif
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++)
+	addeval_frozen_parallel(alpha, atrans, hm->son[i + j * rsons], flat,
+				sfirst[i + j * rsons], slast[i + j * rsons],
+				xp, yp, pardepth - 1);
+  }
+
+  freemem(slast);
+  freemem(sfirst);
+}
+
+void
+fastaddeval_frozen_hmatrix_avector(field alpha, pchmatrix hm,
+				   pcavector xp, pavector yp)
+{
+  assert(hm->flat != NULL);
+  assert(xp->dim == hm->cc->size);
+  assert(yp->dim == hm->rc->size);
+
+  addeval_frozen_parallel(alpha, false, hm, hm->flat, 0, hm->flat->leaves,
+			  xp, yp, max_pardepth);
+}
+
+void
+fastaddevaltrans_frozen_hmatrix_avector(field alpha, pchmatrix hm,
+					pcavector xp, pavector yp)
+{
+  assert(hm->flat != NULL);
+  assert(xp->dim == hm->rc->size);
+  assert(yp->dim == hm->cc->size);
+
+  addeval_frozen_parallel(alpha, true, hm, hm->flat, 0, hm->flat->leaves,
+			  xp, yp, max_pardepth);
+}
+
+/* ------------------------------------------------------------
+ Single precision storage
+ ------------------------------------------------------------ */
+
+void
+tosingle_hmatrix(phmatrix hm)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    if (hm->r->s == NULL)
+      tosingle_rkmatrix(hm->r);
+  }
+  else
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	tosingle_hmatrix(hm->son[i + j * rsons]);
+}
+
+void
+todouble_hmatrix(phmatrix hm)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    if (hm->r->s)
+      todouble_rkmatrix(hm->r);
+  }
+  else
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	todouble_hmatrix(hm->son[i + j * rsons]);
+}
+
+/* ------------------------------------------------------------
+ Adaptive precision storage
+ ------------------------------------------------------------ */
+
+void
+compress_hmatrix(phmatrix hm, real eps)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    if (hm->r->c == NULL)
+      compress_rkmatrix(hm->r, eps);
+  }
+  else
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	compress_hmatrix(hm->son[i + j * rsons], eps);
+}
+
+void
+decompress_hmatrix(phmatrix hm)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    if (hm->r->c)
+      decompress_rkmatrix(hm->r);
+  }
+  else
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++)
+	decompress_hmatrix(hm->son[i + j * rsons]);
+}
+
 /* ------------------------------------------------------------
  Statistics
  ------------------------------------------------------------ */
@@ -254,6 +638,13 @@ getsize_hmatrix(pchmatrix hm)
 
   sz = (size_t) sizeof(hmatrix);
 
+  if (hm->flat) {
+    sz += (size_t) sizeof(hmatrixflat);
+    sz += (size_t) sizeof(field) * hm->flat->size;
+    sz += (size_t) (sizeof(pchmatrix) + 3 * sizeof(uint) + sizeof(size_t))
+      * hm->flat->leaves;
+  }
+
   if (hm->r)
     sz += getsize_rkmatrix(hm->r);
 
@@ -277,9 +668,14 @@ getnearsize_hmatrix(pchmatrix hm)
 
   sz = 0;
 
-  if (hm->f)
+  if (hm->f) {
     sz += getsize_amatrix(hm->f);
 
+    /* Coefficients stored in the arena of a frozen matrix */
+    if (hm->f->owner)
+      sz += (size_t) sizeof(field) * hm->f->rows * hm->f->cols;
+  }
+
   for (j = 0; j < csons; j++)
     for (i = 0; i < rsons; i++)
       sz += getnearsize_hmatrix(hm->son[i + j * rsons]);
@@ -297,9 +693,16 @@ getfarsize_hmatrix(pchmatrix hm)
 
   sz = 0;
 
-  if (hm->r)
+  if (hm->r) {
     sz += getsize_rkmatrix(hm->r);
 
+    /* Coefficients stored in the arena of a frozen matrix */
+    if (hm->r->A.owner)
+      sz += (size_t) sizeof(field) * hm->r->A.rows * hm->r->A.cols;
+    if (hm->r->B.owner)
+      sz += (size_t) sizeof(field) * hm->r->B.rows * hm->r->B.cols;
+  }
+
   for (j = 0; j < csons; j++)
     for (i = 0; i < rsons; i++)
       sz += getfarsize_hmatrix(hm->son[i + j * rsons]);
@@ -472,18 +875,87 @@ fastaddeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 }
 
+void
+fastaddeval_parallel_hmatrix_avector(field alpha, pchmatrix hm,
+				     pcavector xp, pavector yp, uint pardepth)
+{
+  pavector *x1, *y1;
+  uint      rsons, csons;
+  uint      xoff, yoff, i, j;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+
+  assert(xp->dim == hm->cc->size);
+  assert(yp->dim == hm->rc->size);
+
+  /* Leaves and subtrees below the parallelization depth are handled
+     by the sequential algorithm */
+  if (pardepth == 0 || hm->son == NULL) {
+    fastaddeval_hmatrix_avector(alpha, hm, xp, yp);
+    return;
+  }
+
+  rsons = hm->rsons;
+  csons = hm->csons;
+
+  /* Subvectors for block columns */
+  x1 = (pavector *) allocmem((size_t) sizeof(pavector) * csons);
+  xoff = 0;
+  for (j = 0; j < csons; j++) {
+    x1[j] = new_sub_avector((pavector) xp, hm->son[j * rsons]->cc->size, xoff);
+
+    xoff += hm->son[j * rsons]->cc->size;
+  }
+  assert(xoff == hm->cc->size);
+
+  /* Subvectors for block rows */
+  y1 = (pavector *) allocmem((size_t) sizeof(pavector) * rsons);
+  yoff = 0;
+  for (i = 0; i < rsons; i++) {
+    y1[i] = new_sub_avector(yp, hm->son[i]->rc->size, yoff);
+
+    yoff += hm->son[i]->rc->size;
+  }
+  assert(yoff == hm->rc->size);
+
+  /* Every thread owns one block row, i.e., a disjoint part of yp,
+     and adds the contributions of this row in the same order as
+     the sequential algorithm. */
+#ifdef USE_OPENMP
+  nthreads = rsons;
+  (void) nthreads;
+#pragma omp parallel for if(rsons > 1), num_threads(nthreads), private(j)
+#endif
+  for (i = 0; i < rsons; i++)
+    for (j = 0; j < csons; j++)
+      fastaddeval_parallel_hmatrix_avector(alpha, hm->son[i + j * rsons],
+					   x1[j], y1[i], pardepth - 1);
+
+  /* Clean up */
+  for (i = 0; i < rsons; i++)
+    del_avector(y1[i]);
+  freemem(y1);
+  for (j = 0; j < csons; j++)
+    del_avector(x1[j]);
+  freemem(x1);
+}
+
 void
 addeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y)
 {
   pavector  xp, yp;
   avector   xtmp, ytmp;
   uint      i, ip;
+  size_t    mark;
 
   assert(x->dim == hm->cc->size);
   assert(y->dim == hm->rc->size);
 
+  mark = mark_scratch();
+
   /* Permutation of x */
-  xp = init_avector(&xtmp, x->dim);
+  xp = init_scratch_avector(&xtmp, x->dim);
   for (i = 0; i < xp->dim; i++) {
     ip = hm->cc->idx[i];
     assert(ip < x->dim);
@@ -491,7 +963,7 @@ addeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y)
   }
 
   /* Permutation of y */
-  yp = init_avector(&ytmp, y->dim);
+  yp = init_scratch_avector(&ytmp, y->dim);
   for (i = 0; i < yp->dim; i++) {
     ip = hm->rc->idx[i];
     assert(ip < y->dim);
@@ -499,7 +971,14 @@ addeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y)
   }
 
   /* Matrix-vector multiplication */
-  fastaddeval_hmatrix_avector(alpha, hm, xp, yp);
+  if (hm->flat)
+    fastaddeval_frozen_hmatrix_avector(alpha, hm, xp, yp);
+  else
+#ifdef USE_OPENMP
+    fastaddeval_parallel_hmatrix_avector(alpha, hm, xp, yp, max_pardepth);
+#else
+    fastaddeval_hmatrix_avector(alpha, hm, xp, yp);
+#endif
 
   /* Reverse permutation of y */
   for (i = 0; i < yp->dim; i++) {
@@ -510,6 +989,8 @@ addeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y)
 
   uninit_avector(yp);
   uninit_avector(xp);
+
+  release_scratch(mark);
 }
 
 void
@@ -560,6 +1041,73 @@ fastaddevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 }
 
+void
+fastaddevaltrans_parallel_hmatrix_avector(field alpha, pchmatrix hm,
+					  pcavector xp, pavector yp,
+					  uint pardepth)
+{
+  pavector *x1, *y1;
+  uint      rsons, csons;
+  uint      xoff, yoff, i, j;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+
+  assert(xp->dim == hm->rc->size);
+  assert(yp->dim == hm->cc->size);
+
+  /* Leaves and subtrees below the parallelization depth are handled
+     by the sequential algorithm */
+  if (pardepth == 0 || hm->son == NULL) {
+    fastaddevaltrans_hmatrix_avector(alpha, hm, xp, yp);
+    return;
+  }
+
+  rsons = hm->rsons;
+  csons = hm->csons;
+
+  /* Subvectors for block rows */
+  x1 = (pavector *) allocmem((size_t) sizeof(pavector) * rsons);
+  xoff = 0;
+  for (i = 0; i < rsons; i++) {
+    x1[i] = new_sub_avector((pavector) xp, hm->son[i]->rc->size, xoff);
+
+    xoff += hm->son[i]->rc->size;
+  }
+  assert(xoff == hm->rc->size);
+
+  /* Subvectors for block columns */
+  y1 = (pavector *) allocmem((size_t) sizeof(pavector) * csons);
+  yoff = 0;
+  for (j = 0; j < csons; j++) {
+    y1[j] = new_sub_avector(yp, hm->son[j * rsons]->cc->size, yoff);
+
+    yoff += hm->son[j * rsons]->cc->size;
+  }
+  assert(yoff == hm->cc->size);
+
+  /* Every thread owns one block column, i.e., a disjoint part of yp,
+     and adds the contributions of this column in the same order as
+     the sequential algorithm. */
+#ifdef USE_OPENMP
+  nthreads = csons;
+  (void) nthreads;
+#pragma omp parallel for if(csons > 1), num_threads(nthreads), private(i)
+#endif
+  for (j = 0; j < csons; j++)
+    for (i = 0; i < rsons; i++)
+      fastaddevaltrans_parallel_hmatrix_avector(alpha, hm->son[i + j * rsons],
+						x1[i], y1[j], pardepth - 1);
+
+  /* Clean up */
+  for (j = 0; j < csons; j++)
+    del_avector(y1[j]);
+  freemem(y1);
+  for (i = 0; i < rsons; i++)
+    del_avector(x1[i]);
+  freemem(x1);
+}
+
 void
 addevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
 			     pavector y)
@@ -567,12 +1115,15 @@ addevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   pavector  xp, yp;
   avector   xtmp, ytmp;
   uint      i, ip;
+  size_t    mark;
 
   assert(x->dim == hm->rc->size);
   assert(y->dim == hm->cc->size);
 
+  mark = mark_scratch();
+
   /* Permutation of x */
-  xp = init_avector(&xtmp, x->dim);
+  xp = init_scratch_avector(&xtmp, x->dim);
   for (i = 0; i < xp->dim; i++) {
     ip = hm->rc->idx[i];
     assert(ip < x->dim);
@@ -580,7 +1131,7 @@ addevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 
   /* Permutation of y */
-  yp = init_avector(&ytmp, y->dim);
+  yp = init_scratch_avector(&ytmp, y->dim);
   for (i = 0; i < yp->dim; i++) {
     ip = hm->cc->idx[i];
     assert(ip < y->dim);
@@ -588,7 +1139,15 @@ addevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 
   /* Matrix-vector multiplication */
-  fastaddevaltrans_hmatrix_avector(alpha, hm, xp, yp);
+  if (hm->flat)
+    fastaddevaltrans_frozen_hmatrix_avector(alpha, hm, xp, yp);
+  else
+#ifdef USE_OPENMP
+    fastaddevaltrans_parallel_hmatrix_avector(alpha, hm, xp, yp,
+					      max_pardepth);
+#else
+    fastaddevaltrans_hmatrix_avector(alpha, hm, xp, yp);
+#endif
 
   /* Reverse permutation of y */
   for (i = 0; i < yp->dim; i++) {
@@ -599,6 +1158,8 @@ addevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
 
   uninit_avector(yp);
   uninit_avector(xp);
+
+  release_scratch(mark);
 }
 
 static void
@@ -788,6 +1349,181 @@ addevalsymm_hmatrix_avector(field alpha, pchmatrix hm,
   uninit_avector(xp);
 }
 
+/* ------------------------------------------------------------
+ Multiplication with multiple vectors
+ ------------------------------------------------------------ */
+
+void
+fastaddmul_parallel_hmatrix_amatrix_amatrix(field alpha, bool atrans,
+					    pchmatrix hm, pcamatrix Xp,
+					    pamatrix Yp, uint pardepth)
+{
+  pamatrix *X1, *Y1, Z, A, B;
+  amatrix   Atmp, Btmp;
+  pcrkmatrix r;
+  pccluster rc, cc;
+  size_t    mark;
+  uint      rsons, csons;
+  uint      xoff, yoff, i, j, k;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+
+  rc = (atrans ? hm->cc : hm->rc);
+  cc = (atrans ? hm->rc : hm->cc);
+
+  assert(Xp->rows == cc->size);
+  assert(Yp->rows == rc->size);
+  assert(Xp->cols == Yp->cols);
+
+  if (hm->r) {
+    r = hm->r;
+    A = (pamatrix) &r->A;
+    B = (pamatrix) &r->B;
+    mark = mark_scratch();
+
+    if (r->s) {
+      /* Factors in single precision: promote them to double precision
+         in the scratch arena, so the product can still use BLAS 3 */
+      A = init_scratch_amatrix(&Atmp, r->A.rows, r->k);
+      B = init_scratch_amatrix(&Btmp, r->B.rows, r->k);
+      fromsingle_amatrix(r->s, A);
+      fromsingle_amatrix(r->s + (size_t) r->A.rows * r->k, B);
+    }
+    else if (r->c) {
+      /* Compressed factors: decompress them in the scratch arena */
+      A = init_scratch_amatrix(&Atmp, r->A.rows, r->k);
+      B = init_scratch_amatrix(&Btmp, r->B.rows, r->k);
+      decompress_factors_rkmatrix(r, A, B);
+    }
+
+    /* Y += alpha A (B^* X) or Y += alpha B (A^* X) */
+    Z = new_zero_amatrix(r->k, Xp->cols);
+    addmul_amatrix(1.0, true, (atrans ? A : B), false, Xp, Z);
+    addmul_amatrix(alpha, false, (atrans ? B : A), false, Z, Yp);
+    del_amatrix(Z);
+
+    if (r->s || r->c) {
+      uninit_amatrix(B);
+      uninit_amatrix(A);
+    }
+    release_scratch(mark);
+  }
+  else if (hm->f) {
+    addmul_amatrix(alpha, atrans, hm->f, false, Xp, Yp);
+  }
+  else {
+    rsons = (atrans ? hm->csons : hm->rsons);
+    csons = (atrans ? hm->rsons : hm->csons);
+
+    /* Submatrices for block columns */
+    X1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * csons);
+    xoff = 0;
+    for (j = 0; j < csons; j++) {
+      k = (atrans ? j : j * rsons);
+      X1[j] = new_sub_amatrix((pamatrix) Xp,
+			      (atrans ? hm->son[k]->rc->size :
+			       hm->son[k]->cc->size), xoff, Xp->cols, 0);
+
+      xoff += X1[j]->rows;
+    }
+    assert(xoff == cc->size);
+
+    /* Submatrices for block rows */
+    Y1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * rsons);
+    yoff = 0;
+    for (i = 0; i < rsons; i++) {
+      k = (atrans ? i * csons : i);
+      Y1[i] = new_sub_amatrix(Yp,
+			      (atrans ? hm->son[k]->cc->size :
+			       hm->son[k]->rc->size), yoff, Yp->cols, 0);
+
+      yoff += Y1[i]->rows;
+    }
+    assert(yoff == rc->size);
+
+    /* Every thread owns one block row of the target, so the
+       result does not depend on the number of threads */
+#ifdef USE_OPENMP
+    nthreads = rsons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0 && rsons > 1), num_threads(nthreads), private(j, k)
+#endif
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	k = (atrans ? i * csons + j : i + j * rsons);
+	fastaddmul_parallel_hmatrix_amatrix_amatrix(alpha, atrans, hm->son[k],
+						    X1[j], Y1[i],
+						    (pardepth >
+						     0 ? pardepth - 1 : 0));
+      }
+
+    /* Clean up */
+    for (i = 0; i < rsons; i++)
+      del_amatrix(Y1[i]);
+    freemem(Y1);
+    for (j = 0; j < csons; j++)
+      del_amatrix(X1[j]);
+    freemem(X1);
+  }
+}
+
+static void
+addmul_perm_hmatrix_amatrix(field alpha, bool atrans, pchmatrix hm,
+			    pcamatrix X, pamatrix Y)
+{
+  pamatrix  Xp, Yp;
+  pccluster rc, cc;
+  uint      i, j;
+
+  rc = (atrans ? hm->cc : hm->rc);
+  cc = (atrans ? hm->rc : hm->cc);
+
+  assert(X->rows == cc->size);
+  assert(Y->rows == rc->size);
+  assert(X->cols == Y->cols);
+
+  /* Permutation of the rows of X */
+  Xp = new_amatrix(X->rows, X->cols);
+  for (j = 0; j < X->cols; j++)
+    for (i = 0; i < X->rows; i++)
+      Xp->a[i + j * Xp->ld] = X->a[cc->idx[i] + j * X->ld];
+
+  Yp = new_zero_amatrix(Y->rows, Y->cols);
+
+  /* Matrix multiplication, max_pardepth is zero without OpenMP */
+  fastaddmul_parallel_hmatrix_amatrix_amatrix(alpha, atrans, hm, Xp, Yp,
+					      max_pardepth);
+
+  /* Reverse permutation of the rows of Y */
+  for (j = 0; j < Y->cols; j++)
+    for (i = 0; i < Y->rows; i++)
+      Y->a[rc->idx[i] + j * Y->ld] += Yp->a[i + j * Yp->ld];
+
+  del_amatrix(Yp);
+  del_amatrix(Xp);
+}
+
+void
+addeval_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X, pamatrix Y)
+{
+  addmul_perm_hmatrix_amatrix(alpha, false, hm, X, Y);
+}
+
+void
+addevaltrans_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X,
+			     pamatrix Y)
+{
+  addmul_perm_hmatrix_amatrix(alpha, true, hm, X, Y);
+}
+
+void
+mvm_hmatrix_amatrix(field alpha, bool atrans, pchmatrix hm, pcamatrix X,
+		    pamatrix Y)
+{
+  addmul_perm_hmatrix_amatrix(alpha, atrans, hm, X, Y);
+}
+
 /* ------------------------------------------------------------
  Enumeration
  ------------------------------------------------------------ */
@@ -956,6 +1692,38 @@ norm2diff_hmatrix(pchmatrix a, pchmatrix b)
  File I/O
  ------------------------------------------------------------ */
 
+/* Coefficients are written one per line, complex coefficients as
+   real and imaginary part */
+static void
+write_hlib_field(FILE * out, field x)
+{
+#ifdef USE_COMPLEX
+  fprintf(out, "%.16e %.16e\n", REAL(x), IMAG(x));
+#else
+  fprintf(out, "%.16e\n", x);
+#endif
+}
+
+static int
+read_hlib_field(const char *line, pfield x)
+{
+  double    re, im;
+  int       fields;
+
+#ifdef USE_COMPLEX
+  fields = sscanf(line, "%le %le", &re, &im);
+  *x = re + im * I;
+  fields = (fields == 2);
+#else
+  (void) im;
+
+  fields = sscanf(line, "%le", &re);
+  *x = re;
+#endif
+
+  return fields;
+}
+
 static void
 write_hlib_part(pchmatrix G, uint roff, uint coff, FILE * out)
 {
@@ -991,11 +1759,11 @@ write_hlib_part(pchmatrix G, uint roff, uint coff, FILE * out)
 
     for (l = 0; l < k; l++)
       for (i = 0; i < rows; i++)
-	fprintf(out, "%.16e\n", r->A.a[i + lda * l]);
+	write_hlib_field(out, r->A.a[i + lda * l]);
 
     for (l = 0; l < k; l++)
       for (j = 0; j < cols; j++)
-	fprintf(out, "%.16e\n", r->B.a[j + ldb * l]);
+	write_hlib_field(out, r->B.a[j + ldb * l]);
   }
   else if (G->f) {
     f = G->f;
@@ -1012,7 +1780,7 @@ write_hlib_part(pchmatrix G, uint roff, uint coff, FILE * out)
 
     for (j = 0; j < cols; j++)
       for (i = 0; i < rows; i++)
-	fprintf(out, "%.16e\n", f->a[i + ldf * j]);
+	write_hlib_field(out, f->a[i + ldf * j]);
   }
   else {
     assert(G->son != 0);
@@ -1058,6 +1826,8 @@ write_hlib_hmatrix(pchmatrix G, const char *filename)
   fprintf(out, "Beginn der Matrix\n");
   write_hlib_part(G, 0, 0, out);
   fprintf(out, "Ende der Matrix\n");
+
+  fclose(out);
 }
 
 static phmatrix
@@ -1174,7 +1944,7 @@ read_hlib_part(FILE * in, uint roff, uint coff, pcluster *rc,
       for (i = 0; i < rows; i++) {
 	line = fgets(buf, 80, in);
 	(*lineno)++;
-	fields = sscanf(line, "%le", r->A.a + i + l * lda);
+	fields = read_hlib_field(line, r->A.a + i + l * lda);
 	assert(fields == 1);
       }
 
@@ -1183,7 +1953,7 @@ read_hlib_part(FILE * in, uint roff, uint coff, pcluster *rc,
       for (j = 0; j < cols; j++) {
 	line = fgets(buf, 80, in);
 	(*lineno)++;
-	fields = sscanf(line, "%le", r->B.a + j + l * ldb);
+	fields = read_hlib_field(line, r->B.a + j + l * ldb);
 	assert(fields == 1);
       }
     break;
@@ -1199,7 +1969,7 @@ read_hlib_part(FILE * in, uint roff, uint coff, pcluster *rc,
       for (i = 0; i < rows; i++) {
 	line = fgets(buf, 80, in);
 	(*lineno)++;
-	fields = sscanf(line, "%le", f->a + i + j * ldf);
+	fields = read_hlib_field(line, f->a + i + j * ldf);
 	assert(fields == 1);
       }
     break;
@@ -1291,6 +2061,281 @@ read_hlib_hmatrix(const char *filename)
   return G;
 }
 
+/* Sons of a matrix use either the father's cluster or one of its sons */
+static    uint
+son_index(pccluster t, pccluster s)
+{
+  uint      i;
+
+  if (s == t)
+    return 0;
+
+  for (i = 0; i < t->sons && t->son[i] != s; i++);
+  assert(i < t->sons);
+
+  return i + 1;
+}
+
+static    pccluster
+son_cluster(pbinaryfile bf, pccluster t, uint k)
+{
+  if (!check_binaryfile(bf, k <= t->sons))
+    return t;
+
+  return (k == 0 ? t : t->son[k - 1]);
+}
+
+static void
+put_binary_node(pbinaryfile bf, pchmatrix hm)
+{
+  pchmatrix hm1;
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    assert(hm->r->A.rows == hm->rc->size);
+    assert(hm->r->B.rows == hm->cc->size);
+
+    put_uint_binaryfile(bf, 1);
+    put_uint_binaryfile(bf, hm->r->k);
+  }
+  else if (hm->f) {
+    assert(hm->f->rows == hm->rc->size);
+    assert(hm->f->cols == hm->cc->size);
+
+    put_uint_binaryfile(bf, 2);
+  }
+  else if (hm->son) {
+    put_uint_binaryfile(bf, 3);
+    put_uint_binaryfile(bf, rsons);
+    put_uint_binaryfile(bf, csons);
+
+    /* Block rows first, as in freeze_hmatrix */
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++) {
+	hm1 = hm->son[i + j * rsons];
+
+	put_uint_binaryfile(bf, son_index(hm->rc, hm1->rc));
+	put_uint_binaryfile(bf, son_index(hm->cc, hm1->cc));
+	put_binary_node(bf, hm1);
+      }
+  }
+  else
+    put_uint_binaryfile(bf, 0);
+}
+
+void
+put_binary_hmatrix(pbinaryfile bf, pchmatrix hm)
+{
+  uint      leaves;
+  size_t    size;
+
+  leaves = 0;
+  size = 0;
+  count_leaves(hm, true, &leaves, &size);
+
+  put_uint_binaryfile(bf, leaves);
+  put_binary_node(bf, hm);
+}
+
+void
+putdata_binary_hmatrix(pbinaryfile bf, pchmatrix hm)
+{
+  uint      rsons = hm->rsons;
+  uint      csons = hm->csons;
+  uint      i, j;
+
+  if (hm->r) {
+    assert(hm->r->s == NULL);
+    assert(hm->r->c == NULL);
+    put_amatrix_binaryfile(bf, &hm->r->A);
+    put_amatrix_binaryfile(bf, &hm->r->B);
+  }
+  else if (hm->f)
+    put_amatrix_binaryfile(bf, hm->f);
+  else
+    for (i = 0; i < rsons; i++)
+      for (j = 0; j < csons; j++)
+	putdata_binary_hmatrix(bf, hm->son[i + j * rsons]);
+}
+
+static    phmatrix
+get_binary_node(pbinaryfile bf, pccluster rc, pccluster cc, uint roff,
+		uint coff, phmatrixflat flat, size_t base, uint *n)
+{
+  phmatrix  hm, hm1;
+  pccluster rc1, cc1;
+  prkmatrix r;
+  uint      type, k, rsons, csons;
+  uint      ioff, joff, i, j;
+
+  type = get_uint_binaryfile(bf);
+
+  if ((type == 1 || type == 2) && check_binaryfile(bf, *n < flat->leaves)) {
+    flat->leaf[*n] = hm = new_hmatrix(rc, cc);
+    flat->roff[*n] = roff;
+    flat->coff[*n] = coff;
+    flat->doff[*n] = bf->pos - base;
+    (*n)++;
+
+    if (type == 1) {
+      k = get_uint_binaryfile(bf);
+
+      r = (prkmatrix) allocmem(sizeof(rkmatrix));
+      init_pointer_amatrix(&r->A,
+			   get_data_binaryfile(bf, (size_t) rc->size * k),
+			   rc->size, k);
+      init_pointer_amatrix(&r->B,
+			   get_data_binaryfile(bf, (size_t) cc->size * k),
+			   cc->size, k);
+      r->k = k;
+      r->s = NULL;
+      r->cbytes = NULL;
+      r->c = NULL;
+
+      hm->r = r;
+    }
+    else
+      hm->f =
+	new_pointer_amatrix(get_data_binaryfile
+			    (bf, (size_t) rc->size * cc->size), rc->size,
+			    cc->size);
+  }
+  else if (type == 3) {
+    /* Every son needs at least two indices and its type */
+    rsons = get_count_binaryfile(bf, 3 * sizeof(uint));
+    csons = get_count_binaryfile(bf, (size_t) (rsons > 0 ? rsons : 1)
+				 * 3 * sizeof(uint));
+    if (!check_binaryfile(bf, rsons > 0 && csons > 0))
+      rsons = csons = 1;
+
+    hm = new_super_hmatrix(rc, cc, rsons, csons);
+
+    ioff = roff;
+    for (i = 0; i < rsons; i++) {
+      joff = coff;
+      for (j = 0; j < csons; j++) {
+	rc1 = son_cluster(bf, rc, get_uint_binaryfile(bf));
+	cc1 = son_cluster(bf, cc, get_uint_binaryfile(bf));
+
+	hm1 = get_binary_node(bf, rc1, cc1, ioff, joff, flat, base, n);
+	ref_hmatrix(hm->son + i + j * rsons, hm1);
+
+	joff += cc1->size;
+      }
+
+      ioff += hm->son[i]->rc->size;
+    }
+  }
+  else {
+    check_binaryfile(bf, type == 0);
+
+    hm = new_hmatrix(rc, cc);
+  }
+
+  update_hmatrix(hm);
+
+  return hm;
+}
+
+phmatrix
+get_binary_hmatrix(pbinaryfile bf, pccluster rc, pccluster cc)
+{
+  phmatrix  hm;
+  phmatrixflat flat;
+  uint      leaves, n;
+  size_t    base;
+
+  leaves = get_count_binaryfile(bf, sizeof(uint));
+
+  flat = (phmatrixflat) allocmem(sizeof(hmatrixflat));
+  flat->leaves = leaves;
+  flat->leaf = (pchmatrix *) allocmem((size_t) sizeof(pchmatrix) * leaves);
+  flat->roff = allocuint(leaves);
+  flat->coff = allocuint(leaves);
+  flat->doff = (size_t *) allocmem((size_t) sizeof(size_t) * leaves);
+  flat->bin = NULL;
+
+  base = bf->pos;
+
+  n = 0;
+  hm = get_binary_node(bf, rc, cc, 0, 0, flat, base, &n);
+
+  flat->cperm = NULL;
+  if (check_binaryfile(bf, n == leaves)) {
+    flat->cperm = allocuint(leaves);
+    n = 0;
+    transpose_leaves(hm, 0, flat->cperm, &n);
+    assert(n == leaves);
+  }
+
+  /* The coefficients remain in the storage provided by the file */
+  flat->size = bf->pos - base;
+  flat->data = NULL;
+  if (flat->size > 0) {
+    flat->data = bf->store->data + base;
+    ref_binarystore(&flat->bin, bf->store);
+  }
+
+  hm->flat = flat;
+
+  return hm;
+}
+
+bool
+write_binary_hmatrix(pchmatrix hm, const char *filename)
+{
+  pbinaryfile bf;
+
+  bf = new_write_binaryfile(filename, BINARY_HMATRIX);
+  if (bf == NULL)
+    return false;
+
+  put_binary_cluster(bf, hm->rc);
+  put_uint_binaryfile(bf, (hm->rc == hm->cc));
+  if (hm->rc != hm->cc)
+    put_binary_cluster(bf, hm->cc);
+
+  put_binary_hmatrix(bf, hm);
+
+  start_data_binaryfile(bf);
+
+  putdata_binary_hmatrix(bf, hm);
+
+  return del_binaryfile(bf);
+}
+
+phmatrix
+read_binary_hmatrix(const char *filename, bool map)
+{
+  pbinaryfile bf;
+  phmatrix  hm;
+  pcluster  rc, cc;
+
+  bf = new_read_binaryfile(filename, BINARY_HMATRIX, map);
+  if (bf == NULL)
+    return NULL;
+
+  rc = get_binary_cluster(bf);
+  cc = (get_uint_binaryfile(bf) ? rc : get_binary_cluster(bf));
+
+  hm = get_binary_hmatrix(bf, rc, cc);
+
+  if (!del_binaryfile(bf)) {
+    del_hmatrix(hm);
+    if (cc != rc) {
+      freemem(cc->idx);
+      del_cluster(cc);
+    }
+    freemem(rc->idx);
+    del_cluster(rc);
+    return NULL;
+  }
+
+  return hm;
+}
+
 /* ------------------------------------------------------------
  Drawing
  ------------------------------------------------------------ */
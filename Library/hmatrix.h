@@ -27,6 +27,15 @@ typedef hmatrix *phmatrix;
 /** @brief Pointer to constant @ref hmatrix object. */
 typedef const hmatrix *pchmatrix;
 
+/** @brief Contiguous storage of a frozen @ref hmatrix. */
+typedef struct _hmatrixflat hmatrixflat;
+
+/** @brief Pointer to a @ref hmatrixflat object. */
+typedef hmatrixflat *phmatrixflat;
+
+/** @brief Pointer to constant @ref hmatrixflat object. */
+typedef const hmatrixflat *pchmatrixflat;
+
 #ifdef USE_CAIRO
 #include <cairo.h>
 #endif
@@ -67,6 +76,42 @@ struct _hmatrix {
   uint refs;
   /** @brief Number of descendants in matrix tree. */
   uint desc;
+
+  /** @brief Contiguous storage of all leaves, only set in the root
+   *  of a matrix frozen by @ref freeze_hmatrix. */
+  phmatrixflat flat;
+};
+
+/** @brief Contiguous storage and flat leaf list of a frozen
+ *  @ref hmatrix.
+ *
+ *  The coefficients of all leaves are stored in one array in the
+ *  order of the matrix-vector multiplication, so that this
+ *  multiplication can traverse the array linearly. */
+struct _hmatrixflat {
+  /** @brief Coefficients of all leaves. */
+  pfield data;
+  /** @brief Number of coefficients in <tt>data</tt>. */
+  size_t size;
+
+  /** @brief Number of leaves. */
+  uint leaves;
+  /** @brief Leaves in the order of the matrix-vector multiplication. */
+  pchmatrix *leaf;
+  /** @brief Offsets of the leaves' row clusters relative to the root. */
+  uint *roff;
+  /** @brief Offsets of the leaves' column clusters relative to the root. */
+  uint *coff;
+  /** @brief Offsets of the leaves' coefficients in <tt>data</tt>. */
+  size_t *doff;
+
+  /** @brief Indices of the leaves in <tt>leaf</tt>, block column by
+   *  block column, as in the adjoint matrix-vector multiplication. */
+  uint *cperm;
+
+  /** @brief Binary file providing <tt>data</tt> if the matrix has been
+   *  read by @ref read_binary_hmatrix, <tt>NULL</tt> otherwise. */
+  pbinarystore bin;
 };
 
 /* ------------------------------------------------------------
@@ -218,6 +263,135 @@ ref_hmatrix(phmatrix *ptr, phmatrix hm);
 HEADER_PREFIX void
 unref_hmatrix(phmatrix hm);
 
+/* ------------------------------------------------------------
+   Contiguous storage
+   ------------------------------------------------------------ */
+
+/** @brief Move the coefficients of all leaves of an @ref hmatrix into
+ *  one contiguous array.
+ *
+ *  The leaves are arranged block row by block row, i.e., in the order
+ *  used by @ref fastaddeval_frozen_hmatrix_avector and by the parallel
+ *  matrix-vector multiplication, and a flat list of all leaves with
+ *  their offsets is stored in <tt>hm->flat</tt>, together with the
+ *  ordering of the leaves block column by block column used by
+ *  @ref fastaddevaltrans_frozen_hmatrix_avector.
+ *  The array is released together with the matrix by @ref del_hmatrix.
+ *
+ *  @remark The coefficients of a frozen matrix may still be changed,
+ *  but its structure and the ranks of its leaves must not, since
+ *  the leaves no longer own their storage.
+ *
+ *  @param hm Matrix that will be frozen. */
+HEADER_PREFIX void
+freeze_hmatrix(phmatrix hm);
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$ for a frozen matrix.
+ *
+ *  Equivalent to @ref fastaddeval_hmatrix_avector, but traverses the
+ *  flat leaf list created by @ref freeze_hmatrix instead of the tree,
+ *  so the coefficients are read in storage order.
+ *  The block rows are handled in parallel up to @ref max_pardepth, as
+ *  in @ref fastaddeval_parallel_hmatrix_avector, and the leaves below
+ *  are processed in storage order, so the result does not depend on
+ *  the number of threads.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Frozen matrix @f$A@f$.
+ *  @param xp Source vector @f$x@f$ in cluster numbering
+ *            with respect to <tt>hm->cc</tt>.
+ *  @param yp Target vector @f$y@f$ in cluster numbering
+ *            with respect to <tt>hm->rc</tt>. */
+HEADER_PREFIX void
+fastaddeval_frozen_hmatrix_avector(field alpha, pchmatrix hm,
+				   pcavector xp, pavector yp);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$ for a frozen matrix.
+ *
+ *  Equivalent to @ref fastaddevaltrans_hmatrix_avector, but traverses
+ *  the flat leaf list created by @ref freeze_hmatrix block column by
+ *  block column.
+ *  The block columns are handled in parallel up to @ref max_pardepth.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Frozen matrix @f$A@f$.
+ *  @param xp Source vector @f$x@f$ in cluster numbering
+ *            with respect to <tt>hm->rc</tt>.
+ *  @param yp Target vector @f$y@f$ in cluster numbering
+ *            with respect to <tt>hm->cc</tt>. */
+HEADER_PREFIX void
+fastaddevaltrans_frozen_hmatrix_avector(field alpha, pchmatrix hm,
+					pcavector xp, pavector yp);
+
+/* ------------------------------------------------------------
+   Single precision storage
+   ------------------------------------------------------------ */
+
+/** @brief Store the factors of all admissible leaves in single
+ *  precision.
+ *
+ *  Applies @ref tosingle_rkmatrix to all @ref rkmatrix leaves, while
+ *  the nearfield matrices remain in double precision.
+ *  This halves the storage and memory traffic of the farfield, and
+ *  the matrix-vector multiplication promotes the coefficients on the
+ *  fly.
+ *  The relative error introduced in the farfield is of the order of
+ *  the single precision machine accuracy, so this is only advisable
+ *  if the matrix approximation is less accurate anyway.
+ *
+ *  @remark The resulting matrix can only be used for matrix-vector
+ *  multiplications.
+ *  Use @ref todouble_hmatrix before any other operation.
+ *  If the matrix is to be frozen by @ref freeze_hmatrix, this function
+ *  has to be called first.
+ *
+ *  @param hm Target matrix. */
+HEADER_PREFIX void
+tosingle_hmatrix(phmatrix hm);
+
+/** @brief Restore the factors of all admissible leaves from single
+ *  precision.
+ *
+ *  Reverses @ref tosingle_hmatrix.
+ *
+ *  @param hm Target matrix. */
+HEADER_PREFIX void
+todouble_hmatrix(phmatrix hm);
+
+/* ------------------------------------------------------------
+   Adaptive precision storage
+   ------------------------------------------------------------ */
+
+/** @brief Store the factors of all admissible leaves with a precision
+ *  adapted to the singular values.
+ *
+ *  Applies @ref compress_rkmatrix to all @ref rkmatrix leaves, so
+ *  the terms of every block are stored in bfloat16, single or double
+ *  precision depending on their contribution relative to the norm of
+ *  the block.
+ *  The nearfield matrices remain in double precision.
+ *
+ *  @remark The resulting matrix can only be used for matrix-vector
+ *  multiplications.
+ *  Use @ref decompress_hmatrix before any other operation.
+ *  If the matrix is to be frozen by @ref freeze_hmatrix, this function
+ *  has to be called first.
+ *
+ *  @param hm Target matrix.
+ *  @param eps Relative accuracy for every block, usually the accuracy
+ *     used for the approximation of the matrix. */
+HEADER_PREFIX void
+compress_hmatrix(phmatrix hm, real eps);
+
+/** @brief Restore the factors of all admissible leaves compressed by
+ *  @ref compress_hmatrix.
+ *
+ *  @param hm Target matrix. */
+HEADER_PREFIX void
+decompress_hmatrix(phmatrix hm);
+
 /* ------------------------------------------------------------
    Statistics
    ------------------------------------------------------------ */
@@ -317,6 +491,30 @@ mvm_hmatrix_avector(field alpha, bool atrans, pchmatrix a,
 HEADER_PREFIX void
 fastaddeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp, pavector yp);
 
+/** @brief Parallel matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$.
+ *
+ *  The matrix is multiplied by the source vector @f$x@f$, the result
+ *  is scaled by @f$\alpha@f$ and added to the target vector @f$y@f$.
+ *
+ *  The block rows of the matrix are handled in parallel, so every
+ *  thread works on a disjoint part of @f$y@f$ and no synchronization
+ *  is required.
+ *  The contributions to every entry of @f$y@f$ are added in the same
+ *  order as in @ref fastaddeval_hmatrix_avector, so the result does not
+ *  depend on the number of threads.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param xp Source vector @f$x@f$ in cluster numbering
+ *            with respect to <tt>hm->cc</tt>.
+ *  @param yp Target vector @f$y@f$ in cluster numbering
+ *            with respect to <tt>hm->rc</tt>.
+ *  @param pardepth Parallelization depth, typically @ref max_pardepth. */
+HEADER_PREFIX void
+fastaddeval_parallel_hmatrix_avector(field alpha, pchmatrix hm,
+				     pcavector xp, pavector yp, uint pardepth);
+
 /** @brief Matrix-vector multiplication
  *  @f$y \gets y + \alpha A x@f$.
  *
@@ -347,6 +545,28 @@ HEADER_PREFIX void
 fastaddevaltrans_hmatrix_avector(field alpha, pchmatrix hm,
 			 pcavector xp, pavector yp);
 
+/** @brief Parallel adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$.
+ *
+ *  The matrix is multiplied by the source vector @f$x@f$, the result
+ *  is scaled by @f$\alpha@f$ and added to the target vector @f$y@f$.
+ *
+ *  The block columns of the matrix are handled in parallel, so every
+ *  thread works on a disjoint part of @f$y@f$, and the result does not
+ *  depend on the number of threads.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param xp Source vector @f$x@f$ in cluster numbering
+ *            with respect to <tt>hm->rc</tt>.
+ *  @param yp Target vector @f$y@f$ in cluster numbering
+ *            with respect to <tt>hm->cc</tt>.
+ *  @param pardepth Parallelization depth, typically @ref max_pardepth. */
+HEADER_PREFIX void
+fastaddevaltrans_parallel_hmatrix_avector(field alpha, pchmatrix hm,
+					  pcavector xp, pavector yp,
+					  uint pardepth);
+
 /** @brief Adjoint matrix-vector multiplication
  *  @f$y \gets y + \alpha A^* x@f$.
  *
@@ -393,6 +613,75 @@ HEADER_PREFIX void
 addevalsymm_hmatrix_avector(field alpha, pchmatrix hm,
 			    pcavector x, pavector y);
 
+/* ------------------------------------------------------------
+   Multiplication with multiple vectors
+   ------------------------------------------------------------ */
+
+/** @brief Multiplication with multiple vectors in cluster numbering,
+ *  @f$Y \gets Y + \alpha A X@f$ or @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  All columns of @f$X@f$ are handled at once: nearfield blocks are
+ *  multiplied by BLAS level 3 operations, and low-rank blocks
+ *  @f$A B^*@f$ first compute the small matrix @f$B^* X@f$.
+ *  Block rows of the (possibly adjoint) matrix are handled in parallel
+ *  up to the given depth. Since every thread only updates its own rows
+ *  of @f$Y@f$, the result does not depend on the number of threads.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param atrans Set if @f$A^*@f$ is to be used instead of @f$A@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param Xp Source matrix @f$X@f$, rows in cluster numbering
+ *            with respect to <tt>hm->cc</tt> (or <tt>hm->rc</tt>
+ *            if <tt>atrans</tt> is set).
+ *  @param Yp Target matrix @f$Y@f$, rows in cluster numbering
+ *            with respect to <tt>hm->rc</tt> (or <tt>hm->cc</tt>
+ *            if <tt>atrans</tt> is set).
+ *  @param pardepth Parallelization depth, typically @ref max_pardepth. */
+HEADER_PREFIX void
+fastaddmul_parallel_hmatrix_amatrix_amatrix(field alpha, bool atrans,
+					    pchmatrix hm, pcamatrix Xp,
+					    pamatrix Yp, uint pardepth);
+
+/** @brief Multiplication with multiple vectors,
+ *  @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  Matrix version of @ref addeval_hmatrix_avector, the rows of
+ *  @f$X@f$ and @f$Y@f$ use the original numbering of the index sets.
+ *  This function can be used as an <tt>addevalmat_t</tt> callback
+ *  in the block Krylov solvers.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addeval_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X, pamatrix Y);
+
+/** @brief Adjoint multiplication with multiple vectors,
+ *  @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  Matrix version of @ref addevaltrans_hmatrix_avector.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addevaltrans_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X,
+			     pamatrix Y);
+
+/** @brief Multiplication with multiple vectors,
+ *  @f$Y \gets Y + \alpha A X@f$ or @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param atrans Set if @f$A^*@f$ is to be used instead of @f$A@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+mvm_hmatrix_amatrix(field alpha, bool atrans, pchmatrix hm, pcamatrix X,
+		    pamatrix Y);
+
 /* ------------------------------------------------------------
    Enumeration by block number
    ------------------------------------------------------------ */
@@ -476,6 +765,74 @@ write_hlib_hmatrix(pchmatrix G, const char *filename);
 phmatrix
 read_hlib_hmatrix(const char *filename);
 
+/** @brief Write an @f$\mathcal{H}@f$-matrix to a @ref binaryfile.
+ *
+ *  Writes the structure of the matrix and the ranks of its leaves to
+ *  the structure section.
+ *  The cluster trees have to be written separately by
+ *  @ref put_binary_cluster, and the coefficients are written by
+ *  @ref putdata_binary_hmatrix after the data section has been started.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param hm Matrix. */
+HEADER_PREFIX void
+put_binary_hmatrix(pbinaryfile bf, pchmatrix hm);
+
+/** @brief Write the coefficients of an @f$\mathcal{H}@f$-matrix to the
+ *  data section of a @ref binaryfile.
+ *
+ *  The leaves are written in the order used by @ref freeze_hmatrix.
+ *
+ *  @param bf Binary file opened for writing.
+ *  @param hm Matrix. */
+HEADER_PREFIX void
+putdata_binary_hmatrix(pbinaryfile bf, pchmatrix hm);
+
+/** @brief Read an @f$\mathcal{H}@f$-matrix from a @ref binaryfile.
+ *
+ *  The leaves use the coefficients in the data section directly, and
+ *  the matrix is frozen, i.e., its flat leaf list is set up as by
+ *  @ref freeze_hmatrix.
+ *  If the file is damaged, the error flag of <tt>bf</tt> is set and
+ *  the returned matrix should be discarded.
+ *
+ *  @param bf Binary file opened for reading.
+ *  @param rc Row cluster.
+ *  @param cc Column cluster.
+ *  @returns Matrix read from the file. */
+HEADER_PREFIX phmatrix
+get_binary_hmatrix(pbinaryfile bf, pccluster rc, pccluster cc);
+
+/** @brief Write an @f$\mathcal{H}@f$-matrix and its cluster trees into
+ *  a binary file.
+ *
+ *  @param hm Matrix, <tt>hm->rc</tt> and <tt>hm->cc</tt> have to be
+ *     the roots of their cluster trees.
+ *  @param filename Name of the target file.
+ *  @returns <tt>true</tt> if the file has been written successfully. */
+HEADER_PREFIX bool
+write_binary_hmatrix(pchmatrix hm, const char *filename);
+
+/** @brief Read an @f$\mathcal{H}@f$-matrix and its cluster trees from
+ *  a binary file.
+ *
+ *  If <tt>map</tt> is set, the coefficients are mapped into memory
+ *  instead of being read, so they are only loaded from disk when they
+ *  are used, e.g., in the first matrix-vector multiplication.
+ *  Changes to the coefficients are not written back to the file.
+ *
+ *  @remark The cluster trees <tt>hm->rc</tt> and <tt>hm->cc</tt>
+ *  and their index arrays have to be released by the caller.
+ *  If both trees were identical when the file was written,
+ *  <tt>hm->rc</tt> and <tt>hm->cc</tt> point to the same tree.
+ *
+ *  @param filename Name of the source file.
+ *  @param map Set to map the coefficients into memory.
+ *  @returns Matrix read from the file, or <tt>NULL</tt> if the file
+ *     could not be read. */
+HEADER_PREFIX phmatrix
+read_binary_hmatrix(const char *filename, bool map);
+
 /* ------------------------------------------------------------
    Drawing
    ------------------------------------------------------------ */
@@ -55,7 +55,7 @@ evalfunctional_cg(addeval_t addeval,
   (void) addeval;
   (void) matrix;
 
-  return -0.5 * (dotprod_avector(r, x) + dotprod_avector(b, x));
+  return -0.5 * REAL(dotprod_avector(r, x) + dotprod_avector(b, x));
 }
 
 /* ------------------------------------------------------------
@@ -626,3 +626,395 @@ finish_pgmres(addeval_t addeval, void *matrix, prcd_t prcd, void *pdata, pcavect
 
   init_pgmres(addeval, matrix, prcd, pdata, b, x, rhat, q, kk, qr, tau);
 }
+
+/* ------------------------------------------------------------
+   Auxiliary functions for block methods
+   ------------------------------------------------------------ */
+
+/* Replace the first columns of W by an orthonormal basis of its range,
+   dropping directions with singular values below eps times the largest
+   one. If Rc is not null, it receives the coefficients of the original
+   columns with respect to this basis. Returns the dimension of the basis. */
+static uint
+orthonormalize_block(pamatrix W, real eps, pamatrix Rc)
+{
+  amatrix   tmp1, tmp2;
+  pamatrix  Q, R, U, Vt, Uk, Wk;
+  pavector  tau, sigma;
+  uint      n = W->rows;
+  uint      m = W->cols;
+  uint      i, j, k;
+
+  assert(n >= m);
+  assert(Rc == NULL || (Rc->rows >= m && Rc->cols == m));
+
+  if (m == 0)
+    return 0;
+
+  /* W = Q R */
+  tau = new_avector(m);
+  qrdecomp_amatrix(W, tau);
+
+  R = new_zero_amatrix(m, m);
+  copy_upper_amatrix(W, false, R);
+
+  Q = new_amatrix(n, m);
+  qrexpand_amatrix(W, tau, Q);
+
+  /* R = U Sigma V^* */
+  sigma = new_avector(m);
+  U = new_amatrix(m, m);
+  Vt = new_amatrix(m, m);
+  svd_amatrix(R, sigma, U, Vt);
+
+  /* Determine numerical rank */
+  k = 0;
+  while (k < m && REAL(sigma->v[k]) > eps * REAL(sigma->v[0]))
+    k++;
+
+  /* New basis Q U_k */
+  Wk = init_sub_amatrix(&tmp1, W, n, 0, k, 0);
+  Uk = init_sub_amatrix(&tmp2, U, m, 0, k, 0);
+  clear_amatrix(Wk);
+  addmul_amatrix(1.0, false, Q, false, Uk, Wk);
+  uninit_amatrix(Uk);
+  uninit_amatrix(Wk);
+
+  /* Coefficients Sigma_k V_k^* */
+  if (Rc) {
+    clear_amatrix(Rc);
+    for (j = 0; j < m; j++)
+      for (i = 0; i < k; i++)
+	Rc->a[i + j * Rc->ld] = sigma->v[i] * Vt->a[i + j * Vt->ld];
+  }
+
+  del_amatrix(Vt);
+  del_amatrix(U);
+  del_avector(sigma);
+  del_amatrix(Q);
+  del_amatrix(R);
+  del_avector(tau);
+
+  return k;
+}
+
+/* Copy the residual R, setting all columns to zero that satisfy
+   |R_j| <= eps |B_j|. Z and R may coincide. */
+static void
+deflate_block(real eps, pcamatrix B, pcamatrix R, pamatrix Z)
+{
+  avector   tmp1, tmp2;
+  pavector  b, z;
+  uint      j;
+
+  assert(B->rows == R->rows && B->cols == R->cols);
+
+  if (Z != R)
+    copy_amatrix(false, R, Z);
+
+  for (j = 0; j < Z->cols; j++) {
+    b = init_column_avector(&tmp1, (pamatrix) B, j);
+    z = init_column_avector(&tmp2, Z, j);
+
+    if (norm2_avector(z) <= eps * norm2_avector(b))
+      clear_avector(z);
+
+    uninit_avector(z);
+    uninit_avector(b);
+  }
+}
+
+/* ------------------------------------------------------------
+   Block conjugate gradient method
+   ------------------------------------------------------------ */
+
+/* cf. H. Ji, Y. Li, A breakdown-free block conjugate gradient method,
+   BIT Numerical Mathematics 57 (2017) */
+
+void
+init_blockcg(addevalmat_t addeval, void *matrix, real eps, pcamatrix B,	/* Right-hand sides */
+	     pamatrix X,	/* Approximate solutions */
+	     pamatrix R,	/* Residuals B-AX */
+	     pamatrix P,	/* Search directions */
+	     pamatrix AP,	/* Auxiliary matrix */
+	     uint * kk)
+{				/* Number of search directions */
+  assert(X->rows == B->rows && X->cols == B->cols);
+  assert(R->rows == B->rows && R->cols == B->cols);
+  assert(P->rows == B->rows && P->cols == B->cols);
+  assert(AP->rows == B->rows && AP->cols == B->cols);
+
+  (void) AP;
+
+  copy_amatrix(false, B, R);	/* R = B - A X */
+  addeval(-1.0, matrix, X, R);
+
+  deflate_block(eps, B, R, P);	/* P = orth(R) */
+  *kk = orthonormalize_block(P, eps, NULL);
+}
+
+void
+step_blockcg(addevalmat_t addeval, void *matrix, real eps, pcamatrix B,	/* Right-hand sides */
+	     pamatrix X,	/* Approximate solutions */
+	     pamatrix R,	/* Residuals B-AX */
+	     pamatrix P,	/* Search directions */
+	     pamatrix AP,	/* Auxiliary matrix */
+	     uint * kk)
+{				/* Number of search directions */
+  amatrix   tmp1, tmp2;
+  pamatrix  Pk, APk, G, Lambda, Z;
+  uint      n = B->rows;
+  uint      s = B->cols;
+  uint      k = *kk;
+
+  if (k == 0)
+    return;
+
+  Pk = init_sub_amatrix(&tmp1, P, n, 0, k, 0);
+  APk = init_sub_amatrix(&tmp2, AP, n, 0, k, 0);
+
+  clear_amatrix(APk);		/* AP = A P */
+  addeval(1.0, matrix, Pk, APk);
+
+  G = new_zero_amatrix(k, k);	/* G = P^* A P = L L^* */
+  addmul_amatrix(1.0, true, Pk, false, APk, G);
+  if (choldecomp_amatrix(G) != 0) {
+    /* Matrix not positive definite on the search space, stop */
+    *kk = 0;
+  }
+  else {
+    Lambda = new_zero_amatrix(k, s);	/* Lambda = G^{-1} P^* R */
+    addmul_amatrix(1.0, true, Pk, false, R, Lambda);
+    triangularsolve_amatrix(true, false, false, G, false, Lambda);
+    triangularsolve_amatrix(true, false, true, G, false, Lambda);
+
+    addmul_amatrix(1.0, false, Pk, false, Lambda, X);	/* X = X + P Lambda */
+    addmul_amatrix(-1.0, false, APk, false, Lambda, R);	/* R = R - A P Lambda */
+
+    /* Columns that have converged do not contribute new directions */
+    Z = new_amatrix(n, s);
+    deflate_block(eps, B, R, Z);
+
+    clear_amatrix(Lambda);	/* Z = Z - P G^{-1} (A P)^* Z */
+    addmul_amatrix(1.0, true, APk, false, Z, Lambda);
+    triangularsolve_amatrix(true, false, false, G, false, Lambda);
+    triangularsolve_amatrix(true, false, true, G, false, Lambda);
+    addmul_amatrix(-1.0, false, Pk, false, Lambda, Z);
+
+    copy_amatrix(false, Z, P);	/* P = orth(Z) */
+    *kk = orthonormalize_block(P, eps, NULL);
+
+    del_amatrix(Z);
+    del_amatrix(Lambda);
+  }
+
+  del_amatrix(G);
+  uninit_amatrix(APk);
+  uninit_amatrix(Pk);
+}
+
+/* ------------------------------------------------------------
+   Block generalized minimal residual method
+   ------------------------------------------------------------ */
+
+void
+init_blockgmres(addevalmat_t addeval, void *matrix, real eps, pcamatrix B,	/* Right-hand sides */
+		pamatrix X,	/* Approximate solutions */
+		pamatrix V,	/* Block Arnoldi basis */
+		pamatrix H,	/* Block Hessenberg matrix */
+		pamatrix C,	/* Coefficients of initial residuals */
+		uint * kk,	/* Dimension of Krylov space */
+		uint * ll)
+{				/* Size of the current block */
+  amatrix   tmp1, tmp2;
+  pamatrix  R, Rl, Vl, Cl;
+  uint      n = B->rows;
+  uint      s = B->cols;
+  uint      l;
+
+  assert(X->rows == n && X->cols == s);
+  assert(V->rows == n && V->cols >= s);
+  assert(H->rows == V->cols && H->cols == V->cols);
+  assert(C->rows == V->cols && C->cols == s);
+
+  R = new_amatrix(n, s);	/* R = B - A X */
+  copy_amatrix(false, B, R);
+  addeval(-1.0, matrix, X, R);
+
+  /* R = V_l C_l, dropping columns that have already converged */
+  deflate_block(eps, B, R, R);
+  clear_amatrix(C);
+  Cl = init_sub_amatrix(&tmp1, C, s, 0, s, 0);
+  l = orthonormalize_block(R, eps, Cl);
+  uninit_amatrix(Cl);
+
+  Rl = init_sub_amatrix(&tmp1, R, n, 0, l, 0);
+  Vl = init_sub_amatrix(&tmp2, V, n, 0, l, 0);
+  copy_amatrix(false, Rl, Vl);
+  uninit_amatrix(Vl);
+  uninit_amatrix(Rl);
+
+  clear_amatrix(H);
+
+  *kk = 0;
+  *ll = l;
+
+  del_amatrix(R);
+}
+
+void
+step_blockgmres(addevalmat_t addeval, void *matrix, real eps, pcamatrix B,	/* Right-hand sides */
+		pamatrix X,	/* Approximate solutions */
+		pamatrix V,	/* Block Arnoldi basis */
+		pamatrix H,	/* Block Hessenberg matrix */
+		pamatrix C,	/* Coefficients of initial residuals */
+		uint * kk,	/* Dimension of Krylov space */
+		uint * ll)
+{				/* Size of the current block */
+  amatrix   tmp1, tmp2, tmp3, tmp4;
+  pamatrix  Vk, Vl, W, Hw, Hl, Rc, Rl;
+  uint      n = V->rows;
+  uint      k = *kk;
+  uint      l = *ll;
+  uint      i, lnew;
+
+  (void) B;
+  (void) X;
+  (void) C;
+
+  if (l == 0 || k + 2 * l > V->cols)
+    return;
+
+  /* W = A V_l in the next l columns of V */
+  Vl = init_sub_amatrix(&tmp1, V, n, 0, l, k);
+  W = init_sub_amatrix(&tmp2, V, n, 0, l, k + l);
+  clear_amatrix(W);
+  addeval(1.0, matrix, Vl, W);
+  uninit_amatrix(Vl);
+
+  /* Block Gram-Schmidt with reorthogonalization */
+  Vk = init_sub_amatrix(&tmp1, V, n, 0, k + l, 0);
+  Hl = init_sub_amatrix(&tmp3, H, k + l, 0, l, k);
+  Hw = new_amatrix(k + l, l);
+  for (i = 0; i < 2; i++) {
+    clear_amatrix(Hw);
+    addmul_amatrix(1.0, true, Vk, false, W, Hw);
+    addmul_amatrix(-1.0, false, Vk, false, Hw, W);
+    add_amatrix(1.0, false, Hw, Hl);
+  }
+  del_amatrix(Hw);
+  uninit_amatrix(Hl);
+  uninit_amatrix(Vk);
+
+  /* W = V_new R_c, deflating linearly dependent directions */
+  Rc = new_amatrix(l, l);
+  lnew = orthonormalize_block(W, eps, Rc);
+  uninit_amatrix(W);
+
+  Hl = init_sub_amatrix(&tmp3, H, lnew, k + l, l, k);
+  Rl = init_sub_amatrix(&tmp4, Rc, lnew, 0, l, 0);
+  copy_amatrix(false, Rl, Hl);
+  uninit_amatrix(Rl);
+  uninit_amatrix(Hl);
+  del_amatrix(Rc);
+
+  *kk = k + l;
+  *ll = lnew;
+}
+
+/* Solve the least-squares problem min |C - H Y|, returns the
+   QR factorization of H in Hq and tau and Q^* C in Cq. */
+static void
+lsq_blockgmres(pcamatrix H, pcamatrix C, uint k, uint l,
+	       pamatrix Hq, pavector tau, pamatrix Cq)
+{
+  amatrix   tmp;
+  pamatrix  Hk;
+
+  Hk = init_sub_amatrix(&tmp, (pamatrix) H, k + l, 0, k, 0);
+  copy_amatrix(false, Hk, Hq);
+  uninit_amatrix(Hk);
+
+  Hk = init_sub_amatrix(&tmp, (pamatrix) C, k + l, 0, C->cols, 0);
+  copy_amatrix(false, Hk, Cq);
+  uninit_amatrix(Hk);
+
+  if (k > 0) {
+    qrdecomp_amatrix(Hq, tau);
+    qreval_amatrix(true, Hq, tau, Cq);
+  }
+}
+
+void
+residualnorms_blockgmres(pcamatrix H, pcamatrix C, uint kk, uint ll,
+			 pavector norms)
+{
+  avector   tmp;
+  amatrix   tmp2;
+  pamatrix  Hq, Cq, Cr;
+  pavector  tau, c;
+  uint      j;
+
+  assert(norms->dim == C->cols);
+
+  Hq = new_amatrix(kk + ll, kk);
+  Cq = new_amatrix(kk + ll, C->cols);
+  tau = new_avector(kk);
+
+  lsq_blockgmres(H, C, kk, ll, Hq, tau, Cq);
+
+  /* The last ll rows of Q^* C cannot be matched */
+  Cr = init_sub_amatrix(&tmp2, Cq, ll, kk, C->cols, 0);
+  for (j = 0; j < C->cols; j++) {
+    c = init_column_avector(&tmp, Cr, j);
+    norms->v[j] = norm2_avector(c);
+    uninit_avector(c);
+  }
+  uninit_amatrix(Cr);
+
+  del_avector(tau);
+  del_amatrix(Cq);
+  del_amatrix(Hq);
+}
+
+void
+finish_blockgmres(addevalmat_t addeval, void *matrix, real eps, pcamatrix B,	/* Right-hand sides */
+		  pamatrix X,	/* Approximate solutions */
+		  pamatrix V,	/* Block Arnoldi basis */
+		  pamatrix H,	/* Block Hessenberg matrix */
+		  pamatrix C,	/* Coefficients of initial residuals */
+		  uint * kk,	/* Dimension of Krylov space */
+		  uint * ll)
+{				/* Size of the current block */
+  amatrix   tmp1, tmp2;
+  pamatrix  Hq, Cq, Hk, Y, Vk;
+  pavector  tau;
+  uint      k = *kk;
+  uint      l = *ll;
+
+  if (k > 0) {
+    Hq = new_amatrix(k + l, k);
+    Cq = new_amatrix(k + l, C->cols);
+    tau = new_avector(k);
+
+    lsq_blockgmres(H, C, k, l, Hq, tau, Cq);
+
+    /* Y = R^{-1} (Q^* C)_k */
+    Hk = init_sub_amatrix(&tmp1, Hq, k, 0, k, 0);
+    Y = init_sub_amatrix(&tmp2, Cq, k, 0, C->cols, 0);
+    triangularsolve_amatrix(false, false, false, Hk, false, Y);
+    uninit_amatrix(Hk);
+
+    /* X = X + V_k Y */
+    Vk = init_sub_amatrix(&tmp1, V, V->rows, 0, k, 0);
+    addmul_amatrix(1.0, false, Vk, false, Y, X);
+    uninit_amatrix(Vk);
+    uninit_amatrix(Y);
+
+    del_avector(tau);
+    del_amatrix(Cq);
+    del_amatrix(Hq);
+  }
+
+  init_blockgmres(addeval, matrix, eps, B, X, V, H, C, kk, ll);
+}
@@ -14,6 +14,7 @@
 #include "settings.h"
 #include "avector.h"
 #include "factorizations.h"
+#include "eigensolvers.h"
 
 /** @defgroup krylov krylov
  *  @brief Iterative solvers of Krylov type
@@ -38,6 +39,24 @@
 typedef void (*addeval_t)(field alpha, void *matrix,
 			  pcavector x, pavector y);
 
+/** @brief Matrix callback for multiple vectors.
+ *
+ *  Used to evaluate the system matrix @f$A@f$ or its adjoint for a
+ *  block of vectors, i.e., to perform @f$Y \gets Y + \alpha A X@f$.
+ *  This allows block Krylov methods to use BLAS level 3 operations
+ *  and to read the matrix only once for all columns.
+ *
+ *  Functions like @ref addeval_hmatrix_amatrix,
+ *  @ref addevaltrans_hmatrix_amatrix, @ref addeval_h2matrix_amatrix or
+ *  @ref addevaltrans_h2matrix_amatrix can be cast to <tt>addevalmat_t</tt>.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param matrix Matrix data describing @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+typedef void (*addevalmat_t)(field alpha, void *matrix,
+			     pcamatrix X, pamatrix Y);
+
 /** @brief Preconditioner callback.
  *
  *  Used to apply a precondtioner to a vector, i.e., to perform
@@ -484,6 +503,181 @@ finish_pgmres(addeval_t addeval,
 	      pavector rhat, pavector q,
 	      uint *kk, pamatrix qr, pavector tau);
 
+/* ------------------------------------------------------------
+   Block conjugate gradient method
+   ------------------------------------------------------------ */
+
+/** @brief Initialize a block conjugate gradient method to solve
+ *  @f$A X = B@f$ for several right-hand sides simultaneously.
+ *
+ *  The matrix @f$A@f$ has to be self-adjoint and positive definite.
+ *  All columns share one Krylov space, so every step requires only
+ *  one evaluation of <tt>addeval</tt> for a block of vectors.
+ *
+ *  The search directions are kept orthonormal and linearly dependent
+ *  directions are dropped. Columns with
+ *  @f$\|r_j\|_2 \leq \epsilon \|b_j\|_2@f$ are considered converged and
+ *  no longer contribute search directions, so the block size shrinks
+ *  as the iteration proceeds.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param eps Relative accuracy used for deflation.
+ *  @param B Right-hand sides.
+ *  @param X Approximate solutions.
+ *  @param R Residuals @f$B-AX@f$.
+ *  @param P Search directions, only the first <tt>*kk</tt> columns
+ *         are used.
+ *  @param AP Auxiliary matrix, same size as <tt>B</tt>.
+ *  @param kk Number of search directions. If it is zero, all columns
+ *         have converged. */
+HEADER_PREFIX void
+init_blockcg(addevalmat_t addeval,
+	     void *matrix,
+	     real eps,
+	     pcamatrix B,	/* Right-hand sides */
+	     pamatrix X,	/* Approximate solutions */
+	     pamatrix R,	/* Residuals B-AX */
+	     pamatrix P,	/* Search directions */
+	     pamatrix AP,	/* Auxiliary matrix */
+	     uint *kk);
+
+/** @brief One step of a block conjugate gradient method.
+ *
+ *  If <tt>*kk</tt> is zero, the function returns immediately.
+ *  It is also set to zero if @f$P^* A P@f$ turns out not to be
+ *  positive definite.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param eps Relative accuracy used for deflation.
+ *  @param B Right-hand sides.
+ *  @param X Approximate solutions.
+ *  @param R Residuals @f$B-AX@f$.
+ *  @param P Search directions.
+ *  @param AP Auxiliary matrix.
+ *  @param kk Number of search directions. */
+HEADER_PREFIX void
+step_blockcg(addevalmat_t addeval,
+	     void *matrix,
+	     real eps,
+	     pcamatrix B,	/* Right-hand sides */
+	     pamatrix X,	/* Approximate solutions */
+	     pamatrix R,	/* Residuals B-AX */
+	     pamatrix P,	/* Search directions */
+	     pamatrix AP,	/* Auxiliary matrix */
+	     uint *kk);
+
+/* ------------------------------------------------------------
+   Block generalized minimal residual method
+   ------------------------------------------------------------ */
+
+/** @brief Initialize block GMRES to solve @f$A X = B@f$ for
+ *  several right-hand sides simultaneously.
+ *
+ *  The block Arnoldi basis @f$V@f$ is constructed by block Gram-Schmidt
+ *  orthogonalization with reorthogonalization, and
+ *  @f$A V_k = V_{k+l} H_{k+l,k}@f$ holds for the block Hessenberg
+ *  matrix @f$H@f$.
+ *  Converged columns of the initial residual and directions with
+ *  singular values below @f$\epsilon@f$ times the largest one are
+ *  deflated, so the size <tt>*ll</tt> of the current block may
+ *  shrink during the iteration.
+ *
+ *  The maximal dimension of the Krylov space is determined by the
+ *  number of columns of <tt>V</tt>.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param eps Relative accuracy used for deflation.
+ *  @param B Right-hand sides.
+ *  @param X Initial guesses, will eventually be replaced by improved
+ *         approximations.
+ *  @param V Block Arnoldi basis, at least <tt>B->cols</tt> columns.
+ *  @param H Block Hessenberg matrix, <tt>V->cols</tt> rows and columns.
+ *  @param C Coefficients of the initial residuals with respect to
+ *         the Arnoldi basis, <tt>V->cols</tt> rows and <tt>B->cols</tt>
+ *         columns.
+ *  @param kk Pointer to current dimension of the Krylov space.
+ *  @param ll Pointer to size of the current block. */
+HEADER_PREFIX void
+init_blockgmres(addevalmat_t addeval,
+		void *matrix,
+		real eps,
+		pcamatrix B, pamatrix X,
+		pamatrix V, pamatrix H, pamatrix C,
+		uint *kk, uint *ll);
+
+/** @brief One step of block GMRES.
+ *
+ *  If <tt>*kk+2*(*ll) > V->cols</tt>, there is no room for the next
+ *  block and the function returns immediately.
+ *  It can be restarted using @ref finish_blockgmres.
+ *  If <tt>*ll</tt> is zero, the Krylov space is invariant and
+ *  the function also returns immediately.
+ *
+ *  Like @ref step_gmres, this function does not update <tt>X</tt>.
+ *  The residual norms can be obtained by @ref residualnorms_blockgmres,
+ *  the improved solutions by @ref finish_blockgmres.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param eps Relative accuracy used for deflation.
+ *  @param B Right-hand sides.
+ *  @param X Approximate solutions.
+ *  @param V Block Arnoldi basis.
+ *  @param H Block Hessenberg matrix.
+ *  @param C Coefficients of the initial residuals.
+ *  @param kk Pointer to current dimension of the Krylov space.
+ *  @param ll Pointer to size of the current block. */
+HEADER_PREFIX void
+step_blockgmres(addevalmat_t addeval,
+		void *matrix,
+		real eps,
+		pcamatrix B, pamatrix X,
+		pamatrix V, pamatrix H, pamatrix C,
+		uint *kk, uint *ll);
+
+/** @brief Compute the residual norms of block GMRES.
+ *
+ *  Solves the least-squares problems @f$\min \|C - H Y\|@f$ and returns
+ *  the Euclidean norms of the residuals @f$B - A (X + V_k Y)@f$ up to
+ *  the deflated directions.
+ *
+ *  @param H Block Hessenberg matrix.
+ *  @param C Coefficients of the initial residuals.
+ *  @param kk Current dimension of the Krylov space.
+ *  @param ll Size of the current block.
+ *  @param norms Target vector of dimension <tt>C->cols</tt>, will be
+ *         filled with the residual norms of all columns. */
+HEADER_PREFIX void
+residualnorms_blockgmres(pcamatrix H, pcamatrix C, uint kk, uint ll,
+			 pavector norms);
+
+/** @brief Completes or restarts block GMRES.
+ *
+ *  Solves the least-squares problems @f$\min \|C - H Y\|@f$, performs
+ *  the update @f$X \gets X + V_k Y@f$ and calls @ref init_blockgmres
+ *  to prepare for a restart.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param eps Relative accuracy used for deflation.
+ *  @param B Right-hand sides.
+ *  @param X Approximate solutions.
+ *  @param V Block Arnoldi basis.
+ *  @param H Block Hessenberg matrix.
+ *  @param C Coefficients of the initial residuals.
+ *  @param kk Pointer to current dimension of the Krylov space.
+ *  @param ll Pointer to size of the current block. */
+HEADER_PREFIX void
+finish_blockgmres(addevalmat_t addeval,
+		  void *matrix,
+		  real eps,
+		  pcamatrix B, pamatrix X,
+		  pamatrix V, pamatrix H, pamatrix C,
+		  uint *kk, uint *ll);
+
 /** @} */
 
 #endif
@@ -10,6 +10,9 @@
  */
 
 /* C STD LIBRARY */
+#ifdef USE_SIMD
+#include <immintrin.h>
+#endif
 /* CORE 0 */
 #include "basic.h"
 #include "parameters.h"
@@ -27,6 +30,256 @@
  * */
 #define KERNEL_CONST_BEM3D 0.0795774715459476679
 
+/* ------------------------------------------------------------
+ * Quadrature for the nearfield
+ * ------------------------------------------------------------ */
+
+/*
+ * If USE_SIMD is defined, the quadrature loops for constant basis
+ * functions use AVX-512 or AVX vectors, depending on the instruction
+ * sets enabled by the compiler, e.g., by -march=native.
+ * The remaining quadrature points are handled by the scalar code.
+ */
+
+#if defined(USE_SIMD) && defined(__AVX512F__)
+#define SIMD_WIDTH 8
+typedef __m512d vreal;
+#define vset1_real(x) _mm512_set1_pd(x)
+#define vload_real(p) _mm512_loadu_pd(p)
+#define vadd_real(x, y) _mm512_add_pd(x, y)
+#define vsub_real(x, y) _mm512_sub_pd(x, y)
+#define vmul_real(x, y) _mm512_mul_pd(x, y)
+#define vsum_real(x) _mm512_reduce_add_pd(x)
+
+/* Approximation with relative error below 2^-14, improved by two
+ * Newton steps to full double precision */
+INLINE_PREFIX vreal
+vrsqrt_real(vreal x)
+{
+  vreal     y, h;
+
+  y = _mm512_rsqrt14_pd(x);
+  h = vmul_real(vset1_real(0.5), x);
+  y = vmul_real(y, vsub_real(vset1_real(1.5), vmul_real(h, vmul_real(y, y))));
+  y = vmul_real(y, vsub_real(vset1_real(1.5), vmul_real(h, vmul_real(y, y))));
+
+  return y;
+}
+#elif defined(USE_SIMD) && defined(__AVX__)
+#define SIMD_WIDTH 4
+typedef __m256d vreal;
+#define vset1_real(x) _mm256_set1_pd(x)
+#define vload_real(p) _mm256_loadu_pd(p)
+#define vadd_real(x, y) _mm256_add_pd(x, y)
+#define vsub_real(x, y) _mm256_sub_pd(x, y)
+#define vmul_real(x, y) _mm256_mul_pd(x, y)
+
+/* AVX has no double precision reciprocal square root */
+INLINE_PREFIX vreal
+vrsqrt_real(vreal x)
+{
+  return _mm256_div_pd(vset1_real(1.0), _mm256_sqrt_pd(x));
+}
+
+INLINE_PREFIX real
+vsum_real(vreal x)
+{
+  __m128d   lo, hi;
+
+  lo = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+  hi = _mm_unpackhi_pd(lo, lo);
+
+  return _mm_cvtsd_f64(_mm_add_sd(lo, hi));
+}
+#endif
+
+#ifdef SIMD_WIDTH
+/* Differences x_q - y_q for SIMD_WIDTH quadrature points starting
+ * with q, where x_q lies in the triangle (A_t, B_t, C_t) and y_q in
+ * the triangle (A_s, B_s, C_s) */
+INLINE_PREFIX void
+vdiff_laplacebem3d(const real * xq, const real * yq, uint nq, uint q,
+		   const real * A_t, const real * B_t, const real * C_t,
+		   const real * A_s, const real * B_s, const real * C_s,
+		   vreal * dx, vreal * dy, vreal * dz)
+{
+  vreal     tx, sx, ty, sy, Ax, Bx, Cx, Ay, By, Cy, xt, ys;
+  vreal     d[3];
+  uint      i;
+
+  tx = vload_real(xq + q);
+  sx = vload_real(xq + q + nq);
+  ty = vload_real(yq + q);
+  sy = vload_real(yq + q + nq);
+  Ax = vsub_real(vset1_real(1.0), tx);
+  Bx = vsub_real(tx, sx);
+  Cx = sx;
+  Ay = vsub_real(vset1_real(1.0), ty);
+  By = vsub_real(ty, sy);
+  Cy = sy;
+
+  for (i = 0; i < 3; i++) {
+    xt = vadd_real(vadd_real(vmul_real(vset1_real(A_t[i]), Ax),
+			     vmul_real(vset1_real(B_t[i]), Bx)),
+		   vmul_real(vset1_real(C_t[i]), Cx));
+    ys = vadd_real(vadd_real(vmul_real(vset1_real(A_s[i]), Ay),
+			     vmul_real(vset1_real(B_s[i]), By)),
+		   vmul_real(vset1_real(C_s[i]), Cy));
+    d[i] = vsub_real(xt, ys);
+  }
+
+  *dx = d[0];
+  *dy = d[1];
+  *dz = d[2];
+}
+
+/* Set by set_simd_laplacebem3d to use the scalar loops only */
+static bool scalar_laplacebem3d;
+#endif
+
+bool
+set_simd_laplacebem3d(bool simd)
+{
+#ifdef SIMD_WIDTH
+  scalar_laplacebem3d = !simd;
+
+  return true;
+#else
+  (void) simd;
+
+  return false;
+#endif
+}
+
+/* Add the quadrature approximation of the single layer kernel
+ * 1 / |x-y| for two triangles to sum */
+INLINE_PREFIX field
+slp_quadrature_laplacebem3d(const real * xq, const real * yq,
+			    const real * wq, uint nq, const real * A_t,
+			    const real * B_t, const real * C_t,
+			    const real * A_s, const real * B_s,
+			    const real * C_s, field sum)
+{
+  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, dx, dy, dz;
+  uint      q;
+#ifdef SIMD_WIDTH
+  vreal     vdx, vdy, vdz, vr, vsum;
+#endif
+
+  q = 0;
+
+#ifdef SIMD_WIDTH
+  if (!scalar_laplacebem3d) {
+    vsum = vset1_real(0.0);
+    for (; q + SIMD_WIDTH <= nq; q += SIMD_WIDTH) {
+      vdiff_laplacebem3d(xq, yq, nq, q, A_t, B_t, C_t, A_s, B_s, C_s,
+			 &vdx, &vdy, &vdz);
+
+      vr = vrsqrt_real(vadd_real(vadd_real(vmul_real(vdx, vdx),
+					   vmul_real(vdy, vdy)),
+				 vmul_real(vdz, vdz)));
+
+      vsum = vadd_real(vsum, vmul_real(vload_real(wq + q), vr));
+    }
+    sum += vsum_real(vsum);
+  }
+#endif
+
+  for (; q < nq; ++q) {
+    tx = xq[q];
+    sx = xq[q + nq];
+    ty = yq[q];
+    sy = yq[q + nq];
+    Ax = 1.0 - tx;
+    Bx = tx - sx;
+    Cx = sx;
+    Ay = 1.0 - ty;
+    By = ty - sy;
+    Cy = sy;
+
+    dx = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx
+      - (A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy);
+    dy = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx
+      - (A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy);
+    dz = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx
+      - (A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy);
+
+    sum += wq[q] / REAL_SQRT(dx * dx + dy * dy + dz * dz);
+  }
+
+  return sum;
+}
+
+/* Add the quadrature approximation of the double layer kernel
+ * <x-y, n> / |x-y|^3 for two triangles to sum */
+INLINE_PREFIX field
+dlp_quadrature_laplacebem3d(const real * xq, const real * yq,
+			    const real * wq, uint nq, const real * A_t,
+			    const real * B_t, const real * C_t,
+			    const real * A_s, const real * B_s,
+			    const real * C_s, const real * ns, field sum)
+{
+  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, dx, dy, dz, norm;
+  uint      q;
+#ifdef SIMD_WIDTH
+  vreal     vdx, vdy, vdz, vr, vn, vsum, n0, n1, n2;
+#endif
+
+  q = 0;
+
+#ifdef SIMD_WIDTH
+  if (!scalar_laplacebem3d) {
+    n0 = vset1_real(ns[0]);
+    n1 = vset1_real(ns[1]);
+    n2 = vset1_real(ns[2]);
+
+    vsum = vset1_real(0.0);
+    for (; q + SIMD_WIDTH <= nq; q += SIMD_WIDTH) {
+      vdiff_laplacebem3d(xq, yq, nq, q, A_t, B_t, C_t, A_s, B_s, C_s,
+			 &vdx, &vdy, &vdz);
+
+      vr = vrsqrt_real(vadd_real(vadd_real(vmul_real(vdx, vdx),
+					   vmul_real(vdy, vdy)),
+				 vmul_real(vdz, vdz)));
+
+      vn = vadd_real(vadd_real(vmul_real(vdx, n0), vmul_real(vdy, n1)),
+		     vmul_real(vdz, n2));
+
+      vsum = vadd_real(vsum, vmul_real(vmul_real(vload_real(wq + q), vn),
+				       vmul_real(vr, vmul_real(vr, vr))));
+    }
+    sum += vsum_real(vsum);
+  }
+#endif
+
+  for (; q < nq; ++q) {
+    tx = xq[q];
+    sx = xq[q + nq];
+    ty = yq[q];
+    sy = yq[q + nq];
+    Ax = 1.0 - tx;
+    Bx = tx - sx;
+    Cx = sx;
+    Ay = 1.0 - ty;
+    By = ty - sy;
+    Cy = sy;
+
+    dx = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx
+      - (A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy);
+    dy = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx
+      - (A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy);
+    dz = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx
+      - (A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy);
+
+    norm = dx * dx + dy * dy + dz * dz;
+
+    sum += wq[q] * (dx * ns[0] + dy * ns[1] + dz * ns[2])
+      / (norm * REAL_SQRT(norm));
+  }
+
+  return sum;
+}
+
 static void
 fill_slp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 			 pcbem3d bem, bool ntrans, pamatrix N)
@@ -44,10 +297,10 @@ fill_slp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
   const uint *tri_t, *tri_s;
   real     *xq, *yq, *wq;
   uint      tp[3], sp[3];
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, dx, dy, dz, factor,
-    factor2;
+  real      factor, factor2;
   field     sum;
-  uint      q, nq, ss, tt, s, t;
+  real      base;
+  uint      nq, ss, tt, s, t;
 
   if (ntrans == true) {
     for (t = 0; t < cols; ++t) {
@@ -59,8 +312,9 @@ fill_slp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	tri_s = gr_t[ss];
 	factor2 = factor * gr_g[ss];
 
-	select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				     &wq, &nq, &sum);
+	select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss, tri_t,
+					    tri_s, tp, sp, &xq, &yq, &wq, &nq,
+					    &base);
 	wq += 9 * nq;
 
 	A_t = gr_x[tri_t[tp[0]]];
@@ -70,27 +324,8 @@ fill_slp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	B_s = gr_x[tri_s[sp[1]]];
 	C_s = gr_x[tri_s[sp[2]]];
 
-	for (q = 0; q < nq; ++q) {
-	  tx = xq[q];
-	  sx = xq[q + nq];
-	  ty = yq[q];
-	  sy = yq[q + nq];
-	  Ax = 1.0 - tx;
-	  Bx = tx - sx;
-	  Cx = sx;
-	  Ay = 1.0 - ty;
-	  By = ty - sy;
-	  Cy = sy;
-
-	  dx = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx
-	    - (A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy);
-	  dy = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx
-	    - (A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy);
-	  dz = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx
-	    - (A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy);
-
-	  sum += wq[q] / REAL_SQRT(dx * dx + dy * dy + dz * dz);
-	}
+	sum = slp_quadrature_laplacebem3d(xq, yq, wq, nq, A_t, B_t, C_t, A_s,
+					  B_s, C_s, base);
 
 	aa[s + t * ld] = sum * factor2;
       }
@@ -107,8 +342,9 @@ fill_slp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	tri_t = gr_t[tt];
 	factor2 = factor * gr_g[tt];
 
-	select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				     &wq, &nq, &sum);
+	select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss, tri_t,
+					    tri_s, tp, sp, &xq, &yq, &wq, &nq,
+					    &base);
 	wq += 9 * nq;
 
 	A_t = gr_x[tri_t[tp[0]]];
@@ -118,27 +354,8 @@ fill_slp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	B_s = gr_x[tri_s[sp[1]]];
 	C_s = gr_x[tri_s[sp[2]]];
 
-	for (q = 0; q < nq; ++q) {
-	  tx = xq[q];
-	  sx = xq[q + nq];
-	  ty = yq[q];
-	  sy = yq[q + nq];
-	  Ax = 1.0 - tx;
-	  Bx = tx - sx;
-	  Cx = sx;
-	  Ay = 1.0 - ty;
-	  By = ty - sy;
-	  Cy = sy;
-
-	  dx = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx
-	    - (A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy);
-	  dy = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx
-	    - (A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy);
-	  dz = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx
-	    - (A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy);
-
-	  sum += wq[q] / REAL_SQRT(dx * dx + dy * dy + dz * dz);
-	}
+	sum = slp_quadrature_laplacebem3d(xq, yq, wq, nq, A_t, B_t, C_t, A_s,
+					  B_s, C_s, base);
 
 	aa[t + s * ld] = sum * factor2;
       }
@@ -164,10 +381,10 @@ fill_dlp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
   const uint *tri_t, *tri_s;
   real     *xq, *yq, *wq;
   uint      tp[3], sp[3];
-  real      norm, dx, dy, dz, Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, factor,
-    factor2;
+  real      factor, factor2;
   field     res;
-  uint      q, tt, ss, nq, t, s;
+  real      base;
+  uint      tt, ss, nq, t, s;
 
   if (ntrans == true) {
     for (t = 0; t < cols; ++t) {
@@ -188,8 +405,10 @@ fill_dlp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	}
 	else {
 
-	  (void) select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp,
-					      &xq, &yq, &wq, &nq, &res);
+	  (void) select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt,
+						     ss, tri_t, tri_s, tp, sp,
+						     &xq, &yq, &wq, &nq,
+						     &base);
 	  wq += 9 * nq;
 
 	  A_t = gr_x[tri_t[tp[0]]];
@@ -199,30 +418,8 @@ fill_dlp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	  B_s = gr_x[tri_s[sp[1]]];
 	  C_s = gr_x[tri_s[sp[2]]];
 
-	  for (q = 0; q < nq; ++q) {
-	    tx = xq[q];
-	    sx = xq[q + nq];
-	    ty = yq[q];
-	    sy = yq[q + nq];
-	    Ax = 1.0 - tx;
-	    Bx = tx - sx;
-	    Cx = sx;
-	    Ay = 1.0 - ty;
-	    By = ty - sy;
-	    Cy = sy;
-
-	    dx = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx
-	      - (A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy);
-	    dy = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx
-	      - (A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy);
-	    dz = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx
-	      - (A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy);
-
-	    norm = dx * dx + dy * dy + dz * dz;
-
-	    res += wq[q] * (dx * ns[0] + dy * ns[1] + dz * ns[2])
-	      / (norm * REAL_SQRT(norm));
-	  }
+	  res = dlp_quadrature_laplacebem3d(xq, yq, wq, nq, A_t, B_t, C_t, A_s,
+					    B_s, C_s, ns, base);
 
 	  aa[s + t * ld] = res * factor2;
 	}
@@ -248,8 +445,10 @@ fill_dlp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	}
 	else {
 
-	  (void) select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp,
-					      &xq, &yq, &wq, &nq, &res);
+	  (void) select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt,
+						     ss, tri_t, tri_s, tp, sp,
+						     &xq, &yq, &wq, &nq,
+						     &base);
 	  wq += 9 * nq;
 
 	  A_t = gr_x[tri_t[tp[0]]];
@@ -259,30 +458,8 @@ fill_dlp_cc_laplacebem3d(const uint * ridx, const uint * cidx,
 	  B_s = gr_x[tri_s[sp[1]]];
 	  C_s = gr_x[tri_s[sp[2]]];
 
-	  for (q = 0; q < nq; ++q) {
-	    tx = xq[q];
-	    sx = xq[q + nq];
-	    ty = yq[q];
-	    sy = yq[q + nq];
-	    Ax = 1.0 - tx;
-	    Bx = tx - sx;
-	    Cx = sx;
-	    Ay = 1.0 - ty;
-	    By = ty - sy;
-	    Cy = sy;
-
-	    dx = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx
-	      - (A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy);
-	    dy = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx
-	      - (A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy);
-	    dz = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx
-	      - (A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy);
-
-	    norm = dx * dx + dy * dy + dz * dz;
-
-	    res += wq[q] * (dx * ns[0] + dy * ns[1] + dz * ns[2])
-	      / (norm * REAL_SQRT(norm));
-	  }
+	  res = dlp_quadrature_laplacebem3d(xq, yq, wq, nq, A_t, B_t, C_t, A_s,
+					    B_s, C_s, ns, base);
 
 	  aa[t + s * ld] = res * factor2;
 	}
@@ -317,7 +494,8 @@ fill_dlp_cl_laplacebem3d(const uint * ridx, const uint * cidx,
   uint      tp[3], sp[3], tri_tp[3], tri_sp[3];
   real      norm, Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, dx, dy, dz, factor,
     factor2;
-  field     res, base;
+  field     res;
+  real      base;
   uint      i, j, t, s, q, nq, cj;
   uint      ii, jj, tt, ss, vv;
 
@@ -365,8 +543,9 @@ fill_dlp_cl_laplacebem3d(const uint * ridx, const uint * cidx,
 	if (tt != ss) {
 	  factor2 = factor * gr_g[tt];
 
-	  select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq,
-				       &yq, &wq, &nq, &base);
+	  select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss,
+					      tri_t, tri_s, tp, sp, &xq, &yq,
+					      &wq, &nq, &base);
 	  xq2 = xq + nq;
 	  yq2 = yq + nq;
 
@@ -501,8 +680,9 @@ fill_dlp_cl_laplacebem3d(const uint * ridx, const uint * cidx,
 	if (tt != ss) {
 	  factor2 = factor * gr_g[tt];
 
-	  select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq,
-				       &yq, &wq, &nq, &base);
+	  select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss,
+					      tri_t, tri_s, tp, sp, &xq, &yq,
+					      &wq, &nq, &base);
 
 	  for (i = 0; i < 3; ++i) {
 	    tri_tp[i] = tri_t[tp[i]];
@@ -688,8 +868,9 @@ fill_slp_ll_laplacebem3d(const uint * ridx, const uint * cidx,
 	factor2 = factor * gr_g[tt];
 	tri_t = gr_t[tt];
 
-	select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				     &wq, &nq, &base);
+	select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss, tri_t,
+					    tri_s, tp, sp, &xq, &yq, &wq, &nq,
+					    &base);
 
 	for (i = 0; i < 3; ++i) {
 	  tri_tp[i] = tri_t[tp[i]];
@@ -820,8 +1001,9 @@ fill_slp_ll_laplacebem3d(const uint * ridx, const uint * cidx,
 	factor2 = factor * gr_g[tt];
 	tri_t = gr_t[tt];
 
-	select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				     &wq, &nq, &base);
+	select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss, tri_t,
+					    tri_s, tp, sp, &xq, &yq, &wq, &nq,
+					    &base);
 
 	for (i = 0; i < 3; ++i) {
 	  tri_tp[i] = tri_t[tp[i]];
@@ -994,8 +1176,9 @@ fill_dlp_ll_laplacebem3d(const uint * ridx, const uint * cidx,
 	if (tt != ss) {
 	  factor2 = factor * gr_g[tt];
 
-	  select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq,
-				       &yq, &wq, &nq, &base);
+	  select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss,
+					      tri_t, tri_s, tp, sp, &xq, &yq,
+					      &wq, &nq, &base);
 
 	  for (i = 0; i < 3; ++i) {
 	    tri_tp[i] = tri_t[tp[i]];
@@ -1167,8 +1350,9 @@ fill_dlp_ll_laplacebem3d(const uint * ridx, const uint * cidx,
 	if (tt != ss) {
 	  factor2 = factor * gr_g[tt];
 
-	  select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq,
-				       &yq, &wq, &nq, &base);
+	  select_cached_quadrature_singquad2d(bem->sq, bem->sqc, tt, ss,
+					      tri_t, tri_s, tp, sp, &xq, &yq,
+					      &wq, &nq, &base);
 
 	  for (i = 0; i < 3; ++i) {
 	    tri_tp[i] = tri_t[tp[i]];
@@ -2222,7 +2406,7 @@ new_dlp_laplace_bem3d(pcsurface3d gr, uint q,
   }
   else if (basis_neumann == BASIS_LINEAR_BEM3D
 	   && basis_dirichlet == BASIS_CONSTANT_BEM3D) {
-    bem->mass = allocfield(3);
+    bem->mass = allocreal(3);
     /* TODO MASS-MATRIX */
 
   }
@@ -2255,7 +2439,7 @@ new_dlp_laplace_bem3d(pcsurface3d gr, uint q,
     kernels->dnz_kernel_row = fill_dnz_kernel_c_laplacebem3d;
     kernels->dnz_kernel_col = fill_dnzdcol_kernel_l_laplacebem3d;
 
-    bem->mass = allocfield(3);
+    bem->mass = allocreal(3);
     bem->mass[0] = 1.0 / 6.0;
     bem->mass[1] = 1.0 / 6.0;
     bem->mass[2] = 1.0 / 6.0;
@@ -2291,7 +2475,7 @@ new_dlp_laplace_bem3d(pcsurface3d gr, uint q,
     kernels->dnz_kernel_row = NULL;
     kernels->dnz_kernel_col = fill_dnzdcol_kernel_l_laplacebem3d;
 
-    bem->mass = allocfield(9);
+    bem->mass = allocreal(9);
     bem->mass[0] = 1.0 / 12.0;
     bem->mass[1] = 1.0 / 24.0;
     bem->mass[2] = 1.0 / 24.0;
@@ -309,6 +309,26 @@ HEADER_PREFIX uint build_interactive_laplacebem3d(pcsurface3d gr, char op,
     basisfunctionbem3d basis_neumann, basisfunctionbem3d basis_dirichlet,
     uint q, void **G, real *time, char* filename);
 
+/* ------------------------------------------------------------
+ Vectorization
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Switch between the SIMD and the scalar quadrature loops for
+ * piecewise constant basis functions.
+ *
+ * The SIMD loops are only available if the library has been compiled
+ * with <tt>USE_SIMD</tt> and AVX or AVX-512 is enabled, and they are
+ * used by default in this case. Switching them off is mainly useful
+ * for comparing both versions.
+ *
+ * @param simd Set to use the SIMD loops, cleared to use the scalar loops.
+ *
+ * @return Returns <tt>true</tt> if the SIMD loops are available,
+ * otherwise the scalar loops are always used.
+ */
+HEADER_PREFIX bool set_simd_laplacebem3d(bool simd);
+
 /** @} */
 
 #endif /* LAPLACEBEM3D_H_ */
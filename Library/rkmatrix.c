@@ -8,6 +8,10 @@
 
 #include "basic.h"
 
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
 /* ------------------------------------------------------------
    Constructors and destructors
    ------------------------------------------------------------ */
@@ -18,6 +22,9 @@ init_rkmatrix(prkmatrix r, uint rows, uint cols, uint k)
   init_amatrix(&r->A, rows, k);
   init_amatrix(&r->B, cols, k);
   r->k = k;
+  r->s = NULL;
+  r->cbytes = NULL;
+  r->c = NULL;
 
   return r;
 }
@@ -32,6 +39,9 @@ init_sub_rkmatrix(prkmatrix r, pcrkmatrix src,
   init_sub_amatrix(&r->A, &wsrc->A, rows, roff, k, 0);
   init_sub_amatrix(&r->B, &wsrc->B, cols, coff, k, 0);
   r->k = k;
+  r->s = NULL;
+  r->cbytes = NULL;
+  r->c = NULL;
 
   return r;
 }
@@ -39,6 +49,13 @@ init_sub_rkmatrix(prkmatrix r, pcrkmatrix src,
 void
 uninit_rkmatrix(prkmatrix r)
 {
+  if (r->s)
+    freemem(r->s);
+  if (r->c) {
+    freemem(r->c);
+    freemem(r->cbytes);
+  }
+
   uninit_amatrix(&r->B);
   uninit_amatrix(&r->A);
 }
@@ -91,6 +108,344 @@ resize_rkmatrix(prkmatrix r, uint rows, uint cols, uint k)
   r->k = k;
 }
 
+/* ------------------------------------------------------------
+   Single precision storage
+   ------------------------------------------------------------ */
+
+void
+tosingle_rkmatrix(prkmatrix r)
+{
+  uint      rows, cols, k;
+
+  assert(r->s == NULL);
+  assert(r->A.cols == r->k);
+  assert(r->B.cols == r->k);
+
+  rows = r->A.rows;
+  cols = r->B.rows;
+  k = r->k;
+
+  r->s = (psfield) allocmem(sizeof(sfield) * ((size_t) rows + cols) * k);
+  tosingle_amatrix(&r->A, r->s);
+  tosingle_amatrix(&r->B, r->s + (size_t) rows * k);
+
+  resize_amatrix(&r->A, rows, 0);
+  resize_amatrix(&r->B, cols, 0);
+}
+
+void
+todouble_rkmatrix(prkmatrix r)
+{
+  uint      rows, cols, k;
+
+  assert(r->s != NULL);
+
+  rows = r->A.rows;
+  cols = r->B.rows;
+  k = r->k;
+
+  resize_amatrix(&r->A, rows, k);
+  resize_amatrix(&r->B, cols, k);
+  fromsingle_amatrix(r->s, &r->A);
+  fromsingle_amatrix(r->s + (size_t) rows * k, &r->B);
+
+  freemem(r->s);
+  r->s = NULL;
+}
+
+/* ------------------------------------------------------------
+   Adaptive precision storage
+   ------------------------------------------------------------ */
+
+/* Complex coefficients are stored as pairs of real numbers */
+#ifdef USE_COMPLEX
+#define COMPRESSED_PARTS 2
+#else
+#define COMPRESSED_PARTS 1
+#endif
+
+/* Columns are padded to multiples of eight bytes, so every format
+   is properly aligned */
+static size_t
+colsize_compressed(uint bytes, uint n)
+{
+  return ((size_t) bytes * COMPRESSED_PARTS * n + 7) / 8 * 8;
+}
+
+/* bfloat16 keeps the upper half of a float, rounded to nearest even */
+static uint16_t
+tobfloat16(float x)
+{
+  uint32_t  b;
+
+  memcpy(&b, &x, sizeof(float));
+  b += 0x7fff + ((b >> 16) & 1);
+
+  return (uint16_t) (b >> 16);
+}
+
+static float
+frombfloat16(uint16_t h)
+{
+  uint32_t  b;
+  float     x;
+
+  b = (uint32_t) h << 16;
+  memcpy(&x, &b, sizeof(float));
+
+  return x;
+}
+
+static field
+get_bfloat16(const uint16_t *c, uint i)
+{
+#ifdef USE_COMPLEX
+  return frombfloat16(c[2 * i]) + frombfloat16(c[2 * i + 1]) * _Complex_I;
+#else
+  return frombfloat16(c[i]);
+#endif
+}
+
+static field
+get_float(const float *c, uint i)
+{
+#ifdef USE_COMPLEX
+  return c[2 * i] + c[2 * i + 1] * _Complex_I;
+#else
+  return c[i];
+#endif
+}
+
+static void
+compress_column(uint bytes, uint n, pcfield a, void *c)
+{
+  pcreal    ar = (pcreal) a;
+  uint      i;
+
+  n *= COMPRESSED_PARTS;
+
+  switch (bytes) {
+  case 2:
+    for (i = 0; i < n; i++)
+      ((uint16_t *) c)[i] = tobfloat16((float) ar[i]);
+    break;
+  case 4:
+    for (i = 0; i < n; i++)
+      ((float *) c)[i] = (float) ar[i];
+    break;
+  default:
+    memcpy(c, ar, sizeof(real) * n);
+  }
+}
+
+static void
+decompress_column(uint bytes, uint n, const void *c, pfield a)
+{
+  preal     ar = (preal) a;
+  uint      i;
+
+  n *= COMPRESSED_PARTS;
+
+  switch (bytes) {
+  case 2:
+    for (i = 0; i < n; i++)
+      ar[i] = frombfloat16(((const uint16_t *) c)[i]);
+    break;
+  case 4:
+    for (i = 0; i < n; i++)
+      ar[i] = ((const float *) c)[i];
+    break;
+  default:
+    memcpy(ar, c, sizeof(real) * n);
+  }
+}
+
+/* Compute c^* x for a compressed column c */
+static field
+dot_compressed(uint bytes, uint n, const void *c, pcfield x)
+{
+  const uint16_t *ch;
+  const float *cs;
+  pcfield   cd;
+  field     sum;
+  uint      i;
+
+  sum = 0.0;
+  switch (bytes) {
+  case 2:
+    ch = (const uint16_t *) c;
+    for (i = 0; i < n; i++)
+      sum += CONJ(get_bfloat16(ch, i)) * x[i];
+    break;
+  case 4:
+    cs = (const float *) c;
+    for (i = 0; i < n; i++)
+      sum += CONJ(get_float(cs, i)) * x[i];
+    break;
+  default:
+    cd = (pcfield) c;
+    for (i = 0; i < n; i++)
+      sum += CONJ(cd[i]) * x[i];
+  }
+
+  return sum;
+}
+
+/* Compute y = y + alpha c for a compressed column c */
+static void
+axpy_compressed(uint bytes, uint n, field alpha, const void *c, pfield y)
+{
+  const uint16_t *ch;
+  const float *cs;
+  pcfield   cd;
+  uint      i;
+
+  switch (bytes) {
+  case 2:
+    ch = (const uint16_t *) c;
+    for (i = 0; i < n; i++)
+      y[i] += alpha * get_bfloat16(ch, i);
+    break;
+  case 4:
+    cs = (const float *) c;
+    for (i = 0; i < n; i++)
+      y[i] += alpha * get_float(cs, i);
+    break;
+  default:
+    cd = (pcfield) c;
+    for (i = 0; i < n; i++)
+      y[i] += alpha * cd[i];
+  }
+}
+
+void
+compress_rkmatrix(prkmatrix r, real eps)
+{
+  preal     w;
+  real      anorm, bnorm, wmax;
+  size_t    size;
+  char     *c;
+  uint      rows, cols, k;
+  uint      i, nu;
+
+  assert(r->s == NULL);
+  assert(r->c == NULL);
+  assert(r->A.cols == r->k);
+  assert(r->B.cols == r->k);
+
+  rows = r->A.rows;
+  cols = r->B.rows;
+  k = r->k;
+
+  /* Nothing to store for a zero matrix */
+  if (k == 0)
+    return;
+
+  /* Contributions of the individual terms */
+  w = allocreal(k);
+  wmax = 0.0;
+  for (nu = 0; nu < k; nu++) {
+    anorm = 0.0;
+    for (i = 0; i < rows; i++)
+      anorm += ABSSQR(r->A.a[i + (size_t) nu * r->A.ld]);
+    bnorm = 0.0;
+    for (i = 0; i < cols; i++)
+      bnorm += ABSSQR(r->B.a[i + (size_t) nu * r->B.ld]);
+    w[nu] = REAL_SQRT(anorm * bnorm);
+    wmax = REAL_MAX(wmax, w[nu]);
+  }
+
+  /* Choose the storage formats, unit roundoffs 2^-8, 2^-24, 2^-53 */
+  r->cbytes = allocuint(k);
+  size = 0;
+  for (nu = 0; nu < k; nu++) {
+    if (ldexp(w[nu], -8) <= eps * wmax)
+      r->cbytes[nu] = 2;
+    else if (ldexp(w[nu], -24) <= eps * wmax)
+      r->cbytes[nu] = 4;
+    else
+      r->cbytes[nu] = sizeof(real);
+
+    size += colsize_compressed(r->cbytes[nu], rows);
+    size += colsize_compressed(r->cbytes[nu], cols);
+  }
+  freemem(w);
+
+  /* Store a_nu and b_nu consecutively for every term */
+  r->c = allocmem(size);
+  c = (char *) r->c;
+  for (nu = 0; nu < k; nu++) {
+    compress_column(r->cbytes[nu], rows, r->A.a + (size_t) nu * r->A.ld, c);
+    c += colsize_compressed(r->cbytes[nu], rows);
+    compress_column(r->cbytes[nu], cols, r->B.a + (size_t) nu * r->B.ld, c);
+    c += colsize_compressed(r->cbytes[nu], cols);
+  }
+
+  resize_amatrix(&r->A, rows, 0);
+  resize_amatrix(&r->B, cols, 0);
+}
+
+void
+decompress_factors_rkmatrix(pcrkmatrix r, pamatrix A, pamatrix B)
+{
+  const char *c;
+  uint      rows, cols;
+  uint      nu;
+
+  assert(r->c != NULL);
+
+  rows = r->A.rows;
+  cols = r->B.rows;
+
+  assert(A->rows == rows);
+  assert(B->rows == cols);
+  assert(A->cols >= r->k);
+  assert(B->cols >= r->k);
+
+  c = (const char *) r->c;
+  for (nu = 0; nu < r->k; nu++) {
+    decompress_column(r->cbytes[nu], rows, c, A->a + (size_t) nu * A->ld);
+    c += colsize_compressed(r->cbytes[nu], rows);
+    decompress_column(r->cbytes[nu], cols, c, B->a + (size_t) nu * B->ld);
+    c += colsize_compressed(r->cbytes[nu], cols);
+  }
+}
+
+void
+decompress_rkmatrix(prkmatrix r)
+{
+  assert(r->c != NULL);
+
+  resize_amatrix(&r->A, r->A.rows, r->k);
+  resize_amatrix(&r->B, r->B.rows, r->k);
+
+  decompress_factors_rkmatrix(r, &r->A, &r->B);
+
+  freemem(r->c);
+  freemem(r->cbytes);
+  r->c = NULL;
+  r->cbytes = NULL;
+}
+
+/* Size of the compressed columns in bytes */
+static size_t
+getsize_compressed(pcrkmatrix r)
+{
+  size_t    sz;
+  uint      nu;
+
+  sz = 0;
+  if (r->c) {
+    sz += sizeof(uint) * r->k;
+    for (nu = 0; nu < r->k; nu++) {
+      sz += colsize_compressed(r->cbytes[nu], r->A.rows);
+      sz += colsize_compressed(r->cbytes[nu], r->B.rows);
+    }
+  }
+
+  return sz;
+}
+
 /* ------------------------------------------------------------
    Statistics
    ------------------------------------------------------------ */
@@ -103,6 +458,9 @@ getsize_rkmatrix(pcrkmatrix r)
   sz = sizeof(rkmatrix);
   sz += getsize_heap_amatrix(&r->A);
   sz += getsize_heap_amatrix(&r->B);
+  if (r->s)
+    sz += sizeof(sfield) * ((size_t) r->A.rows + r->B.rows) * r->k;
+  sz += getsize_compressed(r);
 
   return sz;
 }
@@ -114,6 +472,9 @@ getsize_heap_rkmatrix(pcrkmatrix r)
 
   sz = getsize_heap_amatrix(&r->A);
   sz += getsize_heap_amatrix(&r->B);
+  if (r->s)
+    sz += sizeof(sfield) * ((size_t) r->A.rows + r->B.rows) * r->k;
+  sz += getsize_compressed(r);
 
   return sz;
 }
@@ -166,13 +527,43 @@ copy_rkmatrix(bool atrans, pcrkmatrix a, prkmatrix b)
 void
 addeval_rkmatrix_avector(field alpha, pcrkmatrix r, pcavector x, pavector y)
 {
-  pavector  ac, bc;
+  pavector  ac, bc, t;
   avector   atmp, btmp;
   field     beta;
+  const char *c;
+  size_t    mark;
   uint      nu;
 
   assert(y->dim == r->A.rows);
   assert(x->dim == r->B.rows);
+
+  if (r->s) {
+    /* Factors in single precision: t = B^* x, y = y + alpha A t */
+    mark = mark_scratch();
+    t = init_scratch_avector(&atmp, r->k);
+    clear_avector(t);
+    addevaltrans_single_avector(1.0, r->B.rows, r->k,
+				r->s + (size_t) r->A.rows * r->k, x, t);
+    addeval_single_avector(alpha, r->A.rows, r->k, r->s, t, y);
+    uninit_avector(t);
+    release_scratch(mark);
+    return;
+  }
+
+  if (r->c) {
+    /* Compressed columns: decompress b_nu and a_nu on the fly */
+    c = (const char *) r->c;
+    for (nu = 0; nu < r->k; nu++) {
+      beta = dot_compressed(r->cbytes[nu], r->B.rows,
+			    c + colsize_compressed(r->cbytes[nu], r->A.rows),
+			    x->v);
+      axpy_compressed(r->cbytes[nu], r->A.rows, alpha * beta, c, y->v);
+      c += colsize_compressed(r->cbytes[nu], r->A.rows);
+      c += colsize_compressed(r->cbytes[nu], r->B.rows);
+    }
+    return;
+  }
+
   assert(r->k <= r->A.cols);
   assert(r->k <= r->B.cols);
 
@@ -192,13 +583,41 @@ void
 addevaltrans_rkmatrix_avector(field alpha, pcrkmatrix r, pcavector x,
 			      pavector y)
 {
-  pavector  ac, bc;
+  pavector  ac, bc, t;
   avector   atmp, btmp;
   field     beta;
+  const char *c;
+  size_t    mark;
   uint      nu;
 
   assert(x->dim == r->A.rows);
   assert(y->dim == r->B.rows);
+
+  if (r->s) {
+    /* Factors in single precision: t = A^* x, y = y + alpha B t */
+    mark = mark_scratch();
+    t = init_scratch_avector(&atmp, r->k);
+    clear_avector(t);
+    addevaltrans_single_avector(1.0, r->A.rows, r->k, r->s, x, t);
+    addeval_single_avector(alpha, r->B.rows, r->k,
+			   r->s + (size_t) r->A.rows * r->k, t, y);
+    uninit_avector(t);
+    release_scratch(mark);
+    return;
+  }
+
+  if (r->c) {
+    /* Compressed columns: decompress a_nu and b_nu on the fly */
+    c = (const char *) r->c;
+    for (nu = 0; nu < r->k; nu++) {
+      beta = dot_compressed(r->cbytes[nu], r->A.rows, c, x->v);
+      c += colsize_compressed(r->cbytes[nu], r->A.rows);
+      axpy_compressed(r->cbytes[nu], r->B.rows, alpha * beta, c, y->v);
+      c += colsize_compressed(r->cbytes[nu], r->B.rows);
+    }
+    return;
+  }
+
   assert(r->k <= r->A.cols);
   assert(r->k <= r->B.cols);
 
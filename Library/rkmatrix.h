@@ -41,6 +41,18 @@ struct _rkmatrix {
 
   /** Maximal rank, i.e., number of columns of @f$A@f$ and @f$B@f$. */
   uint k;
+
+  /** Factors @f$A@f$ and @f$B@f$ in single precision if the matrix has
+   *  been converted by @ref tosingle_rkmatrix, <tt>NULL</tt> otherwise. */
+  psfield s;
+
+  /** Bytes per real number used for the columns of @f$A@f$ and @f$B@f$
+   *  if the matrix has been compressed by @ref compress_rkmatrix,
+   *  <tt>NULL</tt> otherwise.
+   *  Complex coefficients are stored as pairs of real numbers. */
+  uint *cbytes;
+  /** Compressed columns of @f$A@f$ and @f$B@f$. */
+  void *c;
 };
 
 /* ------------------------------------------------------------
@@ -204,6 +216,92 @@ setrank_rkmatrix(prkmatrix r, uint k);
 void
 resize_rkmatrix(prkmatrix r, uint rows, uint cols, uint k);
 
+/* ------------------------------------------------------------
+   Single precision storage
+   ------------------------------------------------------------ */
+
+/** @brief Store the factors of an @ref rkmatrix in single precision.
+ *
+ *  The factors @f$A@f$ and @f$B@f$ are converted to @ref sfield and
+ *  stored in <tt>r->s</tt>, and their double precision coefficients
+ *  are released, so the storage is halved.
+ *  The rank <tt>r->k</tt> remains unchanged, while @f$A@f$ and @f$B@f$
+ *  keep their number of rows but have no columns.
+ *
+ *  @remark A matrix in single precision can only be used for
+ *  matrix-vector multiplications, i.e., by
+ *  @ref addeval_rkmatrix_avector and @ref addevaltrans_rkmatrix_avector.
+ *  Use @ref todouble_rkmatrix before any other operation.
+ *
+ *  @param r Matrix owning its factors. */
+HEADER_PREFIX void
+tosingle_rkmatrix(prkmatrix r);
+
+/** @brief Restore the factors of an @ref rkmatrix from single precision.
+ *
+ *  Reverses @ref tosingle_rkmatrix, the coefficients keep the
+ *  rounding error of single precision.
+ *
+ *  @param r Matrix converted by @ref tosingle_rkmatrix. */
+HEADER_PREFIX void
+todouble_rkmatrix(prkmatrix r);
+
+/* ------------------------------------------------------------
+   Adaptive precision storage
+   ------------------------------------------------------------ */
+
+/** @brief Store the columns of the factors of an @ref rkmatrix with
+ *  a precision adapted to their contribution.
+ *
+ *  The @f$\nu@f$-th term @f$a_\nu b_\nu^*@f$ of @f$R = A B^*@f$
+ *  contributes @f$w_\nu = \|a_\nu\|_2 \|b_\nu\|_2@f$ to the norm,
+ *  and after @ref trunc_rkmatrix the weights @f$w_\nu@f$ are the
+ *  singular values of @f$R@f$.
+ *  The columns @f$a_\nu@f$ and @f$b_\nu@f$ are stored with 2 bytes
+ *  (bfloat16), 4 bytes (single precision) or 8 bytes (double
+ *  precision) per coefficient, using the shortest format with unit
+ *  roundoff @f$u@f$ satisfying
+ *  @f$u w_\nu \leq \epsilon \max_\mu w_\mu@f$.
+ *  The double precision coefficients are released, and @f$A@f$ and
+ *  @f$B@f$ keep their number of rows but have no columns.
+ *
+ *  @remark A compressed matrix can only be used for matrix-vector
+ *  multiplications, i.e., by
+ *  @ref addeval_rkmatrix_avector and @ref addevaltrans_rkmatrix_avector,
+ *  which decompress the coefficients on the fly.
+ *  Use @ref decompress_rkmatrix before any other operation.
+ *
+ *  @param r Matrix owning its factors.
+ *  @param eps Relative accuracy, usually the accuracy used for the
+ *     truncation. */
+HEADER_PREFIX void
+compress_rkmatrix(prkmatrix r, real eps);
+
+/** @brief Decompress the factors of an @ref rkmatrix compressed by
+ *  @ref compress_rkmatrix into given matrices.
+ *
+ *  The first <tt>r->k</tt> columns of <tt>A</tt> and <tt>B</tt> are
+ *  overwritten, while <tt>r</tt> remains compressed.
+ *  This allows algorithms like the multiplication with multiple
+ *  vectors to work with temporary copies of the factors.
+ *
+ *  @param r Matrix compressed by @ref compress_rkmatrix.
+ *  @param A Target for the factor @f$A@f$, has to have
+ *     <tt>r->A.rows</tt> rows and at least <tt>r->k</tt> columns.
+ *  @param B Target for the factor @f$B@f$, has to have
+ *     <tt>r->B.rows</tt> rows and at least <tt>r->k</tt> columns. */
+HEADER_PREFIX void
+decompress_factors_rkmatrix(pcrkmatrix r, pamatrix A, pamatrix B);
+
+/** @brief Restore the factors of an @ref rkmatrix compressed by
+ *  @ref compress_rkmatrix.
+ *
+ *  The coefficients keep the rounding errors of their storage formats.
+ *
+ *  @param r Matrix compressed by @ref compress_rkmatrix. */
+HEADER_PREFIX void
+decompress_rkmatrix(prkmatrix r);
+
 /* ------------------------------------------------------------
    Statistics
    ------------------------------------------------------------ */
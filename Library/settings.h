@@ -15,6 +15,9 @@
  *  @{ */
 
 #include <math.h>
+#ifdef USE_COMPLEX
+#include <complex.h>
+#endif
 
 /* ------------------------------------------------------------
  Compilation settings
@@ -93,8 +96,14 @@ typedef const real *pcreal;
 /** @brief Field type.
  *
  *  This type is used in the linear algebra modules to represent
- *  the coefficients of matrices and vectors. */
+ *  the coefficients of matrices and vectors.
+ *  If <tt>USE_COMPLEX</tt> is defined, it is <tt>double complex</tt>,
+ *  otherwise it is <tt>double</tt>. */
+#ifdef USE_COMPLEX
+typedef double _Complex field;
+#else
 typedef double field;
+#endif
 
 /** @brief Pointer to @ref field array. */
 typedef field *pfield;
@@ -102,6 +111,23 @@ typedef field *pfield;
 /** @brief Pointer to constant @ref field array. */
 typedef const field *pcfield;
 
+/** @brief Single precision field type.
+ *
+ *  This type is used to store the coefficients of low-rank and
+ *  coupling matrices in single precision, see @ref tosingle_rkmatrix
+ *  and @ref tosingle_uniform. */
+#ifdef USE_COMPLEX
+typedef float _Complex sfield;
+#else
+typedef float sfield;
+#endif
+
+/** @brief Pointer to @ref sfield array. */
+typedef sfield *psfield;
+
+/** @brief Pointer to constant @ref sfield array. */
+typedef const sfield *pcsfield;
+
 /** @brief @ref field constant zero */
 extern const field f_zero;
 
@@ -469,12 +469,10 @@ weight_basisfunc_l_singquad2d(real * x, real * y, real * w, uint nq)
 
 }
 
-uint
-select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
-			     const uint * sv, uint * tp, uint * sp, real ** x,
-			     real ** y, real ** w, uint * n, real * base)
+/* Number of common vertices and permutations moving them to the front */
+static    uint
+permute_singquad2d(const uint * tv, const uint * sv, uint * tp, uint * sp)
 {
-
   uint      p, q, i, j;
 
   p =
@@ -485,6 +483,52 @@ select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
   tp[0] = 0, tp[1] = 1, tp[2] = 2;
   sp[0] = 0, sp[1] = 1, sp[2] = 2;
 
+  if (p == 0 || p == 3)
+    return p;
+
+  if (p > 3) {
+    printf("ERROR: Unknown quadrature situation!\n");
+    abort();
+  }
+
+  p = 0;
+  for (i = 0; i < 3; ++i) {
+    for (j = 0; j < 3; ++j) {
+      if (tv[i] == sv[j]) {
+	tp[p] = i;
+	sp[p] = j;
+	p++;
+	break;
+      }
+    }
+  }
+
+  q = p;
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < q && tv[i] != tv[tp[j]]; j++);
+    if (j == q)
+      tp[q++] = i;
+  }
+  assert(q == 3);
+
+  q = p;
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < q && sv[i] != sv[sp[j]]; j++);
+    if (j == q)
+      sp[q++] = i;
+  }
+  assert(q == 3);
+
+  assert(p <= 3);
+
+  return p;
+}
+
+/* Quadrature rule for p common vertices */
+static void
+rule_singquad2d(pcsingquad2d sq, uint p, real ** x, real ** y, real ** w,
+		uint * n, real * base)
+{
   switch (p) {
   case 0:			/* DISTANT */
     *x = sq->x_dist;
@@ -492,7 +536,6 @@ select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
     *w = sq->w_dist;
     *n = sq->n_dist;
     *base = sq->base_dist;
-    return p;
     break;
   case 1:			/* VERTEX */
     *x = sq->x_vert;
@@ -514,44 +557,212 @@ select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
     *w = sq->w_id;
     *n = sq->n_id;
     *base = sq->base_id;
-    return p;
     break;
   default:
     printf("ERROR: Unknown quadrature situation!\n");
     abort();
     break;
   }
+}
 
-  p = 0;
-  for (i = 0; i < 3; ++i) {
-    for (j = 0; j < 3; ++j) {
-      if (tv[i] == sv[j]) {
-	tp[p] = i;
-	sp[p] = j;
-	p++;
-	break;
+uint
+select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
+			     const uint * sv, uint * tp, uint * sp, real ** x,
+			     real ** y, real ** w, uint * n, real * base)
+{
+  uint      p;
+
+  p = permute_singquad2d(tv, sv, tp, sp);
+
+  rule_singquad2d(sq, p, x, y, w, n, base);
+
+  return p;
+}
+
+/* ------------------------------------------------------------
+ Cache for neighbouring triangles
+ ------------------------------------------------------------ */
+
+/* Each entry of the cache packs the number of common vertices into
+ * the lowest four bits, followed by 2 bits for each entry of the
+ * permutations tp and sp. */
+#define PACK_SINGQUAD2D(p, tp, sp)				\
+  ((p) | ((tp)[0] << 4) | ((tp)[1] << 6) | ((tp)[2] << 8)	\
+   | ((sp)[0] << 10) | ((sp)[1] << 12) | ((sp)[2] << 14))
+
+psingquadcache2d
+build_singquadcache2d(uint triangles, uint vertices, const uint(*t)[3])
+{
+  psingquadcache2d sc;
+  uint     *vstart, *vtri, *mark, *list;
+  uint      tp[3], sp[3];
+  uint      i, j, k, l, m, n, s, v;
+
+  /* Triangles sharing each vertex */
+  vstart = allocuint(vertices + 1);
+  for (v = 0; v <= vertices; v++)
+    vstart[v] = 0;
+  for (i = 0; i < triangles; i++)
+    for (k = 0; k < 3; k++) {
+      assert(t[i][k] < vertices);
+      vstart[t[i][k] + 1]++;
+    }
+  for (v = 0; v < vertices; v++)
+    vstart[v + 1] += vstart[v];
+
+  vtri = allocuint(vstart[vertices]);
+  for (i = 0; i < triangles; i++)
+    for (k = 0; k < 3; k++)
+      vtri[vstart[t[i][k]]++] = i;
+  for (v = vertices; v > 0; v--)
+    vstart[v] = vstart[v - 1];
+  vstart[0] = 0;
+
+  sc = (psingquadcache2d) allocmem(sizeof(singquadcache2d));
+  sc->triangles = triangles;
+  sc->start = allocuint(triangles + 1);
+  sc->refs = 0;
+
+  /* Count neighbours of each triangle, marking with i+1 */
+  mark = allocuint(triangles);
+  for (i = 0; i < triangles; i++)
+    mark[i] = 0;
+
+  n = 0;
+  for (i = 0; i < triangles; i++) {
+    sc->start[i] = n;
+    for (k = 0; k < 3; k++) {
+      v = t[i][k];
+      for (j = vstart[v]; j < vstart[v + 1]; j++) {
+	s = vtri[j];
+	if (mark[s] != i + 1) {
+	  mark[s] = i + 1;
+	  n++;
+	}
       }
     }
   }
+  sc->start[triangles] = n;
+
+  sc->neighbour = allocuint(n);
+  sc->perm = allocuint(n);
+
+  /* Collect neighbours in ascending order and compute permutations */
+  for (i = 0; i < triangles; i++)
+    mark[i] = 0;
+
+  for (i = 0; i < triangles; i++) {
+    list = sc->neighbour + sc->start[i];
+    m = 0;
+    for (k = 0; k < 3; k++) {
+      v = t[i][k];
+      for (j = vstart[v]; j < vstart[v + 1]; j++) {
+	s = vtri[j];
+	if (mark[s] != i + 1) {
+	  mark[s] = i + 1;
+
+	  /* Insertion sort, the lists are short */
+	  for (l = m; l > 0 && list[l - 1] > s; l--)
+	    list[l] = list[l - 1];
+	  list[l] = s;
+	  m++;
+	}
+      }
+    }
+    assert(m == sc->start[i + 1] - sc->start[i]);
 
-  q = p;
-  for (i = 0; i < 3; i++) {
-    for (j = 0; j < q && tv[i] != tv[tp[j]]; j++);
-    if (j == q)
-      tp[q++] = i;
+    for (l = 0; l < m; l++) {
+      s = list[l];
+      j = permute_singquad2d(t[i], t[s], tp, sp);
+      assert(j > 0);
+      sc->perm[sc->start[i] + l] = PACK_SINGQUAD2D(j, tp, sp);
+    }
   }
-  assert(q == 3);
 
-  q = p;
-  for (i = 0; i < 3; i++) {
-    for (j = 0; j < q && sv[i] != sv[sp[j]]; j++);
-    if (j == q)
-      sp[q++] = i;
+  freemem(mark);
+  freemem(vtri);
+  freemem(vstart);
+
+  return sc;
+}
+
+void
+del_singquadcache2d(psingquadcache2d sc)
+{
+  assert(sc != NULL);
+  assert(sc->refs == 0);
+
+  freemem(sc->perm);
+  freemem(sc->neighbour);
+  freemem(sc->start);
+  freemem(sc);
+}
+
+void
+ref_singquadcache2d(psingquadcache2d * ptr, psingquadcache2d sc)
+{
+  if (*ptr)
+    unref_singquadcache2d(*ptr);
+
+  *ptr = sc;
+
+  if (sc)
+    sc->refs++;
+}
+
+void
+unref_singquadcache2d(psingquadcache2d sc)
+{
+  assert(sc->refs > 0);
+
+  sc->refs--;
+
+  if (sc->refs == 0)
+    del_singquadcache2d(sc);
+}
+
+uint
+select_cached_quadrature_singquad2d(pcsingquad2d sq, pcsingquadcache2d sc,
+				    uint t, uint s, const uint * tv,
+				    const uint * sv, uint * tp, uint * sp,
+				    real ** x, real ** y, real ** w, uint * n,
+				    real * base)
+{
+  const uint *list;
+  uint      lo, hi, mid, pk, p;
+
+  if (sc == NULL)
+    return select_quadrature_singquad2d(sq, tv, sv, tp, sp, x, y, w, n,
+					base);
+
+  assert(t < sc->triangles);
+  assert(s < sc->triangles);
+
+  /* Binary search in the sorted list of neighbours of t */
+  list = sc->neighbour;
+  lo = sc->start[t];
+  hi = sc->start[t + 1];
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (list[mid] < s)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
-  assert(q == 3);
 
-  assert(p <= 3);
+  if (lo < sc->start[t + 1] && list[lo] == s) {
+    pk = sc->perm[lo];
+    p = pk & 15;
+    tp[0] = (pk >> 4) & 3, tp[1] = (pk >> 6) & 3, tp[2] = (pk >> 8) & 3;
+    sp[0] = (pk >> 10) & 3, sp[1] = (pk >> 12) & 3, sp[2] = (pk >> 14) & 3;
+  }
+  else {
+    p = 0;
+    tp[0] = 0, tp[1] = 1, tp[2] = 2;
+    sp[0] = 0, sp[1] = 1, sp[2] = 2;
+  }
 
-  return p;
+  rule_singquad2d(sq, p, x, y, w, n, base);
 
+  return p;
 }
@@ -135,6 +135,51 @@ typedef singquad2d* psingquad2d;
  */
 typedef const singquad2d *pcsingquad2d;
 
+/**
+ * @brief Classification of all pairs of triangles of a surface mesh that
+ * share at least one vertex.
+ *
+ * For every triangle @f$ t @f$ the neighbouring triangles @f$ s @f$ are
+ * stored in ascending order together with the number of common vertices and
+ * the permutations computed by @ref select_quadrature_singquad2d.
+ * Pairs not contained in the cache are distant.
+ * The cache only depends on the mesh, so it can be shared by all
+ * @ref _bem3d "bem3d" objects on the same surface.
+ */
+struct _singquadcache2d {
+	/** @brief Number of triangles.*/
+	uint triangles;
+	/**
+	 * @brief Neighbours of triangle <tt>t</tt> are stored at the positions
+	 * <tt>start[t], ..., start[t+1]-1</tt>.
+	 */
+	uint *start;
+	/** @brief Indices of neighbouring triangles.*/
+	uint *neighbour;
+	/**
+	 * @brief Number of common vertices in the lowest four bits, followed by
+	 * two bits for each entry of the permutations of both triangles.
+	 */
+	uint *perm;
+	/** @brief Number of references to this object.*/
+	uint refs;
+};
+
+/**
+ * @ref singquadcache2d is just an abbreviation for the struct _singquadcache2d.
+ */
+typedef struct _singquadcache2d singquadcache2d;
+
+/**
+ * Pointer to a @ref singquadcache2d object.
+ */
+typedef singquadcache2d* psingquadcache2d;
+
+/**
+ * Pointer to a constant @ref singquadcache2d object.
+ */
+typedef const singquadcache2d *pcsingquadcache2d;
+
 /* ------------------------------------------------------------
  Constructors and destructors
  ------------------------------------------------------------ */
@@ -245,6 +290,83 @@ HEADER_PREFIX uint
 select_quadrature_singquad2d(pcsingquad2d sq, const uint *tv, const uint *sv,
 		uint *tp, uint *sp, real **x, real **y, real **w, uint *n, real *base);
 
+/* ------------------------------------------------------------
+ Cache for neighbouring triangles
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Classify all pairs of triangles sharing at least one vertex.
+ *
+ * @param triangles Number of triangles.
+ * @param vertices Number of vertices.
+ * @param t Vertex indices of the triangles.
+ * @return returns a new @ref _singquadcache2d "singquadcache2d" object.
+ */
+HEADER_PREFIX psingquadcache2d
+build_singquadcache2d(uint triangles, uint vertices, const uint (*t)[3]);
+
+/**
+ * @brief Destructor for @ref _singquadcache2d "singquadcache2d" objects.
+ *
+ * Only objects with <tt>sc->refs==0</tt> may be deleted.
+ * @param sc @ref _singquadcache2d "singquadcache2d" object to be deleted.
+ */
+HEADER_PREFIX void
+del_singquadcache2d(psingquadcache2d sc);
+
+/**
+ * @brief Set a pointer to a @ref _singquadcache2d "singquadcache2d" object,
+ * increase its reference counter, and decrease reference counter of
+ * original pointer target.
+ *
+ * @param ptr Pointer to the @ref psingquadcache2d variable that will be changed.
+ * @param sc @ref _singquadcache2d "singquadcache2d" that will be referenced.
+ */
+HEADER_PREFIX void
+ref_singquadcache2d(psingquadcache2d *ptr, psingquadcache2d sc);
+
+/**
+ * @brief Reduce the reference counter of a
+ * @ref _singquadcache2d "singquadcache2d" object.
+ *
+ * If the reference counter reaches zero, the object is deleted.
+ * @param sc @ref _singquadcache2d "singquadcache2d" that will be unreferenced.
+ */
+HEADER_PREFIX void
+unref_singquadcache2d(psingquadcache2d sc);
+
+/**
+ * @brief Select the quadrature rule for a pair of triangles using
+ * a precomputed classification.
+ *
+ * Returns the same results as @ref select_quadrature_singquad2d, but
+ * the number of common vertices and the permutations are looked up in
+ * <tt>sc</tt>.
+ * If <tt>sc</tt> is <tt>NULL</tt>, @ref select_quadrature_singquad2d is
+ * called instead.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object containing all necessary
+ * quadrature rules.
+ * @param sc Classification of neighbouring triangles or <tt>NULL</tt>.
+ * @param t Index of triangle @f$ t @f$.
+ * @param s Index of triangle @f$ s @f$.
+ * @param tv An array defining the 3 vertices of triangle @f$ t @f$.
+ * @param sv An array defining the 3 vertices of triangle @f$ s @f$.
+ * @param tp Returning a permutation array of the vertices for @f$ t @f$.
+ * @param sp Returning a permutation array of the vertices for @f$ s @f$.
+ * @param x Returning the quadrature points for the triangle @f$ t @f$.
+ * @param y Returning the quadrature points for the triangle @f$ s @f$.
+ * @param w Returning the quadrature weights.
+ * @param n Returning the total number of quadrature points.
+ * @param base Returning a constant offset.
+ * @return Returns the number of common vertices for triangle @f$ t @f$ and
+ * @f$ s @f$, which defines the current quadrature case.
+ */
+HEADER_PREFIX uint
+select_cached_quadrature_singquad2d(pcsingquad2d sq, pcsingquadcache2d sc,
+		uint t, uint s, const uint *tv, const uint *sv, uint *tp, uint *sp,
+		real **x, real **y, real **w, uint *n, real *base);
+
 /** @} */
 
 #endif /* SINGQUAD2D_H_ */
@@ -79,6 +79,160 @@ new_zero_sparsematrix(psparsepattern sp)
   return A;
 }
 
+static void
+swap(uint i1, uint i2, uint * col, pfield coeff)
+{
+  uint      hcol;
+  field     hcoeff;
+
+  hcol = col[i1];
+  col[i1] = col[i2];
+  col[i2] = hcol;
+
+  hcoeff = coeff[i1];
+  coeff[i1] = coeff[i2];
+  coeff[i2] = hcoeff;
+}
+
+/* Sort the entries of one row by column index */
+struct _sortrow {
+  uint     *col;
+  pfield    coeff;
+};
+
+static    uint
+leq_sortrow(uint i, uint j, void *data)
+{
+  struct _sortrow *sr = (struct _sortrow *) data;
+
+  return (sr->col[i] <= sr->col[j]);
+}
+
+static void
+swap_sortrow(uint i, uint j, void *data)
+{
+  struct _sortrow *sr = (struct _sortrow *) data;
+
+  swap(i, j, sr->col, sr->coeff);
+}
+
+static void
+sort_row(uint n, uint * col, pfield coeff)
+{
+  struct _sortrow sr;
+  uint      i, j;
+
+  if (n > 16) {
+    sr.col = col;
+    sr.coeff = coeff;
+    heapsort(n, leq_sortrow, swap_sortrow, &sr);
+    return;
+  }
+
+  /* Insertion sort is faster for the short rows typical of finite
+   * element matrices */
+  for (i = 1; i < n; i++)
+    for (j = i; j > 0 && col[j - 1] > col[j]; j--)
+      swap(j - 1, j, col, coeff);
+}
+
+psparsematrix
+new_triplet_sparsematrix(uint rows, uint cols, uint nz,
+			 const uint * ri, const uint * ci, pcfield x)
+{
+  psparsematrix A;
+  uint     *start, *pos, *len;
+  uint     *tcol;
+  pfield    tcoeff;
+  uint      i, j, k, n;
+
+  /* Count entries per row */
+  start = allocuint(rows + 1);
+  for (i = 0; i <= rows; i++)
+    start[i] = 0;
+  for (k = 0; k < nz; k++) {
+    assert(ri[k] < rows);
+    assert(ci[k] < cols);
+    start[ri[k] + 1]++;
+  }
+  for (i = 0; i < rows; i++)
+    start[i + 1] += start[i];
+  assert(start[rows] == nz);
+
+  /* Distribute the triplets to their rows */
+  tcol = allocuint(nz);
+  tcoeff = allocfield(nz);
+  pos = allocuint(rows);
+  for (i = 0; i < rows; i++)
+    pos[i] = start[i];
+  for (k = 0; k < nz; k++) {
+    j = pos[ri[k]]++;
+    tcol[j] = ci[k];
+    tcoeff[j] = (x ? x[k] : 0.0);
+  }
+  freemem(pos);
+
+  /* Sort every row and merge duplicate entries */
+  len = allocuint(rows);
+#ifdef USE_OPENMP
+#pragma omp parallel for if(max_pardepth > 0), private(j, k, n)
+#endif
+  for (i = 0; i < rows; i++) {
+    n = start[i + 1] - start[i];
+    sort_row(n, tcol + start[i], tcoeff + start[i]);
+
+    k = start[i];
+    for (j = start[i] + 1; j < start[i + 1]; j++) {
+      if (tcol[j] == tcol[k])
+	tcoeff[k] += tcoeff[j];
+      else {
+	k++;
+	tcol[k] = tcol[j];
+	tcoeff[k] = tcoeff[j];
+      }
+    }
+    len[i] = (n > 0 ? k - start[i] + 1 : 0);
+  }
+
+  /* Set up the final arrays */
+  n = 0;
+  for (i = 0; i < rows; i++)
+    n += len[i];
+
+  A = new_raw_sparsematrix(rows, cols, n);
+  A->row[0] = 0;
+  for (i = 0; i < rows; i++)
+    A->row[i + 1] = A->row[i] + len[i];
+
+  /* Diagonal entries come first, the other entries keep their order */
+#ifdef USE_OPENMP
+#pragma omp parallel for if(max_pardepth > 0), private(j, k)
+#endif
+  for (i = 0; i < rows; i++) {
+    k = A->row[i];
+    for (j = 0; j < len[i]; j++)
+      if (tcol[start[i] + j] == i) {
+	A->col[k] = i;
+	A->coeff[k] = tcoeff[start[i] + j];
+	k++;
+      }
+    for (j = 0; j < len[i]; j++)
+      if (tcol[start[i] + j] != i) {
+	A->col[k] = tcol[start[i] + j];
+	A->coeff[k] = tcoeff[start[i] + j];
+	k++;
+      }
+    assert(k == A->row[i + 1]);
+  }
+
+  freemem(len);
+  freemem(tcoeff);
+  freemem(tcol);
+  freemem(start);
+
+  return A;
+}
+
 void
 del_sparsematrix(psparsematrix a)
 {
@@ -148,21 +302,6 @@ getsize_sparsematrix(pcsparsematrix a)
    Simple utility functions
    ------------------------------------------------------------ */
 
-static void
-swap(uint i1, uint i2, uint * col, pfield coeff)
-{
-  uint      hcol;
-  field     hcoeff;
-
-  hcol = col[i1];
-  col[i1] = col[i2];
-  col[i2] = hcol;
-
-  hcoeff = coeff[i1];
-  coeff[i1] = coeff[i2];
-  coeff[i2] = hcoeff;
-}
-
 void
 sort_sparsematrix(psparsematrix a)
 {
@@ -211,7 +350,8 @@ print_sparsematrix(pcsparsematrix a)
     (void) printf("  %u:", i);
 
     for (j = row[i]; j < row[i + 1]; j++)
-      (void) printf(" (%u %g)", col[j], coeff[j]);
+      (void) printf(" (%u " FIELD_FMT ")", col[j],
+		    FIELD_PRINT(coeff[j]));
 
     (void) printf("\n");
   }
@@ -239,9 +379,9 @@ print_eps_sparsematrix(pcsparsematrix a, const char *filename, uint offset)
 
   maxval = 0.0;
   if (nz > 0) {
-    maxval = fabs(coeff[0]);
+    maxval = ABS(coeff[0]);
     for (i = 1; i < nz; i++) {
-      val = fabs(coeff[i]);
+      val = ABS(coeff[i]);
       if (maxval < val)
 	maxval = val;
     }
@@ -270,7 +410,7 @@ print_eps_sparsematrix(pcsparsematrix a, const char *filename, uint offset)
 
       (void) fprintf(out,
 		     "%u %u %f bx\n",
-		     j, rows - 1 - i, fabs(coeff[r]) / maxval);
+		     j, rows - 1 - i, ABS(coeff[r]) / maxval);
     }
 
   (void) fprintf(out, "showpage\n");
@@ -281,6 +421,58 @@ print_eps_sparsematrix(pcsparsematrix a, const char *filename, uint offset)
    Basic linear algebra
    ------------------------------------------------------------ */
 
+/* Minimal number of non-zero entries per thread in parallel products */
+#define SPARSE_PAR_NZ 4096
+
+/* Number of row blocks used to split a product among threads */
+static    uint
+getparts_sparsematrix(pcsparsematrix a)
+{
+#ifdef USE_OPENMP
+  uint      parts;
+
+  if (max_pardepth == 0)
+    return 1;
+
+  parts = UINT_MIN(getmaxthreads(), a->nz / SPARSE_PAR_NZ);
+  parts = UINT_MIN(parts, a->rows);
+
+  return UINT_MAX(parts, 1);
+#else
+  (void) a;
+
+  return 1;
+#endif
+}
+
+/* Split the rows into blocks with about the same number of non-zero
+ * entries, block p contains the rows start[p] to start[p+1]-1 */
+static void
+partition_sparsematrix(pcsparsematrix a, uint parts, uint * start)
+{
+  const uint *row = a->row;
+  size_t    target;
+  uint      p, i0, i1, i;
+
+  start[0] = 0;
+  for (p = 1; p < parts; p++) {
+    target = (size_t) a->nz * p / parts;
+
+    /* Binary search for the first row starting at or after target */
+    i0 = start[p - 1];
+    i1 = a->rows;
+    while (i0 < i1) {
+      i = (i0 + i1) / 2;
+      if (row[i] < target)
+	i0 = i + 1;
+      else
+	i1 = i;
+    }
+    start[p] = i0;
+  }
+  start[parts] = a->rows;
+}
+
 void
 addeval_sparsematrix_avector(field alpha, pcsparsematrix a,
 			     pcavector x, pavector y)
@@ -288,11 +480,12 @@ addeval_sparsematrix_avector(field alpha, pcsparsematrix a,
   uint     *row;
   uint     *col;
   field    *coeff;
-  uint      rows;
+  uint     *start;
+  uint      parts;
   pcfield   xv;
   pfield    yv;
   register field sum;
-  uint      i, j;
+  uint      p, i, j;
 
   assert(a != NULL);
   assert(x != NULL);
@@ -303,16 +496,26 @@ addeval_sparsematrix_avector(field alpha, pcsparsematrix a,
   row = a->row;
   col = a->col;
   coeff = a->coeff;
-  rows = a->rows;
   xv = x->v;
   yv = y->v;
 
-  for (i = 0; i < rows; i++) {
-    sum = 0.0;
-    for (j = row[i]; j < row[i + 1]; j++)
-      sum += coeff[j] * xv[col[j]];
-    yv[i] += alpha * sum;
-  }
+  parts = getparts_sparsematrix(a);
+  start = allocuint(parts + 1);
+  partition_sparsematrix(a, parts, start);
+
+  /* Rows are independent, so every thread can handle its own block */
+#ifdef USE_OPENMP
+#pragma omp parallel for if(parts > 1), num_threads(parts), private(i, j, sum)
+#endif
+  for (p = 0; p < parts; p++)
+    for (i = start[p]; i < start[p + 1]; i++) {
+      sum = 0.0;
+      for (j = row[i]; j < row[i + 1]; j++)
+	sum += coeff[j] * xv[col[j]];
+      yv[i] += alpha * sum;
+    }
+
+  freemem(start);
 }
 
 void
@@ -322,11 +525,17 @@ addevaltrans_sparsematrix_avector(field alpha, pcsparsematrix a,
   uint     *row;
   uint     *col;
   field    *coeff;
-  uint      rows;
+  uint      rows, cols;
+  uint     *start;
+  pfield   *buf;
+  uint      parts;
   pcfield   xv;
   pfield    yv;
+  pfield    b;
+  size_t    mark;
   register field val;
-  uint      i, j;
+  field     sum;
+  uint      p, q, i, j;
 
   assert(a != NULL);
   assert(x != NULL);
@@ -338,14 +547,64 @@ addevaltrans_sparsematrix_avector(field alpha, pcsparsematrix a,
   col = a->col;
   coeff = a->coeff;
   rows = a->rows;
+  cols = a->cols;
   xv = x->v;
   yv = y->v;
 
-  for (i = 0; i < rows; i++) {
-    val = alpha * xv[i];
-    for (j = row[i]; j < row[i + 1]; j++)
-      yv[col[j]] += coeff[j] * val;
+  parts = getparts_sparsematrix(a);
+
+  if (parts == 1) {
+    for (i = 0; i < rows; i++) {
+      val = alpha * xv[i];
+      for (j = row[i]; j < row[i + 1]; j++)
+	yv[col[j]] += coeff[j] * val;
+    }
+    return;
+  }
+
+  start = allocuint(parts + 1);
+  partition_sparsematrix(a, parts, start);
+  buf = (pfield *) allocmem(sizeof(pfield) * parts);
+
+  /* Different rows may contribute to the same entry of y, so every
+   * block is accumulated in a buffer of its own, and the buffers are
+   * added afterwards in a fixed order. */
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(parts), private(mark, b, val, sum, p, q, i, j)
+#endif
+  {
+    mark = mark_scratch();
+
+#ifdef USE_OPENMP
+#pragma omp for
+#endif
+    for (p = 0; p < parts; p++) {
+      b = buf[p] = allocscratch(cols);
+      for (j = 0; j < cols; j++)
+	b[j] = 0.0;
+
+      for (i = start[p]; i < start[p + 1]; i++) {
+	val = alpha * xv[i];
+	for (j = row[i]; j < row[i + 1]; j++)
+	  b[col[j]] += coeff[j] * val;
+      }
+    }
+
+#ifdef USE_OPENMP
+#pragma omp for
+#endif
+    for (j = 0; j < cols; j++) {
+      sum = 0.0;
+      for (q = 0; q < parts; q++)
+	sum += buf[q][j];
+      yv[j] += sum;
+    }
+
+    release_scratch(mark);
   }
+
+  freemem(buf);
+  freemem(start);
 }
 
 void
@@ -358,6 +617,153 @@ mvm_sparsematrix_avector(field alpha, bool trans, pcsparsematrix a,
     addeval_sparsematrix_avector(alpha, a, x, y);
 }
 
+void
+addeval_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+			     pcamatrix x, pamatrix y)
+{
+  const uint *row = a->row;
+  const uint *col = a->col;
+  pcfield   coeff = a->coeff;
+  uint      vectors = x->cols;
+  uint      ldx = x->ld;
+  uint      ldy = y->ld;
+  uint     *start;
+  uint      parts;
+  pcfield   xv;
+  pfield    sum;
+  size_t    mark;
+  field     c;
+  uint      p, i, j, l;
+
+  assert(x->rows == a->cols);
+  assert(y->rows == a->rows);
+  assert(y->cols == vectors);
+
+  parts = getparts_sparsematrix(a);
+  start = allocuint(parts + 1);
+  partition_sparsematrix(a, parts, start);
+
+  /* Every row of the result is accumulated in a small buffer, so that
+   * the columns of x are only traversed once per non-zero entry */
+#ifdef USE_OPENMP
+#pragma omp parallel for if(parts > 1), num_threads(parts), private(xv, sum, mark, c, i, j, l)
+#endif
+  for (p = 0; p < parts; p++) {
+    mark = mark_scratch();
+    sum = allocscratch(vectors);
+
+    for (i = start[p]; i < start[p + 1]; i++) {
+      for (l = 0; l < vectors; l++)
+	sum[l] = 0.0;
+
+      for (j = row[i]; j < row[i + 1]; j++) {
+	c = coeff[j];
+	xv = x->a + col[j];
+	for (l = 0; l < vectors; l++)
+	  sum[l] += c * xv[l * ldx];
+      }
+
+      for (l = 0; l < vectors; l++)
+	y->a[i + l * ldy] += alpha * sum[l];
+    }
+
+    release_scratch(mark);
+  }
+
+  freemem(start);
+}
+
+void
+addevaltrans_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+				  pcamatrix x, pamatrix y)
+{
+  const uint *row = a->row;
+  const uint *col = a->col;
+  pcfield   coeff = a->coeff;
+  uint      cols = a->cols;
+  uint      vectors = x->cols;
+  uint      ldx = x->ld;
+  uint      ldy = y->ld;
+  uint     *start;
+  pfield   *buf;
+  uint      parts;
+  pfield    b;
+  size_t    mark;
+  field     val, sum;
+  uint      p, q, i, j, l;
+
+  assert(x->rows == a->rows);
+  assert(y->rows == cols);
+  assert(y->cols == vectors);
+
+  parts = getparts_sparsematrix(a);
+
+  if (parts == 1) {
+    for (l = 0; l < vectors; l++)
+      for (i = 0; i < a->rows; i++) {
+	val = alpha * x->a[i + l * ldx];
+	for (j = row[i]; j < row[i + 1]; j++)
+	  y->a[col[j] + l * ldy] += coeff[j] * val;
+      }
+    return;
+  }
+
+  start = allocuint(parts + 1);
+  partition_sparsematrix(a, parts, start);
+  buf = (pfield *) allocmem(sizeof(pfield) * parts);
+
+  /* Same approach as for vectors: one buffer per row block, added up
+   * in a fixed order */
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(parts), private(mark, b, val, sum, p, q, i, j, l)
+#endif
+  {
+    mark = mark_scratch();
+
+#ifdef USE_OPENMP
+#pragma omp for
+#endif
+    for (p = 0; p < parts; p++) {
+      b = buf[p] = allocscratch((size_t) cols * vectors);
+      for (j = 0; j < cols * vectors; j++)
+	b[j] = 0.0;
+
+      for (l = 0; l < vectors; l++)
+	for (i = start[p]; i < start[p + 1]; i++) {
+	  val = alpha * x->a[i + l * ldx];
+	  for (j = row[i]; j < row[i + 1]; j++)
+	    b[col[j] + l * cols] += coeff[j] * val;
+	}
+    }
+
+#ifdef USE_OPENMP
+#pragma omp for
+#endif
+    for (l = 0; l < vectors; l++)
+      for (j = 0; j < cols; j++) {
+	sum = 0.0;
+	for (q = 0; q < parts; q++)
+	  sum += buf[q][j + l * cols];
+	y->a[j + l * ldy] += sum;
+      }
+
+    release_scratch(mark);
+  }
+
+  freemem(buf);
+  freemem(start);
+}
+
+void
+mvm_sparsematrix_amatrix(field alpha, bool trans, pcsparsematrix a,
+			 pcamatrix x, pamatrix y)
+{
+  if (trans)
+    addevaltrans_sparsematrix_amatrix(alpha, a, x, y);
+  else
+    addeval_sparsematrix_amatrix(alpha, a, x, y);
+}
+
 real
 norm2_sparsematrix(pcsparsematrix a)
 {
@@ -420,7 +826,7 @@ add_sparsematrix_amatrix(field alpha, bool atrans, pcsparsematrix a,
     for (i = 0; i < rows; i++)
       for (k = row[i]; k < row[i + 1]; k++) {
 	j = col[k];
-	b->a[i + k * ldb] += alpha * coeff[k];
+	b->a[i + j * ldb] += alpha * coeff[k];
       }
   }
 }
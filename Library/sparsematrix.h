@@ -81,6 +81,33 @@ new_raw_sparsematrix(uint rows, uint cols, uint nz);
 HEADER_PREFIX psparsematrix
 new_zero_sparsematrix(psparsepattern sp);
 
+/** @brief Create a sparsematrix from a list of triplets
+ *  @f$(i_k, j_k, x_k)@f$.
+ *
+ *  The triplets are distributed to their rows by a counting sort,
+ *  the rows are sorted by column and entries appearing more than
+ *  once are added. Compared to a @ref sparsepattern, no storage has
+ *  to be allocated for individual entries, so this is the preferred
+ *  way to set up large matrices, e.g., finite element matrices with
+ *  one triplet per element contribution.
+ *
+ *  @remark Should always be matched by a call to @ref del_sparsematrix.
+ *
+ *  @param rows Number of rows.
+ *  @param cols Number of columns.
+ *  @param nz Number of triplets.
+ *  @param ri Row indices @f$i_k@f$.
+ *  @param ci Column indices @f$j_k@f$.
+ *  @param x Coefficients @f$x_k@f$, if <tt>NULL</tt>, all coefficients
+ *     of the new matrix are zero.
+ *  @returns Fully initialized @ref sparsematrix object with
+ *     @f$a_{ij} = \sum_{i_k=i, j_k=j} x_k@f$, diagonal entries come
+ *     first in every row, followed by the remaining entries in
+ *     ascending order of columns. */
+HEADER_PREFIX psparsematrix
+new_triplet_sparsematrix(uint rows, uint cols, uint nz,
+			 const uint *ri, const uint *ci, pcfield x);
+
 /** @brief Delete a @ref sparsematrix object.
  *
  *  Releases the storage corresponding to the object.
@@ -182,6 +209,9 @@ print_eps_sparsematrix(pcsparsematrix a,
  *  the result is scaled by @f$\alpha@f$ and added to the
  *  target vector @f$y@f$.
  *
+ *  If OpenMP is used, the rows are split into blocks with about
+ *  the same number of non-zero entries that are handled in parallel.
+ *
  *  @param alpha Scaling factor @f$\alpha@f$.
  *  @param a Matrix @f$A@f$.
  *  @param x Source vector @f$x@f$.
@@ -197,6 +227,11 @@ addeval_sparsematrix_avector(field alpha, pcsparsematrix a,
  *  the result is scaled by @f$\alpha@f$ and added to the
  *  target vector @f$y@f$.
  *
+ *  If OpenMP is used, every block of rows is accumulated in an
+ *  auxiliary vector of its own, and these vectors are added to
+ *  @f$y@f$ in a fixed order, so the result does not depend on the
+ *  scheduling of the threads.
+ *
  *  @param alpha Scaling factor @f$\alpha@f$.
  *  @param a Matrix @f$A@f$.
  *  @param x Source vector @f$x@f$.
@@ -221,6 +256,44 @@ HEADER_PREFIX void
 mvm_sparsematrix_avector(field alpha, bool trans, pcsparsematrix a,
 		 pcavector x, pavector y);
 
+/** @brief Multiply a matrix @f$A@f$ by a matrix @f$X@f$,
+ *  @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  Every non-zero entry of @f$A@f$ is used for all columns of
+ *  @f$X@f$ at once, which is considerably faster than multiplying
+ *  by the columns one after another.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param a Matrix @f$A@f$.
+ *  @param x Source matrix @f$X@f$.
+ *  @param y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addeval_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+		     pcamatrix x, pamatrix y);
+
+/** @brief Multiply the adjoint of a matrix @f$A@f$ by a matrix @f$X@f$,
+ *  @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param a Matrix @f$A@f$.
+ *  @param x Source matrix @f$X@f$.
+ *  @param y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addevaltrans_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+			  pcamatrix x, pamatrix y);
+
+/** @brief Multiply a matrix @f$A@f$ or its adjoint @f$A^*@f$ by a
+ *  matrix, @f$Y \gets Y + \alpha A X@f$ or @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param trans Set if @f$A^*@f$ is to be used instead of @f$A@f$.
+ *  @param a Matrix @f$A@f$.
+ *  @param x Source matrix @f$X@f$.
+ *  @param y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+mvm_sparsematrix_amatrix(field alpha, bool trans, pcsparsematrix a,
+		 pcamatrix x, pamatrix y);
+
 /** @brief Approximate the spectral norm @f$\|A\|_2@f$ of a matrix @f$A@f$.
  *
  *  The spectral norm is approximated by applying a few steps of the power
@@ -23,6 +23,8 @@ new_truncmode()
   tm->blocks = false;
   tm->zeta_level = 1.0;
   tm->zeta_age = 1.0;
+  tm->accum_rank = 0;
+  tm->randomized = false;
 
   return tm;
 }
@@ -129,12 +131,12 @@ findrank_truncmode(pctruncmode tm, real eps, pcavector sigma)
   else {
     if (tm && tm->absolute) {
       k = 0;
-      while (k < sigma->dim && sigma->v[k] > eps)
+      while (k < sigma->dim && REAL(sigma->v[k]) > eps)
 	k++;
     }
     else {
       k = 0;
-      while (k < sigma->dim && sigma->v[k] > eps * sigma->v[0])
+      while (k < sigma->dim && REAL(sigma->v[k]) > eps * REAL(sigma->v[0]))
 	k++;
     }
   }
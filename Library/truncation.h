@@ -52,6 +52,16 @@ struct _truncmode {
   real zeta_level;
   /** @brief Block-age-dependent tolerance factor */
   real zeta_age;
+
+  /** @brief If positive, low-rank updates of admissible leaves in the
+   *  @f$\mathcal{H}@f$-matrix arithmetic are accumulated and truncated
+   *  only once or when the rank of a leaf exceeds this value. */
+  uint accum_rank;
+
+  /** @brief If set to <tt>true</tt>, low-rank matrices of high rank are
+   *  truncated by a randomized range finder that adapts the number of
+   *  samples to the new rank. */
+  bool randomized;
 };
 
 /* ------------------------------------------------------------
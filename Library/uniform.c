@@ -27,6 +27,7 @@ new_uniform(pclusterbasis rb, pclusterbasis cb)
   ref_col_uniform(u, cb);
 
   init_amatrix(&u->S, rb->k, cb->k);
+  u->s = NULL;
 
   return u;
 }
@@ -36,6 +37,9 @@ del_uniform(puniform u)
 {
   assert(u != 0);
 
+  if (u->s)
+    freemem(u->s);
+
   uninit_amatrix(&u->S);
 
   unref_row_uniform(u);
@@ -136,6 +140,38 @@ unref_col_uniform(puniform u)
   u->cb = 0;
 }
 
+/* ------------------------------------------------------------
+   Single precision storage
+   ------------------------------------------------------------ */
+
+void
+tosingle_uniform(puniform u)
+{
+  uint      rows, cols;
+
+  assert(u->s == NULL);
+
+  rows = u->S.rows;
+  cols = u->S.cols;
+
+  u->s = (psfield) allocmem(sizeof(sfield) * (size_t) rows * cols);
+  tosingle_amatrix(&u->S, u->s);
+
+  resize_amatrix(&u->S, rows, 0);
+}
+
+void
+todouble_uniform(puniform u)
+{
+  assert(u->s != NULL);
+
+  resize_amatrix(&u->S, u->rb->k, u->cb->k);
+  fromsingle_amatrix(u->s, &u->S);
+
+  freemem(u->s);
+  u->s = NULL;
+}
+
 /* ------------------------------------------------------------
    Statistics
    ------------------------------------------------------------ */
@@ -147,6 +183,8 @@ getsize_uniform(pcuniform u)
 
   sz = sizeof(uniform);
   sz += getsize_heap_amatrix(&u->S);
+  if (u->s)
+    sz += sizeof(sfield) * (size_t) u->rb->k * u->cb->k;
 
   return sz;
 }
@@ -270,7 +308,7 @@ mvm_uniform_avector(field alpha, bool trans, pcuniform u,
 
     clear_avector(yt);
 
-    mvm_amatrix_avector(alpha, true, &u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, true, u, xt, yt);
 
     expand_clusterbasis_avector(u->cb, yt, y);
 
@@ -285,7 +323,7 @@ mvm_uniform_avector(field alpha, bool trans, pcuniform u,
 
     clear_avector(yt);
 
-    mvm_amatrix_avector(alpha, false, &u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, false, u, xt, yt);
 
     expand_clusterbasis_avector(u->rb, yt, y);
 
@@ -294,6 +332,20 @@ mvm_uniform_avector(field alpha, bool trans, pcuniform u,
   }
 }
 
+void
+mvm_coupling_uniform_avector(field alpha, bool trans, pcuniform u,
+			     pcavector xt, pavector yt)
+{
+  if (u->s) {
+    if (trans)
+      addevaltrans_single_avector(alpha, u->rb->k, u->cb->k, u->s, xt, yt);
+    else
+      addeval_single_avector(alpha, u->rb->k, u->cb->k, u->s, xt, yt);
+  }
+  else
+    mvm_amatrix_avector(alpha, trans, &u->S, xt, yt);
+}
+
 /* ------------------------------------------------------------
    Conversion operations
    ------------------------------------------------------------ */
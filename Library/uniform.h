@@ -72,6 +72,9 @@ struct _uniform {
   pclusterbasis cb;
   /** @brief Coupling matrix */
   amatrix S;
+  /** @brief Coupling matrix in single precision if converted by
+   *  @ref tosingle_uniform, <tt>NULL</tt> otherwise */
+  psfield s;
   /** @brief Row block list */
   puniform rnext, rprev;
   /** @brief Column block list */
@@ -166,6 +169,32 @@ unref_row_uniform(puniform u);
 HEADER_PREFIX void
 unref_col_uniform(puniform u);
 
+/* ------------------------------------------------------------
+ Single precision storage
+ ------------------------------------------------------------ */
+
+/** @brief Store the coupling matrix of a @ref _uniform "uniform" matrix
+ *  in single precision.
+ *
+ *  The coupling matrix is converted to @ref sfield and stored in
+ *  <tt>u->s</tt>, its double precision coefficients are released, and
+ *  <tt>u->S</tt> keeps its number of rows but has no columns.
+ *
+ *  @remark The resulting matrix can only be used for matrix-vector
+ *  multiplications.
+ *  Use @ref todouble_uniform before any other operation.
+ *
+ *  @param u Matrix owning its coupling matrix. */
+HEADER_PREFIX void
+tosingle_uniform(puniform u);
+
+/** @brief Restore the coupling matrix of a @ref _uniform "uniform"
+ *  matrix from single precision.
+ *
+ *  @param u Matrix converted by @ref tosingle_uniform. */
+HEADER_PREFIX void
+todouble_uniform(puniform u);
+
 /* ------------------------------------------------------------
  Statistics
  ------------------------------------------------------------ */
@@ -256,6 +285,23 @@ normfrob_fast_uniform(pcuniform u, pcclusteroperator rw, pcclusteroperator cw);
 HEADER_PREFIX void
 mvm_uniform_avector(field alpha, bool trans, pcuniform u, pcavector x, pavector y);
 
+/** @brief Multiply the coupling matrix @f$S_b@f$ or its adjoint by a
+ *  coefficient vector,
+ *  @f$\widehat y \gets \widehat y + \alpha S_b \widehat x@f$ or
+ *  @f$\widehat y \gets \widehat y + \alpha S_b^* \widehat x@f$.
+ *
+ *  Uses the single precision coefficients if the coupling matrix has
+ *  been converted by @ref tosingle_uniform.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param trans Set if @f$S_b^*@f$ is to be used instead of @f$S_b@f$.
+ *  @param u Matrix containing the coupling matrix @f$S_b@f$.
+ *  @param xt Source coefficients @f$\widehat x@f$.
+ *  @param yt Target coefficients @f$\widehat y@f$. */
+HEADER_PREFIX void
+mvm_coupling_uniform_avector(field alpha, bool trans, pcuniform u,
+			     pcavector xt, pavector yt);
+
 /* ------------------------------------------------------------
  Conversion operations
  ------------------------------------------------------------ */
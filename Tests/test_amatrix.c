@@ -2,6 +2,7 @@
 
 #include "amatrix.h"
 #include "factorizations.h"
+#include "sparsematrix.h"
 #include "settings.h"
 
 static uint problems = 0;
@@ -332,6 +333,338 @@ check_triangularaddmul(bool alower, bool atrans, bool blower, bool btrans)
   uninit_amatrix(a);
 }
 
+static void
+check_scratch()
+{
+  amatrix   tmp1, tmp2;
+  avector   tmp3;
+  pamatrix  a, b;
+  pavector  c;
+  size_t    mark0, mark1;
+  uint      i, j, errors;
+
+  (void) printf("Check scratch arena\n");
+
+  errors = 0;
+  mark0 = mark_scratch();
+
+  a = init_scratch_amatrix(&tmp1, 50, 40);
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++)
+      a->a[i + j * a->ld] = i + 100.0 * j;
+
+  /* Larger than the remaining storage, so a new block is required */
+  mark1 = mark_scratch();
+  b = init_scratch_amatrix(&tmp2, 100, 100);
+  clear_amatrix(b);
+  c = init_scratch_avector(&tmp3, 3000);
+  fill_avector(c, 1.0);
+  if (mark_scratch() != mark1 + 13000)
+    errors++;
+  uninit_avector(c);
+  uninit_amatrix(b);
+  release_scratch(mark1);
+  if (mark_scratch() != mark1)
+    errors++;
+
+  /* Reuse the released storage */
+  b = init_scratch_amatrix(&tmp2, 100, 100);
+  clear_amatrix(b);
+  uninit_amatrix(b);
+
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++)
+      if (a->a[i + j * a->ld] != i + 100.0 * j)
+	errors++;
+  uninit_amatrix(a);
+
+  release_scratch(mark0);
+  if (mark_scratch() != mark0)
+    errors++;
+  if (getpeak_scratch() < 15000 * sizeof(field))
+    errors++;
+
+  /* Very large arenas do not keep their storage */
+  mark0 = mark_scratch();
+  fill_avector(init_scratch_avector(&tmp3, 1 << 21), 1.0);
+  uninit_avector(&tmp3);
+  release_scratch(mark0);
+  if (getsize_scratch() >= (1 << 21) * sizeof(field))
+    errors++;
+
+  /* Arenas of all threads are returned to the heap */
+#ifdef USE_OPENMP
+#pragma omp parallel private(mark1, tmp3)
+#endif
+  {
+    mark1 = mark_scratch();
+    fill_avector(init_scratch_avector(&tmp3, 1000), 1.0);
+    uninit_avector(&tmp3);
+    release_scratch(mark1);
+  }
+  clear_all_scratch();
+  if (getsize_scratch() != 0)
+    errors++;
+
+  (void) printf("  %u errors, peak %.1f KB, %sokay\n", errors,
+		getpeak_scratch() / 1024.0, (errors == 0 ? "" : "    NOT "));
+  if (errors > 0)
+    problems++;
+}
+
+static void
+check_sparse(uint rows, uint cols)
+{
+  psparsepattern sp;
+  psparsematrix s;
+  pamatrix  a, x, y1, y2;
+  pavector  xv, yv1, yv2;
+  real      error;
+  uint      i, j;
+
+  (void) printf("Check sparse products for %u x %u matrix\n", rows, cols);
+
+  sp = new_sparsepattern(rows, cols);
+  for (i = 0; i < rows; i++)
+    for (j = 0; j < 40; j++)
+      addnz_sparsepattern(sp, i, (i * 7 + j * j * 13) % cols);
+  s = new_zero_sparsematrix(sp);
+  del_sparsepattern(sp);
+
+  /* Real coefficients, so that transposition and adjoint coincide */
+  for (j = 0; j < s->nz; j++)
+    s->coeff[j] = 2.0 * rand() / RAND_MAX - 1.0;
+
+  a = new_zero_amatrix(rows, cols);
+  add_sparsematrix_amatrix(1.0, false, s, a);
+
+  xv = new_avector(cols);
+  random_avector(xv);
+  yv1 = new_avector(rows);
+  random_avector(yv1);
+  yv2 = new_avector(rows);
+  copy_avector(yv1, yv2);
+  addeval_sparsematrix_avector(2.0, s, xv, yv1);
+  addeval_amatrix_avector(2.0, a, xv, yv2);
+  add_avector(-1.0, yv1, yv2);
+  error = norm2_avector(yv2) / normfrob_amatrix(a) / norm2_avector(xv);
+  (void) printf("  Matrix-vector accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+  del_avector(yv2);
+  del_avector(yv1);
+  del_avector(xv);
+
+  xv = new_avector(rows);
+  random_avector(xv);
+  yv1 = new_avector(cols);
+  random_avector(yv1);
+  yv2 = new_avector(cols);
+  copy_avector(yv1, yv2);
+  addevaltrans_sparsematrix_avector(2.0, s, xv, yv1);
+  addevaltrans_amatrix_avector(2.0, a, xv, yv2);
+  add_avector(-1.0, yv1, yv2);
+  error = norm2_avector(yv2) / normfrob_amatrix(a) / norm2_avector(xv);
+  (void) printf("  Adjoint matrix-vector accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+  del_avector(yv2);
+  del_avector(yv1);
+  del_avector(xv);
+
+  x = new_amatrix(cols, 5);
+  random_amatrix(x);
+  y1 = new_amatrix(rows, 5);
+  random_amatrix(y1);
+  y2 = new_amatrix(rows, 5);
+  copy_amatrix(false, y1, y2);
+  addeval_sparsematrix_amatrix(2.0, s, x, y1);
+  addmul_amatrix(2.0, false, a, false, x, y2);
+  add_amatrix(-1.0, false, y1, y2);
+  error = normfrob_amatrix(y2) / normfrob_amatrix(a) / normfrob_amatrix(x);
+  (void) printf("  Matrix-matrix accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+  del_amatrix(y2);
+  del_amatrix(y1);
+  del_amatrix(x);
+
+  x = new_amatrix(rows, 5);
+  random_amatrix(x);
+  y1 = new_amatrix(cols, 5);
+  random_amatrix(y1);
+  y2 = new_amatrix(cols, 5);
+  copy_amatrix(false, y1, y2);
+  addevaltrans_sparsematrix_amatrix(2.0, s, x, y1);
+  addmul_amatrix(2.0, true, a, false, x, y2);
+  add_amatrix(-1.0, false, y1, y2);
+  error = normfrob_amatrix(y2) / normfrob_amatrix(a) / normfrob_amatrix(x);
+  (void) printf("  Adjoint matrix-matrix accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+  del_amatrix(y2);
+  del_amatrix(y1);
+  del_amatrix(x);
+
+  del_amatrix(a);
+  del_sparsematrix(s);
+}
+
+static void
+check_triplet_sparse(uint rows, uint cols)
+{
+  psparsematrix s;
+  pamatrix  a, b;
+  uint     *ri, *ci;
+  pfield    x;
+  real      error;
+  uint      nz, i, j, k;
+  bool      okay;
+
+  (void) printf("Check triplet construction for %u x %u matrix\n",
+		rows, cols);
+
+  /* Every entry appears several times, so duplicates have to be merged */
+  nz = 20 * rows;
+  ri = allocuint(nz);
+  ci = allocuint(nz);
+  x = allocfield(nz);
+  a = new_zero_amatrix(rows, cols);
+  for (k = 0; k < nz; k++) {
+    ri[k] = (k * 13) % rows;
+    ci[k] = (k < rows ? k % cols : (k * k * 7) % 5 * 31 % cols);
+    x[k] = 2.0 * rand() / RAND_MAX - 1.0;
+    addentry_amatrix(a, ri[k], ci[k], x[k]);
+  }
+
+  s = new_triplet_sparsematrix(rows, cols, nz, ri, ci, x);
+
+  b = new_zero_amatrix(rows, cols);
+  add_sparsematrix_amatrix(1.0, false, s, b);
+  add_amatrix(-1.0, false, a, b);
+  error = normfrob_amatrix(b) / normfrob_amatrix(a);
+  (void) printf("  Coefficient accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+
+  okay = true;
+  for (i = 0; i < rows; i++) {
+    k = s->row[i];
+    if (i < cols && k < s->row[i + 1] && s->col[k] == i)
+      k++;
+    for (j = k + 1; j < s->row[i + 1]; j++)
+      if (s->col[j - 1] >= s->col[j] || s->col[j] == i)
+	okay = false;
+  }
+  (void) printf("  Diagonal first, columns ascending and unique, %sokay\n",
+		(okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  del_amatrix(b);
+  del_amatrix(a);
+  del_sparsematrix(s);
+  freemem(x);
+  freemem(ci);
+  freemem(ri);
+}
+
+static void
+check_blocked(uint n)
+{
+  pamatrix  a, b, c, l, r;
+  avector   tmp1, tmp2;
+  pavector  bj, cj;
+  real      error;
+  uint      j;
+
+  (void) printf("Check blocked kernels for n=%u\n", n);
+
+  a = new_amatrix(n, n);
+  random_invertible_amatrix(a, 1.0);
+  b = new_amatrix(n, n + 3);
+  random_amatrix(b);
+  c = new_amatrix(n, n + 3);
+
+  /* Compare matrix-matrix with matrix-vector products */
+  clear_amatrix(c);
+  addmul_amatrix(1.0, false, a, false, b, c);
+  for (j = 0; j < b->cols; j++) {
+    bj = init_column_avector(&tmp1, b, j);
+    cj = init_column_avector(&tmp2, c, j);
+    addeval_amatrix_avector(-1.0, a, bj, cj);
+    uninit_avector(cj);
+    uninit_avector(bj);
+  }
+  error = normfrob_amatrix(c) / normfrob_amatrix(a) / normfrob_amatrix(b);
+  (void) printf("  Product accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+
+  clear_amatrix(c);
+  addmul_amatrix(1.0, true, a, false, b, c);
+  for (j = 0; j < b->cols; j++) {
+    bj = init_column_avector(&tmp1, b, j);
+    cj = init_column_avector(&tmp2, c, j);
+    addevaltrans_amatrix_avector(-1.0, a, bj, cj);
+    uninit_avector(cj);
+    uninit_avector(bj);
+  }
+  error = normfrob_amatrix(c) / normfrob_amatrix(a) / normfrob_amatrix(b);
+  (void) printf("  Adjoint product accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+
+  del_amatrix(c);
+
+  /* LR factorization */
+  c = new_amatrix(n, n);
+  l = new_amatrix(n, n);
+  r = new_amatrix(n, n);
+  copy_amatrix(false, a, c);
+  lrdecomp_amatrix(c);
+  copy_lower_amatrix(c, true, l);
+  copy_upper_amatrix(c, false, r);
+  addmul_amatrix(-1.0, false, l, false, r, a);
+  error = normfrob_amatrix(a) / normfrob_amatrix(c);
+  (void) printf("  LR factorization accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+
+  /* Cholesky factorization */
+  random_spd_amatrix(a, 1.0);
+  copy_amatrix(false, a, c);
+  choldecomp_amatrix(c);
+  copy_lower_amatrix(c, false, l);
+  addmul_amatrix(-1.0, false, l, true, l, a);
+  error = normfrob_amatrix(a) / normfrob_amatrix(c);
+  (void) printf("  Cholesky factorization accuracy %g, %sokay\n", error,
+		(error < tolerance ? "" : "    NOT "));
+  if (error >= tolerance)
+    problems++;
+
+  /* Triangular solves */
+  check_triangularsolve(true, false, false, l, false);
+  check_triangularsolve(true, false, true, l, true);
+  copy_upper_amatrix(c, false, r);
+  check_triangularsolve(false, false, false, r, true);
+  check_triangularsolve(false, false, true, r, false);
+
+  del_amatrix(r);
+  del_amatrix(l);
+  del_amatrix(c);
+  del_amatrix(b);
+  del_amatrix(a);
+}
+
 static void
 set_unit(pamatrix R)
 {
@@ -344,13 +677,15 @@ set_unit(pamatrix R)
 }
 
 int
-main()
+main(int argc, char **argv)
 {
   pamatrix  a, acopy, l, ld, r, q, qr;
   pavector  x, b, tau;
   uint      rows, cols;
   real      error;
 
+  init_h2lib(&argc, &argv);
+
   rows = 8;
   cols = 5;
 
@@ -694,6 +1029,15 @@ main()
   if (error >= tolerance)
     problems++;
 
+  check_scratch();
+
+  (void) printf("----------------------------------------\n");
+  check_blocked(150);
+
+  (void) printf("----------------------------------------\n");
+  check_sparse(400, 300);
+  check_triplet_sparse(400, 300);
+
   /* Final clean-up */
   (void) printf("Cleaning up\n");
   del_amatrix(qr);
@@ -709,5 +1053,7 @@ main()
 		"  %u errors found\n", getactives_amatrix(),
 		getactives_avector(), problems);
 
+  uninit_h2lib();
+
   return problems;
 }
@@ -16,6 +16,303 @@ static uint problems = 0;
 
 #define IS_IN_RANGE(a, b, c) (((a) < (b)) && ((b) < (c)))
 
+static void
+check_parallel_mvm(pch2matrix h2, bool atrans)
+{
+  pclusterbasis rb = (atrans ? h2->cb : h2->rb);
+  pclusterbasis cb = (atrans ? h2->rb : h2->cb);
+  pavector  x, xt, yt1, yt2;
+  real      error;
+
+  x = new_avector(cb->t->size);
+  random_avector(x);
+
+  xt = new_coeffs_clusterbasis_avector(cb);
+  forward_clusterbasis_avector(cb, x, xt);
+
+  yt1 = new_coeffs_clusterbasis_avector(rb);
+  random_avector(yt1);
+  yt2 = new_coeffs_clusterbasis_avector(rb);
+  copy_avector(yt1, yt2);
+
+  if (atrans) {
+    fastaddevaltrans_h2matrix_avector(1.0, h2, xt, yt1);
+    fastaddevaltrans_parallel_h2matrix_avector(1.0, h2, xt, yt2, 4);
+  }
+  else {
+    fastaddeval_h2matrix_avector(1.0, h2, xt, yt1);
+    fastaddeval_parallel_h2matrix_avector(1.0, h2, xt, yt2, 4);
+  }
+
+  /* The parallel interaction phase has to reproduce the sequential result */
+  add_avector(-1.0, yt1, yt2);
+  error = norm2_avector(yt2);
+  (void) printf("Checking parallel interaction phase (atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error == 0.0 ? "" : "    NOT "));
+  if (error != 0.0)
+    problems++;
+
+  del_avector(yt2);
+  del_avector(yt1);
+  del_avector(xt);
+  del_avector(x);
+}
+
+static void
+check_multi_mvm(pch2matrix h2, bool atrans)
+{
+  pamatrix  X, Y1, Y2;
+  avector   tmp1, tmp2;
+  pavector  x, y;
+  uint      rows, cols, j;
+  real      error;
+
+  rows = (atrans ? h2->cb->t->size : h2->rb->t->size);
+  cols = (atrans ? h2->rb->t->size : h2->cb->t->size);
+
+  X = new_amatrix(cols, 7);
+  random_amatrix(X);
+  Y1 = new_amatrix(rows, 7);
+  random_amatrix(Y1);
+  Y2 = new_amatrix(rows, 7);
+  copy_amatrix(false, Y1, Y2);
+
+  /* Multiply all columns at once */
+  mvm_h2matrix_amatrix(2.0, atrans, h2, X, Y1);
+
+  /* Multiply column by column */
+  for (j = 0; j < X->cols; j++) {
+    x = init_column_avector(&tmp1, X, j);
+    y = init_column_avector(&tmp2, Y2, j);
+    mvm_h2matrix_avector(2.0, atrans, h2, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+
+  add_amatrix(-1.0, false, Y1, Y2);
+  error = normfrob_amatrix(Y2) / normfrob_amatrix(Y1);
+  (void) printf("Checking multiplication with multiple vectors (atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error <= 1e-13 ? "" : "    NOT "));
+  if (error > 1e-13)
+    problems++;
+
+  del_amatrix(Y2);
+  del_amatrix(Y1);
+  del_amatrix(X);
+}
+
+static void
+check_frozen_mvm(pch2matrix h2, bool atrans)
+{
+  pclusterbasis rbcopy, cbcopy;
+  ph2matrix h2copy;
+  pavector  x, y1, y2;
+  real      error;
+
+  rbcopy = clone_clusterbasis(h2->rb);
+  cbcopy = clone_clusterbasis(h2->cb);
+  h2copy = clone_h2matrix(h2, rbcopy, cbcopy);
+
+  freeze_clusterbasis(rbcopy);
+  freeze_clusterbasis(cbcopy);
+  freeze_h2matrix(h2copy);
+
+  x = new_avector(atrans ? h2->rb->t->size : h2->cb->t->size);
+  y1 = new_avector(atrans ? h2->cb->t->size : h2->rb->t->size);
+  y2 = new_avector(y1->dim);
+
+  random_avector(x);
+  random_avector(y1);
+  copy_avector(y1, y2);
+
+  mvm_h2matrix_avector(1.0, atrans, h2, x, y1);
+  mvm_h2matrix_avector(1.0, atrans, h2copy, x, y2);
+
+  /* Only the storage has changed, so the result has to be identical */
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2);
+  (void) printf("Checking frozen matrix-vector multiplication (atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error == 0.0 ? "" : "    NOT "));
+  if (error != 0.0)
+    problems++;
+
+  del_avector(y2);
+  del_avector(y1);
+  del_avector(x);
+
+  del_h2matrix(h2copy);
+}
+
+static void
+check_batch_mvm(pch2matrix h2, bool atrans)
+{
+  pclusterbasis rbcopy, cbcopy;
+  ph2matrix h2copy;
+  pamatrix  X, Y1, Y2;
+  pavector  x, y1, y2;
+  uint      rows, cols;
+  real      error;
+
+  rbcopy = clone_clusterbasis(h2->rb);
+  cbcopy = clone_clusterbasis(h2->cb);
+  h2copy = clone_h2matrix(h2, rbcopy, cbcopy);
+
+  prepare_batch_clusterbasis(rbcopy);
+  prepare_batch_clusterbasis(cbcopy);
+
+  rows = (atrans ? h2->cb->t->size : h2->rb->t->size);
+  cols = (atrans ? h2->rb->t->size : h2->cb->t->size);
+
+  x = new_avector(cols);
+  y1 = new_avector(rows);
+  y2 = new_avector(rows);
+
+  random_avector(x);
+  random_avector(y1);
+  copy_avector(y1, y2);
+
+  mvm_h2matrix_avector(1.0, atrans, h2, x, y1);
+  mvm_h2matrix_avector(1.0, atrans, h2copy, x, y2);
+
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+  (void) printf("Checking batched matrix-vector multiplication (atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error <= 1e-13 ? "" : "    NOT "));
+  if (error > 1e-13)
+    problems++;
+
+  X = new_amatrix(cols, 7);
+  random_amatrix(X);
+  Y1 = new_amatrix(rows, 7);
+  random_amatrix(Y1);
+  Y2 = new_amatrix(rows, 7);
+  copy_amatrix(false, Y1, Y2);
+
+  mvm_h2matrix_amatrix(1.0, atrans, h2, X, Y1);
+  mvm_h2matrix_amatrix(1.0, atrans, h2copy, X, Y2);
+
+  add_amatrix(-1.0, false, Y1, Y2);
+  error = normfrob_amatrix(Y2) / normfrob_amatrix(Y1);
+  (void) printf("Checking batched multiplication with multiple vectors "
+		"(atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error <= 1e-13 ? "" : "    NOT "));
+  if (error > 1e-13)
+    problems++;
+
+  del_amatrix(Y2);
+  del_amatrix(Y1);
+  del_amatrix(X);
+  del_avector(y2);
+  del_avector(y1);
+  del_avector(x);
+
+  del_h2matrix(h2copy);
+}
+
+static void
+check_single_mvm(pch2matrix h2, bool atrans)
+{
+  ph2matrix h2copy;
+  pavector  x, y1, y2;
+  real      error;
+
+  h2copy = clone_h2matrix(h2, h2->rb, h2->cb);
+  tosingle_h2matrix(h2copy);
+
+  x = new_avector(atrans ? h2->rb->t->size : h2->cb->t->size);
+  y1 = new_avector(atrans ? h2->cb->t->size : h2->rb->t->size);
+  y2 = new_avector(y1->dim);
+
+  random_avector(x);
+  random_avector(y1);
+  copy_avector(y1, y2);
+
+  mvm_h2matrix_avector(1.0, atrans, h2, x, y1);
+  mvm_h2matrix_avector(1.0, atrans, h2copy, x, y2);
+
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+  (void) printf("Checking single precision matrix-vector multiplication "
+		"(atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(IS_IN_RANGE(0.0, error, 1.0e-6) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-6))
+    problems++;
+
+  /* Restoring double precision has to reproduce the coupling matrices
+     up to rounding */
+  todouble_h2matrix(h2copy);
+  copy_avector(y1, y2);
+  mvm_h2matrix_avector(1.0, atrans, h2, x, y1);
+  mvm_h2matrix_avector(1.0, atrans, h2copy, x, y2);
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+  (void) printf("  Restored accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 1.0e-6) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-6))
+    problems++;
+
+  del_avector(y2);
+  del_avector(y1);
+  del_avector(x);
+
+  del_h2matrix(h2copy);
+}
+
+static void
+check_binary_h2matrix(pch2matrix h2, bool map)
+{
+  ph2matrix h2copy;
+  pcluster  rc, cc;
+  pavector  x, y1, y2;
+  real      error;
+
+  write_binary_h2matrix(h2, "test_h2matrix.bin");
+  h2copy = read_binary_h2matrix("test_h2matrix.bin", map);
+  (void) remove("test_h2matrix.bin");
+
+  x = new_avector(h2->cb->t->size);
+  y1 = new_avector(h2->rb->t->size);
+  y2 = new_avector(y1->dim);
+
+  random_avector(x);
+  clear_avector(y1);
+  clear_avector(y2);
+
+  mvm_h2matrix_avector(1.0, false, h2, x, y1);
+  mvm_h2matrix_avector(1.0, false, h2copy, x, y2);
+
+  /* Same coefficients and same traversal, so the result is identical */
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2);
+  (void) printf("Checking binary file for H2-matrix (map=%s)\n"
+		"  Accuracy %g, %sokay\n", (map ? "tr" : "fl"), error,
+		(error == 0.0 ? "" : "    NOT "));
+  if (error != 0.0)
+    problems++;
+
+  del_avector(y2);
+  del_avector(y1);
+  del_avector(x);
+
+  rc = (pcluster) h2copy->rb->t;
+  cc = (pcluster) h2copy->cb->t;
+
+  del_h2matrix(h2copy);
+
+  if (cc != rc) {
+    freemem(cc->idx);
+    del_cluster(cc);
+  }
+  freemem(rc->idx);
+  del_cluster(rc);
+}
+
 int
 main()
 {
@@ -69,6 +366,13 @@ main()
   clear_avector(b);
   mvm_h2matrix_avector(1.0, false, h2, x, b);
 
+  check_parallel_mvm(h2, false);
+  check_parallel_mvm(h2, true);
+  check_multi_mvm(h2, false);
+  check_multi_mvm(h2, true);
+  check_batch_mvm(h2, false);
+  check_batch_mvm(h2, true);
+
   (void) printf("Copying matrix\n");
 
   rbcopy = clone_clusterbasis(h2->rb);
@@ -200,6 +504,12 @@ main()
   if (!IS_IN_RANGE(4.0e-15, error, 5.0e-14))
     problems++;
 
+  check_frozen_mvm(L, false);
+  check_frozen_mvm(L, true);
+  check_binary_h2matrix(L, false);
+  check_binary_h2matrix(L, true);
+  check_single_mvm(L, false);
+  check_single_mvm(L, true);
 
   /* Final clean-up */
   (void) printf("Cleaning up\n");
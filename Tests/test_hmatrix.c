@@ -1,4 +1,6 @@
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "settings.h"
 #include "hmatrix.h"
 #include "harith.h"
@@ -32,6 +34,136 @@ check_addhmatrix(phmatrix a, real tol)
   del_hmatrix(acopy);
 }
 
+static void
+check_accum_addmul(pchmatrix a, bool ytrans, real tol)
+{
+  pblock    block;
+  phmatrix  x1, x2;
+  ptruncmode tm;
+  real      eta, error;
+
+  eta = 1.0;
+  block = build_nonstrict_block((pcluster) a->rc, (pcluster) a->cc, &eta,
+				admissible_max_cluster);
+
+  /* Truncate after every update */
+  x1 = build_from_block_hmatrix(block, 0);
+  clear_hmatrix(x1);
+  addmul_hmatrix(1.0, false, a, ytrans, a, 0, tol, x1);
+
+  /* Accumulate updates */
+  tm = new_releucl_truncmode();
+  tm->accum_rank = 16;
+  x2 = build_from_block_hmatrix(block, 0);
+  clear_hmatrix(x2);
+  addmul_hmatrix(1.0, false, a, ytrans, a, tm, tol, x2);
+
+  add_hmatrix(-1.0, x1, 0, tol, x2);
+  error = norm2_hmatrix(x2) / norm2_hmatrix(x1);
+  (void) printf("Checking accumulated multiplication (ytrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (ytrans ? "tr" : "fl"), error,
+		(IS_IN_RANGE(0.0, error, 1.0e-12) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-12))
+    problems++;
+
+  del_truncmode(tm);
+  del_hmatrix(x2);
+  del_hmatrix(x1);
+  del_block(block);
+}
+
+static void
+check_rand_trunc(real eps)
+{
+  prkmatrix r1, r2;
+  ptruncmode tm;
+  amatrix   tmp1, tmp2;
+  pamatrix  f, g;
+  real      norm, error1, error2;
+  uint      i, j;
+
+  /* Low-rank matrix with rapidly decaying singular values */
+  r1 = new_rkmatrix(400, 300, 120);
+  random_amatrix(&r1->A);
+  random_amatrix(&r1->B);
+  for (j = 0; j < r1->k; j++)
+    for (i = 0; i < r1->A.rows; i++)
+      r1->A.a[i + j * r1->A.ld] *= REAL_POW(0.4, j);
+  r2 = clone_rkmatrix(r1);
+
+  f = init_amatrix(&tmp1, 400, 300);
+  clear_amatrix(f);
+  addmul_amatrix(1.0, false, &r1->A, true, &r1->B, f);
+  g = init_amatrix(&tmp2, 400, 300);
+  copy_amatrix(false, f, g);
+  norm = norm2_amatrix(f);
+
+  tm = new_releucl_truncmode();
+  trunc_rkmatrix(tm, eps, r1);
+  tm->randomized = true;
+  trunc_rkmatrix(tm, eps, r2);
+
+  addmul_amatrix(-1.0, false, &r1->A, true, &r1->B, f);
+  error1 = norm2_amatrix(f) / norm;
+  addmul_amatrix(-1.0, false, &r2->A, true, &r2->B, g);
+  error2 = norm2_amatrix(g) / norm;
+
+  (void) printf("Checking randomized truncation\n"
+		"  Rank %u (deterministic %u), accuracy %g (deterministic %g), "
+		"%sokay\n", r2->k, r1->k, error2, error1,
+		(IS_IN_RANGE(0.0, error2, 2.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error2, 2.0 * eps))
+    problems++;
+
+  del_truncmode(tm);
+  uninit_amatrix(g);
+  uninit_amatrix(f);
+  del_rkmatrix(r2);
+  del_rkmatrix(r1);
+}
+
+static void
+check_parallel_mvm(pchmatrix a, bool atrans)
+{
+  uint      rows = (atrans ? a->cc->size : a->rc->size);
+  uint      cols = (atrans ? a->rc->size : a->cc->size);
+  avector   xtmp, y1tmp, y2tmp;
+  pavector  x, y1, y2;
+  real      error;
+
+  x = init_avector(&xtmp, cols);
+  y1 = init_avector(&y1tmp, rows);
+  y2 = init_avector(&y2tmp, rows);
+
+  random_avector(x);
+  random_avector(y1);
+  copy_avector(y1, y2);
+
+  if (atrans) {
+    fastaddevaltrans_hmatrix_avector(1.0, a, x, y1);
+    fastaddevaltrans_parallel_hmatrix_avector(1.0, a, x, y2, 4);
+  }
+  else {
+    fastaddeval_hmatrix_avector(1.0, a, x, y1);
+    fastaddeval_parallel_hmatrix_avector(1.0, a, x, y2, 4);
+  }
+
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+
+  /* The parallel summation has to reproduce the sequential result */
+  (void) printf("Checking parallel matrix-vector multiplication "
+		"(atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error == 0.0 ? "" : "    NOT "));
+  if (error != 0.0)
+    problems++;
+
+  uninit_avector(y2);
+  uninit_avector(y1);
+  uninit_avector(x);
+}
+
 static void
 check_triangularsolve(bool lower, bool unit, bool atrans,
 		      pchmatrix a, bool xtrans, real tol)
@@ -222,8 +354,703 @@ set_unit(phmatrix R)
   }
 }
 
+static void
+check_multi_mvm(pchmatrix a, bool atrans)
+{
+  pamatrix  X, Y1, Y2;
+  avector   tmp1, tmp2;
+  pavector  x, y;
+  uint      rows, cols, j;
+  real      error;
+
+  rows = (atrans ? a->cc->size : a->rc->size);
+  cols = (atrans ? a->rc->size : a->cc->size);
+
+  X = new_amatrix(cols, 7);
+  random_amatrix(X);
+  Y1 = new_amatrix(rows, 7);
+  random_amatrix(Y1);
+  Y2 = new_amatrix(rows, 7);
+  copy_amatrix(false, Y1, Y2);
+
+  /* Multiply all columns at once */
+  mvm_hmatrix_amatrix(2.0, atrans, a, X, Y1);
+
+  /* Multiply column by column */
+  for (j = 0; j < X->cols; j++) {
+    x = init_column_avector(&tmp1, X, j);
+    y = init_column_avector(&tmp2, Y2, j);
+    mvm_hmatrix_avector(2.0, atrans, a, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+
+  add_amatrix(-1.0, false, Y1, Y2);
+  error = normfrob_amatrix(Y2) / normfrob_amatrix(Y1);
+  (void) printf("Checking multiplication with multiple vectors (atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(error <= 1e-13 ? "" : "    NOT "));
+  if (error > 1e-13)
+    problems++;
+
+  del_amatrix(Y2);
+  del_amatrix(Y1);
+  del_amatrix(X);
+}
+
+static void
+check_frozen_mvm(pchmatrix a, bool atrans)
+{
+  uint      rows = (atrans ? a->cc->size : a->rc->size);
+  uint      cols = (atrans ? a->rc->size : a->cc->size);
+  phmatrix  acopy;
+  avector   xtmp, y1tmp, y2tmp;
+  pavector  x, y1, y2;
+  real      error;
+
+  acopy = clone_hmatrix(a);
+  freeze_hmatrix(acopy);
+
+  x = init_avector(&xtmp, cols);
+  y1 = init_avector(&y1tmp, rows);
+  y2 = init_avector(&y2tmp, rows);
+
+  random_avector(x);
+  random_avector(y1);
+  copy_avector(y1, y2);
+
+  if (atrans) {
+    fastaddevaltrans_hmatrix_avector(1.0, a, x, y1);
+    fastaddevaltrans_frozen_hmatrix_avector(1.0, acopy, x, y2);
+  }
+  else {
+    fastaddeval_hmatrix_avector(1.0, a, x, y1);
+    fastaddeval_frozen_hmatrix_avector(1.0, acopy, x, y2);
+  }
+
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+
+  (void) printf("Checking frozen matrix-vector multiplication (atrans=%s)\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), error,
+		(IS_IN_RANGE(0.0, error, 1.0e-14) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-14))
+    problems++;
+
+  uninit_avector(y2);
+  uninit_avector(y1);
+  uninit_avector(x);
+
+  del_hmatrix(acopy);
+}
+
+static void
+check_single_mvm(pchmatrix a, bool atrans)
+{
+  uint      rows = (atrans ? a->cc->size : a->rc->size);
+  uint      cols = (atrans ? a->rc->size : a->cc->size);
+  phmatrix  acopy;
+  avector   xtmp, y1tmp, y2tmp;
+  pavector  x, y1, y2;
+  size_t    sz1, sz2;
+  real      error;
+
+  acopy = clone_hmatrix(a);
+  sz1 = getfarsize_hmatrix(acopy);
+  tosingle_hmatrix(acopy);
+  sz2 = getfarsize_hmatrix(acopy);
+
+  /* Multiple vectors have to use the single precision factors, too */
+  check_multi_mvm(acopy, atrans);
+
+  freeze_hmatrix(acopy);
+
+  x = init_avector(&xtmp, cols);
+  y1 = init_avector(&y1tmp, rows);
+  y2 = init_avector(&y2tmp, rows);
+
+  random_avector(x);
+  random_avector(y1);
+  copy_avector(y1, y2);
+
+  if (atrans) {
+    fastaddevaltrans_hmatrix_avector(1.0, a, x, y1);
+    fastaddevaltrans_frozen_hmatrix_avector(1.0, acopy, x, y2);
+  }
+  else {
+    fastaddeval_hmatrix_avector(1.0, a, x, y1);
+    fastaddeval_frozen_hmatrix_avector(1.0, acopy, x, y2);
+  }
+
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+
+  (void) printf("Checking single precision matrix-vector multiplication "
+		"(atrans=%s)\n"
+		"  Farfield %.1f MB instead of %.1f MB\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"),
+		sz2 / 1048576.0, sz1 / 1048576.0, error,
+		(IS_IN_RANGE(0.0, error, 1.0e-6) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-6) || 2 * sz2 > sz1 + 1048576)
+    problems++;
+
+  uninit_avector(y2);
+  uninit_avector(y1);
+  uninit_avector(x);
+
+  del_hmatrix(acopy);
+}
+
+static void
+check_compressed_mvm(pchmatrix a, bool atrans, real eps)
+{
+  uint      rows = (atrans ? a->cc->size : a->rc->size);
+  uint      cols = (atrans ? a->rc->size : a->cc->size);
+  phmatrix  acopy;
+  avector   xtmp, y1tmp, y2tmp;
+  pavector  x, y1, y2;
+  size_t    sz1, sz2;
+  real      error;
+
+  acopy = clone_hmatrix(a);
+  sz1 = getfarsize_hmatrix(acopy);
+  compress_hmatrix(acopy, eps);
+  sz2 = getfarsize_hmatrix(acopy);
+
+  /* Multiple vectors have to decompress the factors, too */
+  check_multi_mvm(acopy, atrans);
+
+  x = init_avector(&xtmp, cols);
+  y1 = init_avector(&y1tmp, rows);
+  y2 = init_avector(&y2tmp, rows);
+
+  random_avector(x);
+  clear_avector(y1);
+  clear_avector(y2);
+
+  if (atrans) {
+    fastaddevaltrans_hmatrix_avector(1.0, a, x, y1);
+    fastaddevaltrans_hmatrix_avector(1.0, acopy, x, y2);
+  }
+  else {
+    fastaddeval_hmatrix_avector(1.0, a, x, y1);
+    fastaddeval_hmatrix_avector(1.0, acopy, x, y2);
+  }
+
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+
+  (void) printf("Checking compressed matrix-vector multiplication "
+		"(atrans=%s, eps=%.0e)\n"
+		"  Farfield %.1f MB instead of %.1f MB\n"
+		"  Accuracy %g, %sokay\n", (atrans ? "tr" : "fl"), eps,
+		sz2 / 1048576.0, sz1 / 1048576.0, error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps) || sz2 >= sz1)
+    problems++;
+
+  /* Decompression has to restore the layout of the factors */
+  decompress_hmatrix(acopy);
+  clear_avector(y2);
+  if (atrans)
+    fastaddevaltrans_hmatrix_avector(1.0, acopy, x, y2);
+  else
+    fastaddeval_hmatrix_avector(1.0, acopy, x, y2);
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2) / norm2_avector(y1);
+  (void) printf("  Restored accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps))
+    problems++;
+
+  uninit_avector(y2);
+  uninit_avector(y1);
+  uninit_avector(x);
+
+  del_hmatrix(acopy);
+}
+
+static void
+count_entries(pchmatrix a, size_t * nearentries, size_t * farentries)
+{
+  uint      i;
+
+  if (a->f)
+    *nearentries += (size_t) a->f->rows * a->f->cols;
+  if (a->r)
+    *farentries += (size_t) a->r->k * (a->rc->size + a->cc->size);
+  if (a->son)
+    for (i = 0; i < a->rsons * a->csons; i++)
+      count_entries(a->son[i], nearentries, farentries);
+}
+
+static void
+check_cost_block(pcblock b, uint k)
+{
+  blockcost bc;
+  phmatrix  a;
+  size_t    nearentries, farentries;
+  real      load[4], sum, imbalance;
+  int       pardepth;
+  bool      okay;
+
+  estimate_cost_block(b, k, &bc);
+
+  a = build_from_block_hmatrix(b, k);
+  nearentries = 0;
+  farentries = 0;
+  count_entries(a, &nearentries, &farentries);
+  del_hmatrix(a);
+
+  okay = (bc.nearentries == nearentries && bc.farentries == farentries);
+  (void) printf("Checking cost estimate for block tree\n"
+		"  %u near and %u far leaves, %sokay\n",
+		bc.nearleaves, bc.farleaves, (okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  /* The multiplication splits block rows up to max_pardepth, which has
+     to be large enough for four threads */
+  pardepth = max_pardepth;
+  max_pardepth = 3;
+  imbalance = estimate_partition_block(b, k, true, 4, load);
+  max_pardepth = pardepth;
+  sum = load[0] + load[1] + load[2] + load[3];
+
+  okay = (REAL_ABS(sum - bc.hmvm) <= 1e-12 * bc.hmvm && imbalance >= 1.0
+	  && imbalance <= 1.5);
+  (void) printf("Checking predicted partition for 4 threads\n"
+		"  Imbalance %.3f, %sokay\n", imbalance, (okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+}
+
+static void
+check_binary_block(pcblock b)
+{
+  pblock    b2;
+  pcluster  t2;
+  bool      okay;
+  uint      i;
+
+  write_binary_block(b, "test_hmatrix.bin");
+  b2 = read_binary_block("test_hmatrix.bin");
+  (void) remove("test_hmatrix.bin");
+
+  t2 = b2->rc;
+
+  okay = (b2->desc == b->desc && b2->rc == b2->cc
+	  && t2->desc == b->rc->desc && t2->size == b->rc->size);
+  for (i = 0; okay && i < t2->size; i++)
+    okay = (t2->idx[i] == b->rc->idx[i]);
+
+  (void) printf("Checking binary file for block tree\n"
+		"  %sokay\n", (okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  del_block(b2);
+  freemem(t2->idx);
+  del_cluster(t2);
+}
+
+/* Write the first len bytes of buf to a file and try to read it */
+static    bool
+read_damaged_hmatrix(const char *buf, size_t len, bool map)
+{
+  phmatrix  a2;
+  FILE     *out;
+
+  out = fopen("test_hmatrix_damaged.bin", "wb");
+  if (out == NULL)
+    return false;
+  (void) fwrite(buf, sizeof(char), len, out);
+  (void) fclose(out);
+
+  a2 = read_binary_hmatrix("test_hmatrix_damaged.bin", map);
+  (void) remove("test_hmatrix_damaged.bin");
+
+  return (a2 == NULL);
+}
+
+static void
+check_damaged_hmatrix(pchmatrix a, const char *filename, bool map)
+{
+  FILE     *in;
+  char     *buf;
+  size_t    len, header, datasize, hugesize, i;
+  bool      okay;
+
+  in = fopen(filename, "rb");
+  assert(in != NULL);
+  (void) fseek(in, 0, SEEK_END);
+  len = (size_t) ftell(in);
+  (void) fseek(in, 0, SEEK_SET);
+  buf = (char *) allocmem(len);
+  len = fread(buf, sizeof(char), len, in);
+  (void) fclose(in);
+
+  /* Missing coefficients */
+  okay = read_damaged_hmatrix(buf, len - 1, map);
+
+  /* Missing structure */
+  header = 8 + 7 * sizeof(uint) + 2 * sizeof(size_t);
+  okay = okay && read_damaged_hmatrix(buf, header + 2 * sizeof(uint), map);
+
+  /* Size of the data section overflows when added to its offset */
+  memcpy(&datasize, buf + header - sizeof(size_t), sizeof(size_t));
+  hugesize = SIZE_MAX / sizeof(field);
+  memcpy(buf + header - sizeof(size_t), &hugesize, sizeof(size_t));
+  okay = okay && read_damaged_hmatrix(buf, len, map);
+  memcpy(buf + header - sizeof(size_t), &datasize, sizeof(size_t));
+
+  /* Huge counts in the structure section */
+  for (i = header; i < header + 4 * sizeof(uint) && i < len; i++)
+    buf[i] = (char) 0xff;
+  okay = okay && read_damaged_hmatrix(buf, len, map);
+
+  /* Target directory does not exist */
+  okay = okay && !write_binary_hmatrix(a, "test_hmatrix.none/test.bin");
+
+  (void) printf("Checking damaged binary files for H-matrix (map=%s)\n"
+		"  %sokay\n", (map ? "tr" : "fl"), (okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  freemem(buf);
+}
+
+static void
+check_binary_hmatrix(pchmatrix a, bool map)
+{
+  phmatrix  a2;
+  pcluster  t2;
+  pavector  x, y1, y2;
+  real      error;
+  bool      okay;
+
+  okay = write_binary_hmatrix(a, "test_hmatrix.bin");
+  a2 = read_binary_hmatrix("test_hmatrix.bin", map);
+  if (!okay || a2 == NULL) {
+    (void) printf("Checking binary file for H-matrix (map=%s)\n"
+		  "      NOT okay\n", (map ? "tr" : "fl"));
+    problems++;
+    (void) remove("test_hmatrix.bin");
+    return;
+  }
+  check_damaged_hmatrix(a, "test_hmatrix.bin", map);
+  (void) remove("test_hmatrix.bin");
+
+  x = new_avector(a->cc->size);
+  y1 = new_avector(a->rc->size);
+  y2 = new_avector(a->rc->size);
+
+  random_avector(x);
+  clear_avector(y1);
+  clear_avector(y2);
+
+  fastaddeval_hmatrix_avector(1.0, a, x, y1);
+  fastaddeval_hmatrix_avector(1.0, a2, x, y2);
+
+  /* Same coefficients and same traversal, so the result is identical */
+  add_avector(-1.0, y1, y2);
+  error = norm2_avector(y2);
+  (void) printf("Checking binary file for H-matrix (map=%s)\n"
+		"  Accuracy %g, %sokay\n", (map ? "tr" : "fl"), error,
+		(error == 0.0 ? "" : "    NOT "));
+  if (error != 0.0)
+    problems++;
+
+  del_avector(y2);
+  del_avector(y1);
+  del_avector(x);
+
+  t2 = (pcluster) a2->rc;
+  assert(a2->cc == t2);
+
+  del_hmatrix(a2);
+  freemem(t2->idx);
+  del_cluster(t2);
+}
+
+static    bool
+same_cluster(pccluster t1, const uint * idx1, pccluster t2,
+	     const uint * idx2)
+{
+  bool      okay;
+  uint      i;
+
+  okay = (t1->size == t2->size && t1->sons == t2->sons
+	  && t1->desc == t2->desc && t1->idx - idx1 == t2->idx - idx2);
+
+  for (i = 0; okay && i < t1->dim; i++)
+    okay = (t1->bmin[i] == t2->bmin[i] && t1->bmax[i] == t2->bmax[i]);
+
+  for (i = 0; okay && i < t1->sons; i++)
+    okay = same_cluster(t1->son[i], idx1, t2->son[i], idx2);
+
+  return okay;
+}
+
+static void
+check_parallel_cluster(clustermode mode, const char *name)
+{
+  pclustergeometry cf;
+  pcluster  t1, t2;
+  pstopwatch sw;
+  uint     *idx1, *idx2;
+  uint      n, i, j;
+  real      time1, time2;
+  bool      okay;
+
+  n = 40000;
+
+  cf = new_clustergeometry(3, n);
+  idx1 = allocuint(n);
+  idx2 = allocuint(n);
+
+  /* Deterministic points, with repeated coordinates */
+  for (i = 0; i < n; i++) {
+    cf->x[i][0] = REAL_SIN(0.37 * (i % 1000));
+    cf->x[i][1] = REAL_SIN(0.11 * i + 1.0);
+    cf->x[i][2] = 0.001 * (i % 577);
+    for (j = 0; j < 3; j++) {
+      cf->smin[i][j] = cf->x[i][j] - 0.01;
+      cf->smax[i][j] = cf->x[i][j] + 0.01;
+    }
+    cf->w[i] = 1.0;
+    idx1[i] = i;
+    idx2[i] = i;
+  }
+
+  sw = new_stopwatch();
+
+  start_stopwatch(sw);
+  if (mode == H2_ADAPTIVE)
+    t1 = build_adaptive_cluster(cf, n, idx1, 16);
+  else if (mode == H2_REGULAR)
+    t1 = build_regular_cluster(cf, n, idx1, 16, 0);
+  else
+    t1 = build_pca_cluster(cf, n, idx1, 16);
+  time1 = stop_stopwatch(sw);
+
+  start_stopwatch(sw);
+  t2 = build_parallel_cluster(cf, n, idx2, 16, mode, 4);
+  time2 = stop_stopwatch(sw);
+
+  okay = same_cluster(t1, idx1, t2, idx2);
+  for (i = 0; okay && i < n; i++)
+    okay = (idx1[i] == idx2[i]);
+
+  (void) printf("Checking parallel %s clustering\n"
+		"  %.3f seconds sequential, %.3f seconds parallel\n"
+		"  %sokay\n", name, time1, time2, (okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  del_stopwatch(sw);
+  del_cluster(t2);
+  del_cluster(t1);
+  freemem(idx2);
+  freemem(idx1);
+  del_clustergeometry(cf);
+}
+
+static void
+check_sfc_cluster(clustermode mode, const char *name)
+{
+  pclustergeometry cf;
+  pcluster  t;
+  uint     *idx, *mark;
+  uint      n, i, j, x0, y0, x1, y1, k;
+  bool      okay;
+
+  /* Centers of a 16 x 16 grid of cells, plus two points fixing the
+     bounding box to the unit square */
+  n = 258;
+
+  cf = new_clustergeometry(2, n);
+  idx = allocuint(n);
+  mark = allocuint(n);
+
+  for (i = 0; i < 256; i++) {
+    cf->x[i][0] = ((i % 16) + 0.5) / 16.0;
+    cf->x[i][1] = ((i / 16) + 0.5) / 16.0;
+  }
+  cf->x[256][0] = cf->x[256][1] = 0.0;
+  cf->x[257][0] = cf->x[257][1] = 1.0;
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < 2; j++) {
+      cf->smin[i][j] = cf->x[i][j];
+      cf->smax[i][j] = cf->x[i][j];
+    }
+    cf->w[i] = 1.0;
+    idx[i] = i;
+    mark[i] = 0;
+  }
+
+  t = build_sfc_cluster(cf, n, idx, 4, mode);
+
+  /* Result has to be a permutation */
+  okay = (t->size == n && t->idx == idx);
+  for (i = 0; okay && i < n; i++) {
+    okay = (idx[i] < n && mark[idx[i]] == 0);
+    if (okay)
+      mark[idx[i]] = 1;
+  }
+
+  /* Consecutive cells along the Hilbert curve are neighbours,
+     consecutive cells along the Morton curve have increasing keys */
+  x0 = y0 = 0;
+  j = n;
+  for (i = 0; okay && i < n; i++) {
+    if (idx[i] >= 256)
+      continue;
+
+    x1 = idx[i] % 16;
+    y1 = idx[i] / 16;
+
+    if (j < n) {
+      if (mode == H2_HILBERT)
+	okay = ((x0 > x1 ? x0 - x1 : x1 - x0)
+		+ (y0 > y1 ? y0 - y1 : y1 - y0) == 1);
+      else {
+	for (k = 4; k-- > 0 && okay;) {
+	  if (((x0 >> k) & 1) != ((x1 >> k) & 1)) {
+	    okay = (((x1 >> k) & 1) == 1);
+	    break;
+	  }
+	  if (((y0 >> k) & 1) != ((y1 >> k) & 1)) {
+	    okay = (((y1 >> k) & 1) == 1);
+	    break;
+	  }
+	}
+      }
+    }
+
+    x0 = x1;
+    y0 = y1;
+    j = i;
+  }
+
+  (void) printf("Checking %s clustering\n"
+		"  %u clusters, %sokay\n", name, t->desc,
+		(okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  del_cluster(t);
+  freemem(mark);
+  freemem(idx);
+  del_clustergeometry(cf);
+}
+
+static    bool
+same_hmatrix(pchmatrix a, pchmatrix b)
+{
+  uint      rsons, csons;
+  uint      i, j;
+  bool      okay;
+
+  if (a->son) {
+    if (b->son == NULL || a->rsons != b->rsons || a->csons != b->csons)
+      return false;
+
+    rsons = a->rsons;
+    csons = a->csons;
+
+    okay = true;
+    for (j = 0; okay && j < csons; j++)
+      for (i = 0; okay && i < rsons; i++)
+	okay = same_hmatrix(a->son[i + j * rsons], b->son[i + j * rsons]);
+
+    return okay;
+  }
+
+  if (a->r) {
+    if (b->r == NULL || a->r->k != b->r->k)
+      return false;
+
+    for (j = 0; j < a->r->k; j++) {
+      for (i = 0; i < a->r->A.rows; i++)
+	if (a->r->A.a[i + j * a->r->A.ld] != b->r->A.a[i + j * b->r->A.ld])
+	  return false;
+      for (i = 0; i < a->r->B.rows; i++)
+	if (a->r->B.a[i + j * a->r->B.ld] != b->r->B.a[i + j * b->r->B.ld])
+	  return false;
+    }
+
+    return true;
+  }
+
+  if (a->f) {
+    if (b->f == NULL)
+      return false;
+
+    for (j = 0; j < a->f->cols; j++)
+      for (i = 0; i < a->f->rows; i++)
+	if (a->f->a[i + j * a->f->ld] != b->f->a[i + j * b->f->ld])
+	  return false;
+
+    return true;
+  }
+
+  return false;
+}
+
+static void
+check_parallel_decomp(pchmatrix a, bool chol, real tol)
+{
+  phmatrix  a1, a2, a3;
+  ptruncmode tm;
+  real      error;
+  bool      okay;
+
+  a1 = clone_hmatrix(a);
+  a2 = clone_hmatrix(a);
+
+  if (chol) {
+    choldecomp_hmatrix(a1, 0, tol);
+    choldecomp_parallel_hmatrix(a2, 0, tol, max_pardepth);
+  }
+  else {
+    lrdecomp_hmatrix(a1, 0, tol);
+    lrdecomp_parallel_hmatrix(a2, 0, tol, max_pardepth);
+  }
+
+  /* Every submatrix is computed by the same sequence of operations,
+     so the factors have to coincide exactly */
+  okay = same_hmatrix(a1, a2);
+  (void) printf("Checking parallel %s factorization\n"
+		"  Factors %s, %sokay\n", (chol ? "Cholesky" : "LR"),
+		(okay ? "identical" : "different"), (okay ? "" : "    NOT "));
+  if (!okay)
+    problems++;
+
+  /* Accumulated updates are truncated at different times, so only
+     the accuracy can be compared */
+  tm = new_releucl_truncmode();
+  tm->accum_rank = 16;
+  a3 = clone_hmatrix(a);
+  if (chol)
+    choldecomp_parallel_hmatrix(a3, tm, tol, max_pardepth);
+  else
+    lrdecomp_parallel_hmatrix(a3, tm, tol, max_pardepth);
+  add_hmatrix(-1.0, a1, 0, tol, a3);
+  error = norm2_hmatrix(a3) / norm2_hmatrix(a1);
+  (void) printf("  Accumulated updates, accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 1.0e-10) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-10))
+    problems++;
+
+  del_truncmode(tm);
+  del_hmatrix(a3);
+  del_hmatrix(a2);
+  del_hmatrix(a1);
+}
+
 int
-main()
+main(int argc, char **argv)
 {
   phmatrix  a, acopy, L, R;
   pavector  x, b;
@@ -239,6 +1066,8 @@ main()
   uint      clf, m;
   real      tol, eta, delta, eps_aca;
 
+  init_h2lib(&argc, &argv);
+
   n = 579;
   tol = 1.0e-13;
 
@@ -267,6 +1096,17 @@ main()
 
   check_addhmatrix(a, tol);
 
+  check_parallel_mvm(a, false);
+  check_parallel_mvm(a, true);
+  check_multi_mvm(a, false);
+  check_multi_mvm(a, true);
+  check_frozen_mvm(a, false);
+  check_frozen_mvm(a, true);
+  check_binary_block(block2);
+  check_cost_block(block2, 5);
+  check_binary_hmatrix(a, false);
+  check_binary_hmatrix(a, true);
+
   del_hmatrix(a);
 
   (void) printf("----------------------------------------\n"
@@ -287,6 +1127,8 @@ main()
   (void) printf("Copying matrix\n");
   acopy = clone_hmatrix(a);
 
+  check_parallel_decomp(acopy, true, tol);
+
   (void) printf("Computing Cholesky factorization\n");
   choldecomp_hmatrix(a, 0, tol);
 
@@ -364,6 +1206,8 @@ main()
   (void) printf("Copying matrix\n");
   acopy = clone_hmatrix(a);
 
+  check_parallel_decomp(acopy, false, tol);
+
   (void) printf("Computing LR factorization\n");
   lrdecomp_hmatrix(a, 0, tol);
 
@@ -480,6 +1324,23 @@ main()
   cairo_destroy(cr);
 #endif
 
+  (void) printf("----------------------------------------\n");
+  check_parallel_cluster(H2_ADAPTIVE, "adaptive");
+  check_parallel_cluster(H2_REGULAR, "regular");
+  check_parallel_cluster(H2_PCA, "PCA");
+  check_sfc_cluster(H2_MORTON, "Morton");
+  check_sfc_cluster(H2_HILBERT, "Hilbert");
+
+  (void) printf("----------------------------------------\n");
+  check_accum_addmul(a, false, tol);
+  check_accum_addmul(a, true, tol);
+  check_rand_trunc(1.0e-8);
+  check_single_mvm(a, false);
+  check_single_mvm(a, true);
+  check_compressed_mvm(a, false, 1.0e-4);
+  check_compressed_mvm(a, true, 1.0e-4);
+  check_compressed_mvm(a, false, 1.0e-10);
+
   /* Final clean-up */
   (void) printf("Cleaning up\n");
   del_hmatrix(acopy);
@@ -501,5 +1362,7 @@ main()
 		"  %u errors found\n", getactives_amatrix(),
 		getactives_avector(), problems);
 
+  uninit_h2lib();
+
   return problems;
 }
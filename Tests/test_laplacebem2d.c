@@ -116,8 +116,9 @@ test_hmatrix_system(const char *apprxtype, pcamatrix Vfull,
 		    phmatrix V, pbem2d bem_dlp, phmatrix KM, bool exterior)
 {
   pavector  x, b;
-  real      errorV, errorKM, error_solve, eps_solve;
-  uint      steps;
+  const real *ttime;
+  real      errorV, errorKM, error_solve, eps_solve, tmax;
+  uint      steps, threads, i;
 
   eps_solve = 1.0e-12;
   steps = 1000;
@@ -129,6 +130,15 @@ test_hmatrix_system(const char *apprxtype, pcamatrix Vfull,
   assemble_bem2d_hmatrix(bem_slp, block, V);
   assemble_bem2d_hmatrix(bem_dlp, block, KM);
 
+  ttime = getthreadtimes_bem2d(bem_dlp, &threads);
+  tmax = 0.0;
+  for (i = 0; ttime != NULL && i < threads; i++)
+    tmax = REAL_MAX(tmax, ttime[i]);
+  printf("assembly time      : %.2f s, slowest of %u threads   %s\n",
+	 tmax, threads, (ttime != NULL && threads > 0 ? "    okay" : "NOT okay"));
+  if (ttime == NULL || threads == 0)
+    problems++;
+
   errorV = norm2diff_amatrix_hmatrix(V, Vfull) / norm2_amatrix(Vfull);
   printf("rel. error V       : %.5e\n", errorV);
   errorKM = norm2diff_amatrix_hmatrix(KM, KMfull) / norm2_amatrix(KMfull);
@@ -235,6 +245,122 @@ test_h2matrix_system(const char *apprxtype, pcamatrix Vfull,
   del_avector(b);
 }
 
+/* Check residuals |B - V X| <= eps |B| of all columns */
+static void
+check_block_residual(const char *name, ph2matrix V, pcamatrix B,
+		     pcamatrix X, real eps, uint steps)
+{
+  avector   tmp1, tmp2;
+  pamatrix  R;
+  pavector  r, b;
+  real      error, maxerror;
+  uint      j;
+
+  R = new_amatrix(B->rows, B->cols);
+  copy_amatrix(false, B, R);
+  addeval_h2matrix_amatrix(-1.0, V, X, R);
+
+  maxerror = 0.0;
+  for (j = 0; j < R->cols; j++) {
+    r = init_column_avector(&tmp1, R, j);
+    b = init_column_avector(&tmp2, (pamatrix) B, j);
+    error = norm2_avector(r);
+    if (error > eps * norm2_avector(b) && error > maxerror * norm2_avector(b))
+      maxerror = error / norm2_avector(b);
+    uninit_avector(b);
+    uninit_avector(r);
+  }
+
+  printf("%s: %u steps\n"
+	 "  Max. unconverged residual %.5e, %s\n", name, steps, maxerror,
+	 (maxerror == 0.0 ? "    okay" : "NOT okay"));
+  if (maxerror != 0.0)
+    problems++;
+
+  del_amatrix(R);
+}
+
+/* Solve for several right-hand sides, including a linearly dependent
+   and a vanishing one, with the block Krylov methods */
+static void
+test_block_solvers(ph2matrix V)
+{
+  addevalmat_t addevalV;
+  avector   tmp1, tmp2;
+  pamatrix  B, X, R, P, AP, Vb, H, C;
+  pavector  b0, b4, norms;
+  real      eps;
+  uint      n, s, i, j, kk, ll;
+  bool      converged;
+
+  addevalV = (addevalmat_t) addeval_h2matrix_amatrix;
+
+  n = V->rb->t->size;
+  s = 6;
+  eps = 1.0e-10;
+
+  B = new_amatrix(n, s);
+  random_amatrix(B);
+  b0 = init_column_avector(&tmp1, B, 0);
+  b4 = init_column_avector(&tmp2, B, 4);
+  copy_avector(b0, b4);
+  uninit_avector(b4);
+  uninit_avector(b0);
+  b4 = init_column_avector(&tmp2, B, 5);
+  clear_avector(b4);
+  uninit_avector(b4);
+
+  /* Block conjugate gradient method */
+  X = new_zero_amatrix(n, s);
+  R = new_amatrix(n, s);
+  P = new_amatrix(n, s);
+  AP = new_amatrix(n, s);
+
+  init_blockcg(addevalV, V, eps, B, X, R, P, AP, &kk);
+  for (i = 0; i < 1000 && kk > 0; i++)
+    step_blockcg(addevalV, V, eps, B, X, R, P, AP, &kk);
+
+  check_block_residual("Block CG", V, B, X, eps, i);
+
+  del_amatrix(AP);
+  del_amatrix(P);
+  del_amatrix(R);
+
+  /* Restarted block GMRES */
+  clear_amatrix(X);
+  Vb = new_amatrix(n, 60);
+  H = new_amatrix(60, 60);
+  C = new_amatrix(60, s);
+  norms = new_avector(s);
+
+  init_blockgmres(addevalV, V, eps, B, X, Vb, H, C, &kk, &ll);
+  for (i = 0; i < 1000 && ll > 0; i++) {
+    if (kk + 2 * ll > Vb->cols)
+      finish_blockgmres(addevalV, V, eps, B, X, Vb, H, C, &kk, &ll);
+    step_blockgmres(addevalV, V, eps, B, X, Vb, H, C, &kk, &ll);
+    residualnorms_blockgmres(H, C, kk, ll, norms);
+    converged = true;
+    for (j = 0; j < s; j++) {
+      b0 = init_column_avector(&tmp1, B, j);
+      if (REAL(norms->v[j]) > 0.5 * eps * norm2_avector(b0))
+	converged = false;
+      uninit_avector(b0);
+    }
+    if (converged)
+      break;
+  }
+  finish_blockgmres(addevalV, V, eps, B, X, Vb, H, C, &kk, &ll);
+
+  check_block_residual("Block GMRES", V, B, X, eps, i);
+
+  del_avector(norms);
+  del_amatrix(C);
+  del_amatrix(H);
+  del_amatrix(Vb);
+  del_amatrix(X);
+  del_amatrix(B);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -412,6 +538,8 @@ main(int argc, char **argv)
   test_h2matrix_system("Interpolation", Vfull, KMfull, block, bem_slp, V2,
 		       bem_dlp, KM2, false);
 
+  test_block_solvers(V2);
+
   /*
    * Test Greenhybrid
    */
@@ -24,7 +24,7 @@ L2gamma_c_diff_norm2(pbem3d bem, pavector x, boundary_func3d rhs)
   real     *yq = bem->sq->y_single;
   uint      nq = bem->sq->n_single;
   real     *wq = bem->sq->w_single + 3 * nq;
-  real     *xv = x->v;
+  pfield    xv = x->v;
 
   const real *A, *B, *C, *N;
   real      X[3];
@@ -52,7 +52,7 @@ L2gamma_c_diff_norm2(pbem3d bem, pavector x, boundary_func3d rhs)
       X[1] = A[1] * Ax + B[1] * Bx + C[1] * Cx;
       X[2] = A[2] * Ax + B[2] * Bx + C[2] * Cx;
 
-      sum += wq[q] * REAL_SQR(rhs(X, N) - xv[t]);
+      sum += wq[q] * ABSSQR(rhs(X, N) - xv[t]);
     }
     norm += gr_g[t] * sum;
   }
@@ -75,11 +75,12 @@ L2gamma_l_diff_norm2(pbem3d bem, pavector x, boundary_func3d rhs)
   real     *yq = bem->sq->y_single;
   uint      nq = bem->sq->n_single;
   real     *wq = bem->sq->w_single + 3 * nq;
-  real     *xv = x->v;
+  pfield    xv = x->v;
 
   const real *A, *B, *C, *N;
   real      X[3];
-  real      sum, bf, tx, sx, Ax, Bx, Cx;
+  real      sum, tx, sx, Ax, Bx, Cx;
+  field     bf;
   uint      t, q;
 
   real      norm;
@@ -105,7 +106,7 @@ L2gamma_l_diff_norm2(pbem3d bem, pavector x, boundary_func3d rhs)
 
       bf = xv[gr_t[t][0]] * Ax + xv[gr_t[t][1]] * Bx + xv[gr_t[t][2]] * Cx;
 
-      sum += wq[q] * REAL_SQR(rhs(X, N) - bf);
+      sum += wq[q] * ABSSQR(rhs(X, N) - bf);
     }
     norm += gr_g[t] * sum;
   }
@@ -178,8 +179,9 @@ test_hmatrix_system(const char *apprxtype, pcamatrix Vfull,
 		    bool exterior, real low, real high)
 {
   pavector  x, b;
-  real      errorV, errorKM, error_solve, eps_solve;
-  uint      steps;
+  const real *ttime;
+  real      errorV, errorKM, error_solve, eps_solve, tmax;
+  uint      steps, threads, i;
 
   eps_solve = 1.0e-12;
   steps = 1000;
@@ -191,6 +193,15 @@ test_hmatrix_system(const char *apprxtype, pcamatrix Vfull,
   assemble_bem3d_hmatrix(bem_slp, block, V);
   assemble_bem3d_hmatrix(bem_dlp, block, KM);
 
+  ttime = getthreadtimes_bem3d(bem_dlp, &threads);
+  tmax = 0.0;
+  for (i = 0; ttime != NULL && i < threads; i++)
+    tmax = REAL_MAX(tmax, ttime[i]);
+  printf("assembly time      : %.2f s, slowest of %u threads   %s\n",
+	 tmax, threads, (ttime != NULL && threads > 0 ? "    okay" : "NOT okay"));
+  if (ttime == NULL || threads == 0)
+    problems++;
+
   errorV = norm2diff_amatrix_hmatrix(V, Vfull) / norm2_amatrix(Vfull);
   printf("rel. error V       : %.5e\n", errorV);
   errorKM = norm2diff_amatrix_hmatrix(KM, KMfull) / norm2_amatrix(KMfull);
@@ -371,6 +382,128 @@ test_h2matrix_system(const char *apprxtype, pcamatrix Vfull,
 
 }
 
+static void
+test_autotune(pbem3d bem)
+{
+  autotunebem3d at;
+  uint      clf[2] = { 16, 32 };
+  real      eta[2] = { 1.0, 2.0 };
+  uint      m[3] = { 2, 3, 4 };
+  real      accur;
+  bool      okay;
+
+  accur = 1.0e-3;
+
+  okay = autotune_hmatrix_bem3d(bem, APRX_INTER_ROW_BEM3D,
+				BASIS_CONSTANT_BEM3D, BASIS_CONSTANT_BEM3D,
+				2, clf, 2, eta, 3, m, 0, NULL, accur, 4, &at);
+
+  okay = (okay && at.error <= accur && at.candidates == 12);
+  printf("Automatic tuning: clf %u, eta %.1f, m %u, %.2f MB\n"
+	 "  error %.3e, %s\n\n", at.clf, at.eta, at.m,
+	 at.storage / 1048576.0, at.error, (okay ? "    okay" : "NOT okay"));
+  if (!okay)
+    problems++;
+}
+
+/* Assemble the matrix with the SIMD and the scalar quadrature, compare
+ * the results and report the speedup of the SIMD version */
+static void
+test_simd(const char *name, pbem3d bem, pcamatrix Afull)
+{
+  pamatrix  A, B;
+  pstopwatch sw;
+  real      tscalar, tsimd, t, error;
+  uint      i;
+
+  if (!set_simd_laplacebem3d(false)) {
+    printf("SIMD quadrature not available, %s matrix skipped\n", name);
+    return;
+  }
+
+  A = new_amatrix(Afull->rows, Afull->cols);
+  B = new_amatrix(Afull->rows, Afull->cols);
+  sw = new_stopwatch();
+
+  /* Fastest of three runs, to reduce the influence of timing noise */
+  tscalar = tsimd = 0.0;
+  for (i = 0; i < 3; i++) {
+    start_stopwatch(sw);
+    bem->nearfield(NULL, NULL, bem, false, A);
+    t = stop_stopwatch(sw);
+    tscalar = (i == 0 ? t : REAL_MIN(tscalar, t));
+  }
+
+  (void) set_simd_laplacebem3d(true);
+  for (i = 0; i < 3; i++) {
+    start_stopwatch(sw);
+    bem->nearfield(NULL, NULL, bem, false, B);
+    t = stop_stopwatch(sw);
+    tsimd = (i == 0 ? t : REAL_MIN(tsimd, t));
+  }
+
+  /* Only the order of summation and the rounding of the inverse square
+   * root differ */
+  error = normfrob_amatrix(A);
+  add_amatrix(-1.0, false, A, B);
+  error = normfrob_amatrix(B) / error;
+  printf("SIMD quadrature for %s matrix, speedup %.2f\n"
+	 "  Relative difference %g, %sokay\n", name, tscalar / tsimd, error,
+	 (IS_IN_RANGE(0.0, error, 1.0e-14) ? "" : "NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-14))
+    problems++;
+
+  del_stopwatch(sw);
+  del_amatrix(B);
+  del_amatrix(A);
+}
+
+static void
+test_singquadcache(pbem3d bem_slp, pbem3d bem_dlp, pcamatrix Vfull,
+		   pcamatrix KMfull)
+{
+  psingquadcache2d sc;
+  pamatrix  A;
+  pstopwatch sw;
+  real      t, error;
+
+  sw = new_stopwatch();
+
+  /* Classify the mesh once and share the result with the DLP */
+  start_stopwatch(sw);
+  sc = setup_singquadcache_bem3d(bem_slp, NULL);
+  (void) setup_singquadcache_bem3d(bem_dlp, sc);
+  t = stop_stopwatch(sw);
+  printf("Neighbouring triangles classified in %.3f seconds\n", t);
+
+  A = new_amatrix(Vfull->rows, Vfull->cols);
+
+  start_stopwatch(sw);
+  bem_slp->nearfield(NULL, NULL, bem_slp, false, A);
+  t = stop_stopwatch(sw);
+  add_amatrix(-1.0, false, Vfull, A);
+  error = normfrob_amatrix(A);
+  printf("Cached SLP matrix assembled in %.3f seconds\n"
+	 "  Difference %g, %sokay\n", t, error, (error == 0.0 ? "" : "NOT "));
+  if (error != 0.0)
+    problems++;
+
+  resize_amatrix(A, KMfull->rows, KMfull->cols);
+
+  start_stopwatch(sw);
+  bem_dlp->nearfield(NULL, NULL, bem_dlp, false, A);
+  t = stop_stopwatch(sw);
+  add_amatrix(-1.0, false, KMfull, A);
+  error = normfrob_amatrix(A);
+  printf("Cached DLP matrix assembled in %.3f seconds\n"
+	 "  Difference %g, %sokay\n", t, error, (error == 0.0 ? "" : "NOT "));
+  if (error != 0.0)
+    problems++;
+
+  del_amatrix(A);
+  del_stopwatch(sw);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -407,6 +540,13 @@ main(int argc, char **argv)
   bem_slp->nearfield(NULL, NULL, bem_slp, false, Vfull);
   bem_dlp->nearfield(NULL, NULL, bem_dlp, false, KMfull);
 
+  test_simd("SLP", bem_slp, Vfull);
+  test_simd("DLP", bem_dlp, KMfull);
+
+  test_singquadcache(bem_slp, bem_dlp, Vfull, KMfull);
+
+  test_autotune(bem_slp);
+
   V = build_from_block_hmatrix(block, 0);
   KM = build_from_block_hmatrix(block, 0);
 
@@ -783,6 +923,8 @@ main(int argc, char **argv)
   bem_slp->nearfield(NULL, NULL, bem_slp, false, Vfull);
   bem_dlp->nearfield(NULL, NULL, bem_dlp, false, KMfull);
 
+  test_singquadcache(bem_slp, bem_dlp, Vfull, KMfull);
+
   V = build_from_block_hmatrix(block, 0);
   KM = build_from_block_hmatrix(block, 0);
 